@@ -0,0 +1,214 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "asynclog.h"
+
+#include "metrics.h"
+#include "mpscqueue.h"
+#include "tinyformat.h"
+#include "util.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdlib.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct CLogRecord
+{
+    CLogSink* sink;
+    int64_t nTimeMicros;
+    std::string str;
+    //! Formats the message in the logging thread, when set
+    std::function<std::string()> format;
+
+    CLogRecord() : sink(NULL), nTimeMicros(0) {}
+};
+
+class CAsyncLogger
+{
+private:
+    CBoundedMPSCQueue<CLogRecord> queue;
+    std::atomic<bool> fStop;
+    //! Threads in AsyncLogPush, waited for before the last messages are written on stop
+    std::atomic<int> nPushing;
+    //! Messages dropped since the last ones were reported
+    std::atomic<uint64_t> nDropped;
+    //! Whether the logging thread waits for messages and has to be notified
+    std::atomic<bool> fWaiting;
+    //! Sink of the last message dropped, the number of messages dropped is reported to it
+    std::atomic<CLogSink*> pDroppedSink;
+    std::atomic<uint64_t> nDroppedTotal;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::thread thread;
+
+    //! Stamp a batch of messages and write it with a single write per sink
+    void WriteBatch(std::vector<CLogRecord>& vRecords)
+    {
+        std::vector<std::pair<CLogSink*, std::string> > vWrites;
+        for (CLogRecord& record : vRecords) {
+            if (record.format) {
+                try {
+                    record.str = record.format();
+                } catch (const std::exception& e) {
+                    record.str = strprintf("Error \"%s\" while formatting log message\n", e.what());
+                }
+            }
+            auto it = vWrites.begin();
+            while (it != vWrites.end() && it->first != record.sink)
+                ++it;
+            if (it == vWrites.end())
+                it = vWrites.insert(vWrites.end(), std::make_pair(record.sink, std::string()));
+            it->second += record.sink->Stamp(record.str, record.nTimeMicros);
+        }
+        for (const auto& write : vWrites)
+            write.first->Write(write.second);
+        vRecords.clear();
+    }
+
+    void ThreadLog()
+    {
+        RenameThread("bitcoin-log");
+        std::vector<CLogRecord> vRecords;
+        CLogRecord record;
+        while (true) {
+            while (queue.TryPop(record))
+                vRecords.push_back(std::move(record));
+
+            uint64_t nDroppedNow = nDropped.exchange(0);
+            if (nDroppedNow > 0) {
+                CLogRecord dropped;
+                dropped.sink = pDroppedSink;
+                dropped.nTimeMicros = GetLogTimeMicros();
+                dropped.str = strprintf("%u log messages dropped, the log queue was full\n", nDroppedNow);
+                vRecords.push_back(std::move(dropped));
+            }
+
+            if (!vRecords.empty()) {
+                WriteBatch(vRecords);
+                continue;
+            }
+
+            if (fStop && nPushing == 0 && queue.Empty())
+                break;
+
+            std::unique_lock<std::mutex> lock(mutex);
+            fWaiting = true;
+            // A message pushed before fWaiting was set is seen here, one pushed after it notifies
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (queue.Empty() && !fStop)
+                cond.wait_for(lock, std::chrono::milliseconds(100));
+            fWaiting = false;
+        }
+    }
+
+public:
+    explicit CAsyncLogger(size_t nQueueSize)
+        : queue(nQueueSize), fStop(false), nPushing(0), nDropped(0), fWaiting(false), pDroppedSink(NULL), nDroppedTotal(0)
+    {
+        thread = std::thread(&CAsyncLogger::ThreadLog, this);
+    }
+
+    bool Push(CLogSink* sink, int64_t nTimeMicros, std::string&& str, std::function<std::string()>&& format)
+    {
+        nPushing++;
+        if (fStop) {
+            nPushing--;
+            return false;
+        }
+
+        CLogRecord record;
+        record.sink = sink;
+        record.nTimeMicros = nTimeMicros;
+        record.str = std::move(str);
+        record.format = std::move(format);
+        if (queue.TryPush(std::move(record))) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (fWaiting) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cond.notify_one();
+            }
+        } else {
+            pDroppedSink = sink;
+            nDropped++;
+            nDroppedTotal++;
+        }
+        nPushing--;
+        return true;
+    }
+
+    uint64_t GetDropped() const { return nDroppedTotal; }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            fStop = true;
+            cond.notify_one();
+        }
+        if (thread.joinable())
+            thread.join();
+    }
+};
+
+/**
+ * The logger is leaked on exit like the debug log mutex, as messages can still
+ * be logged by global destructors. Messages logged once it is stopped are
+ * written synchronously.
+ */
+std::atomic<CAsyncLogger*> asyncLogger(NULL);
+std::mutex mutexAsyncLogger;
+std::atomic<uint64_t> nDroppedBefore(0);
+
+CMetricFunction metricLogDropped("tecracoin_log_messages_dropped_total", "Log messages dropped because the queue of the logging thread was full",
+    MetricType::COUNTER, [] { return (double)GetAsyncLogDropped(); });
+
+} // anon namespace
+
+void StartAsyncLogging(size_t nQueueSize)
+{
+    std::lock_guard<std::mutex> lock(mutexAsyncLogger);
+    if (asyncLogger || nQueueSize == 0)
+        return;
+
+    static bool fAtExitRegistered = false;
+    if (!fAtExitRegistered) {
+        // Write the queued messages on exit() too, like the ones written synchronously
+        atexit(StopAsyncLogging);
+        fAtExitRegistered = true;
+    }
+    asyncLogger = new CAsyncLogger(nQueueSize);
+}
+
+void StopAsyncLogging()
+{
+    std::lock_guard<std::mutex> lock(mutexAsyncLogger);
+    CAsyncLogger* logger = asyncLogger;
+    if (!logger)
+        return;
+
+    asyncLogger = NULL;
+    logger->Stop();
+    nDroppedBefore += logger->GetDropped();
+}
+
+bool AsyncLogPush(CLogSink* sink, int64_t nTimeMicros, std::string&& str, std::function<std::string()>&& format)
+{
+    CAsyncLogger* logger = asyncLogger;
+    if (!logger)
+        return false;
+    return logger->Push(sink, nTimeMicros, std::move(str), std::move(format));
+}
+
+uint64_t GetAsyncLogDropped()
+{
+    CAsyncLogger* logger = asyncLogger;
+    return nDroppedBefore + (logger ? logger->GetDropped() : 0);
+}
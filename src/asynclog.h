@@ -0,0 +1,49 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_ASYNCLOG_H
+#define BITCOIN_ASYNCLOG_H
+
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+/** A log file, or the console, the messages of the logging thread are written to */
+class CLogSink
+{
+public:
+    virtual ~CLogSink() {}
+
+    /**
+     * Prefix the timestamp of nTimeMicros to a message starting a line. The
+     * messages are stamped in the order they are written, by one thread at a time.
+     */
+    virtual std::string Stamp(const std::string& str, int64_t nTimeMicros) = 0;
+
+    /** Write stamped messages, returns the number of characters written */
+    virtual int Write(const std::string& str) = 0;
+};
+
+/**
+ * Write the log messages from a background thread, with a queue of up to
+ * nQueueSize messages waiting to be written. The messages logged while the
+ * queue is full are dropped, and their number is logged once there is room.
+ */
+void StartAsyncLogging(size_t nQueueSize);
+
+/** Write the messages waiting in the queue and stop the logging thread, the log is written synchronously again */
+void StopAsyncLogging();
+
+/**
+ * Queue a message for the logging thread, formatted by it with format when str
+ * is empty. Returns false when the thread isn't running, the message has to be
+ * written synchronously then.
+ */
+bool AsyncLogPush(CLogSink* sink, int64_t nTimeMicros, std::string&& str, std::function<std::string()>&& format);
+
+/** Number of messages dropped because the queue of the logging thread was full */
+uint64_t GetAsyncLogDropped();
+
+#endif // BITCOIN_ASYNCLOG_H
@@ -5,8 +5,10 @@
 #include "bench.h"
 #include "coins.h"
 #include "policy/policy.h"
+#include "random.h"
 #include "wallet/crypter.h"
 
+#include <unordered_map>
 #include <vector>
 
 // FIXME: Dedup with SetupDummyInputs in test/transaction_tests.cpp.
@@ -85,3 +87,60 @@ static void CCoinsCaching(benchmark::State& state)
 }
 
 BENCHMARK(CCoinsCaching);
+
+// Churn of a coins map as in ConnectBlock: outputs are added, looked up and
+// spent, and new outputs reuse the room of the spent ones. The map of
+// CCoinsViewCache, with nodes from a pool, against a map with a heap
+// allocation per node.
+template <typename Map>
+static void CoinsMapChurn(Map& map, const std::vector<COutPoint>& vOutpoints)
+{
+    const size_t nHalf = vOutpoints.size() / 2;
+    for (size_t i = 0; i < nHalf; i++) {
+        CCoinsCacheEntry& entry = map[vOutpoints[i]];
+        entry.coin = Coin(CTxOut(i, CScript() << OP_TRUE), 1, false);
+        entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+    }
+    for (size_t i = 0; i < nHalf; i++) {
+        typename Map::iterator it = map.find(vOutpoints[i]);
+        assert(it != map.end());
+        if (i % 2 == 0)
+            map.erase(it);
+    }
+    for (size_t i = nHalf; i < vOutpoints.size(); i++) {
+        CCoinsCacheEntry& entry = map[vOutpoints[i]];
+        entry.coin = Coin(CTxOut(i, CScript() << OP_TRUE), 2, false);
+        entry.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+    }
+    assert(map.size() == vOutpoints.size() - (nHalf + 1) / 2);
+}
+
+static std::vector<COutPoint> CoinsMapOutpoints()
+{
+    std::vector<COutPoint> vOutpoints;
+    for (int i = 0; i < 20000; i++)
+        vOutpoints.push_back(COutPoint(GetRandHash(), i % 3));
+    return vOutpoints;
+}
+
+static void CCoinsMapPool(benchmark::State& state)
+{
+    const std::vector<COutPoint> vOutpoints = CoinsMapOutpoints();
+    while (state.KeepRunning()) {
+        CCoinsMapMemoryResource resource;
+        CCoinsMap map(0, SaltedOutpointHasher(), CCoinsMap::key_equal(), &resource);
+        CoinsMapChurn(map, vOutpoints);
+    }
+}
+
+static void CCoinsMapHeap(benchmark::State& state)
+{
+    const std::vector<COutPoint> vOutpoints = CoinsMapOutpoints();
+    while (state.KeepRunning()) {
+        std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> map;
+        CoinsMapChurn(map, vOutpoints);
+    }
+}
+
+BENCHMARK(CCoinsMapPool);
+BENCHMARK(CCoinsMapHeap);
@@ -9,6 +9,7 @@
 #include "hash.h"
 #include "uint256.h"
 #include "utiltime.h"
+#include "crypto/muhash.h"
 #include "crypto/ripemd160.h"
 #include "crypto/sha1.h"
 #include "crypto/sha256.h"
@@ -69,6 +70,30 @@ static void SipHash_32b(benchmark::State& state)
     }
 }
 
+// Adding a coin to the UTXO set hash, and its finalization at each block
+static void MuHash(benchmark::State& state)
+{
+    MuHash3072 acc;
+    unsigned char key[32] = {0};
+    uint32_t i = 0;
+    while (state.KeepRunning()) {
+        key[0] = ++i & 0xFF;
+        acc.Insert(key, sizeof(key));
+    }
+}
+
+static void MuHashFinalize(benchmark::State& state)
+{
+    MuHash3072 acc;
+    unsigned char key[32] = {0};
+    acc.Remove(key, sizeof(key));
+    uint256 out;
+    while (state.KeepRunning()) {
+        MuHash3072 copy = acc;
+        copy.Finalize(out);
+    }
+}
+
 BENCHMARK(RIPEMD160);
 BENCHMARK(SHA1);
 BENCHMARK(SHA256);
@@ -76,3 +101,5 @@ BENCHMARK(SHA512);
 
 BENCHMARK(SHA256_32b);
 BENCHMARK(SipHash_32b);
+BENCHMARK(MuHash);
+BENCHMARK(MuHashFinalize);
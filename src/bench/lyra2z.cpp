@@ -0,0 +1,62 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "chainparams.h"
+#include "chainparamsbase.h"
+#include "crypto/Lyra2Z/Lyra2Z.h"
+#include "primitives/block.h"
+#include "validation.h"
+
+// Hashing of pre-MTP block headers, with every implementation of the sponge and on
+// several threads, as done for a headers message
+
+static void Lyra2ZHash(benchmark::State& state, int impl)
+{
+    if (!lyra2z_select(impl))
+        return;
+    CBlockHeader header;
+    header.nTime = SWITCH_TO_MTP_BLOCK_HEADER - 1;
+    while (state.KeepRunning()) {
+        header.GetHash();
+        header.nNonce++;
+    }
+    lyra2z_autodetect();
+}
+
+static void Lyra2ZHashGeneric(benchmark::State& state)
+{
+    Lyra2ZHash(state, LYRA2Z_IMPL_GENERIC);
+}
+
+static void Lyra2ZHashSSE2(benchmark::State& state)
+{
+    Lyra2ZHash(state, LYRA2Z_IMPL_SSE2);
+}
+
+static void Lyra2ZHashAVX2(benchmark::State& state)
+{
+    Lyra2ZHash(state, LYRA2Z_IMPL_AVX2);
+}
+
+static void Lyra2ZHeaders(benchmark::State& state)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    lyra2z_autodetect();
+    std::vector<CBlockHeader> headers(MAX_HEADERS_RESULTS);
+    for (size_t i = 0; i < headers.size(); i++) {
+        headers[i].nTime = SWITCH_TO_MTP_BLOCK_HEADER - 1;
+        headers[i].nNonce = i;
+    }
+    while (state.KeepRunning()) {
+        GetBlockHeaderHashes(headers);
+        for (CBlockHeader& header : headers)
+            header.cachedPoWHash.SetNull();
+    }
+}
+
+BENCHMARK(Lyra2ZHashGeneric);
+BENCHMARK(Lyra2ZHashSSE2);
+BENCHMARK(Lyra2ZHashAVX2);
+BENCHMARK(Lyra2ZHeaders);
@@ -0,0 +1,148 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "crypto/MerkleTreeProof/merkle-tree.hpp"
+#include "crypto/MerkleTreeProof/mtp.h"
+
+extern "C" {
+#include "crypto/MerkleTreeProof/blake2/blake2.h"
+#include "crypto/MerkleTreeProof/opt.h"
+}
+
+#include <assert.h>
+#include <string.h>
+
+// The MTP kernels with every implementation: filling an Argon2 block, hashing it for
+// a Merkle leaf (compute_blake2b) and hashing a pair of Merkle nodes
+
+static void MtpFillBlock(benchmark::State& state, int impl)
+{
+    if (!mtp_impl_select(impl))
+        return;
+    block blocks[3];
+    uint8_t hash_zero[ARGON2_PREHASH_SEED_LENGTH];
+    memset(blocks, 0x5a, sizeof(blocks));
+    memset(hash_zero, 0xa5, sizeof(hash_zero));
+    uint32_t nIndex = 0;
+    while (state.KeepRunning()) {
+        fill_block_mtp(&blocks[0], &blocks[1], &blocks[2], 1, nIndex++, hash_zero);
+    }
+    mtp_autodetect();
+}
+
+static void MtpBlake2b(benchmark::State& state, int impl)
+{
+    if (!mtp_impl_select(impl))
+        return;
+    block leaf;
+    uint8_t nodes[32], digest[16];
+    memset(&leaf, 0x5a, sizeof(leaf));
+    memset(nodes, 0xa5, sizeof(nodes));
+    while (state.KeepRunning()) {
+        blake2b_state ctx;
+        blake2b_init(&ctx, sizeof(digest));
+        blake2b_4r_update(&ctx, &leaf, sizeof(leaf));
+        blake2b_4r_final(&ctx, digest, sizeof(digest));
+        blake2b_init(&ctx, sizeof(digest));
+        blake2b_4r_update(&ctx, nodes, sizeof(nodes));
+        blake2b_4r_final(&ctx, digest, sizeof(digest));
+        leaf.v[0]++;
+    }
+    mtp_autodetect();
+}
+
+// Builds a tree of 64k leaves (the MTP tree has 4M) and checks openings of it together
+static void MtpMerkleTree(benchmark::State& state, int impl)
+{
+    if (!mtp_impl_select(impl))
+        return;
+    std::vector<uint8_t> leaves(MERKLE_TREE_ELEMENT_SIZE_B << 16);
+    for (size_t i = 0; i < leaves.size(); i++)
+        leaves[i] = (uint8_t)(i * 0x9e + (i >> 8));
+    while (state.KeepRunning()) {
+        MerkleTree tree(leaves);
+        MerkleTree::Buffer root = tree.getRoot();
+
+        std::vector<MerkleTree::Elements> proofs;
+        std::vector<MerkleTree::OrderedProof> openings;
+        proofs.reserve(mtp::MTP_L * 3);
+        for (size_t i = 0; i < mtp::MTP_L * 3; i++) {
+            size_t index = (i * 40503) & 0xffff;
+            MerkleTree::Buffer element(&leaves[index * MERKLE_TREE_ELEMENT_SIZE_B],
+                                       &leaves[(index + 1) * MERKLE_TREE_ELEMENT_SIZE_B]);
+            proofs.push_back(tree.getProofOrdered(element, index + 1));
+            openings.push_back({&proofs.back(), element, index + 1});
+        }
+        assert(MerkleTree::checkProofsOrdered(openings, root));
+    }
+    mtp_autodetect();
+}
+
+static void MtpFillBlockRef(benchmark::State& state)
+{
+    MtpFillBlock(state, MTP_IMPL_REF);
+}
+
+static void MtpFillBlockSSE41(benchmark::State& state)
+{
+    MtpFillBlock(state, MTP_IMPL_SSE41);
+}
+
+static void MtpFillBlockAVX2(benchmark::State& state)
+{
+    MtpFillBlock(state, MTP_IMPL_AVX2);
+}
+
+static void MtpFillBlockAVX512(benchmark::State& state)
+{
+    MtpFillBlock(state, MTP_IMPL_AVX512);
+}
+
+static void MtpBlake2bRef(benchmark::State& state)
+{
+    MtpBlake2b(state, MTP_IMPL_REF);
+}
+
+static void MtpBlake2bSSE41(benchmark::State& state)
+{
+    MtpBlake2b(state, MTP_IMPL_SSE41);
+}
+
+static void MtpBlake2bAVX2(benchmark::State& state)
+{
+    MtpBlake2b(state, MTP_IMPL_AVX2);
+}
+
+static void MtpMerkleTreeRef(benchmark::State& state)
+{
+    MtpMerkleTree(state, MTP_IMPL_REF);
+}
+
+static void MtpMerkleTreeSSE41(benchmark::State& state)
+{
+    MtpMerkleTree(state, MTP_IMPL_SSE41);
+}
+
+static void MtpMerkleTreeAVX2(benchmark::State& state)
+{
+    MtpMerkleTree(state, MTP_IMPL_AVX2);
+}
+
+static void MtpMerkleTreeAVX512(benchmark::State& state)
+{
+    MtpMerkleTree(state, MTP_IMPL_AVX512);
+}
+
+BENCHMARK(MtpFillBlockRef);
+BENCHMARK(MtpFillBlockSSE41);
+BENCHMARK(MtpFillBlockAVX2);
+BENCHMARK(MtpFillBlockAVX512);
+BENCHMARK(MtpBlake2bRef);
+BENCHMARK(MtpBlake2bSSE41);
+BENCHMARK(MtpBlake2bAVX2);
+BENCHMARK(MtpMerkleTreeRef);
+BENCHMARK(MtpMerkleTreeSSE41);
+BENCHMARK(MtpMerkleTreeAVX2);
+BENCHMARK(MtpMerkleTreeAVX512);
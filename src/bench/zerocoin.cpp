@@ -0,0 +1,108 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "libzerocoin/Zerocoin.h"
+#include "zerocoin.h"
+
+#include <iostream>
+#include <memory>
+
+// Benchmarks from libzerocoin/Benchmark.cpp, comparing the bignum backend selected at
+// configure time with plain OpenSSL on the operations done verifying zerocoin spends.
+
+static const int ZEROCOIN_BENCH_COINS = 10;
+
+static void ZerocoinPowMod(benchmark::State& state, bool fBackend)
+{
+    const CBigNum& modulus = ZCParamsV2->accumulatorParams.accumulatorModulus;
+    CBigNum base = CBigNum::randBignum(modulus);
+    CBigNum exp = CBigNum::randBignum(ZCParamsV2->coinCommitmentGroup.modulus);
+    CAutoBN_CTX pctx;
+    CBigNum ret;
+    while (state.KeepRunning()) {
+        if (fBackend)
+            bignum_backend::PowMod(&ret, &base, &exp, &modulus, pctx);
+        else
+            bignum_backend::PowModOpenSSL(&ret, &base, &exp, &modulus, pctx);
+    }
+}
+
+static void ZerocoinMultiPowMod(benchmark::State& state, bool fBackend)
+{
+    const CBigNum& modulus = ZCParamsV2->accumulatorParams.accumulatorModulus;
+    std::vector<std::pair<CBigNum, CBigNum>> terms;
+    for (int i = 0; i < 3; i++)
+        terms.emplace_back(CBigNum::randBignum(modulus), CBigNum::randBignum(modulus));
+    std::vector<bignum_backend::PowTerm> backendTerms;
+    for (const auto& term : terms)
+        backendTerms.emplace_back(&term.first, &term.second);
+    CAutoBN_CTX pctx;
+    CBigNum ret;
+    while (state.KeepRunning()) {
+        if (fBackend)
+            bignum_backend::MultiPowMod(&ret, backendTerms, &modulus, pctx);
+        else
+            bignum_backend::MultiPowModOpenSSL(&ret, backendTerms, &modulus, pctx);
+    }
+}
+
+static void ZerocoinPowModOpenSSL(benchmark::State& state)
+{
+    ZerocoinPowMod(state, false);
+}
+
+static void ZerocoinPowModBackend(benchmark::State& state)
+{
+    ZerocoinPowMod(state, true);
+}
+
+static void ZerocoinMultiPowModOpenSSL(benchmark::State& state)
+{
+    ZerocoinMultiPowMod(state, false);
+}
+
+static void ZerocoinMultiPowModBackend(benchmark::State& state)
+{
+    ZerocoinMultiPowMod(state, true);
+}
+
+static void ZerocoinAccumulate(benchmark::State& state)
+{
+    libzerocoin::PrivateCoin coin(ZCParamsV2, libzerocoin::ZQ_LOVELACE, ZEROCOIN_TX_VERSION_2);
+    while (state.KeepRunning()) {
+        libzerocoin::Accumulator acc(&ZCParamsV2->accumulatorParams, libzerocoin::ZQ_LOVELACE);
+        acc += coin.getPublicCoin();
+    }
+}
+
+static void ZerocoinSpendVerify(benchmark::State& state)
+{
+    std::vector<std::unique_ptr<libzerocoin::PrivateCoin>> coins;
+    for (int i = 0; i < ZEROCOIN_BENCH_COINS; i++)
+        coins.emplace_back(new libzerocoin::PrivateCoin(ZCParamsV2, libzerocoin::ZQ_LOVELACE, ZEROCOIN_TX_VERSION_2));
+
+    libzerocoin::Accumulator acc(&ZCParamsV2->accumulatorParams, libzerocoin::ZQ_LOVELACE);
+    libzerocoin::AccumulatorWitness witness(ZCParamsV2, acc, coins[0]->getPublicCoin());
+    for (const auto& coin : coins) {
+        acc += coin->getPublicCoin();
+        witness += coin->getPublicCoin();
+    }
+
+    libzerocoin::SpendMetaData metaData(0, uint256());
+    libzerocoin::CoinSpend spend(ZCParamsV2, *coins[0], acc, witness, metaData);
+    bool fValid = true;
+    while (state.KeepRunning()) {
+        fValid &= spend.Verify(acc, metaData);
+    }
+    if (!fValid)
+        std::cerr << "ZerocoinSpendVerify: spend failed to verify" << std::endl;
+}
+
+BENCHMARK(ZerocoinPowModOpenSSL);
+BENCHMARK(ZerocoinPowModBackend);
+BENCHMARK(ZerocoinMultiPowModOpenSSL);
+BENCHMARK(ZerocoinMultiPowModBackend);
+BENCHMARK(ZerocoinAccumulate);
+BENCHMARK(ZerocoinSpendVerify);
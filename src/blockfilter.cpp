@@ -0,0 +1,322 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilter.h"
+
+#include "coins.h"
+#include "hash.h"
+#include "primitives/block.h"
+#include "script/script.h"
+#include "streams.h"
+#include "undo.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <map>
+#include <stdexcept>
+
+/// SerType used to serialize parameters in GCS filter encoding.
+static const int GCS_SER_TYPE = SER_NETWORK;
+
+/// Protocol version used to serialize parameters in GCS filter encoding.
+static const int GCS_SER_VERSION = 0;
+
+//! Marker of the Elysium payloads, the first bytes of the first push of their OP_RETURN outputs
+static const unsigned char ELYSIUM_MARKER[] = { 0x65, 0x78, 0x6f, 0x64, 0x75, 0x73 };
+
+static const std::map<BlockFilterType, std::string> mapFilterTypeNames = {
+    {BlockFilterType::BASIC_FILTER, "basic"},
+};
+
+template <typename OStream>
+static void GolombRiceEncode(BitStreamWriter<OStream>& bitwriter, uint8_t nP, uint64_t x)
+{
+    // Write quotient as unary-encoded: q 1's followed by one 0.
+    uint64_t q = x >> nP;
+    while (q > 0) {
+        int nbits = q <= 64 ? static_cast<int>(q) : 64;
+        bitwriter.Write(~0ULL, nbits);
+        q -= nbits;
+    }
+    bitwriter.Write(0, 1);
+
+    // Write the remainder in P bits. Since the remainder is just the bottom
+    // P bits of x, there is no need to mask first.
+    bitwriter.Write(x, nP);
+}
+
+template <typename IStream>
+static uint64_t GolombRiceDecode(BitStreamReader<IStream>& bitreader, uint8_t nP)
+{
+    // Read unary-encoded quotient: q 1's followed by one 0.
+    uint64_t q = 0;
+    while (bitreader.Read(1) == 1) {
+        ++q;
+    }
+
+    uint64_t r = bitreader.Read(nP);
+
+    return (q << nP) + r;
+}
+
+// Map a value x that is uniformly distributed in the range [0, 2^64) to a
+// value uniformly distributed in [0, n) by returning the upper 64 bits of
+// x * n.
+//
+// See: https://lemire.me/blog/2016/06/27/a-fast-alternative-to-the-modulo-reduction/
+static uint64_t MapIntoRange(uint64_t x, uint64_t n)
+{
+#ifdef __SIZEOF_INT128__
+    return (static_cast<unsigned __int128>(x) * static_cast<unsigned __int128>(n)) >> 64;
+#else
+    // To perform the calculation on 64-bit numbers without losing the
+    // result to overflow, split the numbers into the most significant and
+    // least significant 32 bits and perform multiplication piece-wise.
+    //
+    // See: https://stackoverflow.com/a/26855440
+    uint64_t x_hi = x >> 32;
+    uint64_t x_lo = x & 0xFFFFFFFF;
+    uint64_t n_hi = n >> 32;
+    uint64_t n_lo = n & 0xFFFFFFFF;
+
+    uint64_t ac = x_hi * n_hi;
+    uint64_t ad = x_hi * n_lo;
+    uint64_t bc = x_lo * n_hi;
+    uint64_t bd = x_lo * n_lo;
+
+    uint64_t mid34 = (bd >> 32) + (bc & 0xFFFFFFFF) + (ad & 0xFFFFFFFF);
+    uint64_t upper64 = ac + (bc >> 32) + (ad >> 32) + (mid34 >> 32);
+    return upper64;
+#endif
+}
+
+uint64_t GCSFilter::HashToRange(const Element& element) const
+{
+    uint64_t hash = CSipHasher(params.nSipHashK0, params.nSipHashK1)
+        .Write(element.data(), element.size())
+        .Finalize();
+    return MapIntoRange(hash, nF);
+}
+
+std::vector<uint64_t> GCSFilter::BuildHashedSet(const ElementSet& elements) const
+{
+    std::vector<uint64_t> hashedElements;
+    hashedElements.reserve(elements.size());
+    for (const Element& element : elements) {
+        hashedElements.push_back(HashToRange(element));
+    }
+    std::sort(hashedElements.begin(), hashedElements.end());
+    return hashedElements;
+}
+
+GCSFilter::GCSFilter(const Params& paramsIn)
+    : params(paramsIn), nN(0), nF(0), vchEncoded(1, 0)
+{}
+
+GCSFilter::GCSFilter(const Params& paramsIn, const std::vector<unsigned char>& vchEncodedIn)
+    : params(paramsIn), vchEncoded(vchEncodedIn)
+{
+    VectorReader stream(GCS_SER_TYPE, GCS_SER_VERSION, vchEncoded, 0);
+
+    uint64_t nElements = ReadCompactSize(stream);
+    nN = static_cast<uint32_t>(nElements);
+    if (nN != nElements) {
+        throw std::ios_base::failure("N must be <2^32");
+    }
+    nF = static_cast<uint64_t>(nN) * static_cast<uint64_t>(params.nM);
+
+    // Verify that the encoded filter contains exactly N elements. If it has too much or too little
+    // data, a std::ios_base::failure exception will be raised.
+    BitStreamReader<VectorReader> bitreader(stream);
+    for (uint64_t i = 0; i < nN; ++i) {
+        GolombRiceDecode(bitreader, params.nP);
+    }
+    if (!stream.empty()) {
+        throw std::ios_base::failure("encoded_filter contains excess data");
+    }
+}
+
+GCSFilter::GCSFilter(const Params& paramsIn, const ElementSet& elements)
+    : params(paramsIn)
+{
+    size_t nElements = elements.size();
+    nN = static_cast<uint32_t>(nElements);
+    if (nN != nElements) {
+        throw std::invalid_argument("N must be <2^32");
+    }
+    nF = static_cast<uint64_t>(nN) * static_cast<uint64_t>(params.nM);
+
+    CVectorWriter stream(GCS_SER_TYPE, GCS_SER_VERSION, vchEncoded, 0);
+
+    WriteCompactSize(stream, nN);
+
+    if (elements.empty()) {
+        return;
+    }
+
+    BitStreamWriter<CVectorWriter> bitwriter(stream);
+
+    uint64_t nLastValue = 0;
+    for (uint64_t value : BuildHashedSet(elements)) {
+        uint64_t delta = value - nLastValue;
+        GolombRiceEncode(bitwriter, params.nP, delta);
+        nLastValue = value;
+    }
+
+    bitwriter.Flush();
+}
+
+bool GCSFilter::MatchInternal(const uint64_t* elementHashes, size_t size) const
+{
+    VectorReader stream(GCS_SER_TYPE, GCS_SER_VERSION, vchEncoded, 0);
+
+    // Seek forward by size of N
+    uint64_t nElements = ReadCompactSize(stream);
+    assert(nElements == nN);
+
+    BitStreamReader<VectorReader> bitreader(stream);
+
+    uint64_t nValue = 0;
+    size_t nHashesIndex = 0;
+    for (uint32_t i = 0; i < nN; ++i) {
+        uint64_t delta = GolombRiceDecode(bitreader, params.nP);
+        nValue += delta;
+
+        while (true) {
+            if (nHashesIndex == size) {
+                return false;
+            } else if (elementHashes[nHashesIndex] == nValue) {
+                return true;
+            } else if (elementHashes[nHashesIndex] > nValue) {
+                break;
+            }
+
+            nHashesIndex++;
+        }
+    }
+
+    return false;
+}
+
+bool GCSFilter::Match(const Element& element) const
+{
+    uint64_t query = HashToRange(element);
+    return MatchInternal(&query, 1);
+}
+
+bool GCSFilter::MatchAny(const ElementSet& elements) const
+{
+    const std::vector<uint64_t> queries = BuildHashedSet(elements);
+    return MatchInternal(queries.data(), queries.size());
+}
+
+const std::string& BlockFilterTypeName(BlockFilterType filterType)
+{
+    static std::string unknownRetval = "";
+    auto it = mapFilterTypeNames.find(filterType);
+    return it != mapFilterTypeNames.end() ? it->second : unknownRetval;
+}
+
+bool BlockFilterTypeByName(const std::string& name, BlockFilterType& filterType)
+{
+    for (const auto& entry : mapFilterTypeNames) {
+        if (entry.second == name) {
+            filterType = entry.first;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void AddScriptElements(const CScript& script, GCSFilter::ElementSet& elements)
+{
+    if (script.empty())
+        return;
+
+    if (script[0] == OP_RETURN) {
+        CScript::const_iterator pc = script.begin() + 1;
+        opcodetype opcode;
+        std::vector<unsigned char> vchPush;
+        if (script.GetOp(pc, opcode, vchPush) && vchPush.size() >= sizeof(ELYSIUM_MARKER)
+                && std::equal(ELYSIUM_MARKER, ELYSIUM_MARKER + sizeof(ELYSIUM_MARKER), vchPush.begin()))
+            elements.emplace(ELYSIUM_MARKER, ELYSIUM_MARKER + sizeof(ELYSIUM_MARKER));
+        return;
+    }
+
+    if (script.IsSigmaMint()) {
+        // The serialized public coin follows the opcode
+        elements.emplace(script.begin() + 1, script.end());
+        return;
+    }
+
+    elements.emplace(script.begin(), script.end());
+}
+
+GCSFilter::ElementSet BasicFilterElements(const CBlock& block, const CBlockUndo& blockUndo)
+{
+    GCSFilter::ElementSet elements;
+
+    for (const CTransactionRef& tx : block.vtx) {
+        for (const CTxOut& txout : tx->vout) {
+            AddScriptElements(txout.scriptPubKey, elements);
+        }
+    }
+
+    for (const CTxUndo& txUndo : blockUndo.vtxundo) {
+        for (const Coin& prevout : txUndo.vprevout) {
+            AddScriptElements(prevout.out.scriptPubKey, elements);
+        }
+    }
+
+    return elements;
+}
+
+BlockFilter::BlockFilter(BlockFilterType filterTypeIn, const uint256& hashBlockIn, const std::vector<unsigned char>& vchFilter)
+    : filterType(filterTypeIn), hashBlock(hashBlockIn)
+{
+    GCSFilter::Params params;
+    if (!BuildParams(params)) {
+        throw std::invalid_argument("unknown filter_type");
+    }
+    filter = GCSFilter(params, vchFilter);
+}
+
+BlockFilter::BlockFilter(BlockFilterType filterTypeIn, const CBlock& block, const CBlockUndo& blockUndo)
+    : filterType(filterTypeIn), hashBlock(block.GetHash())
+{
+    GCSFilter::Params params;
+    if (!BuildParams(params)) {
+        throw std::invalid_argument("unknown filter_type");
+    }
+    filter = GCSFilter(params, BasicFilterElements(block, blockUndo));
+}
+
+bool BlockFilter::BuildParams(GCSFilter::Params& params) const
+{
+    switch (filterType) {
+    case BlockFilterType::BASIC_FILTER:
+        params.nSipHashK0 = hashBlock.GetUint64(0);
+        params.nSipHashK1 = hashBlock.GetUint64(1);
+        params.nP = BASIC_FILTER_P;
+        params.nM = BASIC_FILTER_M;
+        return true;
+    case BlockFilterType::INVALID:
+        return false;
+    }
+
+    return false;
+}
+
+uint256 BlockFilter::GetHash() const
+{
+    const std::vector<unsigned char>& data = GetEncodedFilter();
+    return Hash(data.begin(), data.end());
+}
+
+uint256 BlockFilter::ComputeHeader(const uint256& prevHeader) const
+{
+    const uint256& filterHash = GetHash();
+    return Hash(filterHash.begin(), filterHash.end(), prevHeader.begin(), prevHeader.end());
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilterindex.h"
+
+#include "blockfilter.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "hash.h"
+#include "init.h"
+#include "txdb.h"
+#include "undo.h"
+#include "util.h"
+#include "validation.h"
+
+namespace {
+
+//! Block and header of the last filter indexed, so the filter of the next block is chained to it without reading it back
+uint256 hashLastIndexed;
+uint256 headerLastIndexed;
+
+//! The header of the filter of the parent of pindex, if it is indexed
+bool GetPrevFilterHeader(const CBlockIndex* pindex, uint256& header)
+{
+    AssertLockHeld(cs_main);
+    if (!pindex->pprev) {
+        header.SetNull();
+        return true;
+    }
+    if (hashLastIndexed == pindex->pprev->GetBlockHash()) {
+        header = headerLastIndexed;
+        return true;
+    }
+    return LookupBlockFilterHeader(pindex->pprev, header);
+}
+
+bool WriteBlockFilter(const BlockFilter& filter, const uint256& prevHeader)
+{
+    AssertLockHeld(cs_main);
+    CBlockFilterIndexValue value;
+    value.vchFilter = filter.GetEncodedFilter();
+    value.hashFilter = filter.GetHash();
+    value.header = Hash(value.hashFilter.begin(), value.hashFilter.end(), prevHeader.begin(), prevHeader.end());
+    if (!pblocktree->WriteBlockFilter(filter.GetBlockHash(), value))
+        return false;
+
+    hashLastIndexed = filter.GetBlockHash();
+    headerLastIndexed = value.header;
+    return true;
+}
+
+} // anon namespace
+
+bool IndexBlockFilter(const CBlock& block, const CBlockUndo& blockUndo, const CBlockIndex* pindex)
+{
+    AssertLockHeld(cs_main);
+    // The blocks above the last one indexed are left to BuildBlockFilterIndex until it has caught up
+    uint256 prevHeader;
+    if (!GetPrevFilterHeader(pindex, prevHeader))
+        return true;
+
+    return WriteBlockFilter(BlockFilter(BlockFilterType::BASIC_FILTER, block, blockUndo), prevHeader);
+}
+
+void BuildBlockFilterIndex()
+{
+    if (!fBlockFilterIndex)
+        return;
+
+    const CBlockIndex *pindex;
+    {
+        LOCK(cs_main);
+        // The filters are indexed from the genesis block on, so the ones missing are above the
+        // last block of the chain with a filter
+        const CBlockIndex *pindexIndexed = chainActive.Tip();
+        while (pindexIndexed && !pblocktree->HaveBlockFilter(pindexIndexed->GetBlockHash()))
+            pindexIndexed = pindexIndexed->pprev;
+        if (pindexIndexed == chainActive.Tip())
+            return;
+        pindex = pindexIndexed ? chainActive.Next(pindexIndexed) : chainActive.Genesis();
+    }
+
+    LogPrintf("Building the block filter index from height %d...\n", pindex->nHeight);
+    int nIndexed = 0;
+    // Blocks are read and their filters built without holding cs_main, the ones disconnected
+    // meanwhile are skipped and the ones connected meanwhile are indexed by ConnectBlock once
+    // this has caught up
+    while (pindex) {
+        if (ShutdownRequested())
+            return;
+
+        CDiskBlockPos undoPos;
+        {
+            LOCK(cs_main);
+            if (!(pindex->nStatus & BLOCK_HAVE_DATA) || (pindex->pprev && !(pindex->nStatus & BLOCK_HAVE_UNDO))) {
+                LogPrintf("%s: block at height %d isn't available, the index can't be built on a pruned node\n", __func__, pindex->nHeight);
+                return;
+            }
+            undoPos = pindex->GetUndoPos();
+        }
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, ::Params().GetConsensus())) {
+            LogPrintf("%s: can't read block at height %d from disk.\n", __func__, pindex->nHeight);
+            return;
+        }
+        CBlockUndo blockUndo;
+        if (pindex->pprev && !UndoReadFromDisk(blockUndo, undoPos, pindex->pprev->GetBlockHash())) {
+            LogPrintf("%s: can't read undo data of block at height %d from disk.\n", __func__, pindex->nHeight);
+            return;
+        }
+        BlockFilter filter(BlockFilterType::BASIC_FILTER, block, blockUndo);
+
+        LOCK(cs_main);
+        if (!chainActive.Contains(pindex)) {
+            pindex = chainActive.FindFork(pindex);
+        } else {
+            uint256 prevHeader;
+            if (!GetPrevFilterHeader(pindex, prevHeader) || !WriteBlockFilter(filter, prevHeader)) {
+                LogPrintf("%s: failed to write the block filter index\n", __func__);
+                return;
+            }
+            nIndexed++;
+        }
+
+        if (pindex == chainActive.Tip())
+            break;
+        pindex = chainActive.Next(pindex);
+    }
+    LogPrintf("Block filter index built, %d blocks indexed\n", nIndexed);
+}
+
+bool LookupBlockFilter(const CBlockIndex* pindex, BlockFilter& filter)
+{
+    CBlockFilterIndexValue value;
+    if (!pblocktree->ReadBlockFilter(pindex->GetBlockHash(), value))
+        return false;
+
+    try {
+        filter = BlockFilter(BlockFilterType::BASIC_FILTER, pindex->GetBlockHash(), value.vchFilter);
+    } catch (const std::exception& e) {
+        return error("%s: invalid filter of block %s: %s", __func__, pindex->GetBlockHash().ToString(), e.what());
+    }
+    return true;
+}
+
+bool LookupBlockFilterHeader(const CBlockIndex* pindex, uint256& header)
+{
+    CBlockFilterIndexValue value;
+    if (!pblocktree->ReadBlockFilter(pindex->GetBlockHash(), value))
+        return false;
+
+    header = value.header;
+    return true;
+}
+
+bool LookupBlockFilterRange(int nStartHeight, const CBlockIndex* pindexStop, std::vector<BlockFilter>& filters)
+{
+    if (nStartHeight < 0 || nStartHeight > pindexStop->nHeight)
+        return false;
+
+    filters.resize(pindexStop->nHeight - nStartHeight + 1);
+    for (const CBlockIndex* pindex = pindexStop; pindex && pindex->nHeight >= nStartHeight; pindex = pindex->pprev) {
+        if (!LookupBlockFilter(pindex, filters[pindex->nHeight - nStartHeight]))
+            return false;
+    }
+    return true;
+}
+
+bool LookupBlockFilterHashRange(int nStartHeight, const CBlockIndex* pindexStop, std::vector<uint256>& hashes)
+{
+    if (nStartHeight < 0 || nStartHeight > pindexStop->nHeight)
+        return false;
+
+    hashes.resize(pindexStop->nHeight - nStartHeight + 1);
+    for (const CBlockIndex* pindex = pindexStop; pindex && pindex->nHeight >= nStartHeight; pindex = pindex->pprev) {
+        CBlockFilterIndexValue value;
+        if (!pblocktree->ReadBlockFilter(pindex->GetBlockHash(), value))
+            return false;
+        hashes[pindex->nHeight - nStartHeight] = value.hashFilter;
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKFILTERINDEX_H
+#define BITCOIN_BLOCKFILTERINDEX_H
+
+#include "serialize.h"
+#include "uint256.h"
+
+#include <vector>
+
+class BlockFilter;
+class CBlock;
+class CBlockIndex;
+class CBlockUndo;
+
+/** Maximum number of filters or filter headers served for a single request (BIP 157) */
+static const int MAX_BLOCKFILTERS_PER_REQUEST = 1000;
+static const int MAX_BLOCKFILTER_HEADERS_PER_REQUEST = 2000;
+/** Interval of the filter headers checkpoints served for "getcfcheckpt" */
+static const int BLOCKFILTER_CHECKPOINT_INTERVAL = 1000;
+
+/** The basic filter of a block with its hash and header, keyed by the block hash */
+struct CBlockFilterIndexValue {
+    std::vector<unsigned char> vchFilter;
+    uint256 hashFilter;
+    uint256 header;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(vchFilter);
+        READWRITE(hashFilter);
+        READWRITE(header);
+    }
+};
+
+/**
+ * Index the basic filter of a block connected to the chain, once the filter of
+ * its parent is indexed. The filters of the blocks connected before the index
+ * was enabled are indexed by BuildBlockFilterIndex.
+ */
+bool IndexBlockFilter(const CBlock& block, const CBlockUndo& blockUndo, const CBlockIndex* pindex);
+
+/** Index the filters of the blocks of chainActive which aren't indexed yet, reading them without holding cs_main */
+void BuildBlockFilterIndex();
+
+/** The basic filter of a block, if it is indexed */
+bool LookupBlockFilter(const CBlockIndex* pindex, BlockFilter& filter);
+
+/** The basic filter header of a block, if its filter is indexed */
+bool LookupBlockFilterHeader(const CBlockIndex* pindex, uint256& header);
+
+/** The basic filters of the blocks from nStartHeight up to pindexStop, on the chain of pindexStop */
+bool LookupBlockFilterRange(int nStartHeight, const CBlockIndex* pindexStop, std::vector<BlockFilter>& filters);
+
+/** The basic filter hashes of the blocks from nStartHeight up to pindexStop, on the chain of pindexStop */
+bool LookupBlockFilterHashRange(int nStartHeight, const CBlockIndex* pindexStop, std::vector<uint256>& hashes);
+
+#endif // BITCOIN_BLOCKFILTERINDEX_H
@@ -0,0 +1,178 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockindexfile.h"
+
+#include "chain.h"
+#include "crypto/common.h"
+#include "util.h"
+
+#include <cstring>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/thread.hpp>
+
+namespace {
+
+const unsigned char BLOCK_INDEX_FILE_MAGIC[4] = {'t', 'b', 'i', 'x'};
+const uint32_t BLOCK_INDEX_FILE_VERSION = 1;
+
+void WriteHash(unsigned char*& ptr, const uint256& hash)
+{
+    memcpy(ptr, hash.begin(), 32);
+    ptr += 32;
+}
+
+void WriteUInt(unsigned char*& ptr, uint32_t n)
+{
+    WriteLE32(ptr, n);
+    ptr += 4;
+}
+
+uint256 ReadHash(const unsigned char*& ptr)
+{
+    uint256 hash;
+    memcpy(hash.begin(), ptr, 32);
+    ptr += 32;
+    return hash;
+}
+
+uint32_t ReadUInt(const unsigned char*& ptr)
+{
+    uint32_t n = ReadLE32(ptr);
+    ptr += 4;
+    return n;
+}
+
+} // anon namespace
+
+bool CBlockIndexFile::HasExtendedData(const CBlockIndex& index)
+{
+    return !index.mintedPubCoins.empty() || !index.accumulatorChanges.empty() || !index.spentSerials.empty() ||
+           !index.sigmaMintedPubCoins.empty() || !index.sigmaSpentSerials.empty() ||
+           !index.lelantusMintedPubCoins.empty() || !index.lelantusSpentSerials.empty() ||
+           !index.activeDisablingSporks.empty();
+}
+
+bool CBlockIndexFile::Write(const std::vector<const CBlockIndex*>& vpindex, const uint256& token) const
+{
+    boost::filesystem::path pathTmp = path;
+    pathTmp += ".new";
+
+    FILE* file = fopen(pathTmp.string().c_str(), "wb");
+    if (!file)
+        return error("%s: failed to open %s", __func__, pathTmp.string());
+
+    std::vector<unsigned char> buf(HEADER_SIZE);
+    unsigned char* ptr = buf.data();
+    memcpy(ptr, BLOCK_INDEX_FILE_MAGIC, 4);
+    ptr += 4;
+    WriteUInt(ptr, BLOCK_INDEX_FILE_VERSION);
+    WriteLE64(ptr, vpindex.size());
+    ptr += 8;
+    WriteHash(ptr, token);
+    bool fOk = fwrite(buf.data(), 1, buf.size(), file) == buf.size();
+
+    // Records are written in chunks of a few thousand
+    const size_t nChunk = 4096;
+    for (size_t i = 0; fOk && i < vpindex.size(); i += nChunk) {
+        size_t nCount = std::min(nChunk, vpindex.size() - i);
+        buf.assign(nCount * RECORD_SIZE, 0);
+        for (size_t j = 0; j < nCount; j++) {
+            const CBlockIndex& index = *vpindex[i + j];
+            ptr = buf.data() + j * RECORD_SIZE;
+            WriteHash(ptr, index.GetBlockHash());
+            WriteHash(ptr, index.pprev ? index.pprev->GetBlockHash() : uint256());
+            WriteHash(ptr, index.hashMerkleRoot);
+            WriteHash(ptr, index.mtpHashValue);
+            WriteHash(ptr, index.reserved[0]);
+            WriteHash(ptr, index.reserved[1]);
+            WriteUInt(ptr, index.nHeight);
+            WriteUInt(ptr, index.nStatus);
+            WriteUInt(ptr, index.nTx);
+            WriteUInt(ptr, index.nFile);
+            WriteUInt(ptr, index.nDataPos);
+            WriteUInt(ptr, index.nUndoPos);
+            WriteUInt(ptr, index.nVersion);
+            WriteUInt(ptr, index.nTime);
+            WriteUInt(ptr, index.nBits);
+            WriteUInt(ptr, index.nNonce);
+            WriteUInt(ptr, index.nVersionMTP);
+            WriteUInt(ptr, HasExtendedData(index) ? RECORD_HAS_EXTENDED : 0);
+        }
+        fOk = fwrite(buf.data(), 1, buf.size(), file) == buf.size();
+    }
+
+    if (fOk)
+        FileCommit(file);
+    fclose(file);
+    if (!fOk || !RenameOver(pathTmp, path)) {
+        boost::filesystem::remove(pathTmp);
+        return error("%s: failed to write %s", __func__, path.string());
+    }
+    return true;
+}
+
+bool CBlockIndexFile::Load(const uint256& token, boost::function<CBlockIndex*(const uint256&)> insertBlockIndex,
+                           std::vector<CBlockIndex*>& vExtended) const
+{
+    namespace bip = boost::interprocess;
+
+    if (!boost::filesystem::exists(path))
+        return false;
+
+    try {
+        bip::file_mapping mapping(path.string().c_str(), bip::read_only);
+        bip::mapped_region region(mapping, bip::read_only);
+        const unsigned char* ptr = static_cast<const unsigned char*>(region.get_address());
+        const size_t nSize = region.get_size();
+
+        // Validate the whole file before inserting anything
+        if (nSize < HEADER_SIZE || memcmp(ptr, BLOCK_INDEX_FILE_MAGIC, 4) != 0)
+            return error("%s: %s is not a block index file", __func__, path.string());
+        ptr += 4;
+        if (ReadUInt(ptr) != BLOCK_INDEX_FILE_VERSION)
+            return false;
+        uint64_t nCount = ReadLE64(ptr);
+        ptr += 8;
+        if (ReadHash(ptr) != token) {
+            LogPrintf("%s: %s is out of date\n", __func__, path.string());
+            return false;
+        }
+        if (nSize != HEADER_SIZE + nCount * RECORD_SIZE)
+            return error("%s: %s has an unexpected size", __func__, path.string());
+
+        for (uint64_t i = 0; i < nCount; i++) {
+            if (i % 8192 == 0)
+                boost::this_thread::interruption_point();
+
+            CBlockIndex* pindexNew       = insertBlockIndex(ReadHash(ptr));
+            uint256 hashPrev             = ReadHash(ptr);
+            pindexNew->pprev             = hashPrev.IsNull() ? NULL : insertBlockIndex(hashPrev);
+            pindexNew->hashMerkleRoot    = ReadHash(ptr);
+            pindexNew->mtpHashValue      = ReadHash(ptr);
+            pindexNew->reserved[0]       = ReadHash(ptr);
+            pindexNew->reserved[1]       = ReadHash(ptr);
+            pindexNew->nHeight           = ReadUInt(ptr);
+            pindexNew->nStatus           = ReadUInt(ptr);
+            pindexNew->nTx               = ReadUInt(ptr);
+            pindexNew->nFile             = ReadUInt(ptr);
+            pindexNew->nDataPos          = ReadUInt(ptr);
+            pindexNew->nUndoPos          = ReadUInt(ptr);
+            pindexNew->nVersion          = ReadUInt(ptr);
+            pindexNew->nTime             = ReadUInt(ptr);
+            pindexNew->nBits             = ReadUInt(ptr);
+            pindexNew->nNonce            = ReadUInt(ptr);
+            pindexNew->nVersionMTP       = ReadUInt(ptr);
+            if (ReadUInt(ptr) & RECORD_HAS_EXTENDED)
+                vExtended.push_back(pindexNew);
+        }
+    } catch (const bip::interprocess_exception& e) {
+        return error("%s: failed to map %s: %s", __func__, path.string(), e.what());
+    }
+
+    return true;
+}
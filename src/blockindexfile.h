@@ -0,0 +1,59 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKINDEXFILE_H
+#define BITCOIN_BLOCKINDEXFILE_H
+
+#include "uint256.h"
+
+#include <vector>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/function.hpp>
+
+class CBlockIndex;
+
+/** Default for -blockindexfile, load the block index from the flat block index file */
+static const bool DEFAULT_BLOCK_INDEX_FILE = true;
+
+/**
+ * Flat file holding a fixed-width record with the header and position fields of every block
+ * index entry. It is memory mapped on startup, which avoids iterating the block tree database
+ * and recomputing the Lyra2Z/MTP hashes of all headers. Entries also having sigma, zerocoin,
+ * lelantus or spork data are flagged, their variable-size fields are kept in the database only.
+ *
+ * The file is written on shutdown together with a token stored in the block tree database.
+ * Every later write of block index entries erases that token, so a file which is out of date
+ * is never used.
+ */
+class CBlockIndexFile
+{
+public:
+    //! The entry has data stored only in the block tree database
+    static const uint32_t RECORD_HAS_EXTENDED = 1;
+
+    static const size_t HEADER_SIZE = 48;
+    static const size_t RECORD_SIZE = 240;
+
+    explicit CBlockIndexFile(const boost::filesystem::path& pathIn) : path(pathIn) {}
+
+    /** Write all given entries, the file is replaced atomically. */
+    bool Write(const std::vector<const CBlockIndex*>& vpindex, const uint256& token) const;
+
+    /**
+     * Load all entries if the file exists and was written with the given token. Entries
+     * flagged with RECORD_HAS_EXTENDED are returned in vExtended. Nothing is inserted
+     * if the file can't be used.
+     */
+    bool Load(const uint256& token, boost::function<CBlockIndex*(const uint256&)> insertBlockIndex,
+              std::vector<CBlockIndex*>& vExtended) const;
+
+    /** Whether the entry has fields not stored in the flat file. */
+    static bool HasExtendedData(const CBlockIndex& index);
+
+private:
+    const boost::filesystem::path path;
+};
+
+#endif // BITCOIN_BLOCKINDEXFILE_H
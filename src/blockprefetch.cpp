@@ -0,0 +1,132 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockprefetch.h"
+
+#include "clientversion.h"
+#include "ctpl.h"
+#include "streams.h"
+#include "util.h"
+#include "utiltime.h"
+#include "validation.h"
+
+#include <climits>
+
+std::unique_ptr<CBlockPrefetcher> g_blockprefetcher;
+
+CBlockPrefetcher::CBlockPrefetcher(const Consensus::Params& consensusParamsIn, int nThreads, int nMaxBlocksIn) :
+    consensusParams(consensusParamsIn),
+    nMaxBlocks(nMaxBlocksIn),
+    workerPool(new ctpl::thread_pool(std::max(nThreads, 1))),
+    nStartTime(GetTimeMillis()),
+    nLastReportTime(nStartTime),
+    nConnected(0)
+{
+    RenameThreadPool(*workerPool, "bitcoin-prefetch");
+}
+
+CBlockPrefetcher::~CBlockPrefetcher()
+{
+    // Let the workers finish whatever they are reading, nobody waits for the results any more
+    workerPool->stop(true);
+}
+
+void CBlockPrefetcher::Prefetch(const std::vector<const CBlockIndex*>& vpindex)
+{
+    AssertLockHeld(cs_main);
+    LOCK(cs);
+    for (const CBlockIndex* pindex : vpindex) {
+        if ((int)mapInFlight.size() >= nMaxBlocks)
+            break;
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA))
+            break;
+        if (mapInFlight.count(pindex))
+            continue;
+
+        // Capture everything needed from the index now, workers don't take cs_main
+        const uint256 hash = pindex->GetBlockHash();
+        const CDiskBlockPos pos = pindex->GetBlockPos();
+        const int nHeight = pindex->nHeight;
+        const Consensus::Params& params = consensusParams;
+        std::future<BlockRef> result = workerPool->push([pos, nHeight, hash, &params](int) -> BlockRef {
+            std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+            if (!ReadBlockFromDisk(*pblock, pos, nHeight, params) || pblock->GetHash() != hash)
+                return nullptr;
+            return pblock;
+        });
+        mapInFlight.emplace(pindex, result.share());
+    }
+}
+
+CBlockPrefetcher::BlockRef CBlockPrefetcher::Take(const CBlockIndex* pindex)
+{
+    std::shared_future<BlockRef> result;
+    {
+        LOCK(cs);
+        auto it = mapInFlight.find(pindex);
+        if (it == mapInFlight.end())
+            return nullptr;
+        result = it->second;
+        mapInFlight.erase(it);
+    }
+    return result.get();
+}
+
+void CBlockPrefetcher::Forget(const CBlockIndex* pindex)
+{
+    LOCK(cs);
+    mapInFlight.erase(pindex);
+}
+
+void CBlockPrefetcher::Prune(const CBlockIndex* pindexTip, const CBlockIndex* pindexTarget)
+{
+    AssertLockHeld(cs_main);
+    LOCK(cs);
+    const int nTipHeight = pindexTip ? pindexTip->nHeight : -1;
+    for (auto it = mapInFlight.begin(); it != mapInFlight.end(); ) {
+        const CBlockIndex* pindex = it->first;
+        // The workers finish reading a dropped block, the result is just not kept
+        if (pindex->nHeight <= nTipHeight || pindexTarget->GetAncestor(pindex->nHeight) != pindex)
+            it = mapInFlight.erase(it);
+        else
+            ++it;
+    }
+}
+
+std::future<CBlockPrefetcher::ParsedBlock> CBlockPrefetcher::Deserialize(std::vector<char>&& vBlockData)
+{
+    return workerPool->push([data = std::move(vBlockData)](int) -> ParsedBlock {
+        std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+        try {
+            CDataStream ssBlock(data.data(), data.data() + data.size(), SER_DISK, CLIENT_VERSION);
+            ssBlock >> *pblock;
+        } catch (const std::exception& e) {
+            LogPrintf("%s: Deserialize error - %s\n", __func__, e.what());
+            return ParsedBlock(nullptr, uint256());
+        }
+        // Both are Lyra2Z hashes of the header, the proof of work hash is cached in the block
+        pblock->GetPoWHash(INT_MAX);
+        uint256 hash = pblock->GetHash();
+        return ParsedBlock(pblock, hash);
+    });
+}
+
+size_t CBlockPrefetcher::InFlight()
+{
+    LOCK(cs);
+    return mapInFlight.size();
+}
+
+void CBlockPrefetcher::BlockConnected(const CBlockIndex* pindex)
+{
+    LOCK(cs);
+    nConnected++;
+
+    int64_t nNow = GetTimeMillis();
+    if (nNow - nLastReportTime < 30 * 1000)
+        return;
+    nLastReportTime = nNow;
+    LogPrintf("Import progress: height=%d, %d blocks connected at %.2f blocks/s, %u blocks prefetched\n",
+              pindex->nHeight, nConnected, 1000.0 * nConnected / std::max(nNow - nStartTime, (int64_t)1), mapInFlight.size());
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKPREFETCH_H
+#define BITCOIN_BLOCKPREFETCH_H
+
+#include "chain.h"
+#include "primitives/block.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <future>
+#include <utility>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace ctpl {
+    class thread_pool;
+}
+
+namespace Consensus {
+    struct Params;
+}
+
+/** Default for -prefetchblocks, number of blocks read ahead of the tip while importing or reindexing */
+static const int DEFAULT_PREFETCH_BLOCKS = 64;
+
+/**
+ * Loads and deserializes blocks on a pool of worker threads ahead of the time they are
+ * connected. Deserialization of TecraCoin blocks (MTP proof data, sigma spends) and the
+ * proof of work checks done while reading them are expensive, so during -reindex and
+ * -reindex-chainstate they are taken off the critical path of ConnectTip.
+ */
+class CBlockPrefetcher
+{
+public:
+    typedef std::shared_ptr<const CBlock> BlockRef;
+    //! A deserialized block together with its (Lyra2Z) hash
+    typedef std::pair<std::shared_ptr<CBlock>, uint256> ParsedBlock;
+
+    CBlockPrefetcher(const Consensus::Params& consensusParams, int nThreads, int nMaxBlocksIn);
+    ~CBlockPrefetcher();
+
+    /**
+     * Start reading the given blocks, in chain order, as long as fewer than the maximum
+     * number of blocks are in flight. Blocks already scheduled are skipped. Requires cs_main.
+     */
+    void Prefetch(const std::vector<const CBlockIndex*>& vpindex);
+
+    /**
+     * Take the block for pindex if it was scheduled, waiting for it to be loaded.
+     * Returns nullptr if the block wasn't scheduled or couldn't be read.
+     */
+    BlockRef Take(const CBlockIndex* pindex);
+
+    /** Drop the block for pindex if it was scheduled, without waiting for it. */
+    void Forget(const CBlockIndex* pindex);
+
+    /**
+     * Drop the blocks that won't be connected on the way from pindexTip to pindexTarget:
+     * the ones at or below the tip, and the ones left on another branch by a reorg or an
+     * invalid block. Requires cs_main.
+     */
+    void Prune(const CBlockIndex* pindexTip, const CBlockIndex* pindexTarget);
+
+    /**
+     * Deserialize a block read from a block file and compute its hashes on the worker
+     * threads. The block is null if the data couldn't be deserialized.
+     */
+    std::future<ParsedBlock> Deserialize(std::vector<char>&& vBlockData);
+
+    /** Maximum number of blocks read ahead. */
+    int MaxBlocks() const { return nMaxBlocks; }
+
+    /** Number of blocks scheduled and not taken yet. */
+    size_t InFlight();
+
+    /** Log the achieved connection rate every so often. */
+    void BlockConnected(const CBlockIndex* pindex);
+
+private:
+    const Consensus::Params& consensusParams;
+    const int nMaxBlocks;
+    std::unique_ptr<ctpl::thread_pool> workerPool;
+
+    CCriticalSection cs;
+    std::map<const CBlockIndex*, std::shared_future<BlockRef>> mapInFlight;
+
+    int64_t nStartTime;
+    int64_t nLastReportTime;
+    int nConnected;
+};
+
+/** Prefetcher used while importing blocks, null otherwise. Protected by cs_main. */
+extern std::unique_ptr<CBlockPrefetcher> g_blockprefetcher;
+
+#endif // BITCOIN_BLOCKPREFETCH_H
@@ -0,0 +1,511 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainsnapshot.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "coins.h"
+#include "evo/evodb.h"
+#include "hash.h"
+#include "streams.h"
+#include "txdb.h"
+#include "util.h"
+#include "utxostats.h"
+#include "validation.h"
+
+#ifdef ENABLE_ELYSIUM
+#include "elysium/elysium.h"
+#include "elysium/fees.h"
+#include "elysium/persistence.h"
+#include "elysium/sigmadb.h"
+#include "elysium/sp.h"
+#endif
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+namespace {
+
+const unsigned char CHAIN_SNAPSHOT_MAGIC[4] = {'t', 'c', 's', 's'};
+const uint32_t CHAIN_SNAPSHOT_VERSION = 1;
+
+//! Number of coins or database entries written at once
+const size_t SNAPSHOT_CHUNK_SIZE = 4096;
+//! Database entries are written in batches of about this size when loading
+const size_t SNAPSHOT_BATCH_SIZE = 16 << 20;
+
+typedef std::vector<unsigned char> RawData;
+typedef std::vector<std::pair<RawData, RawData> > RawEntries;
+
+//! Directories of the Elysium databases, in the order they are written
+const char* const ELYSIUM_DATABASES[] = {
+    "MP_tradelist", "MP_stolist", "MP_txlist", "MP_sigma", "MP_spinfo", "Elysium_TXDB", "ELYSIUM_feecache", "ELYSIUM_feehistory"
+};
+const size_t ELYSIUM_DATABASE_COUNT = sizeof(ELYSIUM_DATABASES) / sizeof(ELYSIUM_DATABASES[0]);
+
+#ifdef ENABLE_ELYSIUM
+/** An Elysium database opened on its own, to fill it before Elysium is initialized */
+class CElysiumSnapshotDB : public CDBBase
+{
+public:
+    leveldb::Status Open(const boost::filesystem::path& path)
+    {
+        return CDBBase::Open(path, true);
+    }
+
+    leveldb::Status Write(leveldb::WriteBatch& batch)
+    {
+        return pdb->Write(syncoptions, &batch);
+    }
+};
+#endif
+
+/**
+ * Follows the magic bytes of a snapshot. The header is followed by the block index entries of
+ * the active chain up to hashBlock, then the coins, the evo database, the Elysium databases and
+ * state files if fElysium is set, the statistics of the UTXO set and the hash of all of the above.
+ * Coins and database entries are written in chunks, the end of each is marked by an empty one.
+ */
+class CChainSnapshotHeader
+{
+public:
+    uint32_t nVersion;
+    CMessageHeader::MessageStartChars pchMessageStart;
+    uint256 hashBlock;
+    int nHeight;
+    bool fElysium;
+
+    CChainSnapshotHeader() : nVersion(CHAIN_SNAPSHOT_VERSION), nHeight(-1), fElysium(false)
+    {
+        memcpy(pchMessageStart, Params().MessageStart(), sizeof(pchMessageStart));
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(nVersion);
+        READWRITE(FLATDATA(pchMessageStart));
+        READWRITE(hashBlock);
+        READWRITE(nHeight);
+        READWRITE(fElysium);
+    }
+};
+
+template <typename Stream, typename T>
+void WriteChunk(Stream& s, std::vector<T>& chunk, bool fLast)
+{
+    if (chunk.size() < SNAPSHOT_CHUNK_SIZE && !fLast)
+        return;
+    if (!chunk.empty())
+        s << chunk;
+    chunk.clear();
+    if (fLast)
+        s << chunk;
+}
+
+template <typename Stream>
+void WriteEntries(Stream& s, CDBIterator& cursor)
+{
+    RawEntries entries;
+    for (cursor.SeekToFirst(); cursor.Valid(); cursor.Next()) {
+        CDataStream ssKey = cursor.GetKey();
+        CDataStream ssValue = cursor.GetValue();
+        entries.emplace_back(RawData(ssKey.begin(), ssKey.end()), RawData(ssValue.begin(), ssValue.end()));
+        WriteChunk(s, entries, false);
+    }
+    WriteChunk(s, entries, true);
+}
+
+//! Read the chunks of entries of a database, passing each one to fn down to the last, empty one
+bool ReadEntries(CAutoFile& filein, const std::function<bool(const RawEntries&)>& fn)
+{
+    RawEntries entries;
+    do {
+        filein >> entries;
+        if (!fn(entries))
+            return false;
+    } while (!entries.empty());
+    return true;
+}
+
+#ifdef ENABLE_ELYSIUM
+template <typename Stream>
+bool WriteEntries(Stream& s, leveldb::Iterator& cursor)
+{
+    RawEntries entries;
+    for (cursor.SeekToFirst(); cursor.Valid(); cursor.Next()) {
+        entries.emplace_back(RawData(cursor.key().data(), cursor.key().data() + cursor.key().size()),
+                             RawData(cursor.value().data(), cursor.value().data() + cursor.value().size()));
+        WriteChunk(s, entries, false);
+    }
+    WriteChunk(s, entries, true);
+    return cursor.status().ok();
+}
+
+boost::filesystem::path GetElysiumStatePath()
+{
+    return GetDataDir() / "MP_persist";
+}
+
+//! Read the Elysium state files saved for a block
+bool ReadElysiumStateFiles(const uint256& hashBlock, std::vector<std::pair<std::string, RawData> >& vFiles)
+{
+    const std::string strSuffix = "-" + hashBlock.ToString() + ".dat";
+    boost::filesystem::directory_iterator endIter;
+    for (boost::filesystem::directory_iterator it(GetElysiumStatePath()); it != endIter; ++it) {
+        const std::string strName = it->path().filename().string();
+        if (!boost::filesystem::is_regular_file(it->status()) || strName.size() <= strSuffix.size() ||
+            strName.compare(strName.size() - strSuffix.size(), strSuffix.size(), strSuffix) != 0)
+            continue;
+
+        FILE* file = fopen(it->path().string().c_str(), "rb");
+        if (!file)
+            return error("%s: failed to open %s", __func__, it->path().string());
+        RawData data(boost::filesystem::file_size(it->path()));
+        bool fOk = data.empty() || fread(data.data(), 1, data.size(), file) == data.size();
+        fclose(file);
+        if (!fOk)
+            return error("%s: failed to read %s", __func__, it->path().string());
+        vFiles.emplace_back(strName, std::move(data));
+    }
+    return !vFiles.empty();
+}
+
+bool WriteElysiumStateFiles(const std::vector<std::pair<std::string, RawData> >& vFiles)
+{
+    TryCreateDirectory(GetElysiumStatePath());
+    for (const auto& stateFile : vFiles) {
+        // Only plain file names are accepted
+        if (boost::filesystem::path(stateFile.first).filename().string() != stateFile.first)
+            return error("%s: invalid Elysium state file name %s", __func__, stateFile.first);
+
+        boost::filesystem::path path = GetElysiumStatePath() / stateFile.first;
+        FILE* file = fopen(path.string().c_str(), "wb");
+        if (!file)
+            return error("%s: failed to open %s", __func__, path.string());
+        bool fOk = stateFile.second.empty() || fwrite(stateFile.second.data(), 1, stateFile.second.size(), file) == stateFile.second.size();
+        if (fOk)
+            FileCommit(file);
+        fclose(file);
+        if (!fOk)
+            return error("%s: failed to write %s", __func__, path.string());
+    }
+    return true;
+}
+#endif
+
+//! Hash the content of a snapshot file and check it against the hash it ends with
+bool HashSnapshotFile(const boost::filesystem::path& path, uint256& hashContent)
+{
+    FILE* file = fopen(path.string().c_str(), "rb");
+    if (!file)
+        return error("%s: failed to open %s", __func__, path.string());
+
+    boost::system::error_code ec;
+    uint64_t nSize = boost::filesystem::file_size(path, ec);
+    bool fOk = !ec && nSize >= sizeof(CHAIN_SNAPSHOT_MAGIC) + sizeof(uint256);
+
+    CHash256 hasher;
+    std::vector<unsigned char> buf(1 << 20);
+    for (uint64_t nRemaining = fOk ? nSize - sizeof(uint256) : 0; nRemaining > 0; ) {
+        size_t nRead = std::min<uint64_t>(nRemaining, buf.size());
+        if (fread(buf.data(), 1, nRead, file) != nRead) {
+            fOk = false;
+            break;
+        }
+        hasher.Write(buf.data(), nRead);
+        nRemaining -= nRead;
+    }
+    uint256 hashStored;
+    fOk = fOk && fread(hashStored.begin(), 1, hashStored.size(), file) == hashStored.size();
+    fclose(file);
+    if (!fOk)
+        return error("%s: failed to read %s", __func__, path.string());
+
+    hasher.Finalize(hashContent.begin());
+    if (hashContent != hashStored)
+        return error("%s: %s is corrupted", __func__, path.string());
+    return true;
+}
+
+bool WriteSnapshot(CAutoFile& fileout, CChainSnapshotInfo& info)
+{
+    CHashedWriter<CAutoFile> hashout(&fileout);
+    CChainSnapshotHeader header;
+    std::unique_ptr<CCoinsViewCursor> pcursor;
+    std::unique_ptr<CDBIterator> pcursorEvo;
+#ifdef ENABLE_ELYSIUM
+    std::vector<std::unique_ptr<leveldb::Iterator> > vcursorElysium;
+    std::vector<std::pair<std::string, RawData> > vElysiumFiles;
+#endif
+
+    {
+        LOCK(cs_main);
+        CBlockIndex* pindexTip = chainActive.Tip();
+        if (!pindexTip)
+            return error("%s: there is no chain to take a snapshot of", __func__);
+
+        // The databases are read through iterators, which keep seeing them as they are
+        // once everything is flushed while blocks keep being connected
+        FlushStateToDisk();
+        pcursor.reset(pcoinsTip->Cursor());
+        if (pcursor->GetBestBlock() != pindexTip->GetBlockHash())
+            return error("%s: the UTXO set isn't at the tip", __func__);
+        pcursorEvo.reset(evoDb->GetRawDB().NewIterator());
+
+        header.hashBlock = pindexTip->GetBlockHash();
+        header.nHeight = pindexTip->nHeight;
+#ifdef ENABLE_ELYSIUM
+        if (isElysiumEnabled()) {
+            header.fElysium = true;
+            elysium_save_state(pindexTip);
+            const CDBBase* databases[] = {
+                elysium::t_tradelistdb, elysium::s_stolistdb, elysium::p_txlistdb, elysium::sigmaDb,
+                elysium::_my_sps, elysium::p_ElysiumTXDB, elysium::p_feecache, elysium::p_feehistory
+            };
+            static_assert(sizeof(databases) / sizeof(databases[0]) == ELYSIUM_DATABASE_COUNT, "every Elysium database is written");
+            for (const CDBBase* db : databases)
+                vcursorElysium.emplace_back(db->NewIterator());
+            if (!ReadElysiumStateFiles(header.hashBlock, vElysiumFiles))
+                return error("%s: failed to read the Elysium state of block %s", __func__, header.hashBlock.ToString());
+        }
+#endif
+
+        hashout.write((const char*)CHAIN_SNAPSHOT_MAGIC, sizeof(CHAIN_SNAPSHOT_MAGIC));
+        hashout << header;
+        for (const CBlockIndex* pindex = chainActive.Genesis(); pindex; pindex = chainActive.Next(pindex)) {
+            // The node loading the snapshot has none of the blocks
+            CDiskBlockIndex diskindex(pindex);
+            diskindex.nStatus &= ~(BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO);
+            diskindex.nFile = diskindex.nDataPos = diskindex.nUndoPos = 0;
+            hashout << pindex->GetBlockHash() << diskindex;
+        }
+    }
+
+    CUTXOStats stats;
+    stats.hashBlock = header.hashBlock;
+    stats.nHeight = header.nHeight;
+    std::vector<std::pair<COutPoint, Coin> > vCoins;
+    for (; pcursor->Valid(); pcursor->Next()) {
+        COutPoint key;
+        Coin coin;
+        if (!pcursor->GetKey(key) || !pcursor->GetValue(coin))
+            return error("%s: unable to read the UTXO set", __func__);
+        stats.AddCoin(key, coin);
+        vCoins.emplace_back(key, std::move(coin));
+        WriteChunk(hashout, vCoins, false);
+    }
+    WriteChunk(hashout, vCoins, true);
+
+    WriteEntries(hashout, *pcursorEvo);
+
+#ifdef ENABLE_ELYSIUM
+    for (const auto& pcursorElysium : vcursorElysium) {
+        if (!WriteEntries(hashout, *pcursorElysium))
+            return error("%s: unable to read the Elysium databases", __func__);
+    }
+    if (header.fElysium)
+        hashout << vElysiumFiles;
+#endif
+
+    hashout << stats;
+    info.hashContent = hashout.GetHash();
+    fileout << info.hashContent;
+
+    info.hashBlock = header.hashBlock;
+    info.nHeight = header.nHeight;
+    info.nTransactionOutputs = stats.nTransactionOutputs;
+    info.nTotalAmount = stats.nTotalAmount;
+    info.hashUTXOSet = stats.GetMuHash();
+    info.fElysium = header.fElysium;
+    return true;
+}
+
+} // anon namespace
+
+bool DumpChainSnapshot(const boost::filesystem::path& path, CChainSnapshotInfo& info)
+{
+    boost::filesystem::path pathTmp = path;
+    pathTmp += ".new";
+
+    CAutoFile fileout(fopen(pathTmp.string().c_str(), "wb"), SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull())
+        return error("%s: failed to open %s", __func__, pathTmp.string());
+
+    bool fOk;
+    try {
+        fOk = WriteSnapshot(fileout, info);
+        if (fOk)
+            FileCommit(fileout.Get());
+    } catch (const std::exception& e) {
+        fOk = error("%s: failed to write %s: %s", __func__, pathTmp.string(), e.what());
+    }
+    fileout.fclose();
+    if (!fOk || !RenameOver(pathTmp, path)) {
+        boost::filesystem::remove(pathTmp);
+        return error("%s: failed to write %s", __func__, path.string());
+    }
+    return true;
+}
+
+bool LoadChainSnapshot(const boost::filesystem::path& path, const uint256& hashExpected, CChainSnapshotInfo& info)
+{
+    // Nothing is written before the whole file is known to be the one expected
+    if (!HashSnapshotFile(path, info.hashContent))
+        return false;
+    if (info.hashContent != hashExpected)
+        return error("%s: %s has hash %s, %s was expected", __func__, path.string(), info.hashContent.ToString(), hashExpected.ToString());
+
+    CAutoFile filein(fopen(path.string().c_str(), "rb"), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("%s: failed to open %s", __func__, path.string());
+
+    LOCK(cs_main);
+    try {
+        unsigned char pchMagic[sizeof(CHAIN_SNAPSHOT_MAGIC)];
+        filein.read((char*)pchMagic, sizeof(pchMagic));
+        if (memcmp(pchMagic, CHAIN_SNAPSHOT_MAGIC, sizeof(pchMagic)) != 0)
+            return error("%s: %s is not a chain state snapshot", __func__, path.string());
+
+        CChainSnapshotHeader header;
+        filein >> header;
+        if (header.nVersion != CHAIN_SNAPSHOT_VERSION)
+            return error("%s: unsupported snapshot version %u", __func__, header.nVersion);
+        if (memcmp(header.pchMessageStart, Params().MessageStart(), sizeof(header.pchMessageStart)) != 0)
+            return error("%s: the snapshot is for another network", __func__);
+        bool fElysium = false;
+#ifdef ENABLE_ELYSIUM
+        fElysium = isElysiumEnabled();
+#endif
+        // Elysium can't scan the blocks below the snapshot
+        if (fElysium && !header.fElysium)
+            return error("%s: the snapshot has no Elysium state", __func__);
+        LogPrintf("Loading the chain state snapshot of block %s at height %d...\n", header.hashBlock.ToString(), header.nHeight);
+
+        // Block index entries, linked from the genesis block up
+        std::vector<std::pair<uint256, CDiskBlockIndex> > vEntries;
+        uint256 hashPrev;
+        for (int nHeight = 0; nHeight <= header.nHeight; nHeight++) {
+            uint256 hash;
+            CDiskBlockIndex diskindex;
+            filein >> hash >> diskindex;
+            if (diskindex.nHeight != nHeight || diskindex.hashPrev != hashPrev ||
+                (nHeight == 0 && hash != Params().GetConsensus().hashGenesisBlock))
+                return error("%s: unexpected block index entry at height %d", __func__, nHeight);
+            diskindex.nStatus &= ~(BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO);
+            vEntries.emplace_back(hash, diskindex);
+            hashPrev = hash;
+            if (vEntries.size() == SNAPSHOT_CHUNK_SIZE || nHeight == header.nHeight) {
+                if (!pblocktree->WriteBlockIndexEntries(vEntries))
+                    return error("%s: failed to write the block index", __func__);
+                vEntries.clear();
+            }
+        }
+        if (hashPrev != header.hashBlock)
+            return error("%s: the block index entries don't lead to block %s", __func__, header.hashBlock.ToString());
+
+        // Coins, without a best block until all of them are written
+        CUTXOStats stats;
+        stats.hashBlock = header.hashBlock;
+        stats.nHeight = header.nHeight;
+        std::vector<std::pair<COutPoint, Coin> > vCoins;
+        do {
+            filein >> vCoins;
+            for (auto& entry : vCoins) {
+                stats.AddCoin(entry.first, entry.second);
+                pcoinsTip->AddCoin(entry.first, std::move(entry.second), false);
+            }
+            if (pcoinsTip->DynamicMemoryUsage() > nCoinCacheUsage && !pcoinsTip->Flush())
+                return error("%s: failed to write the UTXO set", __func__);
+        } while (!vCoins.empty());
+
+        CDBWrapper& evoRawDb = evoDb->GetRawDB();
+        CDBBatch batch(evoRawDb);
+        bool fEvoOk = ReadEntries(filein, [&](const RawEntries& entries) {
+            for (const auto& entry : entries)
+                batch.Write(CDataStream(entry.first, SER_DISK, CLIENT_VERSION), CDataStream(entry.second, SER_DISK, CLIENT_VERSION));
+            if (batch.SizeEstimate() < SNAPSHOT_BATCH_SIZE && !entries.empty())
+                return true;
+            bool fWritten = evoRawDb.WriteBatch(batch);
+            batch.Clear();
+            return fWritten;
+        });
+        if (!fEvoOk)
+            return error("%s: failed to write the evo database", __func__);
+
+        if (header.fElysium) {
+            // The Elysium state is skipped by nodes which don't run it
+            for (size_t i = 0; i < ELYSIUM_DATABASE_COUNT; i++) {
+                std::function<bool(const RawEntries&)> fn = [](const RawEntries&) { return true; };
+#ifdef ENABLE_ELYSIUM
+                CElysiumSnapshotDB db;
+                leveldb::WriteBatch elysiumBatch;
+                size_t nBatchSize = 0;
+                if (fElysium) {
+                    if (!db.Open(GetDataDir() / ELYSIUM_DATABASES[i]).ok())
+                        return error("%s: failed to open %s", __func__, ELYSIUM_DATABASES[i]);
+                    fn = [&](const RawEntries& entries) {
+                        for (const auto& entry : entries) {
+                            elysiumBatch.Put(leveldb::Slice((const char*)entry.first.data(), entry.first.size()),
+                                             leveldb::Slice((const char*)entry.second.data(), entry.second.size()));
+                            nBatchSize += entry.first.size() + entry.second.size();
+                        }
+                        if (nBatchSize < SNAPSHOT_BATCH_SIZE && !entries.empty())
+                            return true;
+                        bool fWritten = db.Write(elysiumBatch).ok();
+                        elysiumBatch.Clear();
+                        nBatchSize = 0;
+                        return fWritten;
+                    };
+                }
+#endif
+                if (!ReadEntries(filein, fn))
+                    return error("%s: failed to write %s", __func__, ELYSIUM_DATABASES[i]);
+            }
+            std::vector<std::pair<std::string, RawData> > vElysiumFiles;
+            filein >> vElysiumFiles;
+#ifdef ENABLE_ELYSIUM
+            if (fElysium && !WriteElysiumStateFiles(vElysiumFiles))
+                return false;
+#endif
+        }
+
+        CUTXOStats statsSnapshot;
+        uint256 hashContent;
+        filein >> statsSnapshot >> hashContent;
+        if (hashContent != info.hashContent)
+            return error("%s: unexpected end of the snapshot", __func__);
+        if (stats.nTransactionOutputs != statsSnapshot.nTransactionOutputs || stats.nTotalAmount != statsSnapshot.nTotalAmount ||
+            stats.GetMuHash() != statsSnapshot.GetMuHash())
+            return error("%s: the UTXO set doesn't match its statistics", __func__);
+
+        // The node is left as if it had pruned the blocks below the snapshot
+        if (!pblocktree->WriteFlag("prunedblockfiles", true))
+            return error("%s: failed to write to the block index", __func__);
+        if (fUTXOStats && !pblocktree->WriteUTXOStats(stats, uint256()))
+            return error("%s: failed to write the UTXO set statistics", __func__);
+        pcoinsTip->SetBestBlock(header.hashBlock);
+        if (!pcoinsTip->Flush())
+            return error("%s: failed to write the UTXO set", __func__);
+
+        info.hashBlock = header.hashBlock;
+        info.nHeight = header.nHeight;
+        info.nTransactionOutputs = stats.nTransactionOutputs;
+        info.nTotalAmount = stats.nTotalAmount;
+        info.hashUTXOSet = stats.GetMuHash();
+        info.fElysium = header.fElysium;
+    } catch (const std::exception& e) {
+        return error("%s: failed to read %s: %s", __func__, path.string(), e.what());
+    }
+
+    return true;
+}
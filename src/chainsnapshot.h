@@ -0,0 +1,45 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CHAINSNAPSHOT_H
+#define BITCOIN_CHAINSNAPSHOT_H
+
+#include "amount.h"
+#include "uint256.h"
+
+#include <boost/filesystem/path.hpp>
+
+/** Summary of a chain state snapshot, returned when it is written and checked when it is loaded */
+struct CChainSnapshotInfo
+{
+    uint256 hashBlock;
+    int nHeight;
+    uint64_t nTransactionOutputs;
+    CAmount nTotalAmount;
+    //! MuHash3072 of the UTXO set, the same as gettxoutsetinfo "muhash" at the block
+    uint256 hashUTXOSet;
+    //! Double SHA256 of the whole file, which a node is given to trust it
+    uint256 hashContent;
+    bool fElysium;
+
+    CChainSnapshotInfo() : nHeight(-1), nTransactionOutputs(0), nTotalAmount(0), fElysium(false) {}
+};
+
+/**
+ * Write a snapshot of the chain state at the tip of chainActive: the block index entries of the
+ * active chain, which the zerocoin, sigma, lelantus and MTP states are built from, the UTXO set,
+ * the evo database and, when Elysium is enabled, its databases and state files. The file is
+ * streamed, cs_main is only held until the block index entries are written.
+ */
+bool DumpChainSnapshot(const boost::filesystem::path& path, CChainSnapshotInfo& info);
+
+/**
+ * Fill the empty databases of a new data directory from a snapshot, which is first checked
+ * against hashExpected: its content isn't validated otherwise. It must be called before the
+ * block index is loaded, the node then starts from the snapshot block with the blocks below
+ * it treated as pruned.
+ */
+bool LoadChainSnapshot(const boost::filesystem::path& path, const uint256& hashExpected, CChainSnapshotInfo& info);
+
+#endif // BITCOIN_CHAINSNAPSHOT_H
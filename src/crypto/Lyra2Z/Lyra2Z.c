@@ -50,3 +50,24 @@ void lyra2z_hash(const char* input, char* output)
 	memcpy(output, hashB, 32);
 }
 
+const char* lyra2z_autodetect(void)
+{
+    static const int impls[] = { LYRA2Z_IMPL_AVX2, LYRA2Z_IMPL_SSE2 };
+    char input[80], expected[32], output[32];
+    size_t i;
+
+    for (i = 0; i < sizeof(input); i++)
+        input[i] = (char)i;
+    lyra2z_select(LYRA2Z_IMPL_GENERIC);
+    lyra2z_hash(input, expected);
+
+    for (i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+        if (!lyra2z_select(impls[i]))
+            continue;
+        lyra2z_hash(input, output);
+        if (memcmp(output, expected, sizeof(output)) == 0)
+            break;
+        lyra2z_select(LYRA2Z_IMPL_GENERIC);
+    }
+    return lyra2z_impl_name();
+}
@@ -7,6 +7,20 @@ extern "C" {
 
 void lyra2z_hash(const char* input, char* output);
 
+/* Implementations of the Blake2b rounds of the Lyra2 sponge */
+#define LYRA2Z_IMPL_GENERIC 0
+#define LYRA2Z_IMPL_SSE2 1
+#define LYRA2Z_IMPL_AVX2 2
+
+/* Whether the CPU supports an implementation */
+int lyra2z_supported(int impl);
+/* Use an implementation from now on, returns 0 if it isn't supported. Not thread safe. */
+int lyra2z_select(int impl);
+/* Name of the implementation in use */
+const char* lyra2z_impl_name(void);
+/* Select the fastest implementation that gives the same hash as the generic one, returns its name */
+const char* lyra2z_autodetect(void);
+
 #ifdef __cplusplus
 }
 #endif
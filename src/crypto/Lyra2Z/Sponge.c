@@ -23,6 +23,14 @@
 #include <time.h>
 #include "Sponge.h"
 #include "Lyra2.h"
+#include "Lyra2Z.h"
+
+//The SIMD code assumes blocks of 12 words
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && BLOCK_LEN_INT64 == 12
+#define LYRA2_X86_SIMD
+#define LYRA2_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#endif
 
 
 
@@ -56,7 +64,7 @@ inline void initState(uint64_t state[/*16*/]) {
  *
  * @param v     A 1024-bit (16 uint64_t) array to be processed by Blake2b's G function
  */
-inline static void blake2bLyra(uint64_t *v) {
+static void blake2bLyraGeneric(uint64_t *v) {
     ROUND_LYRA(0);
     ROUND_LYRA(1);
     ROUND_LYRA(2);
@@ -75,10 +83,387 @@ inline static void blake2bLyra(uint64_t *v) {
  * Executes a reduced version of Blake2b's G function with only one round
  * @param v     A 1024-bit (16 uint64_t) array to be processed by Blake2b's G function
  */
-inline static void reducedBlake2bLyra(uint64_t *v) {
+static void reducedBlake2bLyraGeneric(uint64_t *v) {
     ROUND_LYRA(0);
 }
 
+#ifdef LYRA2_X86_SIMD
+
+/*
+ * SIMD versions of the rounds and of the duplexing of whole rows, which keep the state in
+ * registers from one column to the next. The state is handled as four rows of four words,
+ * a = v[0..3], b = v[4..7], c = v[8..11], d = v[12..15], so a block of the matrix is a, b
+ * and c. G is applied to all columns at once, then the rows are rotated so the diagonals
+ * line up as columns for the second half of the round, and rotated back afterwards.
+ *
+ * Rows of the matrix may be the same row (row* can be prev or row), so every word written
+ * is loaded again right before, in the same order as the generic code does.
+ */
+
+#define ROTR64_SSE2(x, c) _mm_or_si128(_mm_srli_epi64((x), (c)), _mm_slli_epi64((x), 64 - (c)))
+#define ROTR32_SSE2(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define ROTR16_SSE2(x) _mm_shufflehi_epi16(_mm_shufflelo_epi16((x), _MM_SHUFFLE(0, 3, 2, 1)), _MM_SHUFFLE(0, 3, 2, 1))
+#define ROTR63_SSE2(x) _mm_or_si128(_mm_srli_epi64((x), 63), _mm_add_epi64((x), (x)))
+
+#define G_SSE2(a, b, c, d) \
+  do { \
+    a = _mm_add_epi64(a, b); \
+    d = ROTR32_SSE2(_mm_xor_si128(d, a)); \
+    c = _mm_add_epi64(c, d); \
+    b = ROTR64_SSE2(_mm_xor_si128(b, c), 24); \
+    a = _mm_add_epi64(a, b); \
+    d = ROTR16_SSE2(_mm_xor_si128(d, a)); \
+    c = _mm_add_epi64(c, d); \
+    b = ROTR63_SSE2(_mm_xor_si128(b, c)); \
+  } while(0)
+
+/* The state in eight registers of two words: s[0] = v[0..1], s[1] = v[2..3], ... */
+#define ROUND_SSE2(s) \
+  do { \
+    __m128i t0, t1; \
+    G_SSE2(s[0], s[2], s[4], s[6]); \
+    G_SSE2(s[1], s[3], s[5], s[7]); \
+    /*b = (b1, b2, b3, b0), c = (c2, c3, c0, c1), d = (d3, d0, d1, d2)*/ \
+    t0 = s[2]; \
+    s[2] = _mm_unpackhi_epi64(s[2], _mm_unpacklo_epi64(s[3], s[3])); \
+    s[3] = _mm_unpackhi_epi64(s[3], _mm_unpacklo_epi64(t0, t0)); \
+    t0 = s[4]; s[4] = s[5]; s[5] = t0; \
+    t0 = s[6]; \
+    s[6] = _mm_unpackhi_epi64(s[7], _mm_unpacklo_epi64(s[6], s[6])); \
+    s[7] = _mm_unpackhi_epi64(t0, _mm_unpacklo_epi64(s[7], s[7])); \
+    G_SSE2(s[0], s[2], s[4], s[6]); \
+    G_SSE2(s[1], s[3], s[5], s[7]); \
+    t0 = s[2]; t1 = s[6]; \
+    s[2] = _mm_unpackhi_epi64(s[3], _mm_unpacklo_epi64(s[2], s[2])); \
+    s[3] = _mm_unpackhi_epi64(t0, _mm_unpacklo_epi64(s[3], s[3])); \
+    t0 = s[4]; s[4] = s[5]; s[5] = t0; \
+    s[6] = _mm_unpackhi_epi64(s[6], _mm_unpacklo_epi64(s[7], s[7])); \
+    s[7] = _mm_unpackhi_epi64(s[7], _mm_unpacklo_epi64(t1, t1)); \
+  } while(0)
+
+/* (x[1], y[0]): two words of rotW(rand) */
+#define SHIFT_SSE2(x, y) _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(x), _mm_castsi128_pd(y), 1))
+
+#define LOAD_SSE2(p) _mm_loadu_si128((const __m128i*)(p))
+#define STORE_SSE2(p, x) _mm_storeu_si128((__m128i*)(p), (x))
+
+/* Unrolled loops over the registers, so the state isn't spilled to memory */
+#define FOR_BLOCK_TAIL_SSE2(stmt) \
+  do { \
+    { const int j = 1; stmt; } { const int j = 2; stmt; } { const int j = 3; stmt; } \
+    { const int j = 4; stmt; } { const int j = 5; stmt; } \
+  } while(0)
+#define FOR_BLOCK_SSE2(stmt) \
+  do { \
+    { const int j = 0; stmt; } \
+    FOR_BLOCK_TAIL_SSE2(stmt); \
+  } while(0)
+#define LOAD_STATE_SSE2(s, v) \
+  do { \
+    FOR_BLOCK_SSE2(s[j] = LOAD_SSE2((v) + 2 * j)); \
+    s[6] = LOAD_SSE2((v) + 12); \
+    s[7] = LOAD_SSE2((v) + 14); \
+  } while(0)
+#define STORE_STATE_SSE2(v, s) \
+  do { \
+    FOR_BLOCK_SSE2(STORE_SSE2((v) + 2 * j, s[j])); \
+    STORE_SSE2((v) + 12, s[6]); \
+    STORE_SSE2((v) + 14, s[7]); \
+  } while(0)
+
+LYRA2_TARGET("sse2") static void blake2bLyraRoundsSSE2(uint64_t *v, int nRounds) {
+    __m128i s[8];
+    int i;
+    LOAD_STATE_SSE2(s, v);
+    for (i = 0; i < nRounds; i++)
+        ROUND_SSE2(s);
+    STORE_STATE_SSE2(v, s);
+}
+
+LYRA2_TARGET("sse2") static void reducedDuplexRowSetupSSE2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    __m128i s[8], in[6];
+    uint64_t *ptrWordIn = rowIn, *ptrWordInOut = rowInOut, *ptrWordOut = rowOut + (nCols-1)*BLOCK_LEN_INT64;
+    uint64_t i;
+
+    LOAD_STATE_SSE2(s, state);
+    for (i = 0; i < nCols; i++) {
+        //Absorbing "M[prev] [+] M[row*]"
+        FOR_BLOCK_SSE2(in[j] = LOAD_SSE2(ptrWordIn + 2 * j); s[j] = _mm_xor_si128(s[j], _mm_add_epi64(in[j], LOAD_SSE2(ptrWordInOut + 2 * j))));
+
+        ROUND_SSE2(s);
+
+        //M[row][col] = M[prev][col] XOR rand
+        FOR_BLOCK_SSE2(STORE_SSE2(ptrWordOut + 2 * j, _mm_xor_si128(in[j], s[j])));
+
+        //M[row*][col] = M[row*][col] XOR rotW(rand)
+        STORE_SSE2(ptrWordInOut, _mm_xor_si128(LOAD_SSE2(ptrWordInOut), SHIFT_SSE2(s[5], s[0])));
+        FOR_BLOCK_TAIL_SSE2(STORE_SSE2(ptrWordInOut + 2 * j, _mm_xor_si128(LOAD_SSE2(ptrWordInOut + 2 * j), SHIFT_SSE2(s[j - 1], s[j]))));
+
+        ptrWordInOut += BLOCK_LEN_INT64;
+        ptrWordIn += BLOCK_LEN_INT64;
+        ptrWordOut -= BLOCK_LEN_INT64;
+    }
+    STORE_STATE_SSE2(state, s);
+}
+
+LYRA2_TARGET("sse2") static void reducedDuplexRowSSE2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    __m128i s[8];
+    uint64_t *ptrWordIn = rowIn, *ptrWordInOut = rowInOut, *ptrWordOut = rowOut;
+    uint64_t i;
+
+    LOAD_STATE_SSE2(s, state);
+    for (i = 0; i < nCols; i++) {
+        //Absorbing "M[prev] [+] M[row*]"
+        FOR_BLOCK_SSE2(s[j] = _mm_xor_si128(s[j], _mm_add_epi64(LOAD_SSE2(ptrWordIn + 2 * j), LOAD_SSE2(ptrWordInOut + 2 * j))));
+
+        ROUND_SSE2(s);
+
+        //M[rowOut][col] = M[rowOut][col] XOR rand
+        FOR_BLOCK_SSE2(STORE_SSE2(ptrWordOut + 2 * j, _mm_xor_si128(LOAD_SSE2(ptrWordOut + 2 * j), s[j])));
+
+        //M[rowInOut][col] = M[rowInOut][col] XOR rotW(rand)
+        STORE_SSE2(ptrWordInOut, _mm_xor_si128(LOAD_SSE2(ptrWordInOut), SHIFT_SSE2(s[5], s[0])));
+        FOR_BLOCK_TAIL_SSE2(STORE_SSE2(ptrWordInOut + 2 * j, _mm_xor_si128(LOAD_SSE2(ptrWordInOut + 2 * j), SHIFT_SSE2(s[j - 1], s[j]))));
+
+        ptrWordOut += BLOCK_LEN_INT64;
+        ptrWordInOut += BLOCK_LEN_INT64;
+        ptrWordIn += BLOCK_LEN_INT64;
+    }
+    STORE_STATE_SSE2(state, s);
+}
+
+#define ROTR32_AVX2(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define ROTR63_AVX2(x) _mm256_or_si256(_mm256_srli_epi64((x), 63), _mm256_add_epi64((x), (x)))
+
+#define G_AVX2(a, b, c, d) \
+  do { \
+    a = _mm256_add_epi64(a, b); \
+    d = ROTR32_AVX2(_mm256_xor_si256(d, a)); \
+    c = _mm256_add_epi64(c, d); \
+    b = _mm256_shuffle_epi8(_mm256_xor_si256(b, c), rotr24); \
+    a = _mm256_add_epi64(a, b); \
+    d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rotr16); \
+    c = _mm256_add_epi64(c, d); \
+    b = ROTR63_AVX2(_mm256_xor_si256(b, c)); \
+  } while(0)
+
+#define ROUND_AVX2(a, b, c, d) \
+  do { \
+    G_AVX2(a, b, c, d); \
+    b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(0, 3, 2, 1)); \
+    c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2)); \
+    d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(2, 1, 0, 3)); \
+    G_AVX2(a, b, c, d); \
+    b = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3)); \
+    c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(1, 0, 3, 2)); \
+    d = _mm256_permute4x64_epi64(d, _MM_SHUFFLE(0, 3, 2, 1)); \
+  } while(0)
+
+/* Byte shuffles rotating every word right by 24 and 16 bits */
+#define ROTR_CONSTANTS_AVX2 \
+    const __m256i rotr24 = _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, \
+                                            3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10); \
+    const __m256i rotr16 = _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, \
+                                            2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9)
+
+/* rotW(rand) from the first three rows of the state: (c3, a0, a1, a2), (a3, b0, b1, b2), (b3, c0, c1, c2) */
+#define ROTW_AVX2(a, b, c, r0, r1, r2) \
+  do { \
+    __m256i ar = _mm256_permute4x64_epi64(a, _MM_SHUFFLE(2, 1, 0, 3)); \
+    __m256i br = _mm256_permute4x64_epi64(b, _MM_SHUFFLE(2, 1, 0, 3)); \
+    __m256i cr = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(2, 1, 0, 3)); \
+    r0 = _mm256_blend_epi32(ar, cr, 0x03); \
+    r1 = _mm256_blend_epi32(br, ar, 0x03); \
+    r2 = _mm256_blend_epi32(cr, br, 0x03); \
+  } while(0)
+
+#define LOAD_AVX2(p) _mm256_loadu_si256((const __m256i*)(p))
+#define STORE_AVX2(p, x) _mm256_storeu_si256((__m256i*)(p), (x))
+
+LYRA2_TARGET("avx2") static void blake2bLyraRoundsAVX2(uint64_t *v, int nRounds) {
+    ROTR_CONSTANTS_AVX2;
+    __m256i a = LOAD_AVX2(v), b = LOAD_AVX2(v + 4), c = LOAD_AVX2(v + 8), d = LOAD_AVX2(v + 12);
+    int r;
+
+    for (r = 0; r < nRounds; r++)
+        ROUND_AVX2(a, b, c, d);
+
+    STORE_AVX2(v, a);
+    STORE_AVX2(v + 4, b);
+    STORE_AVX2(v + 8, c);
+    STORE_AVX2(v + 12, d);
+}
+
+LYRA2_TARGET("avx2") static void reducedDuplexRowSetupAVX2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    ROTR_CONSTANTS_AVX2;
+    __m256i a = LOAD_AVX2(state), b = LOAD_AVX2(state + 4), c = LOAD_AVX2(state + 8), d = LOAD_AVX2(state + 12);
+    __m256i in0, in1, in2, r0, r1, r2;
+    uint64_t *ptrWordIn = rowIn, *ptrWordInOut = rowInOut, *ptrWordOut = rowOut + (nCols-1)*BLOCK_LEN_INT64;
+    uint64_t i;
+
+    for (i = 0; i < nCols; i++) {
+        //Absorbing "M[prev] [+] M[row*]"
+        in0 = LOAD_AVX2(ptrWordIn);
+        in1 = LOAD_AVX2(ptrWordIn + 4);
+        in2 = LOAD_AVX2(ptrWordIn + 8);
+        a = _mm256_xor_si256(a, _mm256_add_epi64(in0, LOAD_AVX2(ptrWordInOut)));
+        b = _mm256_xor_si256(b, _mm256_add_epi64(in1, LOAD_AVX2(ptrWordInOut + 4)));
+        c = _mm256_xor_si256(c, _mm256_add_epi64(in2, LOAD_AVX2(ptrWordInOut + 8)));
+
+        ROUND_AVX2(a, b, c, d);
+
+        //M[row][col] = M[prev][col] XOR rand
+        STORE_AVX2(ptrWordOut, _mm256_xor_si256(in0, a));
+        STORE_AVX2(ptrWordOut + 4, _mm256_xor_si256(in1, b));
+        STORE_AVX2(ptrWordOut + 8, _mm256_xor_si256(in2, c));
+
+        //M[row*][col] = M[row*][col] XOR rotW(rand)
+        ROTW_AVX2(a, b, c, r0, r1, r2);
+        STORE_AVX2(ptrWordInOut, _mm256_xor_si256(LOAD_AVX2(ptrWordInOut), r0));
+        STORE_AVX2(ptrWordInOut + 4, _mm256_xor_si256(LOAD_AVX2(ptrWordInOut + 4), r1));
+        STORE_AVX2(ptrWordInOut + 8, _mm256_xor_si256(LOAD_AVX2(ptrWordInOut + 8), r2));
+
+        ptrWordInOut += BLOCK_LEN_INT64;
+        ptrWordIn += BLOCK_LEN_INT64;
+        ptrWordOut -= BLOCK_LEN_INT64;
+    }
+
+    STORE_AVX2(state, a);
+    STORE_AVX2(state + 4, b);
+    STORE_AVX2(state + 8, c);
+    STORE_AVX2(state + 12, d);
+}
+
+LYRA2_TARGET("avx2") static void reducedDuplexRowAVX2(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    ROTR_CONSTANTS_AVX2;
+    __m256i a = LOAD_AVX2(state), b = LOAD_AVX2(state + 4), c = LOAD_AVX2(state + 8), d = LOAD_AVX2(state + 12);
+    __m256i r0, r1, r2;
+    uint64_t *ptrWordIn = rowIn, *ptrWordInOut = rowInOut, *ptrWordOut = rowOut;
+    uint64_t i;
+
+    for (i = 0; i < nCols; i++) {
+        //Absorbing "M[prev] [+] M[row*]"
+        a = _mm256_xor_si256(a, _mm256_add_epi64(LOAD_AVX2(ptrWordIn), LOAD_AVX2(ptrWordInOut)));
+        b = _mm256_xor_si256(b, _mm256_add_epi64(LOAD_AVX2(ptrWordIn + 4), LOAD_AVX2(ptrWordInOut + 4)));
+        c = _mm256_xor_si256(c, _mm256_add_epi64(LOAD_AVX2(ptrWordIn + 8), LOAD_AVX2(ptrWordInOut + 8)));
+
+        ROUND_AVX2(a, b, c, d);
+
+        //M[rowOut][col] = M[rowOut][col] XOR rand
+        STORE_AVX2(ptrWordOut, _mm256_xor_si256(LOAD_AVX2(ptrWordOut), a));
+        STORE_AVX2(ptrWordOut + 4, _mm256_xor_si256(LOAD_AVX2(ptrWordOut + 4), b));
+        STORE_AVX2(ptrWordOut + 8, _mm256_xor_si256(LOAD_AVX2(ptrWordOut + 8), c));
+
+        //M[rowInOut][col] = M[rowInOut][col] XOR rotW(rand)
+        ROTW_AVX2(a, b, c, r0, r1, r2);
+        STORE_AVX2(ptrWordInOut, _mm256_xor_si256(LOAD_AVX2(ptrWordInOut), r0));
+        STORE_AVX2(ptrWordInOut + 4, _mm256_xor_si256(LOAD_AVX2(ptrWordInOut + 4), r1));
+        STORE_AVX2(ptrWordInOut + 8, _mm256_xor_si256(LOAD_AVX2(ptrWordInOut + 8), r2));
+
+        ptrWordOut += BLOCK_LEN_INT64;
+        ptrWordInOut += BLOCK_LEN_INT64;
+        ptrWordIn += BLOCK_LEN_INT64;
+    }
+
+    STORE_AVX2(state, a);
+    STORE_AVX2(state + 4, b);
+    STORE_AVX2(state + 8, c);
+    STORE_AVX2(state + 12, d);
+}
+
+static void blake2bLyraSSE2(uint64_t *v) {
+    blake2bLyraRoundsSSE2(v, 12);
+}
+
+static void reducedBlake2bLyraSSE2(uint64_t *v) {
+    blake2bLyraRoundsSSE2(v, 1);
+}
+
+static void blake2bLyraAVX2(uint64_t *v) {
+    blake2bLyraRoundsAVX2(v, 12);
+}
+
+static void reducedBlake2bLyraAVX2(uint64_t *v) {
+    blake2bLyraRoundsAVX2(v, 1);
+}
+
+#endif // LYRA2_X86_SIMD
+
+static void reducedDuplexRowSetupGeneric(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols);
+static void reducedDuplexRowGeneric(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols);
+
+/*Implementation in use, the generic one until lyra2z_select() is called*/
+static int lyra2zImpl = LYRA2Z_IMPL_GENERIC;
+static void (*blake2bLyraImpl)(uint64_t *v) = blake2bLyraGeneric;
+static void (*reducedBlake2bLyraImpl)(uint64_t *v) = reducedBlake2bLyraGeneric;
+static void (*reducedDuplexRowSetupImpl)(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) = reducedDuplexRowSetupGeneric;
+static void (*reducedDuplexRowImpl)(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) = reducedDuplexRowGeneric;
+
+inline static void blake2bLyra(uint64_t *v) {
+    blake2bLyraImpl(v);
+}
+
+inline static void reducedBlake2bLyra(uint64_t *v) {
+    reducedBlake2bLyraImpl(v);
+}
+
+int lyra2z_supported(int impl) {
+    switch (impl) {
+    case LYRA2Z_IMPL_GENERIC:
+        return 1;
+#ifdef LYRA2_X86_SIMD
+    case LYRA2Z_IMPL_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case LYRA2Z_IMPL_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+int lyra2z_select(int impl) {
+    if (!lyra2z_supported(impl))
+        return 0;
+    switch (impl) {
+#ifdef LYRA2_X86_SIMD
+    case LYRA2Z_IMPL_SSE2:
+        blake2bLyraImpl = blake2bLyraSSE2;
+        reducedBlake2bLyraImpl = reducedBlake2bLyraSSE2;
+        reducedDuplexRowSetupImpl = reducedDuplexRowSetupSSE2;
+        reducedDuplexRowImpl = reducedDuplexRowSSE2;
+        break;
+    case LYRA2Z_IMPL_AVX2:
+        blake2bLyraImpl = blake2bLyraAVX2;
+        reducedBlake2bLyraImpl = reducedBlake2bLyraAVX2;
+        reducedDuplexRowSetupImpl = reducedDuplexRowSetupAVX2;
+        reducedDuplexRowImpl = reducedDuplexRowAVX2;
+        break;
+#endif
+    default:
+        blake2bLyraImpl = blake2bLyraGeneric;
+        reducedBlake2bLyraImpl = reducedBlake2bLyraGeneric;
+        reducedDuplexRowSetupImpl = reducedDuplexRowSetupGeneric;
+        reducedDuplexRowImpl = reducedDuplexRowGeneric;
+        break;
+    }
+    lyra2zImpl = impl;
+    return 1;
+}
+
+const char* lyra2z_impl_name(void) {
+    switch (lyra2zImpl) {
+    case LYRA2Z_IMPL_SSE2:
+        return "sse2";
+    case LYRA2Z_IMPL_AVX2:
+        return "avx2";
+    default:
+        return "generic";
+    }
+}
+
 /**
  * Performs a squeeze operation, using Blake2b's G function as the
  * internal permutation
@@ -256,7 +641,7 @@ inline void reducedDuplexRow1(uint64_t *state, uint64_t *rowIn, uint64_t *rowOut
  * @param rowOut         Row receiving the output
  *
  */
-inline void reducedDuplexRowSetup(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+static void reducedDuplexRowSetupGeneric(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
     uint64_t* ptrWordIn = rowIn;				//In Lyra2: pointer to prev
     uint64_t* ptrWordInOut = rowInOut;				//In Lyra2: pointer to row*
     uint64_t* ptrWordOut = rowOut + (nCols-1)*BLOCK_LEN_INT64; //In Lyra2: pointer to row
@@ -330,7 +715,7 @@ inline void reducedDuplexRowSetup(uint64_t *state, uint64_t *rowIn, uint64_t *ro
  * @param rowOut         Row receiving the output
  *
  */
-inline void reducedDuplexRow(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+static void reducedDuplexRowGeneric(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
     uint64_t* ptrWordInOut = rowInOut; //In Lyra2: pointer to row*
     uint64_t* ptrWordIn = rowIn; //In Lyra2: pointer to prev
     uint64_t* ptrWordOut = rowOut; //In Lyra2: pointer to row
@@ -391,6 +776,15 @@ inline void reducedDuplexRow(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOu
 }
 
 
+inline void reducedDuplexRowSetup(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    reducedDuplexRowSetupImpl(state, rowIn, rowInOut, rowOut, nCols);
+}
+
+inline void reducedDuplexRow(uint64_t *state, uint64_t *rowIn, uint64_t *rowInOut, uint64_t *rowOut, uint64_t nCols) {
+    reducedDuplexRowImpl(state, rowIn, rowInOut, rowOut, nCols);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /**
@@ -85,6 +85,16 @@ ARGON2_LOCAL int blake2b_long(void *out, size_t outlen, const void *in, size_t i
 int blake2b_4r_final(blake2b_state *S, void *out, size_t outlen);
 int blake2b_4r_update(blake2b_state *S, const void *in, size_t inlen);
 
+/*
+ * Hash @count inputs of 32 bytes (pairs of Merkle tree nodes) stored one after the
+ * other into 16 byte digests, several at a time. Same as blake2b_init(S, 16),
+ * blake2b_4r_update() and blake2b_4r_final() on every input.
+ */
+void blake2b_4r_hash_nodes(uint8_t *out, const uint8_t *in, size_t count);
+
+/* Switch the compressions to one of the MTP_IMPL_* from opt.h, see mtp_impl_select() */
+void blake2b_select_impl(int impl);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -21,6 +21,13 @@
 
 #include "blake2.h"
 #include "blake2-impl.h"
+#include "../opt.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLAKE2B_X86_SIMD
+#define BLAKE2B_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#endif
 
 static const uint64_t blake2b_IV[8] = {
     UINT64_C(0x6a09e667f3bcc908), UINT64_C(0xbb67ae8584caa73b),
@@ -163,7 +170,7 @@ int blake2b_init_key(blake2b_state *S, size_t outlen, const void *key,
     return 0;
 }
 
-static void blake2b_compress(blake2b_state *S, const uint8_t *block) {
+static void blake2b_compress_ref(blake2b_state *S, const uint8_t *block) {
     uint64_t m[16];
     uint64_t v[16];
     unsigned int i, r;
@@ -221,7 +228,7 @@ static void blake2b_compress(blake2b_state *S, const uint8_t *block) {
 #undef ROUND
 }
 
-static void blake2b_4r_compress(blake2b_state *S, const uint8_t *block) {
+static void blake2b_4r_compress_ref(blake2b_state *S, const uint8_t *block) {
     uint64_t m[16];
     uint64_t v[16];
     unsigned int i, r;
@@ -276,6 +283,401 @@ static void blake2b_4r_compress(blake2b_state *S, const uint8_t *block) {
 }
 
 
+#ifdef BLAKE2B_X86_SIMD
+
+/*
+ * Vectorized compressions, one G per 64-bit lane: rows of the state are kept in
+ * registers and the message words of each round are gathered in sigma order.
+ */
+
+#define B2_SSE_ROTR32(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define B2_SSE_ROTR24(x) _mm_shuffle_epi8((x), _mm_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10))
+#define B2_SSE_ROTR16(x) _mm_shuffle_epi8((x), _mm_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9))
+#define B2_SSE_ROTR63(x) _mm_xor_si128(_mm_srli_epi64((x), 63), _mm_add_epi64((x), (x)))
+
+#define B2_SSE_MSG(r, i0, i1)                                                  \
+    _mm_set_epi64x((int64_t)m[blake2b_sigma[r][i1]], (int64_t)m[blake2b_sigma[r][i0]])
+
+#define B2_SSE_G(r, i0, i1, i2, i3, ROTD, ROTB)                                \
+    do {                                                                       \
+        row1l = _mm_add_epi64(_mm_add_epi64(row1l, row2l), B2_SSE_MSG(r, i0, i1)); \
+        row1h = _mm_add_epi64(_mm_add_epi64(row1h, row2h), B2_SSE_MSG(r, i2, i3)); \
+        row4l = ROTD(_mm_xor_si128(row4l, row1l));                             \
+        row4h = ROTD(_mm_xor_si128(row4h, row1h));                             \
+        row3l = _mm_add_epi64(row3l, row4l);                                   \
+        row3h = _mm_add_epi64(row3h, row4h);                                   \
+        row2l = ROTB(_mm_xor_si128(row2l, row3l));                             \
+        row2h = ROTB(_mm_xor_si128(row2h, row3h));                             \
+    } while ((void)0, 0)
+
+#define B2_SSE_ROUND(r)                                                        \
+    do {                                                                       \
+        __m128i t0, t1;                                                        \
+        B2_SSE_G(r, 0, 2, 4, 6, B2_SSE_ROTR32, B2_SSE_ROTR24);                 \
+        B2_SSE_G(r, 1, 3, 5, 7, B2_SSE_ROTR16, B2_SSE_ROTR63);                 \
+        t0 = _mm_alignr_epi8(row2h, row2l, 8);                                 \
+        t1 = _mm_alignr_epi8(row2l, row2h, 8);                                 \
+        row2l = t0;                                                            \
+        row2h = t1;                                                            \
+        t0 = row3l;                                                            \
+        row3l = row3h;                                                         \
+        row3h = t0;                                                            \
+        t0 = _mm_alignr_epi8(row4h, row4l, 8);                                 \
+        t1 = _mm_alignr_epi8(row4l, row4h, 8);                                 \
+        row4l = t1;                                                            \
+        row4h = t0;                                                            \
+        B2_SSE_G(r, 8, 10, 12, 14, B2_SSE_ROTR32, B2_SSE_ROTR24);              \
+        B2_SSE_G(r, 9, 11, 13, 15, B2_SSE_ROTR16, B2_SSE_ROTR63);              \
+        t0 = _mm_alignr_epi8(row2l, row2h, 8);                                 \
+        t1 = _mm_alignr_epi8(row2h, row2l, 8);                                 \
+        row2l = t0;                                                            \
+        row2h = t1;                                                            \
+        t0 = row3l;                                                            \
+        row3l = row3h;                                                         \
+        row3h = t0;                                                            \
+        t0 = _mm_alignr_epi8(row4l, row4h, 8);                                 \
+        t1 = _mm_alignr_epi8(row4h, row4l, 8);                                 \
+        row4l = t1;                                                            \
+        row4h = t0;                                                            \
+    } while ((void)0, 0)
+
+BLAKE2B_TARGET("sse4.1") static inline void blake2b_compress_sse41(blake2b_state *S, const uint8_t *block, unsigned int rounds) {
+    uint64_t m[16];
+    __m128i row1l, row1h, row2l, row2h, row3l, row3h, row4l, row4h;
+    __m128i h0, h1, h2, h3;
+
+    load64_many(m, block, 16);
+
+    row1l = h0 = _mm_loadu_si128((const __m128i *)&S->h[0]);
+    row1h = h1 = _mm_loadu_si128((const __m128i *)&S->h[2]);
+    row2l = h2 = _mm_loadu_si128((const __m128i *)&S->h[4]);
+    row2h = h3 = _mm_loadu_si128((const __m128i *)&S->h[6]);
+    row3l = _mm_loadu_si128((const __m128i *)&blake2b_IV[0]);
+    row3h = _mm_loadu_si128((const __m128i *)&blake2b_IV[2]);
+    row4l = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&blake2b_IV[4]), _mm_loadu_si128((const __m128i *)&S->t[0]));
+    row4h = _mm_xor_si128(_mm_loadu_si128((const __m128i *)&blake2b_IV[6]), _mm_loadu_si128((const __m128i *)&S->f[0]));
+
+    B2_SSE_ROUND(0);
+    B2_SSE_ROUND(1);
+    B2_SSE_ROUND(2);
+    B2_SSE_ROUND(3);
+    if (rounds == 12) {
+        B2_SSE_ROUND(4);
+        B2_SSE_ROUND(5);
+        B2_SSE_ROUND(6);
+        B2_SSE_ROUND(7);
+        B2_SSE_ROUND(8);
+        B2_SSE_ROUND(9);
+        B2_SSE_ROUND(10);
+        B2_SSE_ROUND(11);
+    }
+
+    _mm_storeu_si128((__m128i *)&S->h[0], _mm_xor_si128(h0, _mm_xor_si128(row1l, row3l)));
+    _mm_storeu_si128((__m128i *)&S->h[2], _mm_xor_si128(h1, _mm_xor_si128(row1h, row3h)));
+    _mm_storeu_si128((__m128i *)&S->h[4], _mm_xor_si128(h2, _mm_xor_si128(row2l, row4l)));
+    _mm_storeu_si128((__m128i *)&S->h[6], _mm_xor_si128(h3, _mm_xor_si128(row2h, row4h)));
+}
+
+BLAKE2B_TARGET("sse4.1") static void blake2b_compress_sse41_12(blake2b_state *S, const uint8_t *block) {
+    blake2b_compress_sse41(S, block, 12);
+}
+
+BLAKE2B_TARGET("sse4.1") static void blake2b_compress_sse41_4(blake2b_state *S, const uint8_t *block) {
+    blake2b_compress_sse41(S, block, 4);
+}
+
+#define B2_AVX2_ROTR32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define B2_AVX2_ROTR24(x) _mm256_shuffle_epi8((x), _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10))
+#define B2_AVX2_ROTR16(x) _mm256_shuffle_epi8((x), _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9))
+#define B2_AVX2_ROTR63(x) _mm256_xor_si256(_mm256_srli_epi64((x), 63), _mm256_add_epi64((x), (x)))
+
+#define B2_AVX2_MSG(r, i0, i1, i2, i3)                                         \
+    _mm256_set_epi64x((int64_t)m[blake2b_sigma[r][i3]], (int64_t)m[blake2b_sigma[r][i2]], \
+                      (int64_t)m[blake2b_sigma[r][i1]], (int64_t)m[blake2b_sigma[r][i0]])
+
+#define B2_AVX2_G(r, i0, i1, i2, i3, ROTD, ROTB)                               \
+    do {                                                                       \
+        row1 = _mm256_add_epi64(_mm256_add_epi64(row1, row2), B2_AVX2_MSG(r, i0, i1, i2, i3)); \
+        row4 = ROTD(_mm256_xor_si256(row4, row1));                             \
+        row3 = _mm256_add_epi64(row3, row4);                                   \
+        row2 = ROTB(_mm256_xor_si256(row2, row3));                             \
+    } while ((void)0, 0)
+
+#define B2_AVX2_ROUND(r)                                                       \
+    do {                                                                       \
+        B2_AVX2_G(r, 0, 2, 4, 6, B2_AVX2_ROTR32, B2_AVX2_ROTR24);              \
+        B2_AVX2_G(r, 1, 3, 5, 7, B2_AVX2_ROTR16, B2_AVX2_ROTR63);              \
+        row2 = _mm256_permute4x64_epi64(row2, _MM_SHUFFLE(0, 3, 2, 1));        \
+        row3 = _mm256_permute4x64_epi64(row3, _MM_SHUFFLE(1, 0, 3, 2));        \
+        row4 = _mm256_permute4x64_epi64(row4, _MM_SHUFFLE(2, 1, 0, 3));        \
+        B2_AVX2_G(r, 8, 10, 12, 14, B2_AVX2_ROTR32, B2_AVX2_ROTR24);           \
+        B2_AVX2_G(r, 9, 11, 13, 15, B2_AVX2_ROTR16, B2_AVX2_ROTR63);           \
+        row2 = _mm256_permute4x64_epi64(row2, _MM_SHUFFLE(2, 1, 0, 3));        \
+        row3 = _mm256_permute4x64_epi64(row3, _MM_SHUFFLE(1, 0, 3, 2));        \
+        row4 = _mm256_permute4x64_epi64(row4, _MM_SHUFFLE(0, 3, 2, 1));        \
+    } while ((void)0, 0)
+
+BLAKE2B_TARGET("avx2") static inline void blake2b_compress_avx2(blake2b_state *S, const uint8_t *block, unsigned int rounds) {
+    uint64_t m[16];
+    __m256i row1, row2, row3, row4, h0, h1;
+
+    load64_many(m, block, 16);
+
+    row1 = h0 = _mm256_loadu_si256((const __m256i *)&S->h[0]);
+    row2 = h1 = _mm256_loadu_si256((const __m256i *)&S->h[4]);
+    row3 = _mm256_loadu_si256((const __m256i *)&blake2b_IV[0]);
+    row4 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&blake2b_IV[4]),
+                            _mm256_set_epi64x((int64_t)S->f[1], (int64_t)S->f[0], (int64_t)S->t[1], (int64_t)S->t[0]));
+
+    B2_AVX2_ROUND(0);
+    B2_AVX2_ROUND(1);
+    B2_AVX2_ROUND(2);
+    B2_AVX2_ROUND(3);
+    if (rounds == 12) {
+        B2_AVX2_ROUND(4);
+        B2_AVX2_ROUND(5);
+        B2_AVX2_ROUND(6);
+        B2_AVX2_ROUND(7);
+        B2_AVX2_ROUND(8);
+        B2_AVX2_ROUND(9);
+        B2_AVX2_ROUND(10);
+        B2_AVX2_ROUND(11);
+    }
+
+    _mm256_storeu_si256((__m256i *)&S->h[0], _mm256_xor_si256(h0, _mm256_xor_si256(row1, row3)));
+    _mm256_storeu_si256((__m256i *)&S->h[4], _mm256_xor_si256(h1, _mm256_xor_si256(row2, row4)));
+}
+
+BLAKE2B_TARGET("avx2") static void blake2b_compress_avx2_12(blake2b_state *S, const uint8_t *block) {
+    blake2b_compress_avx2(S, block, 12);
+}
+
+BLAKE2B_TARGET("avx2") static void blake2b_compress_avx2_4(blake2b_state *S, const uint8_t *block) {
+    blake2b_compress_avx2(S, block, 4);
+}
+
+#endif // BLAKE2B_X86_SIMD
+
+/*
+ * Merkle nodes: every input is a single 32 byte block, hashed into 16 bytes with
+ * the 4 round compression. The multi-lane versions run one message per 64-bit lane,
+ * so the state words and the constants are shared by all the lanes.
+ */
+
+#define BLAKE2B_NODE_INBYTES 32
+#define BLAKE2B_NODE_OUTBYTES 16
+
+static void blake2b_4r_hash_nodes_ref(uint8_t *out, const uint8_t *in, size_t count) {
+    size_t i;
+    for (i = 0; i < count; i++) {
+        blake2b_state S;
+        blake2b_init(&S, BLAKE2B_NODE_OUTBYTES);
+        blake2b_4r_update(&S, in + i * BLAKE2B_NODE_INBYTES, BLAKE2B_NODE_INBYTES);
+        blake2b_4r_final(&S, out + i * BLAKE2B_NODE_OUTBYTES, BLAKE2B_NODE_OUTBYTES);
+    }
+}
+
+#ifdef BLAKE2B_X86_SIMD
+
+/* Parameter block of blake2b_init(S, 16) XORed into the first word of the IV */
+#define BLAKE2B_NODE_H0 (UINT64_C(0x6a09e667f3bcc908) ^ UINT64_C(0x01010010))
+
+/* The message has 4 words followed by zeros, the vector of zeros folds away */
+#define B2X_G(OPS, r, i, a, b, c, d)                                           \
+    do {                                                                       \
+        a = OPS##_ADD(OPS##_ADD(a, b), mv[blake2b_sigma[r][2 * i + 0]]);       \
+        d = OPS##_ROTR32(OPS##_XOR(d, a));                                     \
+        c = OPS##_ADD(c, d);                                                   \
+        b = OPS##_ROTR24(OPS##_XOR(b, c));                                     \
+        a = OPS##_ADD(OPS##_ADD(a, b), mv[blake2b_sigma[r][2 * i + 1]]);       \
+        d = OPS##_ROTR16(OPS##_XOR(d, a));                                     \
+        c = OPS##_ADD(c, d);                                                   \
+        b = OPS##_ROTR63(OPS##_XOR(b, c));                                     \
+    } while ((void)0, 0)
+
+#define B2X_ROUND(OPS, r)                                                      \
+    do {                                                                       \
+        B2X_G(OPS, r, 0, v[0], v[4], v[8], v[12]);                             \
+        B2X_G(OPS, r, 1, v[1], v[5], v[9], v[13]);                             \
+        B2X_G(OPS, r, 2, v[2], v[6], v[10], v[14]);                            \
+        B2X_G(OPS, r, 3, v[3], v[7], v[11], v[15]);                            \
+        B2X_G(OPS, r, 4, v[0], v[5], v[10], v[15]);                            \
+        B2X_G(OPS, r, 5, v[1], v[6], v[11], v[12]);                            \
+        B2X_G(OPS, r, 6, v[2], v[7], v[8], v[13]);                             \
+        B2X_G(OPS, r, 7, v[3], v[4], v[9], v[14]);                             \
+    } while ((void)0, 0)
+
+/* Initial state of a node hash: h = IV ^ param, t0 = 32, f0 = ~0 */
+#define B2X_INIT(SET1)                                                         \
+    do {                                                                       \
+        for (j = 0; j < 8; j++)                                                \
+            v[j] = SET1((int64_t)(j == 0 ? BLAKE2B_NODE_H0 : blake2b_IV[j]));  \
+        for (j = 0; j < 4; j++)                                                \
+            v[8 + j] = SET1((int64_t)blake2b_IV[j]);                           \
+        v[12] = SET1((int64_t)(blake2b_IV[4] ^ BLAKE2B_NODE_INBYTES));         \
+        v[13] = SET1((int64_t)blake2b_IV[5]);                                  \
+        v[14] = SET1((int64_t)~blake2b_IV[6]);                                 \
+        v[15] = SET1((int64_t)blake2b_IV[7]);                                  \
+    } while ((void)0, 0)
+
+#define B2X_SSE_ADD _mm_add_epi64
+#define B2X_SSE_XOR _mm_xor_si128
+#define B2X_SSE_ROTR32 B2_SSE_ROTR32
+#define B2X_SSE_ROTR24 B2_SSE_ROTR24
+#define B2X_SSE_ROTR16 B2_SSE_ROTR16
+#define B2X_SSE_ROTR63 B2_SSE_ROTR63
+
+BLAKE2B_TARGET("sse4.1") static void blake2b_4r_hash_nodes_sse41(uint8_t *out, const uint8_t *in, size_t count) {
+    size_t n;
+    for (n = 0; n + 2 <= count; n += 2, in += 2 * BLAKE2B_NODE_INBYTES, out += 2 * BLAKE2B_NODE_OUTBYTES) {
+        __m128i v[16], mv[16], a0, a1, b0, b1;
+        unsigned int j;
+
+        /* Rows are messages, columns are words: transpose 2x4 */
+        a0 = _mm_loadu_si128((const __m128i *)in);
+        a1 = _mm_loadu_si128((const __m128i *)in + 1);
+        b0 = _mm_loadu_si128((const __m128i *)(in + BLAKE2B_NODE_INBYTES));
+        b1 = _mm_loadu_si128((const __m128i *)(in + BLAKE2B_NODE_INBYTES) + 1);
+        mv[0] = _mm_unpacklo_epi64(a0, b0);
+        mv[1] = _mm_unpackhi_epi64(a0, b0);
+        mv[2] = _mm_unpacklo_epi64(a1, b1);
+        mv[3] = _mm_unpackhi_epi64(a1, b1);
+        for (j = 4; j < 16; j++)
+            mv[j] = _mm_setzero_si128();
+
+        B2X_INIT(_mm_set1_epi64x);
+        B2X_ROUND(B2X_SSE, 0);
+        B2X_ROUND(B2X_SSE, 1);
+        B2X_ROUND(B2X_SSE, 2);
+        B2X_ROUND(B2X_SSE, 3);
+
+        a0 = _mm_xor_si128(_mm_set1_epi64x((int64_t)BLAKE2B_NODE_H0), _mm_xor_si128(v[0], v[8]));
+        a1 = _mm_xor_si128(_mm_set1_epi64x((int64_t)blake2b_IV[1]), _mm_xor_si128(v[1], v[9]));
+        _mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi64(a0, a1));
+        _mm_storeu_si128((__m128i *)out + 1, _mm_unpackhi_epi64(a0, a1));
+    }
+    blake2b_4r_hash_nodes_ref(out, in, count - n);
+}
+
+#define B2X_AVX2_ADD _mm256_add_epi64
+#define B2X_AVX2_XOR _mm256_xor_si256
+#define B2X_AVX2_ROTR32 B2_AVX2_ROTR32
+#define B2X_AVX2_ROTR24 B2_AVX2_ROTR24
+#define B2X_AVX2_ROTR16 B2_AVX2_ROTR16
+#define B2X_AVX2_ROTR63 B2_AVX2_ROTR63
+
+BLAKE2B_TARGET("avx2") static void blake2b_4r_hash_nodes_avx2(uint8_t *out, const uint8_t *in, size_t count) {
+    size_t n;
+    for (n = 0; n + 4 <= count; n += 4, in += 4 * BLAKE2B_NODE_INBYTES, out += 4 * BLAKE2B_NODE_OUTBYTES) {
+        __m256i v[16], mv[16], r0, r1, r2, r3, t0, t1, t2, t3;
+        unsigned int j;
+
+        /* Rows are messages, columns are words: transpose 4x4 */
+        r0 = _mm256_loadu_si256((const __m256i *)in);
+        r1 = _mm256_loadu_si256((const __m256i *)in + 1);
+        r2 = _mm256_loadu_si256((const __m256i *)in + 2);
+        r3 = _mm256_loadu_si256((const __m256i *)in + 3);
+        t0 = _mm256_unpacklo_epi64(r0, r1);
+        t1 = _mm256_unpackhi_epi64(r0, r1);
+        t2 = _mm256_unpacklo_epi64(r2, r3);
+        t3 = _mm256_unpackhi_epi64(r2, r3);
+        mv[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+        mv[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+        mv[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+        mv[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+        for (j = 4; j < 16; j++)
+            mv[j] = _mm256_setzero_si256();
+
+        B2X_INIT(_mm256_set1_epi64x);
+        B2X_ROUND(B2X_AVX2, 0);
+        B2X_ROUND(B2X_AVX2, 1);
+        B2X_ROUND(B2X_AVX2, 2);
+        B2X_ROUND(B2X_AVX2, 3);
+
+        t0 = _mm256_xor_si256(_mm256_set1_epi64x((int64_t)BLAKE2B_NODE_H0), _mm256_xor_si256(v[0], v[8]));
+        t1 = _mm256_xor_si256(_mm256_set1_epi64x((int64_t)blake2b_IV[1]), _mm256_xor_si256(v[1], v[9]));
+        t2 = _mm256_unpacklo_epi64(t0, t1);
+        t3 = _mm256_unpackhi_epi64(t0, t1);
+        _mm256_storeu_si256((__m256i *)out, _mm256_permute2x128_si256(t2, t3, 0x20));
+        _mm256_storeu_si256((__m256i *)out + 1, _mm256_permute2x128_si256(t2, t3, 0x31));
+    }
+    blake2b_4r_hash_nodes_ref(out, in, count - n);
+}
+
+#define B2X_AVX512_ADD _mm512_add_epi64
+#define B2X_AVX512_XOR _mm512_xor_si512
+#define B2X_AVX512_ROTR32(x) _mm512_ror_epi64((x), 32)
+#define B2X_AVX512_ROTR24(x) _mm512_ror_epi64((x), 24)
+#define B2X_AVX512_ROTR16(x) _mm512_ror_epi64((x), 16)
+#define B2X_AVX512_ROTR63(x) _mm512_ror_epi64((x), 63)
+
+BLAKE2B_TARGET("avx512f") static void blake2b_4r_hash_nodes_avx512(uint8_t *out, const uint8_t *in, size_t count) {
+    const __m512i in_index = _mm512_setr_epi64(0, 4, 8, 12, 16, 20, 24, 28);
+    const __m512i out_index = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+    size_t n;
+    for (n = 0; n + 8 <= count; n += 8, in += 8 * BLAKE2B_NODE_INBYTES, out += 8 * BLAKE2B_NODE_OUTBYTES) {
+        __m512i v[16], mv[16];
+        unsigned int j;
+
+        for (j = 0; j < 4; j++)
+            mv[j] = _mm512_i64gather_epi64(in_index, (const void *)(in + j * sizeof(uint64_t)), 8);
+        for (j = 4; j < 16; j++)
+            mv[j] = _mm512_setzero_si512();
+
+        B2X_INIT(_mm512_set1_epi64);
+        B2X_ROUND(B2X_AVX512, 0);
+        B2X_ROUND(B2X_AVX512, 1);
+        B2X_ROUND(B2X_AVX512, 2);
+        B2X_ROUND(B2X_AVX512, 3);
+
+        _mm512_i64scatter_epi64((void *)out, out_index,
+                _mm512_xor_si512(_mm512_set1_epi64((int64_t)BLAKE2B_NODE_H0), _mm512_xor_si512(v[0], v[8])), 8);
+        _mm512_i64scatter_epi64((void *)(out + sizeof(uint64_t)), out_index,
+                _mm512_xor_si512(_mm512_set1_epi64((int64_t)blake2b_IV[1]), _mm512_xor_si512(v[1], v[9])), 8);
+    }
+    blake2b_4r_hash_nodes_ref(out, in, count - n);
+}
+
+#endif // BLAKE2B_X86_SIMD
+
+/* Compressions in use, see blake2b_select_impl() */
+static void (*blake2b_compress_impl)(blake2b_state *S, const uint8_t *block) = blake2b_compress_ref;
+static void (*blake2b_4r_compress_impl)(blake2b_state *S, const uint8_t *block) = blake2b_4r_compress_ref;
+static void (*blake2b_4r_hash_nodes_impl)(uint8_t *out, const uint8_t *in, size_t count) = blake2b_4r_hash_nodes_ref;
+
+void blake2b_select_impl(int impl) {
+    switch (impl) {
+#ifdef BLAKE2B_X86_SIMD
+    case MTP_IMPL_SSE41:
+        blake2b_compress_impl = blake2b_compress_sse41_12;
+        blake2b_4r_compress_impl = blake2b_compress_sse41_4;
+        blake2b_4r_hash_nodes_impl = blake2b_4r_hash_nodes_sse41;
+        break;
+    case MTP_IMPL_AVX2:
+        blake2b_compress_impl = blake2b_compress_avx2_12;
+        blake2b_4r_compress_impl = blake2b_compress_avx2_4;
+        blake2b_4r_hash_nodes_impl = blake2b_4r_hash_nodes_avx2;
+        break;
+    case MTP_IMPL_AVX512:
+        /* A single compression has 4 lanes of G, AVX-512 only helps hashing several nodes */
+        blake2b_compress_impl = blake2b_compress_avx2_12;
+        blake2b_4r_compress_impl = blake2b_compress_avx2_4;
+        blake2b_4r_hash_nodes_impl = blake2b_4r_hash_nodes_avx512;
+        break;
+#endif
+    default:
+        blake2b_compress_impl = blake2b_compress_ref;
+        blake2b_4r_compress_impl = blake2b_4r_compress_ref;
+        blake2b_4r_hash_nodes_impl = blake2b_4r_hash_nodes_ref;
+        break;
+    }
+}
+
+void blake2b_4r_hash_nodes(uint8_t *out, const uint8_t *in, size_t count) {
+    blake2b_4r_hash_nodes_impl(out, in, count);
+}
+
+
 int blake2b_update(blake2b_state *S, const void *in, size_t inlen) {
     const uint8_t *pin = (const uint8_t *)in;
 
@@ -299,14 +701,14 @@ int blake2b_update(blake2b_state *S, const void *in, size_t inlen) {
         size_t fill = BLAKE2B_BLOCKBYTES - left;
         memcpy(&S->buf[left], pin, fill);
         blake2b_increment_counter(S, BLAKE2B_BLOCKBYTES);
-        blake2b_compress(S, S->buf);
+        blake2b_compress_impl(S, S->buf);
         S->buflen = 0;
         inlen -= fill;
         pin += fill;
         /* Avoid buffer copies when possible */
         while (inlen > BLAKE2B_BLOCKBYTES) {
             blake2b_increment_counter(S, BLAKE2B_BLOCKBYTES);
-            blake2b_compress(S, pin);
+            blake2b_compress_impl(S, pin);
             inlen -= BLAKE2B_BLOCKBYTES;
             pin += BLAKE2B_BLOCKBYTES;
         }
@@ -339,14 +741,14 @@ int blake2b_4r_update(blake2b_state *S, const void *in, size_t inlen) {
         size_t fill = BLAKE2B_BLOCKBYTES - left;
         memcpy(&S->buf[left], pin, fill);
         blake2b_increment_counter(S, BLAKE2B_BLOCKBYTES);
-        blake2b_4r_compress(S, S->buf);
+        blake2b_4r_compress_impl(S, S->buf);
         S->buflen = 0;
         inlen -= fill;
         pin += fill;
         /* Avoid buffer copies when possible */
         while (inlen > BLAKE2B_BLOCKBYTES) {
             blake2b_increment_counter(S, BLAKE2B_BLOCKBYTES);
-            blake2b_4r_compress(S, pin);
+            blake2b_4r_compress_impl(S, pin);
             inlen -= BLAKE2B_BLOCKBYTES;
             pin += BLAKE2B_BLOCKBYTES;
         }
@@ -374,7 +776,7 @@ int blake2b_final(blake2b_state *S, void *out, size_t outlen) {
     blake2b_increment_counter(S, S->buflen);
     blake2b_set_lastblock(S);
     memset(&S->buf[S->buflen], 0, BLAKE2B_BLOCKBYTES - S->buflen); /* Padding */
-    blake2b_compress(S, S->buf);
+    blake2b_compress_impl(S, S->buf);
 
     for (i = 0; i < 8; ++i) { /* Output full hash to temp buffer */
         store64(buffer + sizeof(S->h[i]) * i, S->h[i]);
@@ -404,7 +806,7 @@ int blake2b_4r_final(blake2b_state *S, void *out, size_t outlen) {
     blake2b_increment_counter(S, S->buflen);
     blake2b_set_lastblock(S);
     memset(&S->buf[S->buflen], 0, BLAKE2B_BLOCKBYTES - S->buflen); /* Padding */
-    blake2b_4r_compress(S, S->buf);
+    blake2b_4r_compress_impl(S, S->buf);
 
     for (i = 0; i < 8; ++i) { /* Output full hash to temp buffer */
         store64(buffer + sizeof(S->h[i]) * i, S->h[i]);
@@ -2,6 +2,8 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <array>
+#include <string.h>
 #include "blake2/blake2.h"
 
 std::ostream& operator<<(std::ostream& os, const MerkleTree::Buffer& buffer)
@@ -21,6 +23,7 @@ MerkleTree::MerkleTree(const Elements& elements, bool preserveOrder)
         throw std::runtime_error("Empty elements list");
     }
 
+    Elements leaves;
     for (   Elements::const_iterator it = elements.begin();
             it != elements.end();
             ++it) {
@@ -33,18 +36,39 @@ MerkleTree::MerkleTree(const Elements& elements, bool preserveOrder)
                 << MERKLE_TREE_ELEMENT_SIZE_B;
             throw std::runtime_error(oss.str());
         }
-        if (!preserveOrder_) {
-            // Check that this element has not been pushed yet
-            if (std::find(elements_.begin(), elements_.end(), *it)
-                    != elements_.end()) {
-                continue; // ignore duplicates
-            }
-        }
-        elements_.push_back(*it);
+        leaves.push_back(*it);
     } // for each element
 
     if (!preserveOrder_) {
-        std::sort(elements_.begin(), elements_.end()); // sort elements
+        // sort elements and ignore duplicates
+        std::sort(leaves.begin(), leaves.end());
+        leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+    }
+    if (leaves.empty()) {
+        throw std::runtime_error("Empty elements list");
+    }
+
+    nodes_.reserve(leaves.size() * MERKLE_TREE_ELEMENT_SIZE_B);
+    for (   Elements::const_iterator it = leaves.begin();
+            it != leaves.end();
+            ++it) {
+        nodes_.insert(nodes_.end(), it->begin(), it->end());
+    }
+
+    getLayers();
+}
+
+MerkleTree::MerkleTree(std::vector<uint8_t> leaves)
+    : preserveOrder_(true), nodes_(std::move(leaves))
+{
+    if (nodes_.empty()) {
+        throw std::runtime_error("Empty elements list");
+    }
+    if (nodes_.size() % MERKLE_TREE_ELEMENT_SIZE_B != 0) {
+        std::ostringstream oss;
+        oss << "Elements size is " << nodes_.size() << ", it must be a "
+            << "multiple of " << MERKLE_TREE_ELEMENT_SIZE_B;
+        throw std::runtime_error(oss.str());
     }
 
     getLayers();
@@ -58,8 +82,8 @@ MerkleTree::Buffer MerkleTree::hash(const Buffer& data)
 {
     blake2b_state state;
     blake2b_init(&state, MERKLE_TREE_ELEMENT_SIZE_B);
-    for (Buffer::const_iterator it = data.begin(); it != data.end(); ++it) {
-        blake2b_4r_update(&state, &(*it), sizeof(*it));
+    if (!data.empty()) {
+        blake2b_4r_update(&state, data.data(), data.size());
     }
     uint8_t digest[MERKLE_TREE_ELEMENT_SIZE_B];
     blake2b_4r_final(&state, digest, sizeof(digest));
@@ -89,18 +113,15 @@ MerkleTree::Buffer MerkleTree::merkleRoot(const Elements& elements,
 
 MerkleTree::Elements MerkleTree::getProof(const Buffer& element) const
 {
-    bool found = false;
-    size_t index;
-    for (size_t i = 0; (i < elements_.size()) && !found; ++i) {
-        if (elements_[i] == element) {
-            found = true;
-            index = i;
+    if (element.size() == MERKLE_TREE_ELEMENT_SIZE_B) {
+        for (size_t i = 0; i < layerSize(0); ++i) {
+            if (memcmp(&nodes_[i * MERKLE_TREE_ELEMENT_SIZE_B], element.data(),
+                        MERKLE_TREE_ELEMENT_SIZE_B) == 0) {
+                return getProof(i);
+            }
         }
     }
-    if (!found) {
-        throw std::runtime_error("Element not found");
-    }
-    return getProof(index);
+    throw std::runtime_error("Element not found");
 }
 
 std::string MerkleTree::getProofHex(const Buffer& element) const
@@ -115,7 +136,7 @@ MerkleTree::Elements MerkleTree::getProofOrdered(const Buffer& element,
         throw std::runtime_error("Index is zero");
     }
     index--;
-    if ((index >= elements_.size()) || (elements_[index] != element)) {
+    if ((index >= layerSize(0)) || (MerkleTree::element(0, index) != element)) {
         throw std::runtime_error("Index does not point to element");
     }
     return getProof(index);
@@ -172,15 +193,7 @@ bool MerkleTree::checkProofOrdered(const Elements& proof,
     --index; // `index` argument starts at 1
     Buffer tempHash = element;
     for (size_t i = 0; i < proof.size(); ++i) {
-        size_t remaining = proof.size() - i;
-
-        // We don't assume that the tree is padded to a power of 2. If the
-        // index is even and the last one of the layer, then the proof starts
-        // with a hash at a higher layer, so we have to adjust the index to be
-        // the index at that layer.
-        while (((index & 1) == 0) && (index >= (1u << remaining))) {
-            index = index / 2;
-        }
+        skipUnpairedLayers(index, proof.size() - i);
 
         if (index & 1) {
             tempHash = combinedHash(proof[i], tempHash, true);
@@ -192,77 +205,177 @@ bool MerkleTree::checkProofOrdered(const Elements& proof,
     return tempHash == root;
 }
 
-void MerkleTree::getLayers()
+bool MerkleTree::checkProofsOrdered(const std::vector<OrderedProof>& proofs,
+        const Buffer& root, size_t* invalid)
 {
-    layers_.clear();
+    typedef std::array<uint8_t, 2 * MERKLE_TREE_ELEMENT_SIZE_B> Pair;
+
+    std::vector<Buffer> tempHashes;
+    std::vector<size_t> indexes;
+    size_t maxProofSize = 0;
+    for (   std::vector<OrderedProof>::const_iterator it = proofs.begin();
+            it != proofs.end();
+            ++it) {
+        tempHashes.push_back(it->element);
+        indexes.push_back(it->index - 1); // `index` starts at 1
+        maxProofSize = std::max(maxProofSize, it->proof->size());
+    }
 
-    // The first layer is the elements themselves
-    layers_.push_back(elements_);
+    // Walk up all the proofs at the same time: at each step, every proof
+    // needs one hash, those are computed together and only once if several
+    // proofs need the same one
+    std::vector<std::pair<Pair, size_t>> pairs; // pair, position in `proofs`
+    std::vector<uint8_t> input, digests;
+    for (size_t i = 0; i < maxProofSize; ++i) {
+        pairs.clear();
+        for (size_t p = 0; p < proofs.size(); ++p) {
+            const Elements& proof = *proofs[p].proof;
+            if (i >= proof.size()) {
+                continue;
+            }
+            skipUnpairedLayers(indexes[p], proof.size() - i);
+
+            const Buffer& first = (indexes[p] & 1) ? proof[i] : tempHashes[p];
+            const Buffer& second = (indexes[p] & 1) ? tempHashes[p] : proof[i];
+            if ((first.size() == MERKLE_TREE_ELEMENT_SIZE_B)
+                    && (second.size() == MERKLE_TREE_ELEMENT_SIZE_B)) {
+                pairs.emplace_back(Pair(), p);
+                std::copy(first.begin(), first.end(), pairs.back().first.begin());
+                std::copy(second.begin(), second.end(),
+                        pairs.back().first.begin() + MERKLE_TREE_ELEMENT_SIZE_B);
+            } else {
+                // Elements of another size can't be hashed in batches
+                tempHashes[p] = combinedHash(first, second, true);
+            }
+            indexes[p] = indexes[p] / 2;
+        }
 
-    if (elements_.empty()) {
-        return; // nothing left to do
+        // Hash every distinct pair once
+        std::sort(pairs.begin(), pairs.end());
+        input.clear();
+        for (size_t k = 0; k < pairs.size(); ++k) {
+            if ((k == 0) || (pairs[k].first != pairs[k - 1].first)) {
+                input.insert(input.end(), pairs[k].first.begin(),
+                        pairs[k].first.end());
+            }
+        }
+        size_t count = input.size() / (2 * MERKLE_TREE_ELEMENT_SIZE_B);
+        digests.resize(count * MERKLE_TREE_ELEMENT_SIZE_B);
+        blake2b_4r_hash_nodes(digests.data(), input.data(), count);
+
+        size_t digest = 0;
+        for (size_t k = 0; k < pairs.size(); ++k) {
+            if ((k > 0) && (pairs[k].first != pairs[k - 1].first)) {
+                ++digest;
+            }
+            const uint8_t* begin = &digests[digest * MERKLE_TREE_ELEMENT_SIZE_B];
+            tempHashes[pairs[k].second].assign(begin,
+                    begin + MERKLE_TREE_ELEMENT_SIZE_B);
+        }
     }
 
-    // For subsequent layers, combine each pair of hashes in the previous
-    // layer to build the current layer. Repeat until the current layer has
-    // only one hash (this will be the root of the tree).
-    while (layers_.back().size() > 1) {
-        getNextLayer();
+    for (size_t p = 0; p < proofs.size(); ++p) {
+        if (tempHashes[p] != root) {
+            if (invalid) {
+                *invalid = p;
+            }
+            return false;
+        }
     }
+    return true;
 }
 
-void MerkleTree::getNextLayer()
+void MerkleTree::skipUnpairedLayers(size_t& index, size_t remaining)
 {
-    const Elements& previous_layer = layers_.back();
-
-    // Create a new empty layer
-    layers_.push_back(Elements());
-    Elements& current_layer = layers_.back();
-
-    // For each pair of elements in the previous layer
-    // NB: If there is an odd number of elements, we ignore the last one for now
-    for (size_t i = 0; i < (previous_layer.size() / 2); ++i) {
-        current_layer.push_back(combinedHash(previous_layer[2*i],
-                    previous_layer[2*i + 1], preserveOrder_));
+    while (((index & 1) == 0) && (index >= (1u << remaining))) {
+        index = index / 2;
     }
+}
 
-    // If there is an odd one out at the end, process it
-    // NB: It's on its own, so we don't combine it with anything
-    if (previous_layer.size() & 1) {
-        current_layer.push_back(previous_layer.back());
+void MerkleTree::getLayers()
+{
+    // Layer sizes: each layer combines the pairs of hashes of the previous
+    // layer, until the current layer has only one hash (this will be the root
+    // of the tree)
+    size_t nodeCount = 0;
+    layerOffsets_.clear();
+    for (size_t size = nodes_.size() / MERKLE_TREE_ELEMENT_SIZE_B; ;
+            size = (size + 1) / 2) {
+        layerOffsets_.push_back(nodeCount);
+        nodeCount += size;
+        if (size <= 1) {
+            break;
+        }
+    }
+    nodes_.resize(nodeCount * MERKLE_TREE_ELEMENT_SIZE_B);
+
+    std::vector<uint8_t> ordered;
+    for (size_t layer = 1; layer < layerOffsets_.size(); ++layer) {
+        const uint8_t* previous = &nodes_[layerOffsets_[layer - 1]
+            * MERKLE_TREE_ELEMENT_SIZE_B];
+        uint8_t* current = &nodes_[layerOffsets_[layer]
+            * MERKLE_TREE_ELEMENT_SIZE_B];
+        size_t pairCount = layerSize(layer - 1) / 2;
+
+        // With the order preserved, the pairs of the previous layer are
+        // already stored as the inputs of the hashes
+        const uint8_t* input = previous;
+        if (!preserveOrder_) {
+            ordered.resize(pairCount * 2 * MERKLE_TREE_ELEMENT_SIZE_B);
+            for (size_t i = 0; i < pairCount; ++i) {
+                const uint8_t* first = previous + 2 * i * MERKLE_TREE_ELEMENT_SIZE_B;
+                const uint8_t* second = first + MERKLE_TREE_ELEMENT_SIZE_B;
+                if (memcmp(first, second, MERKLE_TREE_ELEMENT_SIZE_B) < 0) {
+                    std::swap(first, second); // see combinedHash()
+                }
+                memcpy(&ordered[2 * i * MERKLE_TREE_ELEMENT_SIZE_B], first,
+                        MERKLE_TREE_ELEMENT_SIZE_B);
+                memcpy(&ordered[(2 * i + 1) * MERKLE_TREE_ELEMENT_SIZE_B],
+                        second, MERKLE_TREE_ELEMENT_SIZE_B);
+            }
+            input = ordered.data();
+        }
+        blake2b_4r_hash_nodes(current, input, pairCount);
+
+        // If there is an odd one out at the end, process it
+        // NB: It's on its own, so we don't combine it with anything
+        if (layerSize(layer - 1) & 1) {
+            memcpy(current + pairCount * MERKLE_TREE_ELEMENT_SIZE_B,
+                    previous + 2 * pairCount * MERKLE_TREE_ELEMENT_SIZE_B,
+                    MERKLE_TREE_ELEMENT_SIZE_B);
+        }
     }
 }
 
+size_t MerkleTree::layerSize(size_t layer) const
+{
+    size_t end = (layer + 1 < layerOffsets_.size())
+        ? layerOffsets_[layer + 1]
+        : nodes_.size() / MERKLE_TREE_ELEMENT_SIZE_B;
+    return end - layerOffsets_[layer];
+}
+
+MerkleTree::Buffer MerkleTree::element(size_t layer, size_t index) const
+{
+    const uint8_t* begin = &nodes_[(layerOffsets_[layer] + index)
+        * MERKLE_TREE_ELEMENT_SIZE_B];
+    return Buffer(begin, begin + MERKLE_TREE_ELEMENT_SIZE_B);
+}
+
 MerkleTree::Elements MerkleTree::getProof(size_t index) const
 {
     Elements proof;
-    for (   Layers::const_iterator it = layers_.begin();
-            it != layers_.end();
-            ++it) {
-        Buffer pair;
-        if (getPair(*it, index, pair)) {
-            proof.push_back(pair);
+    for (size_t layer = 0; layer < layerOffsets_.size(); ++layer) {
+        // The pair of an element is its neighbour, if the layer has one
+        size_t pairIndex = index ^ 1;
+        if (pairIndex < layerSize(layer)) {
+            proof.push_back(element(layer, pairIndex));
         }
         index = index / 2; // point to correct hash in next layer
     } // for each layer
     return proof;
 }
 
-bool MerkleTree::getPair(const Elements& layer, size_t index, Buffer& pair)
-{
-    size_t pairIndex;
-    if (index & 1) {
-        pairIndex = index - 1;
-    } else {
-        pairIndex = index + 1;
-    }
-    if (pairIndex >= layer.size()) {
-        return false;
-    }
-    pair = layer[pairIndex];
-    return true;
-}
-
 std::string MerkleTree::elementsToHex(const Elements& elements)
 {
     std::ostringstream oss;
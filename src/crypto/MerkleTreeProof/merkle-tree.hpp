@@ -9,6 +9,7 @@ extern "C" {
 #include <deque>
 #include <string>
 #include <stdexcept>
+#include <stddef.h>
 
 /** Size of a hash, in bytes
  *
@@ -53,6 +54,18 @@ public :
      */
     MerkleTree(const Elements& elements, bool preserveOrder = false);
 
+    /** Constructor for a Merkle Tree with preserved order
+     *
+     * Same as above with `preserveOrder` set to `true`, taking the elements
+     * stored one after the other, without building a list of them first.
+     *
+     * \param leaves [in] Elements, `MERKLE_TREE_ELEMENT_SIZE_B` bytes each
+     *
+     * \throw `std::runtime_error` if `leaves` is empty or its size is not a
+     *        multiple of `MERKLE_TREE_ELEMENT_SIZE_B`
+     */
+    explicit MerkleTree(std::vector<uint8_t> leaves);
+
     /** Destructor */
     virtual ~MerkleTree();
 
@@ -78,7 +91,7 @@ public :
     /** Get the root hash of the Merkle Tree */
     Buffer getRoot() const
     {
-        return layers_.back()[0];
+        return element(layerOffsets_.size() - 1, 0);
     }
 
     /** Compute a root hash given a set of hashes
@@ -199,26 +212,55 @@ public :
     static bool checkProofOrdered(const Elements& proof, const Buffer& root,
             const Buffer& element, size_t index);
 
+    /** A proof to check with `checkProofsOrdered()` */
+    struct OrderedProof
+    {
+        const Elements* proof; /**< Proof to check */
+        Buffer element;        /**< Element for which the proof is checked */
+        size_t index;          /**< Index of the element, starting at 1 */
+    };
+
+    /** Check several proofs for elements of the same Merkle Tree with order preserved
+     *
+     * This function gives the same result as calling `checkProofOrdered()`
+     * on every proof, but the proofs are checked together: the hashes of one
+     * level are computed several at a time, and a hash needed by several
+     * proofs (as happens close to the root) is only computed once.
+     *
+     * \param proofs  [in]  Proofs to check
+     * \param root    [in]  Root hash of the Merke Tree
+     * \param invalid [out] If not null and a proof is invalid, set to the
+     *                      position in `proofs` of the first invalid one
+     *
+     * \return `true` if all the proofs are valid, `false` if not
+     */
+    static bool checkProofsOrdered(const std::vector<OrderedProof>& proofs,
+            const Buffer& root, size_t* invalid = nullptr);
+
 private :
-    /** Layers data structure
+    bool preserveOrder_; /**< Whether to preserve the initial order */
+
+    /** Hashes of all the layers, one after the other
      *
-     * This data structure represents the various layers of the Merkle Tree.
      * The first layer is the initial list of hashes, the 2nd layer is the
      * combination of the hashes of the first layer, etc. until the last layer
      * which is the top-level hash, aka the root. The last layer has a length
-     * of one.
+     * of one. Each layer is contiguous so pairs of hashes can be combined
+     * without copying them.
      */
-    typedef std::deque<Elements> Layers;
+    std::vector<uint8_t> nodes_;
 
-    bool     preserveOrder_; /**< Whether to preserve the initial order */
-    Elements elements_;      /**< Leaves of the Merkle Tree */
-    Layers   layers_;        /**< The various layers of the Merkle Tree */
+    /** Position in `nodes_` of the first hash of every layer, in hashes */
+    std::vector<size_t> layerOffsets_;
 
-    /** Build the Merkle Tree layers */
+    /** Build the Merkle Tree layers from the leaves in `nodes_` */
     void getLayers();
 
-    /** Build the next Merkle Tree layer */
-    void getNextLayer();
+    /** Number of hashes in a layer */
+    size_t layerSize(size_t layer) const;
+
+    /** Get a hash given its layer and its index in the layer */
+    Buffer element(size_t layer, size_t index) const;
 
     /** Get proof given the index of the element
      *
@@ -228,17 +270,17 @@ private :
      */
     Elements getProof(size_t index) const;
 
-    /** Get the peer of an element
+    /** Move the index of a proof to the layer of the next hash of the proof
      *
-     * \param layer [in]  Layer to search
-     * \param index [in]  Index of element in layer
-     * \param pair  [out] Peer element
+     * We don't assume that the tree is padded to a power of 2. If the index
+     * is even and the last one of the layer, then the proof continues with a
+     * hash at a higher layer, so we have to adjust the index to be the index
+     * at that layer.
      *
-     * \return `true` if OK, `false` if no peer element (this can happen if
-     *         the `layer` has an odd number of elements, and you are asking
-     *         for the last one, which obviously has no peer)
+     * \param index     [in/out] Index of the element, starting at 0
+     * \param remaining [in]     Number of hashes left in the proof
      */
-    static bool getPair(const Elements& layer, size_t index, Buffer& pair);
+    static void skipUnpairedLayers(size_t& index, size_t remaining);
 
     /** Converts a list of hashes into a hexadecimal string */
     static std::string elementsToHex(const Elements& elements);
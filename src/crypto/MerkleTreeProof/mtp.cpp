@@ -295,6 +295,13 @@ bool mtp_verify(const char* input, const uint32_t target,
     initial_hash(h0, &context_verify, instance.type);
     
     // step 8
+    // The openings are checked together a few iterations at a time, so that
+    // the hashes shared by their Merkle paths are computed once. The first
+    // iteration is checked on its own, an invalid proof is mostly rejected
+    // before paying for the whole verification.
+    static const uint32_t OPENINGS_BATCH_ITERATIONS = 8;
+    std::vector<MerkleTree::OrderedProof> openings;
+    openings.reserve(OPENINGS_BATCH_ITERATIONS * 3);
     for (uint32_t j = 1; j <= L; ++j) {
         // compute ij
         std::string s = "0x" + y[j - 1].GetHex();
@@ -336,11 +343,7 @@ bool mtp_verify(const char* input, const uint32_t target,
         compute_blake2b(prev_block, digest_prev);
         MerkleTree::Buffer hash_prev(digest_prev,
                 digest_prev + sizeof(digest_prev));
-        if (!MerkleTree::checkProofOrdered(proof_mtp[(j * 3) - 2],
-                    root, hash_prev, ij_prev + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij_prev]\n");
-            return false;
-        }
+        openings.push_back({&proof_mtp[(j * 3) - 2], hash_prev, ij_prev + 1});
 
         //compute ref_index
         uint64_t prev_block_opening = prev_block.v[0];
@@ -367,11 +370,8 @@ bool mtp_verify(const char* input, const uint32_t target,
         uint8_t digest_ref[MERKLE_TREE_ELEMENT_SIZE_B];
         compute_blake2b(ref_block, digest_ref);
         MerkleTree::Buffer hash_ref(digest_ref, digest_ref + sizeof(digest_ref));
-        if (!MerkleTree::checkProofOrdered(proof_mtp[(j * 3) - 1],
-                    root, hash_ref, computed_ref_block + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij_ref]\n");
-            return false;
-        }
+        openings.push_back({&proof_mtp[(j * 3) - 1], hash_ref,
+                computed_ref_block + 1});
 
         // compute x[ij]
         block block_ij;
@@ -383,12 +383,7 @@ bool mtp_verify(const char* input, const uint32_t target,
         uint8_t digest_ij[MERKLE_TREE_ELEMENT_SIZE_B];
         compute_blake2b(block_ij, digest_ij);
         MerkleTree::Buffer hash_ij(digest_ij, digest_ij + sizeof(digest_ij));
-
-        if (!MerkleTree::checkProofOrdered(proof_mtp[(j * 3) - 3], root,
-                    hash_ij, ij + 1)) {
-            LogPrintf("error : checkProofOrdered in x[ij]\n");
-            return false;
-        }
+        openings.push_back({&proof_mtp[(j * 3) - 3], hash_ij, ij + 1});
 
         // compute y(j)
         block blockhash;
@@ -403,6 +398,16 @@ bool mtp_verify(const char* input, const uint32_t target,
         clear_internal_memory(block_ij.v, ARGON2_BLOCK_SIZE);
         clear_internal_memory(blockhash.v, ARGON2_BLOCK_SIZE);
         clear_internal_memory(blockhash_bytes, ARGON2_BLOCK_SIZE);
+
+        if (j == 1 || j % OPENINGS_BATCH_ITERATIONS == 0 || j == L) {
+            size_t invalid = 0;
+            if (!MerkleTree::checkProofsOrdered(openings, root, &invalid)) {
+                static const char* const opening_names[] = { "x[ij_prev]", "x[ij_ref]", "x[ij]" };
+                LogPrintf("error : checkProofOrdered in %s\n", opening_names[invalid % 3]);
+                return false;
+            }
+            openings.clear();
+        }
     }    
 
     // step 9
@@ -496,14 +501,12 @@ bool mtp_hash1(const char* input, uint32_t target, uint8_t hash_root_mtp[16],
     Argon2CtxMtp(&context, Argon2_d, &instance);
 
     // step 2
-    MerkleTree::Elements elements;
+    std::vector<uint8_t> leaves(instance.memory_blocks * MERKLE_TREE_ELEMENT_SIZE_B);
     for (long int i = 0; i < instance.memory_blocks; ++i) {
-        uint8_t digest[MERKLE_TREE_ELEMENT_SIZE_B];
-        compute_blake2b(instance.memory[i], digest);
-        elements.emplace_back(digest, digest + sizeof(digest));
+        compute_blake2b(instance.memory[i], &leaves[i * MERKLE_TREE_ELEMENT_SIZE_B]);
     }
 
-    MerkleTree ordered_tree(elements, true);
+    MerkleTree ordered_tree(std::move(leaves));
     MerkleTree::Buffer root = ordered_tree.getRoot();
     std::copy(root.begin(), root.end(), hash_root_mtp);
 
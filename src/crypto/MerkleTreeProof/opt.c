@@ -0,0 +1,487 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/*
+ * SIMD implementations of fill_block_mtp(), following the layouts of the Argon2 opt.c
+ * kernels. blamka-round-opt.h picks its instruction set at compile time, these are
+ * compiled with target attributes instead so one binary can pick the fastest one at
+ * runtime, see mtp_impl_select().
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "argon2.h"
+#include "core.h"
+#include "opt.h"
+#include "ref.h"
+
+#include "blake2/blake2.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MTP_X86_SIMD
+#define MTP_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#endif
+
+/*
+ * MTP makes the compression depend on the block index and the seed: words 14 and
+ * 16..19 of R = ref ^ prev are replaced before the rounds (but not in the copy that
+ * is XORed back at the end). The vectors hold the words in block order, whatever
+ * their width.
+ */
+static void inject_mtp_words(void *state, uint32_t block_index, const uint8_t *hash_zero) {
+    uint32_t the_index[2] = {0, block_index};
+    memcpy((uint8_t *)state + 14 * sizeof(uint64_t), the_index, sizeof(uint64_t));
+    memcpy((uint8_t *)state + 16 * sizeof(uint64_t), hash_zero, 4 * sizeof(uint64_t));
+}
+
+#ifdef MTP_X86_SIMD
+
+/* SSE4.1: 64 vectors of 2 words, BLAKE2_ROUND from blamka-round-opt.h (SSSE3 path) */
+
+#define SSE_ROTR32(x) _mm_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define SSE_ROTR24(x) _mm_shuffle_epi8((x), _mm_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10))
+#define SSE_ROTR16(x) _mm_shuffle_epi8((x), _mm_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9))
+#define SSE_ROTR63(x) _mm_xor_si128(_mm_srli_epi64((x), 63), _mm_add_epi64((x), (x)))
+
+MTP_TARGET("sse4.1") static inline __m128i fBlaMkaSSE41(__m128i x, __m128i y) {
+    const __m128i z = _mm_mul_epu32(x, y);
+    return _mm_add_epi64(_mm_add_epi64(x, y), _mm_add_epi64(z, z));
+}
+
+#define SSE_G(A0, B0, C0, D0, A1, B1, C1, D1, ROTD, ROTB)                      \
+    do {                                                                       \
+        A0 = fBlaMkaSSE41(A0, B0);                                             \
+        A1 = fBlaMkaSSE41(A1, B1);                                             \
+        D0 = ROTD(_mm_xor_si128(D0, A0));                                      \
+        D1 = ROTD(_mm_xor_si128(D1, A1));                                      \
+        C0 = fBlaMkaSSE41(C0, D0);                                             \
+        C1 = fBlaMkaSSE41(C1, D1);                                             \
+        B0 = ROTB(_mm_xor_si128(B0, C0));                                      \
+        B1 = ROTB(_mm_xor_si128(B1, C1));                                      \
+    } while ((void)0, 0)
+
+#define SSE_DIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1)                        \
+    do {                                                                       \
+        __m128i t0 = _mm_alignr_epi8(B1, B0, 8);                               \
+        __m128i t1 = _mm_alignr_epi8(B0, B1, 8);                               \
+        B0 = t0;                                                               \
+        B1 = t1;                                                               \
+        t0 = C0;                                                               \
+        C0 = C1;                                                               \
+        C1 = t0;                                                               \
+        t0 = _mm_alignr_epi8(D1, D0, 8);                                       \
+        t1 = _mm_alignr_epi8(D0, D1, 8);                                       \
+        D0 = t1;                                                               \
+        D1 = t0;                                                               \
+    } while ((void)0, 0)
+
+#define SSE_UNDIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1)                      \
+    do {                                                                       \
+        __m128i t0 = _mm_alignr_epi8(B0, B1, 8);                               \
+        __m128i t1 = _mm_alignr_epi8(B1, B0, 8);                               \
+        B0 = t0;                                                               \
+        B1 = t1;                                                               \
+        t0 = C0;                                                               \
+        C0 = C1;                                                               \
+        C1 = t0;                                                               \
+        t0 = _mm_alignr_epi8(D0, D1, 8);                                       \
+        t1 = _mm_alignr_epi8(D1, D0, 8);                                       \
+        D0 = t1;                                                               \
+        D1 = t0;                                                               \
+    } while ((void)0, 0)
+
+#define SSE_ROUND(A0, A1, B0, B1, C0, C1, D0, D1)                              \
+    do {                                                                       \
+        SSE_G(A0, B0, C0, D0, A1, B1, C1, D1, SSE_ROTR32, SSE_ROTR24);         \
+        SSE_G(A0, B0, C0, D0, A1, B1, C1, D1, SSE_ROTR16, SSE_ROTR63);         \
+        SSE_DIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1);                       \
+        SSE_G(A0, B0, C0, D0, A1, B1, C1, D1, SSE_ROTR32, SSE_ROTR24);         \
+        SSE_G(A0, B0, C0, D0, A1, B1, C1, D1, SSE_ROTR16, SSE_ROTR63);         \
+        SSE_UNDIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1);                     \
+    } while ((void)0, 0)
+
+MTP_TARGET("sse4.1") static void fill_block_mtp_sse41(const block *prev_block, const block *ref_block,
+        block *next_block, int with_xor, uint32_t block_index, uint8_t *hash_zero) {
+    __m128i state[ARGON2_OWORDS_IN_BLOCK];
+    __m128i block_XY[ARGON2_OWORDS_IN_BLOCK];
+    unsigned i;
+
+    for (i = 0; i < ARGON2_OWORDS_IN_BLOCK; i++) {
+        state[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)prev_block->v + i),
+                                 _mm_loadu_si128((const __m128i *)ref_block->v + i));
+        block_XY[i] = with_xor ? _mm_xor_si128(state[i], _mm_loadu_si128((const __m128i *)next_block->v + i)) : state[i];
+    }
+    inject_mtp_words(state, block_index, hash_zero);
+
+    for (i = 0; i < 8; ++i) {
+        SSE_ROUND(state[8 * i + 0], state[8 * i + 1], state[8 * i + 2], state[8 * i + 3],
+                  state[8 * i + 4], state[8 * i + 5], state[8 * i + 6], state[8 * i + 7]);
+    }
+    for (i = 0; i < 8; ++i) {
+        SSE_ROUND(state[8 * 0 + i], state[8 * 1 + i], state[8 * 2 + i], state[8 * 3 + i],
+                  state[8 * 4 + i], state[8 * 5 + i], state[8 * 6 + i], state[8 * 7 + i]);
+    }
+
+    for (i = 0; i < ARGON2_OWORDS_IN_BLOCK; i++)
+        _mm_storeu_si128((__m128i *)next_block->v + i, _mm_xor_si128(state[i], block_XY[i]));
+}
+
+/* AVX2: 32 vectors of 4 words, BLAKE2_ROUND_1/2 from blamka-round-opt.h */
+
+#define AVX2_ROTR32(x) _mm256_shuffle_epi32((x), _MM_SHUFFLE(2, 3, 0, 1))
+#define AVX2_ROTR24(x) _mm256_shuffle_epi8((x), _mm256_setr_epi8(3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10, 3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10))
+#define AVX2_ROTR16(x) _mm256_shuffle_epi8((x), _mm256_setr_epi8(2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9, 2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9))
+#define AVX2_ROTR63(x) _mm256_xor_si256(_mm256_srli_epi64((x), 63), _mm256_add_epi64((x), (x)))
+
+MTP_TARGET("avx2") static inline __m256i fBlaMkaAVX2(__m256i x, __m256i y) {
+    const __m256i z = _mm256_mul_epu32(x, y);
+    return _mm256_add_epi64(_mm256_add_epi64(x, y), _mm256_add_epi64(z, z));
+}
+
+#define AVX2_G(A0, A1, B0, B1, C0, C1, D0, D1, ROTD, ROTB)                     \
+    do {                                                                       \
+        A0 = fBlaMkaAVX2(A0, B0);                                              \
+        A1 = fBlaMkaAVX2(A1, B1);                                              \
+        D0 = ROTD(_mm256_xor_si256(D0, A0));                                   \
+        D1 = ROTD(_mm256_xor_si256(D1, A1));                                   \
+        C0 = fBlaMkaAVX2(C0, D0);                                              \
+        C1 = fBlaMkaAVX2(C1, D1);                                              \
+        B0 = ROTB(_mm256_xor_si256(B0, C0));                                   \
+        B1 = ROTB(_mm256_xor_si256(B1, C1));                                   \
+    } while ((void)0, 0)
+
+#define AVX2_GG(A0, A1, B0, B1, C0, C1, D0, D1)                                \
+    do {                                                                       \
+        AVX2_G(A0, A1, B0, B1, C0, C1, D0, D1, AVX2_ROTR32, AVX2_ROTR24);      \
+        AVX2_G(A0, A1, B0, B1, C0, C1, D0, D1, AVX2_ROTR16, AVX2_ROTR63);      \
+    } while ((void)0, 0)
+
+#define AVX2_DIAGONALIZE_1(A0, B0, C0, D0, A1, B1, C1, D1)                     \
+    do {                                                                       \
+        B0 = _mm256_permute4x64_epi64(B0, _MM_SHUFFLE(0, 3, 2, 1));            \
+        C0 = _mm256_permute4x64_epi64(C0, _MM_SHUFFLE(1, 0, 3, 2));            \
+        D0 = _mm256_permute4x64_epi64(D0, _MM_SHUFFLE(2, 1, 0, 3));            \
+        B1 = _mm256_permute4x64_epi64(B1, _MM_SHUFFLE(0, 3, 2, 1));            \
+        C1 = _mm256_permute4x64_epi64(C1, _MM_SHUFFLE(1, 0, 3, 2));            \
+        D1 = _mm256_permute4x64_epi64(D1, _MM_SHUFFLE(2, 1, 0, 3));            \
+    } while ((void)0, 0)
+
+#define AVX2_UNDIAGONALIZE_1(A0, B0, C0, D0, A1, B1, C1, D1)                   \
+    do {                                                                       \
+        B0 = _mm256_permute4x64_epi64(B0, _MM_SHUFFLE(2, 1, 0, 3));            \
+        C0 = _mm256_permute4x64_epi64(C0, _MM_SHUFFLE(1, 0, 3, 2));            \
+        D0 = _mm256_permute4x64_epi64(D0, _MM_SHUFFLE(0, 3, 2, 1));            \
+        B1 = _mm256_permute4x64_epi64(B1, _MM_SHUFFLE(2, 1, 0, 3));            \
+        C1 = _mm256_permute4x64_epi64(C1, _MM_SHUFFLE(1, 0, 3, 2));            \
+        D1 = _mm256_permute4x64_epi64(D1, _MM_SHUFFLE(0, 3, 2, 1));            \
+    } while ((void)0, 0)
+
+#define AVX2_DIAGONALIZE_2(A0, A1, B0, B1, C0, C1, D0, D1)                     \
+    do {                                                                       \
+        __m256i tmp1 = _mm256_blend_epi32(B0, B1, 0xCC);                       \
+        __m256i tmp2 = _mm256_blend_epi32(B0, B1, 0x33);                       \
+        B1 = _mm256_permute4x64_epi64(tmp1, _MM_SHUFFLE(2, 3, 0, 1));          \
+        B0 = _mm256_permute4x64_epi64(tmp2, _MM_SHUFFLE(2, 3, 0, 1));          \
+        tmp1 = C0;                                                             \
+        C0 = C1;                                                               \
+        C1 = tmp1;                                                             \
+        tmp1 = _mm256_blend_epi32(D0, D1, 0xCC);                               \
+        tmp2 = _mm256_blend_epi32(D0, D1, 0x33);                               \
+        D0 = _mm256_permute4x64_epi64(tmp1, _MM_SHUFFLE(2, 3, 0, 1));          \
+        D1 = _mm256_permute4x64_epi64(tmp2, _MM_SHUFFLE(2, 3, 0, 1));          \
+    } while ((void)0, 0)
+
+#define AVX2_UNDIAGONALIZE_2(A0, A1, B0, B1, C0, C1, D0, D1)                   \
+    do {                                                                       \
+        __m256i tmp1 = _mm256_blend_epi32(B0, B1, 0xCC);                       \
+        __m256i tmp2 = _mm256_blend_epi32(B0, B1, 0x33);                       \
+        B0 = _mm256_permute4x64_epi64(tmp1, _MM_SHUFFLE(2, 3, 0, 1));          \
+        B1 = _mm256_permute4x64_epi64(tmp2, _MM_SHUFFLE(2, 3, 0, 1));          \
+        tmp1 = C0;                                                             \
+        C0 = C1;                                                               \
+        C1 = tmp1;                                                             \
+        tmp1 = _mm256_blend_epi32(D0, D1, 0x33);                               \
+        tmp2 = _mm256_blend_epi32(D0, D1, 0xCC);                               \
+        D0 = _mm256_permute4x64_epi64(tmp1, _MM_SHUFFLE(2, 3, 0, 1));          \
+        D1 = _mm256_permute4x64_epi64(tmp2, _MM_SHUFFLE(2, 3, 0, 1));          \
+    } while ((void)0, 0)
+
+#define AVX2_ROUND_1(A0, A1, B0, B1, C0, C1, D0, D1)                           \
+    do {                                                                       \
+        AVX2_GG(A0, A1, B0, B1, C0, C1, D0, D1);                               \
+        AVX2_DIAGONALIZE_1(A0, B0, C0, D0, A1, B1, C1, D1);                    \
+        AVX2_GG(A0, A1, B0, B1, C0, C1, D0, D1);                               \
+        AVX2_UNDIAGONALIZE_1(A0, B0, C0, D0, A1, B1, C1, D1);                  \
+    } while ((void)0, 0)
+
+#define AVX2_ROUND_2(A0, A1, B0, B1, C0, C1, D0, D1)                           \
+    do {                                                                       \
+        AVX2_GG(A0, A1, B0, B1, C0, C1, D0, D1);                               \
+        AVX2_DIAGONALIZE_2(A0, A1, B0, B1, C0, C1, D0, D1);                    \
+        AVX2_GG(A0, A1, B0, B1, C0, C1, D0, D1);                               \
+        AVX2_UNDIAGONALIZE_2(A0, A1, B0, B1, C0, C1, D0, D1);                  \
+    } while ((void)0, 0)
+
+MTP_TARGET("avx2") static void fill_block_mtp_avx2(const block *prev_block, const block *ref_block,
+        block *next_block, int with_xor, uint32_t block_index, uint8_t *hash_zero) {
+    __m256i state[ARGON2_HWORDS_IN_BLOCK];
+    __m256i block_XY[ARGON2_HWORDS_IN_BLOCK];
+    unsigned i;
+
+    for (i = 0; i < ARGON2_HWORDS_IN_BLOCK; i++) {
+        state[i] = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)prev_block->v + i),
+                                    _mm256_loadu_si256((const __m256i *)ref_block->v + i));
+        block_XY[i] = with_xor ? _mm256_xor_si256(state[i], _mm256_loadu_si256((const __m256i *)next_block->v + i)) : state[i];
+    }
+    inject_mtp_words(state, block_index, hash_zero);
+
+    for (i = 0; i < 4; ++i) {
+        AVX2_ROUND_1(state[8 * i + 0], state[8 * i + 4], state[8 * i + 1], state[8 * i + 5],
+                     state[8 * i + 2], state[8 * i + 6], state[8 * i + 3], state[8 * i + 7]);
+    }
+    for (i = 0; i < 4; ++i) {
+        AVX2_ROUND_2(state[0 + i], state[4 + i], state[8 + i], state[12 + i],
+                     state[16 + i], state[20 + i], state[24 + i], state[28 + i]);
+    }
+
+    for (i = 0; i < ARGON2_HWORDS_IN_BLOCK; i++)
+        _mm256_storeu_si256((__m256i *)next_block->v + i, _mm256_xor_si256(state[i], block_XY[i]));
+}
+
+/* AVX-512F: 16 vectors of 8 words, BLAKE2_ROUND_1/2 from blamka-round-opt.h */
+
+MTP_TARGET("avx512f") static inline __m512i fBlaMkaAVX512(__m512i x, __m512i y) {
+    const __m512i z = _mm512_mul_epu32(x, y);
+    return _mm512_add_epi64(_mm512_add_epi64(x, y), _mm512_add_epi64(z, z));
+}
+
+#define AVX512_G(A0, B0, C0, D0, A1, B1, C1, D1, RD, RB)                       \
+    do {                                                                       \
+        A0 = fBlaMkaAVX512(A0, B0);                                            \
+        A1 = fBlaMkaAVX512(A1, B1);                                            \
+        D0 = _mm512_ror_epi64(_mm512_xor_si512(D0, A0), RD);                   \
+        D1 = _mm512_ror_epi64(_mm512_xor_si512(D1, A1), RD);                   \
+        C0 = fBlaMkaAVX512(C0, D0);                                            \
+        C1 = fBlaMkaAVX512(C1, D1);                                            \
+        B0 = _mm512_ror_epi64(_mm512_xor_si512(B0, C0), RB);                   \
+        B1 = _mm512_ror_epi64(_mm512_xor_si512(B1, C1), RB);                   \
+    } while ((void)0, 0)
+
+#define AVX512_PERMUTE(A0, A1, n)                                              \
+    do {                                                                       \
+        A0 = _mm512_permutex_epi64(A0, n);                                     \
+        A1 = _mm512_permutex_epi64(A1, n);                                     \
+    } while ((void)0, 0)
+
+#define AVX512_ROUND(A0, B0, C0, D0, A1, B1, C1, D1)                           \
+    do {                                                                       \
+        AVX512_G(A0, B0, C0, D0, A1, B1, C1, D1, 32, 24);                      \
+        AVX512_G(A0, B0, C0, D0, A1, B1, C1, D1, 16, 63);                      \
+        AVX512_PERMUTE(B0, B1, _MM_SHUFFLE(0, 3, 2, 1));                       \
+        AVX512_PERMUTE(C0, C1, _MM_SHUFFLE(1, 0, 3, 2));                       \
+        AVX512_PERMUTE(D0, D1, _MM_SHUFFLE(2, 1, 0, 3));                       \
+        AVX512_G(A0, B0, C0, D0, A1, B1, C1, D1, 32, 24);                      \
+        AVX512_G(A0, B0, C0, D0, A1, B1, C1, D1, 16, 63);                      \
+        AVX512_PERMUTE(B0, B1, _MM_SHUFFLE(2, 1, 0, 3));                       \
+        AVX512_PERMUTE(C0, C1, _MM_SHUFFLE(1, 0, 3, 2));                       \
+        AVX512_PERMUTE(D0, D1, _MM_SHUFFLE(0, 3, 2, 1));                       \
+    } while ((void)0, 0)
+
+#define AVX512_SWAP_HALVES(A0, A1)                                             \
+    do {                                                                       \
+        __m512i t0 = _mm512_shuffle_i64x2(A0, A1, _MM_SHUFFLE(1, 0, 1, 0));    \
+        __m512i t1 = _mm512_shuffle_i64x2(A0, A1, _MM_SHUFFLE(3, 2, 3, 2));    \
+        A0 = t0;                                                               \
+        A1 = t1;                                                               \
+    } while ((void)0, 0)
+
+#define AVX512_QUARTERS_PERMUTATION _mm512_setr_epi64(0, 1, 4, 5, 2, 3, 6, 7)
+
+#define AVX512_SWAP_QUARTERS(A0, A1)                                           \
+    do {                                                                       \
+        AVX512_SWAP_HALVES(A0, A1);                                            \
+        A0 = _mm512_permutexvar_epi64(AVX512_QUARTERS_PERMUTATION, A0);        \
+        A1 = _mm512_permutexvar_epi64(AVX512_QUARTERS_PERMUTATION, A1);        \
+    } while ((void)0, 0)
+
+#define AVX512_UNSWAP_QUARTERS(A0, A1)                                         \
+    do {                                                                       \
+        A0 = _mm512_permutexvar_epi64(AVX512_QUARTERS_PERMUTATION, A0);        \
+        A1 = _mm512_permutexvar_epi64(AVX512_QUARTERS_PERMUTATION, A1);        \
+        AVX512_SWAP_HALVES(A0, A1);                                            \
+    } while ((void)0, 0)
+
+#define AVX512_ROUND_1(A0, C0, B0, D0, A1, C1, B1, D1)                         \
+    do {                                                                       \
+        AVX512_SWAP_HALVES(A0, B0);                                            \
+        AVX512_SWAP_HALVES(C0, D0);                                            \
+        AVX512_SWAP_HALVES(A1, B1);                                            \
+        AVX512_SWAP_HALVES(C1, D1);                                            \
+        AVX512_ROUND(A0, B0, C0, D0, A1, B1, C1, D1);                          \
+        AVX512_SWAP_HALVES(A0, B0);                                            \
+        AVX512_SWAP_HALVES(C0, D0);                                            \
+        AVX512_SWAP_HALVES(A1, B1);                                            \
+        AVX512_SWAP_HALVES(C1, D1);                                            \
+    } while ((void)0, 0)
+
+#define AVX512_ROUND_2(A0, A1, B0, B1, C0, C1, D0, D1)                         \
+    do {                                                                       \
+        AVX512_SWAP_QUARTERS(A0, A1);                                          \
+        AVX512_SWAP_QUARTERS(B0, B1);                                          \
+        AVX512_SWAP_QUARTERS(C0, C1);                                          \
+        AVX512_SWAP_QUARTERS(D0, D1);                                          \
+        AVX512_ROUND(A0, B0, C0, D0, A1, B1, C1, D1);                          \
+        AVX512_UNSWAP_QUARTERS(A0, A1);                                        \
+        AVX512_UNSWAP_QUARTERS(B0, B1);                                        \
+        AVX512_UNSWAP_QUARTERS(C0, C1);                                        \
+        AVX512_UNSWAP_QUARTERS(D0, D1);                                        \
+    } while ((void)0, 0)
+
+MTP_TARGET("avx512f") static void fill_block_mtp_avx512(const block *prev_block, const block *ref_block,
+        block *next_block, int with_xor, uint32_t block_index, uint8_t *hash_zero) {
+    __m512i state[ARGON2_512BIT_WORDS_IN_BLOCK];
+    __m512i block_XY[ARGON2_512BIT_WORDS_IN_BLOCK];
+    unsigned i;
+
+    for (i = 0; i < ARGON2_512BIT_WORDS_IN_BLOCK; i++) {
+        state[i] = _mm512_xor_si512(_mm512_loadu_si512((const __m512i *)prev_block->v + i),
+                                    _mm512_loadu_si512((const __m512i *)ref_block->v + i));
+        block_XY[i] = with_xor ? _mm512_xor_si512(state[i], _mm512_loadu_si512((const __m512i *)next_block->v + i)) : state[i];
+    }
+    inject_mtp_words(state, block_index, hash_zero);
+
+    for (i = 0; i < 2; ++i) {
+        AVX512_ROUND_1(state[8 * i + 0], state[8 * i + 1], state[8 * i + 2], state[8 * i + 3],
+                       state[8 * i + 4], state[8 * i + 5], state[8 * i + 6], state[8 * i + 7]);
+    }
+    for (i = 0; i < 2; ++i) {
+        AVX512_ROUND_2(state[2 * 0 + i], state[2 * 1 + i], state[2 * 2 + i], state[2 * 3 + i],
+                       state[2 * 4 + i], state[2 * 5 + i], state[2 * 6 + i], state[2 * 7 + i]);
+    }
+
+    for (i = 0; i < ARGON2_512BIT_WORDS_IN_BLOCK; i++)
+        _mm512_storeu_si512((__m512i *)next_block->v + i, _mm512_xor_si512(state[i], block_XY[i]));
+}
+
+#endif // MTP_X86_SIMD
+
+/* Implementation in use, the reference one until mtp_impl_select() is called */
+static int mtpImpl = MTP_IMPL_REF;
+static void (*fill_block_mtp_impl)(const block *prev_block, const block *ref_block,
+        block *next_block, int with_xor, uint32_t block_index, uint8_t *hash_zero) = fill_block_mtp_ref;
+
+void fill_block_mtp(const block *prev_block, const block *ref_block,
+                    block *next_block, int with_xor, uint32_t block_index, uint8_t *hash_zero) {
+    fill_block_mtp_impl(prev_block, ref_block, next_block, with_xor, block_index, hash_zero);
+}
+
+int mtp_impl_supported(int impl) {
+    switch (impl) {
+    case MTP_IMPL_REF:
+        return 1;
+#ifdef MTP_X86_SIMD
+    case MTP_IMPL_SSE41:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1");
+    case MTP_IMPL_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    case MTP_IMPL_AVX512:
+        /* Blake2b has no AVX-512 kernel and uses the AVX2 one */
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return 0;
+    }
+}
+
+int mtp_impl_select(int impl) {
+    if (!mtp_impl_supported(impl))
+        return 0;
+    switch (impl) {
+#ifdef MTP_X86_SIMD
+    case MTP_IMPL_SSE41:
+        fill_block_mtp_impl = fill_block_mtp_sse41;
+        break;
+    case MTP_IMPL_AVX2:
+        fill_block_mtp_impl = fill_block_mtp_avx2;
+        break;
+    case MTP_IMPL_AVX512:
+        fill_block_mtp_impl = fill_block_mtp_avx512;
+        break;
+#endif
+    default:
+        fill_block_mtp_impl = fill_block_mtp_ref;
+        break;
+    }
+    blake2b_select_impl(impl);
+    mtpImpl = impl;
+    return 1;
+}
+
+const char* mtp_impl_name(void) {
+    switch (mtpImpl) {
+    case MTP_IMPL_SSE41:
+        return "sse4.1";
+    case MTP_IMPL_AVX2:
+        return "avx2";
+    case MTP_IMPL_AVX512:
+        return "avx512";
+    default:
+        return "ref";
+    }
+}
+
+/* Fills a few blocks (with and without XOR) and hashes them with both Blake2b variants
+ * and as Merkle nodes (19 nodes go through the full lanes and the tail of every kernel) */
+static void mtp_self_test_digest(uint8_t digest[BLAKE2B_OUTBYTES]) {
+    block blocks[4];
+    uint8_t hash_zero[ARGON2_PREHASH_SEED_LENGTH];
+    uint8_t nodes[19 * 16];
+    blake2b_state state;
+    unsigned i;
+
+    for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++) {
+        blocks[0].v[i] = UINT64_C(0x9e3779b97f4a7c15) * (i + 1);
+        blocks[1].v[i] = UINT64_C(0xc2b2ae3d27d4eb4f) * (i + 7);
+        blocks[2].v[i] = blocks[3].v[i] = i;
+    }
+    for (i = 0; i < sizeof(hash_zero); i++)
+        hash_zero[i] = (uint8_t)(3 * i + 1);
+
+    fill_block_mtp(&blocks[0], &blocks[1], &blocks[2], 0, 12345, hash_zero);
+    fill_block_mtp(&blocks[1], &blocks[2], &blocks[3], 1, 0x80000001, hash_zero);
+
+    blake2b_init(&state, BLAKE2B_OUTBYTES);
+    blake2b_4r_update(&state, blocks, sizeof(blocks) - 5);
+    blake2b_4r_final(&state, digest, BLAKE2B_OUTBYTES);
+    blake2b_init(&state, BLAKE2B_OUTBYTES);
+    blake2b_update(&state, digest, BLAKE2B_OUTBYTES);
+    blake2b_update(&state, blocks, sizeof(blocks));
+    blake2b_4r_hash_nodes(nodes, (const uint8_t *)blocks, 19);
+    blake2b_update(&state, nodes, sizeof(nodes));
+    blake2b_final(&state, digest, BLAKE2B_OUTBYTES);
+}
+
+const char* mtp_autodetect(void) {
+    static const int impls[] = { MTP_IMPL_AVX512, MTP_IMPL_AVX2, MTP_IMPL_SSE41 };
+    uint8_t expected[BLAKE2B_OUTBYTES], digest[BLAKE2B_OUTBYTES];
+    size_t i;
+
+    mtp_impl_select(MTP_IMPL_REF);
+    mtp_self_test_digest(expected);
+
+    for (i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+        if (!mtp_impl_select(impls[i]))
+            continue;
+        mtp_self_test_digest(digest);
+        if (memcmp(digest, expected, sizeof(digest)) == 0)
+            break;
+        mtp_impl_select(MTP_IMPL_REF);
+    }
+    return mtp_impl_name();
+}
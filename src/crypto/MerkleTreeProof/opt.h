@@ -0,0 +1,42 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef SRC_OPT_H_
+#define SRC_OPT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "core.h"
+
+/* Implementations of the Argon2 block filling and Blake2b compression used by MTP */
+#define MTP_IMPL_REF 0
+#define MTP_IMPL_SSE41 1
+#define MTP_IMPL_AVX2 2
+#define MTP_IMPL_AVX512 3
+
+/* Whether the CPU supports an implementation */
+int mtp_impl_supported(int impl);
+/* Use an implementation from now on, returns 0 if it isn't supported. Not thread safe. */
+int mtp_impl_select(int impl);
+/* Name of the implementation in use */
+const char* mtp_impl_name(void);
+/* Select the fastest implementation that gives the same blocks and hashes as the reference one, returns its name */
+const char* mtp_autodetect(void);
+
+/*
+ * Same as fill_block_mtp_ref() from ref.h, using the implementation selected with
+ * mtp_impl_select(). Used by both the miner and mtp_verify().
+ */
+void fill_block_mtp(const block *prev_block, const block *ref_block,
+                    block *next_block, int with_xor, uint32_t block_index, uint8_t *hash_zero);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_OPT_H_ */
@@ -0,0 +1,126 @@
+// Copyright (c) 2017-2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_MUHASH_H
+#define BITCOIN_CRYPTO_MUHASH_H
+
+#include "uint256.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/** A number modulo the 3072-bit safe prime 2^3072 - 1103717. */
+class Num3072
+{
+public:
+    static constexpr size_t BYTE_SIZE = 384;
+
+#ifdef __SIZEOF_INT128__
+    typedef unsigned __int128 double_limb_t;
+    typedef uint64_t limb_t;
+    static constexpr int LIMBS = 48;
+    static constexpr int LIMB_SIZE = 64;
+#else
+    typedef uint64_t double_limb_t;
+    typedef uint32_t limb_t;
+    static constexpr int LIMBS = 96;
+    static constexpr int LIMB_SIZE = 32;
+#endif
+
+private:
+    limb_t limbs[LIMBS];
+
+    // Sanity checks
+    static_assert(LIMB_SIZE * LIMBS == 3072, "Num3072 isn't 3072 bits");
+    static_assert(sizeof(double_limb_t) == sizeof(limb_t) * 2, "bad size for double_limb_t");
+    static_assert(sizeof(limb_t) * 8 == LIMB_SIZE, "LIMB_SIZE is incorrect");
+
+    bool IsOverflow() const;
+    void FullReduce();
+    Num3072 GetInverse() const;
+
+public:
+    Num3072() { SetToOne(); }
+    explicit Num3072(const unsigned char (&data)[BYTE_SIZE]);
+
+    void SetToOne();
+    void Multiply(const Num3072& a);
+    void Square();
+    void Divide(const Num3072& a);
+    //! Little endian bytes of the number, which may not be fully reduced
+    void ToBytes(unsigned char (&out)[BYTE_SIZE]) const;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        unsigned char data[BYTE_SIZE];
+        ToBytes(data);
+        s.write((const char*)data, BYTE_SIZE);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        unsigned char data[BYTE_SIZE];
+        s.read((char*)data, BYTE_SIZE);
+        *this = Num3072(data);
+    }
+};
+
+/**
+ * A hash of a set of byte strings which doesn't depend on the order they are
+ * added in, and from which an element can be removed again.
+ *
+ * Each element is hashed with SHA256 and expanded with ChaCha20 into a
+ * number modulo a 3072-bit prime, and the set hash is the product of these
+ * numbers: adding an element multiplies it in, removing one divides it out.
+ * Divisions are deferred by keeping a numerator and a denominator, so a
+ * modular inverse is only computed by Finalize(). Two MuHash3072 objects of
+ * disjoint sets can be combined with *= and /=.
+ *
+ * The security of the construction relies on the discrete logarithm problem
+ * in the multiplicative group of the field, see "Incremental Multiset Hash
+ * Functions and Their Application to Memory Integrity Checking" (Clarke et
+ * al., 2003) and https://cseweb.ucsd.edu/~mihir/papers/inchash.pdf.
+ */
+class MuHash3072
+{
+private:
+    Num3072 numerator;
+    Num3072 denominator;
+
+    static Num3072 ToNum3072(const unsigned char* data, size_t len);
+
+public:
+    //! The hash of the empty set
+    MuHash3072() {}
+
+    //! The hash of the set with a single element
+    MuHash3072(const unsigned char* data, size_t len);
+
+    MuHash3072& Insert(const unsigned char* data, size_t len);
+    MuHash3072& Remove(const unsigned char* data, size_t len);
+
+    MuHash3072& operator*=(const MuHash3072& mul);
+    MuHash3072& operator/=(const MuHash3072& div);
+
+    //! Writes the 256-bit hash of the set, which computes an inverse and can take a few milliseconds
+    void Finalize(uint256& out);
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        numerator.Serialize(s);
+        denominator.Serialize(s);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        numerator.Unserialize(s);
+        denominator.Unserialize(s);
+    }
+};
+
+#endif // BITCOIN_CRYPTO_MUHASH_H
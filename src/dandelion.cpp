@@ -0,0 +1,142 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "dandelion.h"
+
+#include <algorithm>
+
+namespace {
+
+const int64_t INNER_SLOTS = int64_t(1) << CDandelionEmbargoWheel::INNER_BITS;
+const int64_t OUTER_SLOTS = int64_t(1) << CDandelionEmbargoWheel::OUTER_BITS;
+
+int LevelShift(int nLevel)
+{
+    return CDandelionEmbargoWheel::INNER_BITS + CDandelionEmbargoWheel::OUTER_BITS * (nLevel - 1);
+}
+
+size_t OuterSlot(int nLevel, int64_t nLevelTick)
+{
+    return INNER_SLOTS + (nLevel - 1) * OUTER_SLOTS + (nLevelTick & (OUTER_SLOTS - 1));
+}
+
+} // anon namespace
+
+CDandelionEmbargoWheel::CDandelionEmbargoWheel() :
+    vSlots(INNER_SLOTS + OUTER_LEVELS * OUTER_SLOTS),
+    nCurrentTick(0)
+{
+}
+
+bool CDandelionEmbargoWheel::Insert(const uint256& hash, int64_t nEmbargoTime, int64_t nNow)
+{
+    if (mapEmbargo.empty()) {
+        // Nothing is pending, start the wheel at the current time
+        for (std::vector<Entry>& slot : vSlots)
+            slot.clear();
+        nCurrentTick = nNow / TICK_MICROS;
+    }
+    if (!mapEmbargo.emplace(hash, Embargo{nNow, nEmbargoTime}).second)
+        return false;
+    Schedule(Entry{hash, nEmbargoTime});
+    return true;
+}
+
+bool CDandelionEmbargoWheel::Contains(const uint256& hash) const
+{
+    return mapEmbargo.count(hash) != 0;
+}
+
+bool CDandelionEmbargoWheel::Remove(const uint256& hash)
+{
+    if (mapEmbargo.erase(hash) == 0)
+        return false;
+    stats.nRemoved++;
+    return true;
+}
+
+void CDandelionEmbargoWheel::Schedule(const Entry& entry)
+{
+    const int64_t nTick = std::max(entry.nEmbargoTime / TICK_MICROS, nCurrentTick);
+    if (nTick - nCurrentTick < INNER_SLOTS) {
+        vSlots[nTick & (INNER_SLOTS - 1)].push_back(entry);
+        return;
+    }
+    // A slot of an outer level is moved inwards at the start of its range, which has to be
+    // one of the next OUTER_SLOTS ranges of that level
+    for (int nLevel = 1; nLevel <= OUTER_LEVELS; nLevel++) {
+        const int nShift = LevelShift(nLevel);
+        if ((nTick >> nShift) - (nCurrentTick >> nShift) <= OUTER_SLOTS) {
+            vSlots[OuterSlot(nLevel, nTick >> nShift)].push_back(entry);
+            return;
+        }
+    }
+    vSlots[OuterSlot(OUTER_LEVELS, (nCurrentTick >> LevelShift(OUTER_LEVELS)) + OUTER_SLOTS)].push_back(entry);
+}
+
+void CDandelionEmbargoWheel::Cascade(int nLevel, int64_t nTick)
+{
+    std::vector<Entry> slot;
+    slot.swap(vSlots[OuterSlot(nLevel, nTick >> LevelShift(nLevel))]);
+    for (const Entry& entry : slot) {
+        auto it = mapEmbargo.find(entry.hash);
+        if (it != mapEmbargo.end() && it->second.nEmbargoTime == entry.nEmbargoTime)
+            Schedule(entry);
+    }
+}
+
+std::vector<uint256> CDandelionEmbargoWheel::PopExpired(int64_t nNow)
+{
+    std::vector<Entry> vDue;
+    const int64_t nNowTick = nNow / TICK_MICROS;
+    while (!mapEmbargo.empty() && nCurrentTick <= nNowTick) {
+        const int64_t nTick = nCurrentTick;
+        for (int nLevel = OUTER_LEVELS; nLevel >= 1; nLevel--) {
+            if ((nTick & ((int64_t(1) << LevelShift(nLevel)) - 1)) == 0)
+                Cascade(nLevel, nTick);
+        }
+
+        std::vector<Entry> slot;
+        slot.swap(vSlots[nTick & (INNER_SLOTS - 1)]);
+        nCurrentTick++;
+        for (const Entry& entry : slot) {
+            auto it = mapEmbargo.find(entry.hash);
+            if (it == mapEmbargo.end() || it->second.nEmbargoTime != entry.nEmbargoTime)
+                continue;
+            if (entry.nEmbargoTime > nNow) {
+                // Ends later within the tick of nNow, check again at the next tick
+                Schedule(entry);
+                continue;
+            }
+            const int64_t nFluffLatency = nNow - it->second.nStartTime;
+            const int64_t nExpiryDelay = nNow - entry.nEmbargoTime;
+            stats.nExpired++;
+            stats.nTotalFluffLatency += nFluffLatency;
+            stats.nMaxFluffLatency = std::max(stats.nMaxFluffLatency, nFluffLatency);
+            stats.nTotalExpiryDelay += nExpiryDelay;
+            stats.nMaxExpiryDelay = std::max(stats.nMaxExpiryDelay, nExpiryDelay);
+            mapEmbargo.erase(it);
+            vDue.push_back(entry);
+        }
+    }
+
+    std::stable_sort(vDue.begin(), vDue.end(), [](const Entry& a, const Entry& b) {
+        return a.nEmbargoTime < b.nEmbargoTime;
+    });
+    std::vector<uint256> vExpired;
+    vExpired.reserve(vDue.size());
+    for (const Entry& entry : vDue)
+        vExpired.push_back(entry.hash);
+    return vExpired;
+}
+
+std::vector<size_t> CDandelionEmbargoWheel::GetRemainingHistogram(int64_t nNow, const std::vector<int64_t>& vBoundaries) const
+{
+    std::vector<size_t> vCounts(vBoundaries.size() + 1, 0);
+    for (const auto& embargo : mapEmbargo) {
+        int64_t nRemaining = (embargo.second.nEmbargoTime - nNow) / 1000000;
+        vCounts[std::upper_bound(vBoundaries.begin(), vBoundaries.end(), nRemaining) - vBoundaries.begin()]++;
+    }
+    return vCounts;
+}
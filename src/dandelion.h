@@ -0,0 +1,108 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_DANDELION_H
+#define BITCOIN_DANDELION_H
+
+#include "uint256.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+/** Dandelion routing as of the last route shuffle */
+struct CDandelionShuffleStats
+{
+    uint64_t nShuffles = 0;
+    int64_t nLastShuffleTime = 0;
+    size_t nInbound = 0;
+    size_t nOutbound = 0;
+    size_t nDestinations = 0;
+    size_t nRoutes = 0;
+    //! Most inbound peers routed to a single destination
+    size_t nMaxRoutesPerDestination = 0;
+    bool fLocalDestination = false;
+};
+
+/** Statistics about the Dandelion embargoes, as reported by getdandelioninfo */
+struct CDandelionEmbargoStats
+{
+    //! Embargoes which expired, the transaction was fluffed by us
+    uint64_t nExpired = 0;
+    //! Embargoes removed because the transaction came back in fluff phase
+    uint64_t nRemoved = 0;
+    //! Total and maximum time from embargo start until expiry was processed, in microseconds
+    int64_t nTotalFluffLatency = 0;
+    int64_t nMaxFluffLatency = 0;
+    //! Total and maximum delay between the embargo time and the time expiry was processed
+    int64_t nTotalExpiryDelay = 0;
+    int64_t nMaxExpiryDelay = 0;
+};
+
+/**
+ * Embargo timers of the Dandelion transactions in the stem pool, kept in a hierarchical
+ * timer wheel. Inserting and removing an embargo costs O(log n), and checking for expired
+ * embargoes only touches the slots which became due since the last check, instead of
+ * iterating all embargoes every time a message is processed.
+ *
+ * The innermost level has one slot per tick of 100ms, every outer level covers the whole
+ * range of the level below in each slot. Entries of an outer slot are moved inwards when
+ * the wheel reaches it. Embargoes further away than the outermost level are parked in its
+ * last slot and moved inwards again until they are due. Removal is lazy: removed entries
+ * stay in their slot and are skipped when it is processed.
+ *
+ * Times are in microseconds. Not thread safe, guarded by cs_main.
+ */
+class CDandelionEmbargoWheel
+{
+public:
+    static const int64_t TICK_MICROS = 100 * 1000;
+    static const int INNER_BITS = 8;
+    static const int OUTER_BITS = 6;
+    static const int OUTER_LEVELS = 2;
+
+    CDandelionEmbargoWheel();
+
+    /** Start an embargo ending at nEmbargoTime. Returns false if hash is embargoed already. */
+    bool Insert(const uint256& hash, int64_t nEmbargoTime, int64_t nNow);
+    bool Contains(const uint256& hash) const;
+    /** Remove the embargo because the transaction was seen in fluff phase. */
+    bool Remove(const uint256& hash);
+
+    /**
+     * Move the wheel forward to nNow and return all embargoes which ended at or before it,
+     * ordered by the time they ended.
+     */
+    std::vector<uint256> PopExpired(int64_t nNow);
+
+    size_t Size() const { return mapEmbargo.size(); }
+    /** Number of embargoes ending in each of the given ranges of seconds from nNow. */
+    std::vector<size_t> GetRemainingHistogram(int64_t nNow, const std::vector<int64_t>& vBoundaries) const;
+    const CDandelionEmbargoStats& GetStats() const { return stats; }
+
+private:
+    struct Entry
+    {
+        uint256 hash;
+        int64_t nEmbargoTime;
+    };
+
+    struct Embargo
+    {
+        int64_t nStartTime;
+        int64_t nEmbargoTime;
+    };
+
+    std::map<uint256, Embargo> mapEmbargo;
+    //! Slots of the innermost level, followed by the slots of the outer levels
+    std::vector<std::vector<Entry>> vSlots;
+    //! Next tick to be processed
+    int64_t nCurrentTick;
+    CDandelionEmbargoStats stats;
+
+    void Schedule(const Entry& entry);
+    void Cascade(int nLevel, int64_t nTick);
+};
+
+#endif // BITCOIN_DANDELION_H
@@ -6,6 +6,7 @@
 
 #include "util.h"
 #include "random.h"
+#include "sync.h"
 
 #include <boost/filesystem.hpp>
 
@@ -15,46 +16,248 @@
 #include <memenv.h>
 #include <stdint.h>
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+/** Block cache that counts lookups so that getdbstats can report hit rates */
+class CCountingCache : public leveldb::Cache
+{
+private:
+    leveldb::Cache* cache;
+    size_t nCapacity;
+
+public:
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+
+    CCountingCache(size_t nCapacityIn) : cache(leveldb::NewLRUCache(nCapacityIn)), nCapacity(nCapacityIn), nHits(0), nMisses(0) {}
+    ~CCountingCache() { delete cache; }
+
+    Handle* Insert(const leveldb::Slice& key, void* value, size_t charge, void (*deleter)(const leveldb::Slice& key, void* value)) override
+    {
+        return cache->Insert(key, value, charge, deleter);
+    }
+
+    Handle* Lookup(const leveldb::Slice& key) override
+    {
+        Handle* handle = cache->Lookup(key);
+        if (handle)
+            nHits++;
+        else
+            nMisses++;
+        return handle;
+    }
+
+    void Release(Handle* handle) override { cache->Release(handle); }
+    void* Value(Handle* handle) override { return cache->Value(handle); }
+    void Erase(const leveldb::Slice& key) override { cache->Erase(key); }
+    uint64_t NewId() override { return cache->NewId(); }
+    void Prune() override { cache->Prune(); }
+    size_t TotalCharge() const override { return cache->TotalCharge(); }
+    size_t Capacity() const { return nCapacity; }
+};
+
+struct CDBStatsEntry
 {
-    leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
+    std::string name;
+    std::string path;
+    DBProfile profile;
+    leveldb::DB* pdb;
+    const CCountingCache* cache;
+    int nExtraOpenFiles;
+};
+
+CCriticalSection cs_dbstats;
+std::vector<CDBStatsEntry> vDBStatsEntries;
+//! File descriptors left for the databases beyond DB_DEFAULT_MAX_OPEN_FILES each
+int nDBExtraOpenFiles = DB_EXTRA_OPEN_FILES;
+
+} // anon namespace
+
+void SetDBExtraOpenFiles(int nExtraOpenFiles)
+{
+    LOCK(cs_dbstats);
+    nDBExtraOpenFiles = std::max(nExtraOpenFiles, 0);
+}
+
+std::string DBProfileToString(DBProfile profile)
+{
+    switch (profile) {
+    case DBProfile::DEFAULT: return "default";
+    case DBProfile::POINT_LOOKUP: return "pointlookup";
+    case DBProfile::SCAN: return "scan";
+    }
+    assert(false);
+}
+
+bool DBProfileFromString(const std::string& str, DBProfile& profile)
+{
+    for (DBProfile p : {DBProfile::DEFAULT, DBProfile::POINT_LOOKUP, DBProfile::SCAN}) {
+        if (str == DBProfileToString(p)) {
+            profile = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+DBProfile ApplyDBProfile(leveldb::Options& options, const std::string& name, DBProfile defaultProfile, size_t nCacheSize, bool fMemory)
+{
+    DBProfile profile = defaultProfile;
+    if (mapMultiArgs.count("-dbprofile")) {
+        for (const std::string& strOverride : mapMultiArgs.at("-dbprofile")) {
+            size_t nSep = strOverride.find(':');
+            if (nSep == std::string::npos || strOverride.substr(0, nSep) != name)
+                continue;
+            if (!DBProfileFromString(strOverride.substr(nSep + 1), profile))
+                LogPrintf("Ignoring unknown database profile %s for %s\n", strOverride.substr(nSep + 1), name);
+        }
+    }
+
+    size_t nBlockCache, nWriteBuffer;
+    switch (profile) {
+    case DBProfile::POINT_LOOKUP:
+        // Reads dominate, so favour the block cache over the memtable
+        nBlockCache = nCacheSize * 3 / 4;
+        nWriteBuffer = nCacheSize / 8;
+        options.compression = leveldb::kNoCompression;
+        options.max_open_files = 256;
+        break;
+    case DBProfile::SCAN:
+        // Index-like databases: larger blocks compress well and make iteration cheaper
+        nBlockCache = nCacheSize / 4;
+        nWriteBuffer = nCacheSize * 3 / 8;
+        options.block_size = 32 * 1024;
+        options.compression = leveldb::kSnappyCompression;
+        options.max_open_files = 128;
+        break;
+    case DBProfile::DEFAULT:
+    default:
+        nBlockCache = nCacheSize / 2;
+        nWriteBuffer = nCacheSize / 4;
+        options.compression = leveldb::kNoCompression;
+        options.max_open_files = DB_DEFAULT_MAX_OPEN_FILES;
+        break;
+    }
+
+    // The extra open files count against the descriptors reserved at startup, a
+    // database opened once they are used up keeps as many files open as the default
+    if (!fMemory && options.max_open_files > DB_DEFAULT_MAX_OPEN_FILES) {
+        LOCK(cs_dbstats);
+        int nExtra = std::min(options.max_open_files - DB_DEFAULT_MAX_OPEN_FILES, nDBExtraOpenFiles);
+        nDBExtraOpenFiles -= nExtra;
+        options.max_open_files = DB_DEFAULT_MAX_OPEN_FILES + nExtra;
+    }
+
+    // Up to two write buffers may be held in memory simultaneously
+    options.write_buffer_size = std::max(nWriteBuffer, (size_t)(64 << 10));
+    options.block_cache = new CCountingCache(std::max(nBlockCache, (size_t)(64 << 10)));
     options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
-    options.max_open_files = 64;
-    if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
-        // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
-        // on corruption in later versions.
-        options.paranoid_checks = true;
+    return profile;
+}
+
+void ReleaseDBOpenFiles(const leveldb::Options& options)
+{
+    LOCK(cs_dbstats);
+    nDBExtraOpenFiles += std::max(options.max_open_files - DB_DEFAULT_MAX_OPEN_FILES, 0);
+}
+
+void RegisterDBStats(const std::string& name, const boost::filesystem::path& path, DBProfile profile, leveldb::DB* pdb, const leveldb::Options& options)
+{
+    LOCK(cs_dbstats);
+    vDBStatsEntries.push_back(CDBStatsEntry{name, path.string(), profile, pdb, dynamic_cast<const CCountingCache*>(options.block_cache),
+                                            std::max(options.max_open_files - DB_DEFAULT_MAX_OPEN_FILES, 0)});
+}
+
+void UnregisterDBStats(leveldb::DB* pdb)
+{
+    LOCK(cs_dbstats);
+    auto it = std::find_if(vDBStatsEntries.begin(), vDBStatsEntries.end(),
+                           [pdb](const CDBStatsEntry& entry) { return entry.pdb == pdb; });
+    if (it == vDBStatsEntries.end())
+        return;
+    nDBExtraOpenFiles += it->nExtraOpenFiles;
+    vDBStatsEntries.erase(it);
+}
+
+std::vector<CDBStats> GetDBStats()
+{
+    std::vector<CDBStats> vStats;
+    LOCK(cs_dbstats);
+    for (const CDBStatsEntry& entry : vDBStatsEntries) {
+        CDBStats stats;
+        stats.name = entry.name;
+        stats.path = entry.path;
+        stats.profile = entry.profile;
+        stats.nMaxOpenFiles = DB_DEFAULT_MAX_OPEN_FILES + entry.nExtraOpenFiles;
+        stats.nCacheCapacity = entry.cache ? entry.cache->Capacity() : 0;
+        stats.nCacheUsage = entry.cache ? entry.cache->TotalCharge() : 0;
+        stats.nCacheHits = entry.cache ? entry.cache->nHits.load() : 0;
+        stats.nCacheMisses = entry.cache ? entry.cache->nMisses.load() : 0;
+
+        std::string strValue;
+        stats.nApproxMemoryUsage = 0;
+        if (entry.pdb->GetProperty("leveldb.approximate-memory-usage", &strValue))
+            stats.nApproxMemoryUsage = atoi64(strValue);
+        if (entry.pdb->GetProperty("leveldb.stats", &strValue))
+            stats.strCompactionStats = strValue;
+        for (int nLevel = 0; entry.pdb->GetProperty("leveldb.num-files-at-level" + std::to_string(nLevel), &strValue); nLevel++)
+            stats.vFilesPerLevel.push_back(atoi(strValue));
+
+        // Approximate size of the whole key space, all keys sort below the limit
+        uint64_t nSize = 0;
+        const std::string strLimit(256, '\xff');
+        leveldb::Range range(leveldb::Slice(""), leveldb::Slice(strLimit));
+        entry.pdb->GetApproximateSizes(&range, 1, &nSize);
+        stats.nApproxDiskSize = nSize;
+
+        vStats.push_back(std::move(stats));
     }
-    return options;
+    return vStats;
 }
 
-CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
+CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate,
+                       DBProfile profile, const std::string& name)
 {
+    const std::string strName = name.empty() ? path.filename().string() : name;
     penv = NULL;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    profile = ApplyDBProfile(options, strName, profile, nCacheSize, fMemory);
+    if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
+        // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
+        // on corruption in later versions.
+        options.paranoid_checks = true;
+    }
     options.create_if_missing = true;
-    if (fMemory) {
-        penv = leveldb::NewMemEnv(leveldb::Env::Default());
-        options.env = penv;
-    } else {
-        if (fWipe) {
-            LogPrintf("Wiping LevelDB in %s\n", path.string());
-            leveldb::Status result = leveldb::DestroyDB(path.string(), options);
-            dbwrapper_private::HandleError(result);
+    try {
+        if (fMemory) {
+            penv = leveldb::NewMemEnv(leveldb::Env::Default());
+            options.env = penv;
+        } else {
+            if (fWipe) {
+                LogPrintf("Wiping LevelDB in %s\n", path.string());
+                leveldb::Status result = leveldb::DestroyDB(path.string(), options);
+                dbwrapper_private::HandleError(result);
+            }
+            TryCreateDirectory(path);
+            LogPrintf("Opening LevelDB in %s\n", path.string());
         }
-        TryCreateDirectory(path);
-        LogPrintf("Opening LevelDB in %s\n", path.string());
+        leveldb::Status status = leveldb::DB::Open(options, path.string(), &pdb);
+        dbwrapper_private::HandleError(status);
+    } catch (...) {
+        // The destructor isn't run, the open files are given back here for the databases opened again
+        if (!fMemory)
+            ReleaseDBOpenFiles(options);
+        throw;
     }
-    leveldb::Status status = leveldb::DB::Open(options, path.string(), &pdb);
-    dbwrapper_private::HandleError(status);
-    LogPrintf("Opened LevelDB successfully\n");
+    LogPrintf("Opened LevelDB successfully (profile %s)\n", DBProfileToString(profile));
+    if (!fMemory)
+        RegisterDBStats(strName, path, profile, pdb, options);
 
     // The base-case obfuscation key, which is a noop.
     obfuscate_key = std::vector<unsigned char>(OBFUSCATE_KEY_NUM_BYTES, '\000');
@@ -78,6 +281,7 @@ CDBWrapper::CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, b
 
 CDBWrapper::~CDBWrapper()
 {
+    UnregisterDBStats(pdb);
     delete pdb;
     pdb = NULL;
     delete options.filter_policy;
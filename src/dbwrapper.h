@@ -28,6 +28,66 @@ public:
 
 class CDBWrapper;
 
+/**
+ * LevelDB tuning presets. Each database picks the one matching its access
+ * pattern, which can be overridden per database with -dbprofile=<name>:<profile>.
+ */
+enum class DBProfile
+{
+    DEFAULT,       //!< mixed reads and writes
+    POINT_LOOKUP,  //!< mostly random single-key reads: large block cache, many open files
+    SCAN,          //!< mostly prefix iteration: big compressed blocks, large write buffer
+};
+
+/** Files a database keeps open with the default profile */
+static const int DB_DEFAULT_MAX_OPEN_FILES = 64;
+/**
+ * File descriptors shared by the databases for the files the other profiles
+ * keep open beyond DB_DEFAULT_MAX_OPEN_FILES. They are reserved at startup next
+ * to the ones of the connections, databases take them as they are opened while
+ * some are left and give them back when they are closed.
+ */
+static const int DB_EXTRA_OPEN_FILES = 512;
+
+/** Set the file descriptors left for the databases beyond DB_DEFAULT_MAX_OPEN_FILES each */
+void SetDBExtraOpenFiles(int nExtraOpenFiles);
+
+std::string DBProfileToString(DBProfile profile);
+bool DBProfileFromString(const std::string& str, DBProfile& profile);
+
+/**
+ * Tune options for the database called name according to its configured profile.
+ * The block cache and filter policy are allocated here and owned by the caller.
+ * The open files beyond DB_DEFAULT_MAX_OPEN_FILES are taken from the ones left
+ * for the databases unless fMemory, and given back by UnregisterDBStats, or by
+ * ReleaseDBOpenFiles when the database couldn't be opened.
+ * Returns the profile that was applied.
+ */
+DBProfile ApplyDBProfile(leveldb::Options& options, const std::string& name, DBProfile defaultProfile, size_t nCacheSize, bool fMemory = false);
+void ReleaseDBOpenFiles(const leveldb::Options& options);
+
+/** Statistics of an open database as reported by getdbstats */
+struct CDBStats
+{
+    std::string name;
+    std::string path;
+    DBProfile profile;
+    int nMaxOpenFiles;
+    size_t nCacheCapacity;
+    size_t nCacheUsage;
+    uint64_t nCacheHits;
+    uint64_t nCacheMisses;
+    uint64_t nApproxMemoryUsage;
+    uint64_t nApproxDiskSize;
+    std::vector<int> vFilesPerLevel;
+    std::string strCompactionStats;
+};
+
+/** Make an open database visible to GetDBStats. */
+void RegisterDBStats(const std::string& name, const boost::filesystem::path& path, DBProfile profile, leveldb::DB* pdb, const leveldb::Options& options);
+void UnregisterDBStats(leveldb::DB* pdb);
+std::vector<CDBStats> GetDBStats();
+
 /** These should be considered an implementation detail of the specific database.
  */
 namespace dbwrapper_private {
@@ -107,6 +167,19 @@ public:
         ssValue.clear();
     }
 
+    void Write(const CDataStream& _ssKey, const CDataStream& _ssValue)
+    {
+        leveldb::Slice slKey(_ssKey.data(), _ssKey.size());
+
+        ssValue.write(_ssValue.data(), _ssValue.size());
+        ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
+        leveldb::Slice slValue(ssValue.data(), ssValue.size());
+
+        batch.Put(slKey, slValue);
+        size_estimate += 3 + (slKey.size() > 127) + slKey.size() + (slValue.size() > 127) + slValue.size();
+        ssValue.clear();
+    }
+
     template <typename K>
     void Erase(const K& key)
     {
@@ -194,6 +267,13 @@ public:
         return true;
     }
 
+    CDataStream GetValue() {
+        leveldb::Slice slValue = piter->value();
+        CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+        ssValue.Xor(dbwrapper_private::GetObfuscateKey(parent));
+        return ssValue;
+    }
+
     unsigned int GetValueSize() {
         return piter->value().size();
     }
@@ -244,8 +324,11 @@ public:
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
+     * @param[in] profile     Tuning profile used unless -dbprofile overrides it for this database.
+     * @param[in] name        Name used for -dbprofile and getdbstats, defaults to the directory name.
      */
-    CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false,
+               DBProfile profile = DBProfile::DEFAULT, const std::string& name = "");
     ~CDBWrapper();
 
     template <typename K>
@@ -34,6 +34,7 @@
 #include "../coins.h"
 #include "../core_io.h"
 #include "../init.h"
+#include "../metrics.h"
 #include "../validation.h"
 #include "../net.h"
 #include "../primitives/block.h"
@@ -69,6 +70,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <deque>
 #include <fstream>
 #include <map>
 #include <set>
@@ -121,6 +123,11 @@ static boost::filesystem::path MPPersistencePath;
 
 static int elysiumInitialized = 0;
 
+static CMetricHistogram metricHandlerTx("tecracoin_elysium_seconds", "Time spent in each step of the Elysium processing of a block", "step", "tx");
+static CMetricHistogram metricHandlerBlockSpends("tecracoin_elysium_seconds", "Time spent in each step of the Elysium processing of a block", "step", "block_spends");
+static CMetricHistogram metricHandlerBlockEnd("tecracoin_elysium_seconds", "Time spent in each step of the Elysium processing of a block", "step", "block_end");
+static CMetricCounter metricTransactions("tecracoin_elysium_transactions_total", "Valid Elysium transactions found in the blocks connected");
+
 static int reorgRecoveryMode = 0;
 static int reorgRecoveryMaxHeight = 0;
 
@@ -1189,6 +1196,7 @@ static int elysium_initial_scan(int nFirstBlock)
         unsigned parsed = 0;
 
         elysium_handler_block_begin(nBlock, pblockindex);
+        elysium_handler_block_spends(nBlock, pblockindex, block);
 
         for (unsigned i = 0; i < block.vtx.size(); i++) {
             if (elysium_handler_tx(*block.vtx[i], nBlock, i, pblockindex)) {
@@ -2143,6 +2151,7 @@ int elysium_shutdown()
 bool elysium_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, const CBlockIndex* pBlockIndex)
 {
     LOCK(cs_main);
+    CMetricTimer timer(metricHandlerTx);
 
     if (!elysiumInitialized) {
         elysium_init();
@@ -2180,6 +2189,10 @@ bool elysium_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, co
         fFoundTx |= (interp_ret == 0);
     }
 
+    if (fFoundTx) {
+        metricTransactions.Inc();
+    }
+
     if (fFoundTx && elysium_debug_consensus_hash_every_transaction) {
         uint256 consensusHash = GetConsensusHash();
         PrintToLog("Consensus hash for transaction %s: %s\n", tx.GetHash().GetHex(), consensusHash.GetHex());
@@ -2188,6 +2201,43 @@ bool elysium_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, co
     return fFoundTx;
 }
 
+/**
+ * Verifies the sigma spends of a block together, before elysium_handler_tx() processes its
+ * transactions one by one. Must be called after elysium_handler_block_begin().
+ *
+ * @return The number of sigma spends found
+ */
+int elysium_handler_block_spends(int nBlockNow, CBlockIndex const * pBlockIndex, const CBlock& block)
+{
+    LOCK(cs_main);
+    CMetricTimer timer(metricHandlerBlockSpends);
+
+    if (!elysiumInitialized) {
+        elysium_init();
+    }
+
+    if (nBlockNow < nWaterlineBlock) return 0;
+    int64_t nBlockTime = pBlockIndex->GetBlockTime();
+
+    // The transactions are only parsed here, in read-only mode.
+    std::deque<CMPTransaction> spends;
+
+    for (unsigned int idx = 0; idx < block.vtx.size(); idx++) {
+        spends.emplace_back();
+
+        auto& mp_obj = spends.back();
+        if (ParseTransaction(*block.vtx[idx], nBlockNow, idx, mp_obj, nBlockTime) != 0
+            || !mp_obj.interpret_Transaction()
+            || mp_obj.getType() != ELYSIUM_TYPE_SIMPLE_SPEND) {
+            spends.pop_back();
+        }
+    }
+
+    txProcessor->PrepareBlock(nBlockNow, spends);
+
+    return spends.size();
+}
+
 /**
  * Determines, whether it is valid to use a Class C transaction for a given payload size.
  *
@@ -3758,6 +3808,7 @@ int elysium_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
         unsigned int countMP)
 {
     LOCK(cs_main);
+    CMetricTimer timer(metricHandlerBlockEnd);
 
     if (!elysiumInitialized) {
         elysium_init();
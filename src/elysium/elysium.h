@@ -1,6 +1,7 @@
 #ifndef TECRACOIN_ELYSIUM_ELYSIUM_H
 #define TECRACOIN_ELYSIUM_ELYSIUM_H
 
+class CBlock;
 class CBlockIndex;
 class CCoinsView;
 class CCoinsViewCache;
@@ -263,6 +264,7 @@ int elysium_handler_disc_begin(int nBlockNow, CBlockIndex const * pBlockIndex);
 int elysium_handler_disc_end(int nBlockNow, CBlockIndex const * pBlockIndex);
 int elysium_handler_block_begin(int nBlockNow, CBlockIndex const * pBlockIndex);
 int elysium_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex, unsigned int);
+int elysium_handler_block_spends(int nBlockNow, CBlockIndex const * pBlockIndex, const CBlock& block);
 bool elysium_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, const CBlockIndex* pBlockIndex);
 int elysium_save_state( CBlockIndex const *pBlockIndex );
 
@@ -1,5 +1,6 @@
 #include "elysium/log.h"
 
+#include "asynclog.h"
 #include "chainparamsbase.h"
 #include "util.h"
 #include "utiltime.h"
@@ -88,11 +89,11 @@ static boost::mutex* mutexDebugLog = NULL;
 extern std::atomic<bool> fReopenElysiumLog;
 
 /**
- * @return The current timestamp in the format: 2009-01-03 18:15:05
+ * @return The timestamp in the format: 2009-01-03 18:15:05
  */
-static std::string GetTimestamp()
+static std::string GetTimestamp(int64_t nTime)
 {
-    return DateTimeStrFormat("%Y-%m-%d %H:%M:%S", GetTime());
+    return DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nTime);
 }
 
 /**
@@ -107,10 +108,10 @@ static std::string GetTimestamp()
 static int ConsolePrint(const std::string& str)
 {
     int ret = 0; // Number of characters written
-    static bool fStartedNewLine = true;
+    static std::atomic_bool fStartedNewLine(true);
 
     if (fLogTimestamps && fStartedNewLine) {
-        ret = fprintf(stdout, "%s %s", GetTimestamp().c_str(), str.c_str());
+        ret = fprintf(stdout, "%s %s", GetTimestamp(GetTime()).c_str(), str.c_str());
     } else {
         ret = fwrite(str.data(), 1, str.size(), stdout);
     }
@@ -165,6 +166,69 @@ static void DebugLogInit()
     mutexDebugLog = new boost::mutex();
 }
 
+/**
+ * The Elysium log file, or the console, written by LogFilePrint or the logging
+ * thread. Messages to the console are stamped by ConsolePrint when written.
+ */
+class CElysiumLogSink : public CLogSink
+{
+private:
+    std::atomic_bool fStartedNewLine;
+
+public:
+    CElysiumLogSink() : fStartedNewLine(true) {}
+
+    std::string Stamp(const std::string& str, int64_t nTimeMicros) override
+    {
+        if (fPrintToConsole) {
+            return str;
+        }
+
+        std::string strStamped;
+        // Printing log timestamps can be useful for profiling
+        if (fLogTimestamps && fStartedNewLine) {
+            strStamped = GetTimestamp(nTimeMicros / 1000000) + " " + str;
+        } else {
+            strStamped = str;
+        }
+        if (!str.empty() && str[str.size()-1] == '\n') {
+            fStartedNewLine = true;
+        } else {
+            fStartedNewLine = false;
+        }
+        return strStamped;
+    }
+
+    int Write(const std::string& str) override
+    {
+        int ret = 0; // Number of characters written
+        if (fPrintToConsole) {
+            // Print to console
+            ret = ConsolePrint(str);
+        }
+        else if (fPrintToDebugLog && AreBaseParamsConfigured()) {
+            boost::call_once(&DebugLogInit, debugLogInitFlag);
+
+            if (fileout == NULL) {
+                return ret;
+            }
+            boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+
+            // Reopen the log file, if requested
+            if (fReopenElysiumLog) {
+                fReopenElysiumLog = false;
+                boost::filesystem::path pathDebug = GetLogPath();
+                if (freopen(pathDebug.string().c_str(), "a", fileout) != NULL) {
+                    setbuf(fileout, NULL); // Unbuffered
+                }
+            }
+
+            ret = fwrite(str.data(), 1, str.size(), fileout);
+        }
+        return ret;
+    }
+};
+
 /**
  * Prints to log file.
  *
@@ -174,47 +238,24 @@ static void DebugLogInit()
  * If "-printtoconsole" is enabled, then the message is written to the standard
  * output, usually the console, instead of a log file.
  *
+ * The message is written by the logging thread, if it is running.
+ *
  * @param str[in]  The message to log
  * @return The total number of characters written
  */
 int LogFilePrint(const std::string& str)
 {
-    int ret = 0; // Number of characters written
-    if (fPrintToConsole) {
-        // Print to console
-        ret = ConsolePrint(str);
+    if (!fPrintToConsole && !(fPrintToDebugLog && AreBaseParamsConfigured())) {
+        return 0;
     }
-    else if (fPrintToDebugLog && AreBaseParamsConfigured()) {
-        static bool fStartedNewLine = true;
-        boost::call_once(&DebugLogInit, debugLogInitFlag);
-
-        if (fileout == NULL) {
-            return ret;
-        }
-        boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
-
-        // Reopen the log file, if requested
-        if (fReopenElysiumLog) {
-        	fReopenElysiumLog = false;
-            boost::filesystem::path pathDebug = GetLogPath();
-            if (freopen(pathDebug.string().c_str(), "a", fileout) != NULL) {
-                setbuf(fileout, NULL); // Unbuffered
-            }
-        }
 
-        // Printing log timestamps can be useful for profiling
-        if (fLogTimestamps && fStartedNewLine) {
-            ret += fprintf(fileout, "%s ", GetTimestamp().c_str());
-        }
-        if (!str.empty() && str[str.size()-1] == '\n') {
-            fStartedNewLine = true;
-        } else {
-            fStartedNewLine = false;
-        }
-        ret += fwrite(str.data(), 1, str.size(), fileout);
+    // Leaked on exit, like the log file, as messages can be logged by global destructors
+    static CElysiumLogSink* sink = new CElysiumLogSink();
+    int64_t nTimeMicros = GetLogTimeMicros();
+    if (AsyncLogPush(sink, nTimeMicros, std::string(str), std::function<std::string()>())) {
+        return str.size();
     }
-
-    return ret;
+    return sink->Write(sink->Stamp(str, nTimeMicros));
 }
 
 /**
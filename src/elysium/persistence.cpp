@@ -16,6 +16,9 @@
  */
 leveldb::Status CDBBase::Open(const boost::filesystem::path& path, bool fWipe)
 {
+    const std::string name = path.filename().string();
+    DBProfile profile = ApplyDBProfile(options, name, DBProfile::SCAN, ELYSIUM_DB_CACHE_SIZE);
+
     if (fWipe) {
         if (elysium_debug_persistence) PrintToLog("Wiping LevelDB in %s\n", path.string());
         leveldb::DestroyDB(path.string(), options);
@@ -23,7 +26,13 @@ leveldb::Status CDBBase::Open(const boost::filesystem::path& path, bool fWipe)
     TryCreateDirectory(path);
     if (elysium_debug_persistence) PrintToLog("Opening LevelDB in %s\n", path.string());
 
-    return leveldb::DB::Open(options, path.string(), &pdb);
+    leveldb::Status status = leveldb::DB::Open(options, path.string(), &pdb);
+    if (status.ok())
+        RegisterDBStats(name, path, profile, pdb, options);
+    else
+        ReleaseDBOpenFiles(options);
+
+    return status;
 }
 
 /**
@@ -59,9 +68,14 @@ void CDBBase::Clear()
 void CDBBase::Close()
 {
     if (pdb) {
+        UnregisterDBStats(pdb);
         delete pdb;
         pdb = NULL;
     }
+    delete options.filter_policy;
+    options.filter_policy = NULL;
+    delete options.block_cache;
+    options.block_cache = NULL;
 }
 
 
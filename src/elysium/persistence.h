@@ -1,6 +1,8 @@
 #ifndef ELYSIUM_PERSISTENCE_H
 #define ELYSIUM_PERSISTENCE_H
 
+#include "dbwrapper.h"
+
 #include "leveldb/db.h"
 
 #include <boost/filesystem/path.hpp>
@@ -8,6 +10,9 @@
 #include <assert.h>
 #include <stddef.h>
 
+/** Cache budget of each Elysium database, split according to its tuning profile */
+static const size_t ELYSIUM_DB_CACHE_SIZE = 16 << 20;
+
 /** Base class for LevelDB based storage.
  */
 class CDBBase
@@ -42,8 +47,6 @@ protected:
     {
         options.paranoid_checks = true;
         options.create_if_missing = true;
-        options.compression = leveldb::kNoCompression;
-        options.max_open_files = 64;
         readoptions.verify_checksums = true;
         iteroptions.verify_checksums = true;
         iteroptions.fill_cache = false;
@@ -55,25 +58,12 @@ protected:
         Close();
     }
 
-    /**
-     * Creates and returns a new LevelDB iterator.
-     *
-     * It is expected that the database is not closed. The iterator is owned by the
-     * caller, and the object has to be deleted explicitly.
-     *
-     * @return A new LevelDB iterator
-     */
-    leveldb::Iterator* NewIterator() const
-    {
-        assert(pdb != NULL);
-        return pdb->NewIterator(iteroptions);
-    }
-
     /**
      * Opens or creates a LevelDB based database.
      *
      * If the database is wiped before opening, it's content is destroyed, including
-     * all log files and meta data.
+     * all log files and meta data. The database is tuned with the scan profile unless
+     * -dbprofile overrides it for the name of its directory.
      *
      * @param path   The path of the database to open
      * @param fWipe  Whether to wipe the database before opening
@@ -87,6 +77,20 @@ protected:
     void Close();
 
 public:
+    /**
+     * Creates and returns a new LevelDB iterator.
+     *
+     * It is expected that the database is not closed. The iterator is owned by the
+     * caller, and the object has to be deleted explicitly.
+     *
+     * @return A new LevelDB iterator
+     */
+    leveldb::Iterator* NewIterator() const
+    {
+        assert(pdb != NULL);
+        return pdb->NewIterator(iteroptions);
+    }
+
     /**
      * Deletes all entries of the database, and resets the counters.
      */
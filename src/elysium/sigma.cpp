@@ -6,12 +6,44 @@
 #include "../validation.h"
 #include "../sync.h"
 
+#include "../sigma/sigmaplus_verifier.h"
+
 #include <iterator>
 #include <vector>
 
 namespace elysium {
 
-bool VerifySigmaSpend(
+// SigmaGroupCache Implementation.
+
+const std::vector<SigmaPublicKey> *SigmaGroupCache::Get(
+    PropertyId property,
+    SigmaDenomination denomination,
+    SigmaMintGroup group,
+    size_t count)
+{
+    auto& mints = groups[std::make_tuple(property, denomination, group)];
+
+    // Mints are only appended to a group so the ones already read never change, the group only
+    // needs to be read again when more mints are needed.
+    if (mints.size() < count) {
+        mints.clear();
+
+        LOCK(cs_main);
+        sigmaDb->GetAnonimityGroup(property, denomination, group, count, std::back_inserter(mints));
+    }
+
+    return (mints.size() < count) ? nullptr : &mints;
+}
+
+void SigmaGroupCache::Clear()
+{
+    groups.clear();
+}
+
+// SigmaSpendBatch Implementation.
+
+void SigmaSpendBatch::Add(
+    const uint256& tx,
     PropertyId property,
     SigmaDenomination denomination,
     SigmaMintGroup group,
@@ -20,6 +52,112 @@ bool VerifySigmaSpend(
     const secp_primitives::Scalar& serial,
     bool fPadding)
 {
+    spends.push_back({tx, property, denomination, group, groupSize, proof, serial, fPadding});
+}
+
+void SigmaSpendBatch::Verify(SigmaGroupCache& groups)
+{
+    // Spends of the same anonymity set go in the same batch.
+    std::map<std::tuple<PropertyId, SigmaDenomination, SigmaMintGroup, size_t>, std::vector<const Spend *>> sets;
+
+    for (auto& spend : spends) {
+        if (!results.count(spend.tx)) {
+            sets[std::make_tuple(spend.property, spend.denomination, spend.group, spend.groupSize)].push_back(&spend);
+        }
+    }
+
+    for (auto& set : sets) {
+        auto& batch = set.second;
+        auto& first = *batch.front();
+        auto mints = groups.Get(first.property, first.denomination, first.group, first.groupSize);
+
+        if (!mints) {
+            continue;
+        }
+
+        auto last = mints->begin() + first.groupSize;
+
+        if (batch.size() > 1) {
+            std::vector<secp_primitives::GroupElement> commits;
+            std::vector<secp_primitives::Scalar> serials;
+            std::vector<bool> fPaddings;
+            std::vector<size_t> setSizes;
+            std::vector<sigma::SigmaPlusProof<secp_primitives::Scalar, secp_primitives::GroupElement>> proofs;
+
+            commits.reserve(first.groupSize);
+
+            for (auto it = mints->begin(); it != last; it++) {
+                commits.push_back(it->commitment);
+            }
+
+            for (auto spend : batch) {
+                serials.push_back(spend->serial);
+                fPaddings.push_back(spend->fPadding);
+                setSizes.push_back(spend->groupSize);
+                proofs.push_back(spend->proof.proof);
+            }
+
+            auto& params = first.proof.params;
+            sigma::SigmaPlusVerifier<secp_primitives::Scalar, secp_primitives::GroupElement> verifier(
+                params.g,
+                params.h,
+                params.n,
+                params.m
+            );
+
+            if (verifier.batch_verify(commits, serials, fPaddings, setSizes, proofs)) {
+                for (auto spend : batch) {
+                    results[spend->tx] = true;
+                }
+                continue;
+            }
+        }
+
+        // A single spend, or a batch with at least one invalid spend which we need to find.
+        for (auto spend : batch) {
+            results[spend->tx] = spend->proof.Verify(spend->serial, mints->begin(), last, spend->fPadding);
+        }
+    }
+}
+
+boost::optional<bool> SigmaSpendBatch::GetResult(const uint256& tx) const
+{
+    auto it = results.find(tx);
+
+    if (it == results.end()) {
+        return boost::none;
+    }
+
+    return it->second;
+}
+
+void SigmaSpendBatch::Clear()
+{
+    spends.clear();
+    results.clear();
+}
+
+bool VerifySigmaSpend(
+    PropertyId property,
+    SigmaDenomination denomination,
+    SigmaMintGroup group,
+    size_t groupSize,
+    const SigmaProof& proof,
+    const secp_primitives::Scalar& serial,
+    bool fPadding,
+    SigmaGroupCache *groups)
+{
+    if (groups) {
+        auto mints = groups->Get(property, denomination, group, groupSize);
+
+        // If the size of anonimity set is not the expected once then no need to verify the proof.
+        if (!mints) {
+            return false;
+        }
+
+        return proof.Verify(serial, mints->begin(), mints->begin() + groupSize, fPadding);
+    }
+
     std::vector<SigmaPublicKey> anonimitySet; // Don't preallocate the vector due to it will allow attacker to crash all client.
 
     {
@@ -4,10 +4,89 @@
 #include "property.h"
 #include "sigmaprimitives.h"
 
+#include "../uint256.h"
+
+#include <boost/optional.hpp>
+
+#include <map>
+#include <tuple>
+#include <vector>
+
 #include <stddef.h>
 
 namespace elysium {
 
+/**
+ * Anonymity groups read from the sigma database, kept in memory so that the spends of a block
+ * referencing the same group only read it once.
+ */
+class SigmaGroupCache
+{
+public:
+    /**
+     * Returns the group with at least its first `count` mints, or null if the group does not
+     * have that many mints yet. The group is only read from the database when needed.
+     */
+    const std::vector<SigmaPublicKey> *Get(
+        PropertyId property,
+        SigmaDenomination denomination,
+        SigmaMintGroup group,
+        size_t count);
+
+    void Clear();
+
+private:
+    std::map<std::tuple<PropertyId, SigmaDenomination, SigmaMintGroup>, std::vector<SigmaPublicKey>> groups;
+};
+
+/**
+ * Sigma spends collected from the transactions of a block and verified together, with one
+ * batch verification per anonymity set.
+ */
+class SigmaSpendBatch
+{
+public:
+    void Add(
+        const uint256& tx,
+        PropertyId property,
+        SigmaDenomination denomination,
+        SigmaMintGroup group,
+        size_t groupSize,
+        const SigmaProof& proof,
+        const secp_primitives::Scalar& serial,
+        bool fPadding);
+
+    /**
+     * Verifies all the spends added. Spends whose anonymity set does not have enough mints yet
+     * are left unverified, mints of the same block may complete it later.
+     */
+    void Verify(SigmaGroupCache& groups);
+
+    /**
+     * Returns the result of `Verify()` for the spend of a transaction, or nothing if the spend
+     * has not been verified.
+     */
+    boost::optional<bool> GetResult(const uint256& tx) const;
+
+    void Clear();
+
+private:
+    struct Spend
+    {
+        uint256 tx;
+        PropertyId property;
+        SigmaDenomination denomination;
+        SigmaMintGroup group;
+        size_t groupSize;
+        SigmaProof proof;
+        secp_primitives::Scalar serial;
+        bool fPadding;
+    };
+
+    std::vector<Spend> spends;
+    std::map<uint256, bool> results;
+};
+
 bool VerifySigmaSpend(
     PropertyId property,
     SigmaDenomination denomination,
@@ -15,7 +94,8 @@ bool VerifySigmaSpend(
     size_t groupSize,
     const SigmaProof& proof,
     const secp_primitives::Scalar& serial,
-    bool fPadding);
+    bool fPadding,
+    SigmaGroupCache *groups = nullptr);
 
 } // namespace elysium
 
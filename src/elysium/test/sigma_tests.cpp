@@ -2,10 +2,13 @@
 #include "../sigmadb.h"
 #include "../sigmaprimitives.h"
 
+#include "../../random.h"
 #include "../../test/test_bitcoin.h"
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+
 #include <stddef.h>
 #include <vector>
 
@@ -100,6 +103,98 @@ BOOST_FIXTURE_TEST_CASE(verify_spend, SigmaDatabaseFixture)
     BOOST_CHECK_EQUAL(VerifySigmaSpend(3, 0, 1, sigmaDb->groupSize, proof, key.serial, false), false);
 }
 
+BOOST_FIXTURE_TEST_CASE(group_cache, SigmaDatabaseFixture)
+{
+    SigmaGroupCache groups;
+    auto mints = CreateMints(5);
+
+    for (auto& mint : mints) {
+        sigmaDb->RecordMint(3, 0, mint, 100);
+    }
+
+    auto group = groups.Get(3, 0, 0, 3);
+    BOOST_REQUIRE(group);
+    BOOST_CHECK(std::equal(mints.begin(), mints.begin() + 3, group->begin()));
+
+    BOOST_CHECK(!groups.Get(3, 0, 0, 6));
+    BOOST_CHECK(!groups.Get(3, 1, 0, 1));
+
+    // Mints recorded after the group has been read.
+    sigmaDb->RecordMint(3, 0, CreateMint(), 101);
+
+    group = groups.Get(3, 0, 0, 6);
+    BOOST_REQUIRE(group);
+    BOOST_CHECK_EQUAL(group->size(), 6U);
+    BOOST_CHECK(std::equal(mints.begin(), mints.end(), group->begin()));
+}
+
+BOOST_FIXTURE_TEST_CASE(verify_spend_batch, SigmaDatabaseFixture)
+{
+    auto& params = DefaultSigmaParams;
+    std::vector<SigmaPrivateKey> keys(4);
+    std::vector<SigmaPublicKey> anonimitySet;
+
+    for (auto& key : keys) {
+        key.Generate();
+        anonimitySet.push_back(SigmaPublicKey(key, params));
+    }
+
+    for (auto& mint : CreateMints(2)) {
+        anonimitySet.push_back(mint);
+    }
+
+    for (auto& mint : anonimitySet) {
+        sigmaDb->RecordMint(3, 0, mint, 100);
+    }
+
+    std::vector<SigmaProof> proofs;
+    std::vector<uint256> txs;
+
+    for (auto& key : keys) {
+        proofs.emplace_back(params, key, anonimitySet.begin(), anonimitySet.end(), false);
+        txs.push_back(GetRandHash());
+    }
+
+    // All valid, with another set that is not complete yet.
+    SigmaGroupCache groups;
+    SigmaSpendBatch batch;
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        batch.Add(txs[i], 3, 0, 0, anonimitySet.size(), proofs[i], keys[i].serial, false);
+    }
+
+    uint256 incomplete = GetRandHash();
+    batch.Add(incomplete, 3, 0, 0, anonimitySet.size() + 1, proofs[0], keys[0].serial, false);
+
+    batch.Verify(groups);
+
+    for (auto& tx : txs) {
+        BOOST_CHECK(batch.GetResult(tx) == boost::optional<bool>(true));
+    }
+    BOOST_CHECK(!batch.GetResult(incomplete));
+    BOOST_CHECK(!batch.GetResult(GetRandHash()));
+
+    // A proof with the wrong serial fails the batch, only it is invalid.
+    batch.Clear();
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        batch.Add(txs[i], 3, 0, 0, anonimitySet.size(), proofs[i], keys[i == 2 ? 1 : i].serial, false);
+    }
+
+    batch.Verify(groups);
+
+    for (size_t i = 0; i < txs.size(); i++) {
+        BOOST_CHECK(batch.GetResult(txs[i]) == boost::optional<bool>(i != 2));
+    }
+
+    // The same results when verified one by one.
+    for (size_t i = 0; i < keys.size(); i++) {
+        BOOST_CHECK_EQUAL(
+            VerifySigmaSpend(3, 0, 0, anonimitySet.size(), proofs[i], keys[i == 2 ? 1 : i].serial, false, &groups),
+            i != 2);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace elysium
@@ -40,6 +40,35 @@ int TxProcessor::ProcessTx(CMPTransaction& tx)
     return 0;
 }
 
+void TxProcessor::PrepareBlock(int block, const std::deque<CMPTransaction>& txs)
+{
+    LOCK(cs_main);
+
+    sigmaBlock = block;
+    sigmaGroups.Clear();
+    sigmaSpends.Clear();
+
+    bool const fPadding = block >= ::Params().GetConsensus().nSigmaPaddingBlock;
+
+    for (auto& tx : txs) {
+        if (tx.getType() != ELYSIUM_TYPE_SIMPLE_SPEND || !tx.getSpend() || !tx.getSerial()) {
+            continue;
+        }
+
+        sigmaSpends.Add(
+            tx.getHash(),
+            tx.getProperty(),
+            tx.getDenomination(),
+            tx.getGroup(),
+            tx.getGroupSize(),
+            *tx.getSpend(),
+            *tx.getSerial(),
+            fPadding);
+    }
+
+    sigmaSpends.Verify(sigmaGroups);
+}
+
 int TxProcessor::ProcessSimpleMint(const CMPTransaction& tx)
 {
     auto block = tx.getBlock();
@@ -160,8 +189,6 @@ int TxProcessor::ProcessSimpleSpend(const CMPTransaction& tx)
     auto spend = tx.getSpend();
     auto serial = tx.getSerial();
     auto denomination = tx.getDenomination();
-    auto group = tx.getGroup();
-    auto groupSize = tx.getGroupSize();
 
     bool const fPadding = block >= ::Params().GetConsensus().nSigmaPaddingBlock;
 
@@ -197,7 +224,7 @@ int TxProcessor::ProcessSimpleSpend(const CMPTransaction& tx)
     // check serial in database
     uint256 spendTx;
     if (sigmaDb->HasSpendSerial(property, denomination, *serial, spendTx)
-        || !VerifySigmaSpend(property, denomination, group, groupSize, *spend, *serial, fPadding)) {
+        || !IsSigmaSpendValid(tx, fPadding)) {
         PrintToLog("%s(): rejected: spend is invalid\n", __func__);
         return PKT_ERROR_SIGMA - 907;
     }
@@ -218,5 +245,23 @@ int TxProcessor::ProcessSimpleSpend(const CMPTransaction& tx)
     return 0;
 }
 
+bool TxProcessor::IsSigmaSpendValid(const CMPTransaction& tx, bool fPadding)
+{
+    // Spends of the block being prepared have been verified together, or can at least use the
+    // groups already read.
+    if (tx.getBlock() != sigmaBlock) {
+        return VerifySigmaSpend(tx.getProperty(), tx.getDenomination(), tx.getGroup(), tx.getGroupSize(),
+            *tx.getSpend(), *tx.getSerial(), fPadding);
+    }
+
+    auto result = sigmaSpends.GetResult(tx.getHash());
+
+    if (result) {
+        return *result;
+    }
+
+    return VerifySigmaSpend(tx.getProperty(), tx.getDenomination(), tx.getGroup(), tx.getGroupSize(),
+        *tx.getSpend(), *tx.getSerial(), fPadding, &sigmaGroups);
+}
 
 }
@@ -2,11 +2,14 @@
 #define TECRACOIN_ELYSIUM_TXPROCESSOR_H
 
 #include "property.h"
+#include "sigma.h"
 #include "sigmaprimitives.h"
 #include "tx.h"
 
 #include <boost/signals2/signal.hpp>
 
+#include <deque>
+
 namespace elysium {
 
 class TxProcessor
@@ -14,6 +17,12 @@ class TxProcessor
 public:
     int ProcessTx(CMPTransaction& tx);
 
+    /**
+     * Verifies together the sigma spends of the transactions of a block, before they are
+     * processed. `ProcessTx()` then uses the results for the transactions of that block.
+     */
+    void PrepareBlock(int block, const std::deque<CMPTransaction>& txs);
+
 public:
     boost::signals2::signal<void(PropertyId, SigmaDenomination, SigmaMintGroup, SigmaMintIndex, const SigmaPublicKey&)> SimpleMintProcessed;
     boost::signals2::signal<void(const CMPTransaction&)> TransactionProcessed;
@@ -21,6 +30,13 @@ public:
 private:
     int ProcessSimpleMint(const CMPTransaction& tx);
     int ProcessSimpleSpend(const CMPTransaction& tx);
+
+    bool IsSigmaSpendValid(const CMPTransaction& tx, bool fPadding);
+
+private:
+    int sigmaBlock = -1;
+    SigmaGroupCache sigmaGroups;
+    SigmaSpendBatch sigmaSpends;
 };
 
 extern TxProcessor *txProcessor;
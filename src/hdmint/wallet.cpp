@@ -15,6 +15,7 @@
 #include "crypto/hmac_sha256.h"
 #include "crypto/hmac_sha512.h"
 #include "keystore.h"
+#include "ctpl.h"
 #include <boost/optional.hpp>
 #include "masternode-sync.h"
 
@@ -45,6 +46,26 @@ CHDMintWallet::CHDMintWallet(const std::string& strWalletFile, bool resetCount)
     }
 }
 
+CHDMintWallet::~CHDMintWallet()
+{
+    if (workerPool)
+        workerPool->stop(true);
+}
+
+/**
+ * Get the pool of threads used to derive mints, starting it on first use.
+ *
+ * @return the worker pool
+ */
+ctpl::thread_pool& CHDMintWallet::GetWorkerPool()
+{
+    if (!workerPool) {
+        workerPool.reset(new ctpl::thread_pool(std::max(GetNumCores(), 1)));
+        RenameThreadPool(*workerPool, "bitcoin-hdmint");
+    }
+    return *workerPool;
+}
+
 /**
  * Constructor helper function.
  *
@@ -153,6 +174,10 @@ void CHDMintWallet::GenerateMintPool(CWalletDB& walletdb, int32_t nIndex)
     if(nIndex > 0 && nIndex >= nLastCount)
         nStop = nIndex + 20;
     LogPrintf("%s : nLastCount=%d nStop=%d\n", __func__, nLastCount, nStop - 1);
+
+    // Deriving the seeds walks the HD chain and may generate new keys, so it is done in order
+    std::vector<std::pair<CKeyID, uint512>> vSeeds;
+    std::vector<int32_t> vCounts;
     for (; nLastCount <= nStop; ++nLastCount) {
         if (ShutdownRequested())
             return;
@@ -162,18 +187,42 @@ void CHDMintWallet::GenerateMintPool(CWalletDB& walletdb, int32_t nIndex)
         if(!CreateMintSeed(walletdb, mintSeed, nLastCount, seedId, false))
             continue;
 
-        GroupElement commitmentValue;
-        sigma::PrivateCoin coin(sigma::Params::get_default(), sigma::CoinDenomination::SIGMA_DENOM_1);
-        if(!SeedToMint(mintSeed, commitmentValue, coin)) //for lelantus put just part of commit, for checking we will need to reduce h1^v from lelantus mint
+        vSeeds.emplace_back(seedId, mintSeed);
+        vCounts.push_back(nLastCount);
+    }
+
+    // The commitments are independent of each other, compute them on the worker threads
+    typedef std::pair<GroupElement, Scalar> MintCommitment;
+    std::vector<std::future<boost::optional<MintCommitment>>> vCommitments;
+    vCommitments.reserve(vSeeds.size());
+    for (const auto& seed : vSeeds) {
+        const uint512 mintSeed = seed.second;
+        vCommitments.emplace_back(GetWorkerPool().push([this, mintSeed](int) -> boost::optional<MintCommitment> {
+            GroupElement commitmentValue;
+            sigma::PrivateCoin coin(sigma::Params::get_default(), sigma::CoinDenomination::SIGMA_DENOM_1);
+            if(!SeedToMint(mintSeed, commitmentValue, coin)) //for lelantus put just part of commit, for checking we will need to reduce h1^v from lelantus mint
+                return boost::none;
+            return MintCommitment(commitmentValue, coin.getSerialNumber());
+        }));
+    }
+
+    // Write the whole batch in a single database transaction, unless the caller already runs one
+    bool fTxn = walletdb.TxnBegin();
+    for (size_t i = 0; i < vCommitments.size(); i++) {
+        boost::optional<MintCommitment> commitment = vCommitments[i].get();
+        if (!commitment)
             continue;
 
+        const GroupElement& commitmentValue = commitment->first;
         uint256 hashPubcoin = primitives::GetPubCoinValueHash(commitmentValue);
 
-        MintPoolEntry mintPoolEntry(hashSeedMaster, seedId, nLastCount);
+        MintPoolEntry mintPoolEntry(hashSeedMaster, vSeeds[i].first, vCounts[i]);
         mintPool.Add(make_pair(hashPubcoin, mintPoolEntry));
-        walletdb.WritePubcoin(primitives::GetSerialHash(coin.getSerialNumber()), commitmentValue);
+        walletdb.WritePubcoin(primitives::GetSerialHash(commitment->second), commitmentValue);
         walletdb.WriteMintPoolPair(hashPubcoin, mintPoolEntry);
     }
+    if (fTxn && !walletdb.TxnCommit())
+        throw std::runtime_error(std::string(__func__) + ": Writing mint pool failed");
 
     // write hdchain back to database
     if (!walletdb.WriteHDChain(pwalletMain->GetHDChain()))
@@ -262,21 +311,34 @@ void CHDMintWallet::SyncWithChain(bool fGenerateMintPool, boost::optional<std::l
             listMints = list<pair<uint256, MintPoolEntry>>();
             mintPool.List(listMints.get());
         }
+        // Collect the mints not seen yet and look all of them up on chain at once
+        std::vector<pair<uint256, MintPoolEntry>*> vUnchecked;
+        std::set<uint256> setUnchecked;
         for (pair<uint256, MintPoolEntry>& pMint : listMints.get()) {
             if (setChecked.count(pMint.first))
                 continue;
             setChecked.insert(pMint.first);
 
+            // halt processing if mint already in tracker
+            if (tracker.HasPubcoinHash(pMint.first, walletdb))
+                continue;
+
+            vUnchecked.push_back(&pMint);
+            setUnchecked.insert(pMint.first);
+        }
+
+        std::map<uint256, sigma::CMintOnChain> mapMintsOnChain;
+        sigma::GetMintsOnChain(setUnchecked, mapMintsOnChain);
+
+        for (pair<uint256, MintPoolEntry>* ppMint : vUnchecked) {
+            pair<uint256, MintPoolEntry>& pMint = *ppMint;
+
             if (ShutdownRequested())
                 return;
 
             uint160& mintHashSeedMaster = get<0>(pMint.second);
             int32_t& mintCount = get<2>(pMint.second);
 
-            // halt processing if mint already in tracker
-            if (tracker.HasPubcoinHash(pMint.first, walletdb))
-                continue;
-
             uint160 seedId = get<1>(pMint.second);
             CDataStream ss(SER_GETHASH, 0);
             ss << pMint.first;
@@ -284,68 +346,25 @@ void CHDMintWallet::SyncWithChain(bool fGenerateMintPool, boost::optional<std::l
             uint256 mintTag = Hash(ss.begin(), ss.end());
 
             COutPoint outPoint;
-            if (sigma::GetOutPoint(outPoint, pMint.first)) {
-                const uint256& txHash = outPoint.hash;
+            auto itMint = mapMintsOnChain.find(pMint.first);
+            if (itMint != mapMintsOnChain.end()) {
+                const sigma::CMintOnChain& mint = itMint->second;
+                const uint256& txHash = mint.outPoint.hash;
                 //this mint has already occurred on the chain, increment counter's state to reflect this
                 LogPrintf("%s : Found wallet coin mint=%s count=%d tx=%s\n", __func__, pMint.first.GetHex(), mintCount, txHash.GetHex());
                 found = true;
 
-                uint256 hashBlock;
-                CTransactionRef tx;
-                if (!GetTransaction(txHash, tx, Params().GetConsensus(), hashBlock, true)) {
-                    LogPrintf("%s : failed to get transaction for mint %s!\n", __func__, pMint.first.GetHex());
-                    found = false;
-                    continue;
-                }
-
-                //Find the denomination
-                boost::optional<sigma::CoinDenomination> denomination = boost::none;
-                bool fFoundMint = false;
-                GroupElement bnValue;
-                for (const CTxOut& out : tx->vout) {
-                    if (!out.scriptPubKey.IsSigmaMint())
-                        continue;
-
-                    sigma::PublicCoin pubcoin;
-                    CValidationState state;
-                    if (!TxOutToPublicCoin(out, pubcoin, state)) {
-                        LogPrintf("%s : failed to get mint from txout for %s!\n", __func__, pMint.first.GetHex());
-                        continue;
-                    }
-
-                    // See if this is the mint that we are looking for
-                    uint256 hashPubcoin = primitives::GetPubCoinValueHash(pubcoin.getValue());
-                    if (pMint.first == hashPubcoin) {
-                        denomination = pubcoin.getDenomination();
-                        bnValue = pubcoin.getValue();
-                        fFoundMint = true;
-                        break;
-                    }
-                }
-
-                if (!fFoundMint || denomination == boost::none) {
-                    LogPrintf("%s : failed to get mint %s from tx %s!\n", __func__, pMint.first.GetHex(), tx->GetHash().GetHex());
-                    found = false;
-                    break;
-                }
-
-                CBlockIndex* pindex = nullptr;
-                if (mapBlockIndex.count(hashBlock))
-                    pindex = mapBlockIndex.at(hashBlock);
-
                 if (!setAddedTx.count(txHash)) {
-                    CBlock block;
-                    CWalletTx wtx(pwalletMain, tx);
-                    if (pindex && ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
-                        SetWalletTransactionBlock(wtx, pindex, block);
+                    CWalletTx wtx(pwalletMain, mint.tx);
+                    wtx.SetMerkleBranch(mint.pindex, mint.nTxIndex);
 
                     //Fill out wtx so that a transaction record can be created
-                    wtx.nTimeReceived = pindex->GetBlockTime();
+                    wtx.nTimeReceived = mint.pindex->GetBlockTime();
                     pwalletMain->AddToWallet(wtx, false);
                     setAddedTx.insert(txHash);
                 }
 
-                if(!SetMintSeedSeen(walletdb, pMint, pindex->nHeight, txHash, denomination.get()))
+                if(!SetMintSeedSeen(walletdb, pMint, mint.pindex->nHeight, txHash, mint.pubCoin.getDenomination()))
                     continue;
 
                 // Only update if the current hashSeedMaster matches the mints'
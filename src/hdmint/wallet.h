@@ -6,6 +6,7 @@
 #define FIRO_HDMINTWALLET_H
 
 #include <map>
+#include <memory>
 #include "libzerocoin/Zerocoin.h"
 #include "hdmint/mintpool.h"
 #include "uint256.h"
@@ -15,6 +16,10 @@
 
 class CHDMint;
 
+namespace ctpl {
+    class thread_pool;
+}
+
 class CHDMintWallet
 {
 private:
@@ -24,11 +29,14 @@ private:
     CMintPool mintPool;
     CHDMintTracker tracker;
     uint160 hashSeedMaster;
+    // Threads deriving mint commitments, started on first use
+    std::unique_ptr<ctpl::thread_pool> workerPool;
 
 public:
     int static const COUNT_DEFAULT = 0;
 
     CHDMintWallet(const std::string& strWalletFile, bool resetCount=false);
+    ~CHDMintWallet();
 
     bool SetupWallet(const uint160& hashSeedMaster, bool fResetCount=false);
     void SyncWithChain(bool fGenerateMintPool = true, boost::optional<std::list<std::pair<uint256, MintPoolEntry>>> listMints = boost::none);
@@ -60,6 +68,7 @@ public:
     void SetWalletTransactionBlock(CWalletTx &wtx, const CBlockIndex *blockIndex, const CBlock &block);
 
 private:
+    ctpl::thread_pool& GetWorkerPool();
     CKeyID GetMintSeedID(CWalletDB& walletdb, int32_t nCount);
     bool CreateMintSeed(CWalletDB& walletdb, uint512& mintSeed, const int32_t& n, CKeyID& seedId, bool nWriteChain = true);
 };
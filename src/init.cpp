@@ -10,17 +10,25 @@
 #include "init.h"
 
 #include "addrman.h"
+#include "asynclog.h"
+#include "blockfilterindex.h"
+#include "blockindexfile.h"
+#include "blockprefetch.h"
 #include "amount.h"
 #include "chain.h"
 #include "chainparams.h"
+#include "chainsnapshot.h"
 #include "checkpoints.h"
 #include "compat/sanity.h"
 #include "consensus/validation.h"
+#include "crypto/Lyra2Z/Lyra2Z.h"
+#include "crypto/MerkleTreeProof/opt.h"
 #include "elysium/elysium.h"
 #include "httpserver.h"
 #include "httprpc.h"
 #include "key.h"
 #include "zerocoin.h"
+#include "sigma.h"
 #include "validation.h"
 #include "miner.h"
 #include "netbase.h"
@@ -31,6 +39,7 @@
 #include "rpc/register.h"
 #include "script/standard.h"
 #include "script/sigcache.h"
+#include "spendcache.h"
 #include "scheduler.h"
 #include "timedata.h"
 #include "txdb.h"
@@ -39,6 +48,7 @@
 #include "ui_interface.h"
 #include "util.h"
 #include "utilmoneystr.h"
+#include "utxostats.h"
 #include "validationinterface.h"
 #include "validation.h"
 #include "mtpstate.h"
@@ -121,8 +131,11 @@ static CDSNotificationInterface* pdsNotificationInterface = NULL;
 // accessing block files don't count towards the fd_set size limit
 // anyway.
 #define MIN_CORE_FILEDESCRIPTORS 0
+#define DB_EXTRA_FILEDESCRIPTORS 0
 #else
 #define MIN_CORE_FILEDESCRIPTORS 150
+// Files the databases keep open beyond DB_DEFAULT_MAX_OPEN_FILES each
+#define DB_EXTRA_FILEDESCRIPTORS DB_EXTRA_OPEN_FILES
 #endif
 
 /** Used to pass flags to the Bind() function */
@@ -286,8 +299,14 @@ void Shutdown()
 
     {
         LOCK(cs_main);
+        // An interrupted import leaves its prefetcher behind
+        g_blockprefetcher.reset();
         if (pcoinsTip != NULL) {
             FlushStateToDisk();
+            if (GetBoolArg("-blockindexfile", DEFAULT_BLOCK_INDEX_FILE))
+                WriteBlockIndexFile();
+            if (!sigma::WriteSigmaStateFile(chainActive))
+                LogPrintf("%s: failed to write the sigma state\n", __func__);
         }
         delete pcoinsTip;
         pcoinsTip = NULL;
@@ -351,6 +370,7 @@ void Shutdown()
     globalVerifyHandle.reset();
     ECC_Stop();
     LogPrintf("%s: done\n", __func__);
+    StopAsyncLogging();
 }
 
 /**
@@ -420,6 +440,8 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-version", _("Print version and exit"));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
+    strUsage += HelpMessageOpt("-blockindexfile", strprintf(_("Keep a memory mapped copy of the block index in blocks/blockindex.dat to speed up startup (default: %u)"), DEFAULT_BLOCK_INDEX_FILE));
+    strUsage += HelpMessageOpt("-blockfilterindex", strprintf(_("Maintain an index of the compact filters of the blocks (BIP 158), used by the getblockfilter rpc call and the blockfilter REST endpoints. Incompatible with -prune (default: %u)"), DEFAULT_BLOCKFILTERINDEX));
     if (showDebug)
         strUsage += HelpMessageOpt("-blocksonly", strprintf(_("Whether to operate in a blocks only mode (default: %u)"), DEFAULT_BLOCKSONLY));
     strUsage +=HelpMessageOpt("-assumevalid=<hex>", strprintf(_("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s)"), Params(CBaseChainParams::MAIN).GetConsensus().defaultAssumeValid.GetHex(), Params(CBaseChainParams::TESTNET).GetConsensus().defaultAssumeValid.GetHex()));
@@ -432,13 +454,20 @@ std::string HelpMessage(HelpMessageMode mode)
     }
     strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory"));
     strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
+    strUsage += HelpMessageOpt("-partialflush", strprintf(_("When the database cache gets close to its limit, write its oldest changes instead of flushing all of it (default: %u)"), DEFAULT_PARTIAL_FLUSH));
+    strUsage += HelpMessageOpt("-dbprofile=<name>:<profile>", _("Use the LevelDB tuning profile <profile> (default, pointlookup or scan) for database <name>, e.g. chainstate, blockindex, evodb, llmq or an Elysium database directory name. Can be specified multiple times"));
     if (showDebug)
         strUsage += HelpMessageOpt("-feefilter", strprintf("Tell other nodes to filter invs to us by our mempool min fee (default: %u)", DEFAULT_FEEFILTER));
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file on startup"));
+    strUsage += HelpMessageOpt("-loadchainstate=<file>", _("Start a new data directory from a snapshot written by the dumpchainstate rpc call, the blocks below it are treated as pruned. "
+        "The snapshot isn't validated, it is trusted like the hash given to -loadchainstatehash, which it must match. Requires -prune and -loadchainstatehash"));
+    strUsage += HelpMessageOpt("-loadchainstatehash=<hash>", _("Hash of the -loadchainstate snapshot, as returned by dumpchainstate, the snapshot is only loaded if its content has this hash"));
+    strUsage += HelpMessageOpt("-prefetchblocks=<n>", strprintf(_("Read and deserialize up to <n> blocks ahead on worker threads while importing or reindexing, 0 to disable (default: %u)"), DEFAULT_PREFETCH_BLOCKS));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-maxmempool=<n>", strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE));
     strUsage += HelpMessageOpt("-mempoolexpiry=<n>", strprintf(_("Do not keep transactions in the mempool longer than <n> hours (default: %u)"), DEFAULT_MEMPOOL_EXPIRY));
     strUsage += HelpMessageOpt("-blockreconstructionextratxn=<n>", strprintf(_("Extra transactions to keep in memory for compact block reconstructions (default: %u)"), DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN));
+    strUsage += HelpMessageOpt("-maxrawblockcache=<n>", strprintf(_("Keep up to <n> megabytes of recently served blocks in memory, 0 to disable (default: %u)"), DEFAULT_MAX_RAW_BLOCK_CACHE));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
 #ifndef WIN32
@@ -453,6 +482,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-sysperms", _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)"));
 #endif
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), DEFAULT_TXINDEX));
+    strUsage += HelpMessageOpt("-utxostats", strprintf(_("Keep the statistics and hash of the UTXO set up to date with each block, used by the gettxoutsetinfo rpc call (default: %u)"), DEFAULT_UTXOSTATS));
 
     strUsage += HelpMessageGroup(_("Connection options:"));
     strUsage += HelpMessageOpt("-addnode=<ip>", _("Add a node to connect to and attempt to keep the connection open"));
@@ -474,6 +504,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-onion=<ip:port>", strprintf(_("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: %s)"), "-proxy"));
     strUsage += HelpMessageOpt("-onlynet=<net>", _("Only connect to nodes in network <net> (ipv4, ipv6 or onion)"));
     strUsage += HelpMessageOpt("-permitbaremultisig", strprintf(_("Relay non-P2SH multisig (default: %u)"), DEFAULT_PERMIT_BAREMULTISIG));
+    strUsage += HelpMessageOpt("-peerblockfilters", strprintf(_("Serve compact block filters to peers per BIP 157, requires -blockfilterindex (default: %u)"), DEFAULT_PEERBLOCKFILTERS));
     strUsage += HelpMessageOpt("-peerbloomfilters", strprintf(_("Support filtering of blocks and transaction with bloom filters (default: %u)"), DEFAULT_PEERBLOOMFILTERS));
     strUsage += HelpMessageOpt("-port=<port>", strprintf(_("Listen for connections on <port> (default: %u or testnet: %u)"), Params(CBaseChainParams::MAIN).GetDefaultPort(), Params(CBaseChainParams::TESTNET).GetDefaultPort()));
     strUsage += HelpMessageOpt("-proxy=<ip:port>", _("Connect through SOCKS5 proxy"));
@@ -519,6 +550,7 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-checkblockindex", strprintf("Do a full consistency check for mapBlockIndex, setBlockIndexCandidates, chainActive and mapBlocksUnlinked occasionally. Also sets -checkmempool (default: %u)", Params(CBaseChainParams::MAIN).DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkmempool=<n>", strprintf("Run checks every <n> transactions (default: %u)", Params(CBaseChainParams::MAIN).DefaultConsistencyChecks()));
         strUsage += HelpMessageOpt("-checkpoints", strprintf("Disable expensive verification for known chain history (default: %u)", DEFAULT_CHECKPOINTS_ENABLED));
+        strUsage += HelpMessageOpt("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize));
         strUsage += HelpMessageOpt("-disablesafemode", strprintf("Disable safemode, override a real safe mode event (default: %u)", DEFAULT_DISABLE_SAFEMODE));
         strUsage += HelpMessageOpt("-testsafemode", strprintf("Force safe mode (default: %u)", DEFAULT_TESTSAFEMODE));
         strUsage += HelpMessageOpt("-dropmessagestest=<n>", "Randomly drop 1 of every <n> network messages");
@@ -538,6 +570,7 @@ std::string HelpMessage(HelpMessageMode mode)
     if (showDebug)
         strUsage += HelpMessageOpt("-nodebug", "Turn off debugging messages, same as -debug=0");
     strUsage += HelpMessageOpt("-help-debug", _("Show all debugging options (usage: --help -help-debug)"));
+    strUsage += HelpMessageOpt("-logqueuesize=<n>", strprintf(_("Write the debug output from a background thread with a queue of <n> messages, dropping messages while it is full, 0 to write it synchronously (default: %u)"), DEFAULT_LOGQUEUESIZE));
     strUsage += HelpMessageOpt("-logips", strprintf(_("Include IP addresses in debug output (default: %u)"), DEFAULT_LOGIPS));
     strUsage += HelpMessageOpt("-logtimestamps", strprintf(_("Prepend debug output with timestamp (default: %u)"), DEFAULT_LOGTIMESTAMPS));
     if (showDebug)
@@ -547,6 +580,7 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-limitfreerelay=<n>", strprintf("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default: %u)", DEFAULT_LIMITFREERELAY));
         strUsage += HelpMessageOpt("-relaypriority", strprintf("Require high priority for relaying free or low-fee transactions (default: %u)", DEFAULT_RELAYPRIORITY));
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit size of signature cache to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxspendcachesize=<n>", strprintf("Limit size of sigma and zerocoin spend verification cache to <n> MiB (default: %u)", DEFAULT_MAX_SPEND_CACHE_SIZE));
         strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE));
     }
     strUsage += HelpMessageOpt("-minrelaytxfee=<amt>", strprintf(_("Fees (in %s/kB) smaller than this are considered zero fee for relaying, mining and transaction creation (default: %s)"),
@@ -739,6 +773,13 @@ void ThreadImport(std::vector <boost::filesystem::path> vImportFiles) {
     {
     CImportingNow imp;
 
+    // Read blocks ahead of the tip on worker threads while importing
+    int nPrefetchBlocks = GetArg("-prefetchblocks", DEFAULT_PREFETCH_BLOCKS);
+    if (nPrefetchBlocks > 0) {
+        LOCK(cs_main);
+        g_blockprefetcher.reset(new CBlockPrefetcher(chainparams.GetConsensus(), std::min(std::max(GetNumCores() - 1, 1), 8), nPrefetchBlocks));
+    }
+
     // -reindex
     if (fReindex) {
         MTPState::GetMTPState()->Reset();
@@ -793,6 +834,11 @@ void ThreadImport(std::vector <boost::filesystem::path> vImportFiles) {
         StartShutdown();
     }
 
+    {
+        LOCK(cs_main);
+        g_blockprefetcher.reset();
+    }
+
     if (GetBoolArg("-stopafterblockimport", DEFAULT_STOPAFTERBLOCKIMPORT)) {
         LogPrintf("Stopping after block import\n");
         StartShutdown();
@@ -820,6 +866,15 @@ void ThreadImport(std::vector <boost::filesystem::path> vImportFiles) {
         LoadMempool();
     }
 
+    // Index the mints of the sigma blocks connected by older versions, for the wallet sync below
+    sigma::BuildSigmaMintIndex();
+
+    // Catch the UTXO set statistics up when they weren't kept so far
+    BuildUTXOStats();
+
+    // Index the filters of the blocks connected before -blockfilterindex was enabled
+    BuildBlockFilterIndex();
+
 #ifdef ENABLE_WALLET
     if (!GetBoolArg("-disablewallet", false) && pwalletMain->zwallet) {
         pwalletMain->zwallet->SyncWithChain();
@@ -1174,6 +1229,26 @@ bool AppInitParameterInteraction()
     if (GetArg("-prune", 0)) {
         if (GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX))
+            return InitError(_("Prune mode is incompatible with -blockfilterindex."));
+    }
+
+    if (GetBoolArg("-peerblockfilters", DEFAULT_PEERBLOCKFILTERS) && !GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX))
+        return InitError(_("-peerblockfilters requires -blockfilterindex."));
+
+    // a node started from a chain state snapshot has no blocks below it
+    if (IsArgSet("-loadchainstate")) {
+        if (!GetArg("-prune", 0))
+            return InitError(_("-loadchainstate requires -prune."));
+        // the snapshot isn't validated, only trusted when it is the one the user expects
+        std::string strSnapshotHash = GetArg("-loadchainstatehash", "");
+        if (strSnapshotHash.size() != 64 || !IsHex(strSnapshotHash))
+            return InitError(_("-loadchainstate requires -loadchainstatehash, the hash of the snapshot returned by dumpchainstate."));
+        if (GetBoolArg("-reindex", false) || GetBoolArg("-reindex-chainstate", false))
+            return InitError(_("-loadchainstate is incompatible with -reindex and -reindex-chainstate."));
+        if (GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) || GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
+            GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX))
+            return InitError(_("-loadchainstate is incompatible with -addressindex, -spentindex and -timestampindex."));
     }
 
     // Make sure enough file descriptors are available
@@ -1184,11 +1259,15 @@ bool AppInitParameterInteraction()
     nMaxConnections = std::max(nUserMaxConnections, 0);
 
     // Trim requested connection counts, to fit into system limitations
-    nMaxConnections = std::max(std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS)), 0);
-    nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS + MAX_ADDNODE_CONNECTIONS);
+    nMaxConnections = std::max(std::min(nMaxConnections, (int)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS - DB_EXTRA_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS)), 0);
+    nFD = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS + DB_EXTRA_FILEDESCRIPTORS + MAX_ADDNODE_CONNECTIONS);
     if (nFD < MIN_CORE_FILEDESCRIPTORS)
         return InitError(_("Not enough file descriptors available."));
     nMaxConnections = std::min(nFD - MIN_CORE_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS, nMaxConnections);
+#ifndef WIN32
+    // The databases keep more files open with the tuned profiles only with the descriptors the connections leave
+    SetDBExtraOpenFiles(std::min(nFD - MIN_CORE_FILEDESCRIPTORS - MAX_ADDNODE_CONNECTIONS - nMaxConnections, DB_EXTRA_FILEDESCRIPTORS));
+#endif
 
     if (nMaxConnections < nUserMaxConnections)
         InitWarning(strprintf(_("Reducing -maxconnections from %d to %d, because of system limitations."), nUserMaxConnections, nMaxConnections));
@@ -1229,6 +1308,8 @@ bool AppInitParameterInteraction()
     }
     fCheckBlockIndex = GetBoolArg("-checkblockindex", chainparams.DefaultConsistencyChecks());
     fCheckpointsEnabled = GetBoolArg("-checkpoints", DEFAULT_CHECKPOINTS_ENABLED);
+    fUTXOStats = GetBoolArg("-utxostats", DEFAULT_UTXOSTATS);
+    fBlockFilterIndex = GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX);
 
     hashAssumeValid = uint256S(GetArg("-assumevalid", chainparams.GetConsensus().defaultAssumeValid.GetHex()));
     if (!hashAssumeValid.IsNull())
@@ -1345,6 +1426,9 @@ bool AppInitParameterInteraction()
     if (GetBoolArg("-peerbloomfilters", DEFAULT_PEERBLOOMFILTERS))
         nLocalServices = ServiceFlags(nLocalServices | NODE_BLOOM);
 
+    if (GetBoolArg("-peerblockfilters", DEFAULT_PEERBLOCKFILTERS))
+        nLocalServices = ServiceFlags(nLocalServices | NODE_COMPACT_FILTERS);
+
     if (GetArg("-rpcserialversion", DEFAULT_RPC_SERIALIZE_VERSION) < 0)
         return InitError("rpcserialversion must be non-negative.");
 
@@ -1430,6 +1514,9 @@ bool AppInitSanityChecks()
     ECC_Start();
     globalVerifyHandle.reset(new ECCVerifyHandle());
 
+    LogPrintf("Using the '%s' Lyra2Z implementation\n", lyra2z_autodetect());
+    LogPrintf("Using the '%s' MTP implementation\n", mtp_autodetect());
+
     // Sanity check
     if (!InitSanityCheck())
         return InitError(strprintf(_("Initialization sanity check failed. %s is shutting down."), _(PACKAGE_NAME)));
@@ -1462,6 +1549,10 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     if (fPrintToDebugLog)
         OpenDebugLog();
 
+    int64_t nLogQueueSize = GetArg("-logqueuesize", DEFAULT_LOGQUEUESIZE);
+    if (nLogQueueSize > 0)
+        StartAsyncLogging(std::min(nLogQueueSize, (int64_t)MAX_LOGQUEUESIZE));
+
     if (!fLogTimestamps)
         LogPrintf("Startup time: %s\n", DateTimeStrFormat("%Y-%m-%d %H:%M:%S", GetTime()));
     LogPrintf("Default data directory %s\n", GetDefaultDataDir().string());
@@ -1470,6 +1561,7 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     LogPrintf("Using at most %i automatic connections (%i file descriptors available)\n", nMaxConnections, nFD);
 
     InitSignatureCache();
+    InitSpendVerificationCache();
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
@@ -1771,6 +1863,21 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                     }
                 }
 
+                // A new data directory is filled from the chain state snapshot, later starts find it done
+                if (IsArgSet("-loadchainstate") && pcoinsdbview->GetBestBlock().IsNull()) {
+                    uiInterface.InitMessage(_("Loading chain state snapshot..."));
+                    boost::filesystem::path pathSnapshot = GetArg("-loadchainstate", "");
+                    CChainSnapshotInfo info;
+                    if (!LoadChainSnapshot(pathSnapshot, uint256S(GetArg("-loadchainstatehash", "")), info))
+                        return InitError(strprintf(_("Unable to load the chain state snapshot %s"), pathSnapshot.string()));
+                    LogPrintf("Loaded the chain state snapshot %s of block %s, %u transaction outputs\n",
+                        info.hashContent.ToString(), info.hashBlock.ToString(), info.nTransactionOutputs);
+
+                    // The empty block index made it look like a reindex was needed
+                    fReindex = false;
+                    pblocktree->WriteReindexing(false);
+                }
+
                 if (!LoadBlockIndex(chainparams)) {
                     strLoadError = _("Error loading block database");
                     break;
@@ -1802,6 +1909,9 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                     return InitError(_("Incorrect or no genesis block found. Wrong datadir for network?"));
                 }
 
+                // Pick up the UTXO set statistics of the loaded tip, before any block is connected
+                LoadUTXOStats();
+
                 // Initialize the block index (no-op if non-empty database was already loaded)
                 if (!InitBlockIndex(chainparams)) {
                     strLoadError = _("Error initializing block database");
@@ -144,38 +144,22 @@ namespace libzerocoin {
 
         Bignum c = Bignum(hasher.GetHash()); //this hash should be of length k_prime bits
 
-        Bignum st_1_prime = (valueOfCommitmentToCoin.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) *
-                             sg.pow_mod(s_alpha, params->accumulatorPoKCommitmentGroup.modulus) *
-                             sh.pow_mod(s_phi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                            params->accumulatorPoKCommitmentGroup.modulus;
-        Bignum st_2_prime = (sg.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) * ((valueOfCommitmentToCoin *
-                                                                                              sg.inverse(
-                                                                                                      params->accumulatorPoKCommitmentGroup.modulus)).pow_mod(
-                s_gamma, params->accumulatorPoKCommitmentGroup.modulus)) *
-                             sh.pow_mod(s_psi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                            params->accumulatorPoKCommitmentGroup.modulus;
-        Bignum st_3_prime = (sg.pow_mod(c, params->accumulatorPoKCommitmentGroup.modulus) *
-                             (sg * valueOfCommitmentToCoin).pow_mod(s_sigma,
-                                                                    params->accumulatorPoKCommitmentGroup.modulus) *
-                             sh.pow_mod(s_xi, params->accumulatorPoKCommitmentGroup.modulus)) %
-                            params->accumulatorPoKCommitmentGroup.modulus;
-
-        Bignum t_1_prime =
-                (C_r.pow_mod(c, params->accumulatorModulus) * h_n.pow_mod(s_zeta, params->accumulatorModulus) *
-                 g_n.pow_mod(s_epsilon, params->accumulatorModulus)) % params->accumulatorModulus;
-        Bignum t_2_prime =
-                (C_e.pow_mod(c, params->accumulatorModulus) * h_n.pow_mod(s_eta, params->accumulatorModulus) *
-                 g_n.pow_mod(s_alpha, params->accumulatorModulus)) % params->accumulatorModulus;
-
-        Bignum t_3_prime = ((a.getValue()).pow_mod(c, params->accumulatorModulus) *
-                            C_u.pow_mod(s_alpha, params->accumulatorModulus) *
-                            ((h_n.inverse(params->accumulatorModulus)).pow_mod(s_beta, params->accumulatorModulus))) %
-                           params->accumulatorModulus;
-
-        Bignum t_4_prime = (C_r.pow_mod(s_alpha, params->accumulatorModulus) *
-                            ((h_n.inverse(params->accumulatorModulus)).pow_mod(s_delta, params->accumulatorModulus)) *
-                            ((g_n.inverse(params->accumulatorModulus)).pow_mod(s_beta, params->accumulatorModulus))) %
-                           params->accumulatorModulus;
+        const Bignum& sModulus = params->accumulatorPoKCommitmentGroup.modulus;
+        const Bignum& nModulus = params->accumulatorModulus;
+
+        Bignum st_1_prime = Bignum::multi_pow_mod({{valueOfCommitmentToCoin, c}, {sg, s_alpha}, {sh, s_phi}}, sModulus);
+        Bignum st_2_prime = Bignum::multi_pow_mod({{sg, c}, {valueOfCommitmentToCoin * sg.inverse(sModulus), s_gamma},
+                                                   {sh, s_psi}}, sModulus);
+        Bignum st_3_prime = Bignum::multi_pow_mod({{sg, c}, {sg * valueOfCommitmentToCoin, s_sigma}, {sh, s_xi}}, sModulus);
+
+        Bignum t_1_prime = Bignum::multi_pow_mod({{C_r, c}, {h_n, s_zeta}, {g_n, s_epsilon}}, nModulus);
+        Bignum t_2_prime = Bignum::multi_pow_mod({{C_e, c}, {h_n, s_eta}, {g_n, s_alpha}}, nModulus);
+
+        Bignum t_3_prime = Bignum::multi_pow_mod({{a.getValue(), c}, {C_u, s_alpha}, {h_n.inverse(nModulus), s_beta}},
+                                                 nModulus);
+
+        Bignum t_4_prime = Bignum::multi_pow_mod({{C_r, s_alpha}, {h_n.inverse(nModulus), s_delta},
+                                                  {g_n.inverse(nModulus), s_beta}}, nModulus);
 
         bool result = false;
 
@@ -143,10 +143,9 @@ bool SerialNumberSignatureOfKnowledge::Verify(const Bignum& coinSerialNumber, co
             if(challenge_bit) {
                 tprime[i] = challengeCalculation(coinSerialNumber, s_notprime[i], sprime[i]);
             } else {
-                Bignum exp = b.pow_mod(s_notprime[i], params->serialNumberSoKCommitmentGroup.groupOrder);
-                tprime[i] = ((valueOfCommitmentToCoin.pow_mod(exp, params->serialNumberSoKCommitmentGroup.modulus) % params->serialNumberSoKCommitmentGroup.modulus) *
-                             (h.pow_mod(sprime[i], params->serialNumberSoKCommitmentGroup.modulus) % params->serialNumberSoKCommitmentGroup.modulus)) %
-                            params->serialNumberSoKCommitmentGroup.modulus;
+                Bignum exp = b.pow_mod_public(s_notprime[i], params->serialNumberSoKCommitmentGroup.groupOrder);
+                tprime[i] = Bignum::multi_pow_mod({{valueOfCommitmentToCoin, exp}, {h, sprime[i]}},
+                                                  params->serialNumberSoKCommitmentGroup.modulus);
             }
         });
 	}
@@ -9,6 +9,8 @@
 #include <vector>
 #include <openssl/bn.h>
 
+#include "bignum_backend.h"
+
 #include "../../uint256.h" // for uint64
 #include "../../arith_uint256.h"
 #include "../../version.h"
@@ -549,6 +551,55 @@ public:
         return ret;
     }
 
+    /**
+     * modular exponentiation this^e mod n using the backend selected at configure time.
+     * Only to be used on public data, the backend isn't constant time.
+     * @param e exponent
+     * @param m modulus
+     */
+    CBigNum pow_mod_public(const CBigNum& e, const CBigNum& m) const {
+        CAutoBN_CTX pctx;
+        CBigNum ret;
+        if (e < 0) {
+            CBigNum inv = this->inverse(m);
+            CBigNum posE = e * -1;
+            if (!bignum_backend::PowMod(&ret, &inv, &posE, &m, pctx))
+                throw bignum_error("CBigNum::pow_mod_public : PowMod failed on negative exponent");
+        } else if (!bignum_backend::PowMod(&ret, bn, &e, &m, pctx))
+            throw bignum_error("CBigNum::pow_mod_public : PowMod failed");
+
+        return ret;
+    }
+
+    /**
+     * product of base^exponent mod m over all terms, computed with a simultaneous
+     * exponentiation by the configured backend. Only to be used on public data.
+     * @param terms (base, exponent) pairs, exponents may be negative
+     * @param m modulus
+     */
+    static CBigNum multi_pow_mod(const std::vector<std::pair<CBigNum, CBigNum>>& terms, const CBigNum& m) {
+        CAutoBN_CTX pctx;
+        // g^-x = (g^-1)^x
+        std::vector<std::pair<CBigNum, CBigNum>> posTerms;
+        std::vector<bignum_backend::PowTerm> backendTerms;
+        posTerms.reserve(terms.size());
+        backendTerms.reserve(terms.size());
+        for (const std::pair<CBigNum, CBigNum>& term : terms) {
+            if (term.second < 0) {
+                posTerms.emplace_back(term.first.inverse(m), term.second * -1);
+                backendTerms.emplace_back(&posTerms.back().first, &posTerms.back().second);
+            } else {
+                backendTerms.emplace_back(&term.first, &term.second);
+            }
+        }
+
+        CBigNum ret;
+        if (!bignum_backend::MultiPowMod(&ret, backendTerms, &m, pctx))
+            throw bignum_error("CBigNum::multi_pow_mod : MultiPowMod failed");
+
+        return ret;
+    }
+
     /**
      * Calculates the inverse of this element mod m.
      * i.e. i such this*i = 1 mod m
@@ -0,0 +1,177 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include "config/bitcoin-config.h"
+#endif
+
+#include "bignum_backend.h"
+
+#include <algorithm>
+
+#ifdef USE_GMP_BIGNUM
+#include <gmp.h>
+#endif
+
+namespace bignum_backend {
+
+bool PowModOpenSSL(BIGNUM* r, const BIGNUM* a, const BIGNUM* e, const BIGNUM* m, BN_CTX* ctx)
+{
+    return BN_mod_exp(r, a, e, m, ctx) == 1;
+}
+
+bool MultiPowModOpenSSL(BIGNUM* r, const std::vector<PowTerm>& terms, const BIGNUM* m, BN_CTX* ctx)
+{
+    if (!BN_one(r))
+        return false;
+    BIGNUM* t = BN_new();
+    bool fOk = t != NULL;
+    for (size_t i = 0; fOk && i < terms.size(); i++)
+        fOk = BN_mod_exp(t, terms[i].first, terms[i].second, m, ctx) && BN_mod_mul(r, r, t, m, ctx);
+    BN_free(t);
+    // An empty product still has to be reduced, like the exponentiations are
+    return fOk && BN_nnmod(r, r, m, ctx);
+}
+
+#ifdef USE_GMP_BIGNUM
+
+namespace {
+
+/** A number of mpz_t, initialized and cleared together. */
+class CMpzArray
+{
+public:
+    explicit CMpzArray(size_t n) : v(n)
+    {
+        for (__mpz_struct& z : v)
+            mpz_init(&z);
+    }
+    ~CMpzArray()
+    {
+        for (__mpz_struct& z : v)
+            mpz_clear(&z);
+    }
+    CMpzArray(const CMpzArray&) = delete;
+    CMpzArray& operator=(const CMpzArray&) = delete;
+
+    mpz_ptr operator[](size_t i) { return &v[i]; }
+
+private:
+    std::vector<__mpz_struct> v;
+};
+
+void BNToMpz(mpz_ptr z, const BIGNUM* bn)
+{
+    std::vector<unsigned char> buf(BN_num_bytes(bn));
+    BN_bn2bin(bn, buf.data());
+    mpz_import(z, buf.size(), 1, 1, 1, 0, buf.data());
+    if (BN_is_negative(bn))
+        mpz_neg(z, z);
+}
+
+bool MpzToBN(BIGNUM* bn, mpz_srcptr z)
+{
+    // Results are reduced modulo a positive number, they are never negative
+    std::vector<unsigned char> buf((mpz_sizeinbase(z, 2) + 7) / 8 + 1);
+    size_t nSize = 0;
+    mpz_export(buf.data(), &nSize, 1, 1, 1, 0, z);
+    return BN_bin2bn(buf.data(), nSize, bn) != NULL;
+}
+
+//! Bits of the exponents handled at once by MultiPowMod
+const unsigned int WINDOW_BITS = 4;
+
+} // anon namespace
+
+const char* Name()
+{
+    return "gmp";
+}
+
+bool PowMod(BIGNUM* r, const BIGNUM* a, const BIGNUM* e, const BIGNUM* m, BN_CTX* ctx)
+{
+    if (BN_is_zero(m) || BN_is_negative(e))
+        return false;
+
+    CMpzArray z(4);
+    BNToMpz(z[0], a);
+    BNToMpz(z[1], e);
+    BNToMpz(z[2], m);
+    mpz_powm(z[3], z[0], z[1], z[2]);
+    return MpzToBN(r, z[3]);
+}
+
+bool MultiPowMod(BIGNUM* r, const std::vector<PowTerm>& terms, const BIGNUM* m, BN_CTX* ctx)
+{
+    if (BN_is_zero(m))
+        return false;
+    if (terms.size() == 1)
+        return PowMod(r, terms[0].first, terms[0].second, m, ctx);
+
+    // Interleaved fixed window exponentiation: every base gets a table of its first
+    // 2^WINDOW_BITS powers, then all exponents are scanned from the top at the same time.
+    const size_t nTable = size_t(1) << WINDOW_BITS;
+    CMpzArray mod(1), acc(1), exps(terms.size()), table(terms.size() * nTable);
+    BNToMpz(mod[0], m);
+    mpz_abs(mod[0], mod[0]);
+
+    size_t nBits = 0;
+    for (size_t i = 0; i < terms.size(); i++) {
+        if (BN_is_negative(terms[i].second))
+            return false;
+        BNToMpz(exps[i], terms[i].second);
+        nBits = std::max(nBits, mpz_sizeinbase(exps[i], 2));
+
+        mpz_set_ui(table[i * nTable], 1);
+        BNToMpz(table[i * nTable + 1], terms[i].first);
+        mpz_mod(table[i * nTable + 1], table[i * nTable + 1], mod[0]);
+        for (size_t j = 2; j < nTable; j++) {
+            mpz_mul(table[i * nTable + j], table[i * nTable + j - 1], table[i * nTable + 1]);
+            mpz_mod(table[i * nTable + j], table[i * nTable + j], mod[0]);
+        }
+    }
+
+    mpz_set_ui(acc[0], 1);
+    const size_t nWindows = (nBits + WINDOW_BITS - 1) / WINDOW_BITS;
+    for (size_t w = nWindows; w-- > 0;) {
+        if (w + 1 != nWindows) {
+            for (unsigned int k = 0; k < WINDOW_BITS; k++) {
+                mpz_mul(acc[0], acc[0], acc[0]);
+                mpz_mod(acc[0], acc[0], mod[0]);
+            }
+        }
+        for (size_t i = 0; i < terms.size(); i++) {
+            size_t nDigit = 0;
+            for (unsigned int k = WINDOW_BITS; k-- > 0;)
+                nDigit = (nDigit << 1) | mpz_tstbit(exps[i], w * WINDOW_BITS + k);
+            if (nDigit != 0) {
+                mpz_mul(acc[0], acc[0], table[i * nTable + nDigit]);
+                mpz_mod(acc[0], acc[0], mod[0]);
+            }
+        }
+    }
+    mpz_mod(acc[0], acc[0], mod[0]);
+    return MpzToBN(r, acc[0]);
+}
+
+#else
+
+const char* Name()
+{
+    return "openssl";
+}
+
+bool PowMod(BIGNUM* r, const BIGNUM* a, const BIGNUM* e, const BIGNUM* m, BN_CTX* ctx)
+{
+    return PowModOpenSSL(r, a, e, m, ctx);
+}
+
+bool MultiPowMod(BIGNUM* r, const std::vector<PowTerm>& terms, const BIGNUM* m, BN_CTX* ctx)
+{
+    return MultiPowModOpenSSL(r, terms, m, ctx);
+}
+
+#endif // USE_GMP_BIGNUM
+
+} // namespace bignum_backend
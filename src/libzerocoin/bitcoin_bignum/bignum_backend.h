@@ -0,0 +1,40 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BIGNUM_BACKEND_H
+#define BITCOIN_BIGNUM_BACKEND_H
+
+#include <utility>
+#include <vector>
+
+#include <openssl/bn.h>
+
+/**
+ * Modular exponentiation used when verifying zerocoin proofs. All operands are public,
+ * so the implementation doesn't have to be constant time. By default OpenSSL is used,
+ * configuring with --enable-zerocoin-gmp switches to GMP.
+ */
+namespace bignum_backend {
+
+typedef std::pair<const BIGNUM*, const BIGNUM*> PowTerm;
+
+/** Name of the backend selected at configure time. */
+const char* Name();
+
+/** r = a^e mod m. The exponent must not be negative. */
+bool PowMod(BIGNUM* r, const BIGNUM* a, const BIGNUM* e, const BIGNUM* m, BN_CTX* ctx);
+
+/**
+ * r = a_1^e_1 * ... * a_n^e_n mod m for the given (base, exponent) terms, sharing the
+ * squarings between all terms. Exponents must not be negative.
+ */
+bool MultiPowMod(BIGNUM* r, const std::vector<PowTerm>& terms, const BIGNUM* m, BN_CTX* ctx);
+
+/** Same as above, always using OpenSSL. Used for comparing the backends. */
+bool PowModOpenSSL(BIGNUM* r, const BIGNUM* a, const BIGNUM* e, const BIGNUM* m, BN_CTX* ctx);
+bool MultiPowModOpenSSL(BIGNUM* r, const std::vector<PowTerm>& terms, const BIGNUM* m, BN_CTX* ctx);
+
+} // namespace bignum_backend
+
+#endif // BITCOIN_BIGNUM_BACKEND_H
@@ -9,6 +9,7 @@
 #include "activemasternode.h"
 #include "bls/bls_batchverifier.h"
 #include "init.h"
+#include "metrics.h"
 #include "net_processing.h"
 #include "netmessagemaker.h"
 #include "validation.h"
@@ -20,6 +21,12 @@ namespace llmq
 
 CSigSharesManager* quorumSigSharesManager = nullptr;
 
+static CMetricHistogram metricSign("tecracoin_llmq_signing_seconds", "Time spent in each step of LLMQ signing", "step", "sign");
+static CMetricHistogram metricVerifySigShares("tecracoin_llmq_signing_seconds", "Time spent in each step of LLMQ signing", "step", "verify_sig_shares");
+static CMetricHistogram metricRecover("tecracoin_llmq_signing_seconds", "Time spent in each step of LLMQ signing", "step", "recover");
+static CMetricCounter metricSigSharesVerified("tecracoin_llmq_sig_shares_verified_total", "LLMQ signature shares verified");
+static CMetricCounter metricSigsRecovered("tecracoin_llmq_sigs_recovered_total", "LLMQ signatures recovered from their shares");
+
 void CSigShare::UpdateKey()
 {
     key.first = CLLMQUtils::BuildSignHash(*this);
@@ -618,8 +625,12 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
     }
 
     cxxtimer::Timer verifyTimer(true);
-    batchVerifier.Verify();
+    {
+        CMetricTimer timer(metricVerifySigShares);
+        batchVerifier.Verify();
+    }
     verifyTimer.stop();
+    metricSigSharesVerified.Inc(verifyCount);
 
     LogPrint("llmq-sigs", "CSigSharesManager::%s -- verified sig shares. count=%d, vt=%d, nodes=%d\n", __func__, verifyCount, verifyTimer.count(), sigSharesByNodes.size());
 
@@ -747,7 +758,12 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
     // now recover it
     cxxtimer::Timer t(true);
     CBLSSignature recoveredSig;
-    if (!recoveredSig.Recover(sigSharesForRecovery, idsForRecovery)) {
+    bool fRecovered;
+    {
+        CMetricTimer timer(metricRecover);
+        fRecovered = recoveredSig.Recover(sigSharesForRecovery, idsForRecovery);
+    }
+    if (!fRecovered) {
         LogPrintf("CSigSharesManager::%s -- failed to recover signature. id=%s, msgHash=%s, time=%d\n", __func__,
                   id.ToString(), msgHash.ToString(), t.count());
         return;
@@ -755,6 +771,7 @@ void CSigSharesManager::TryRecoverSig(const CQuorumCPtr& quorum, const uint256&
 
     LogPrint("llmq-sigs", "CSigSharesManager::%s -- recovered signature. id=%s, msgHash=%s, time=%d\n", __func__,
               id.ToString(), msgHash.ToString(), t.count());
+    metricSigsRecovered.Inc();
 
     CRecoveredSig rs;
     rs.llmqType = quorum->params.type;
@@ -1420,7 +1437,10 @@ void CSigSharesManager::Sign(const CQuorumCPtr& quorum, const uint256& id, const
     sigShare.quorumMember = (uint16_t)memberIdx;
     uint256 signHash = CLLMQUtils::BuildSignHash(sigShare);
 
-    sigShare.sigShare.Set(skShare.Sign(signHash));
+    {
+        CMetricTimer timer(metricSign);
+        sigShare.sigShare.Set(skShare.Sign(signHash));
+    }
     if (!sigShare.sigShare.Get().IsValid()) {
         LogPrintf("CSigSharesManager::%s -- failed to sign sigShare. signHash=%s, id=%s, msgHash=%s, time=%s\n", __func__,
                   signHash.ToString(), sigShare.id.ToString(), sigShare.msgHash.ToString(), t.count());
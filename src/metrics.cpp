@@ -0,0 +1,231 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "metrics.h"
+
+#include "tinyformat.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <mutex>
+
+namespace {
+
+class CMetricsRegistry
+{
+private:
+    std::mutex mutex;
+    std::vector<const CMetric*> vMetrics;
+
+public:
+    void Register(const CMetric* metric)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        vMetrics.push_back(metric);
+    }
+
+    void Unregister(const CMetric* metric)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        vMetrics.erase(std::remove(vMetrics.begin(), vMetrics.end(), metric), vMetrics.end());
+    }
+
+    std::vector<CMetricSnapshot> Snapshot()
+    {
+        std::vector<CMetricSnapshot> vSnapshots;
+        std::lock_guard<std::mutex> lock(mutex);
+        vSnapshots.resize(vMetrics.size());
+        for (size_t i = 0; i < vMetrics.size(); i++)
+            vMetrics[i]->Snapshot(vSnapshots[i]);
+        return vSnapshots;
+    }
+};
+
+/**
+ * The metrics are static objects registered by their constructors, the
+ * registry is created by the first one and leaked on exit, like the debug log
+ * mutex, so the metrics can be destroyed in any order.
+ */
+CMetricsRegistry& GetMetricsRegistry()
+{
+    static CMetricsRegistry* registry = new CMetricsRegistry();
+    return *registry;
+}
+
+std::atomic<size_t> nNextMetricShard(0);
+
+//! Prometheus value of a counter or a gauge
+std::string FormatMetricValue(double value)
+{
+    if (value == (double)(int64_t)value)
+        return strprintf("%d", (int64_t)value);
+    return strprintf("%.6f", value);
+}
+
+std::string FormatMetricLabels(const CMetricSnapshot& snapshot, const std::string& strBound = "")
+{
+    std::string strLabels;
+    if (!snapshot.labelName.empty())
+        strLabels = strprintf("%s=\"%s\"", snapshot.labelName, snapshot.labelValue);
+    if (!strBound.empty())
+        strLabels += (strLabels.empty() ? "" : ",") + strprintf("le=\"%s\"", strBound);
+    return strLabels.empty() ? "" : "{" + strLabels + "}";
+}
+
+} // anon namespace
+
+size_t GetMetricShard()
+{
+    static thread_local size_t nShard = nNextMetricShard++ % METRIC_SHARDS;
+    return nShard;
+}
+
+const char* MetricTypeName(MetricType type)
+{
+    switch (type) {
+    case MetricType::COUNTER: return "counter";
+    case MetricType::GAUGE: return "gauge";
+    case MetricType::HISTOGRAM: return "histogram";
+    }
+    return "untyped";
+}
+
+CMetric::CMetric(const std::string& nameIn, const std::string& helpIn, const std::string& labelNameIn, const std::string& labelValueIn)
+    : name(nameIn), help(helpIn), labelName(labelNameIn), labelValue(labelValueIn)
+{
+    GetMetricsRegistry().Register(this);
+}
+
+CMetric::~CMetric()
+{
+    GetMetricsRegistry().Unregister(this);
+}
+
+void CMetric::SnapshotInfo(CMetricSnapshot& snapshot, MetricType type) const
+{
+    snapshot.name = name;
+    snapshot.help = help;
+    snapshot.type = type;
+    snapshot.labelName = labelName;
+    snapshot.labelValue = labelValue;
+}
+
+CMetricCounter::CMetricCounter(const std::string& nameIn, const std::string& helpIn, const std::string& labelNameIn, const std::string& labelValueIn)
+    : CMetric(nameIn, helpIn, labelNameIn, labelValueIn)
+{
+    for (Shard& shard : shards)
+        shard.nValue.store(0, std::memory_order_relaxed);
+}
+
+uint64_t CMetricCounter::Value() const
+{
+    uint64_t nValue = 0;
+    for (const Shard& shard : shards)
+        nValue += shard.nValue.load(std::memory_order_relaxed);
+    return nValue;
+}
+
+void CMetricCounter::Snapshot(CMetricSnapshot& snapshot) const
+{
+    SnapshotInfo(snapshot, MetricType::COUNTER);
+    snapshot.value = Value();
+}
+
+CMetricGauge::CMetricGauge(const std::string& nameIn, const std::string& helpIn, const std::string& labelNameIn, const std::string& labelValueIn)
+    : CMetric(nameIn, helpIn, labelNameIn, labelValueIn), nValue(0)
+{
+}
+
+void CMetricGauge::Snapshot(CMetricSnapshot& snapshot) const
+{
+    SnapshotInfo(snapshot, MetricType::GAUGE);
+    snapshot.value = Value();
+}
+
+CMetricFunction::CMetricFunction(const std::string& nameIn, const std::string& helpIn, MetricType typeIn, std::function<double()> funcIn,
+                                 const std::string& labelNameIn, const std::string& labelValueIn)
+    : CMetric(nameIn, helpIn, labelNameIn, labelValueIn), type(typeIn), func(std::move(funcIn))
+{
+    assert(type != MetricType::HISTOGRAM);
+}
+
+void CMetricFunction::Snapshot(CMetricSnapshot& snapshot) const
+{
+    SnapshotInfo(snapshot, type);
+    snapshot.value = func();
+}
+
+CMetricHistogram::CMetricHistogram(const std::string& nameIn, const std::string& helpIn, const std::string& labelNameIn, const std::string& labelValueIn)
+    : CMetric(nameIn, helpIn, labelNameIn, labelValueIn)
+{
+    for (Shard& shard : shards) {
+        for (std::atomic<uint64_t>& nCount : shard.vCounts)
+            nCount.store(0, std::memory_order_relaxed);
+        shard.nSumMicros.store(0, std::memory_order_relaxed);
+    }
+}
+
+void CMetricHistogram::Observe(int64_t nMicros)
+{
+    if (nMicros < 0)
+        nMicros = 0;
+    size_t nBucket = std::lower_bound(std::begin(METRIC_LATENCY_BOUNDS), std::end(METRIC_LATENCY_BOUNDS), nMicros) - std::begin(METRIC_LATENCY_BOUNDS);
+    Shard& shard = shards[GetMetricShard()];
+    shard.vCounts[nBucket].fetch_add(1, std::memory_order_relaxed);
+    shard.nSumMicros.fetch_add(nMicros, std::memory_order_relaxed);
+}
+
+void CMetricHistogram::Snapshot(CMetricSnapshot& snapshot) const
+{
+    SnapshotInfo(snapshot, MetricType::HISTOGRAM);
+    snapshot.vCumulativeCounts.assign(METRIC_LATENCY_BUCKETS - 1, 0);
+    snapshot.nCount = 0;
+    uint64_t nSumMicros = 0;
+    for (const Shard& shard : shards) {
+        uint64_t nCumulative = 0;
+        for (size_t i = 0; i < METRIC_LATENCY_BUCKETS; i++) {
+            nCumulative += shard.vCounts[i].load(std::memory_order_relaxed);
+            if (i < METRIC_LATENCY_BUCKETS - 1)
+                snapshot.vCumulativeCounts[i] += nCumulative;
+        }
+        snapshot.nCount += nCumulative;
+        nSumMicros += shard.nSumMicros.load(std::memory_order_relaxed);
+    }
+    snapshot.sum = nSumMicros * 0.000001;
+}
+
+std::vector<CMetricSnapshot> GetMetricsSnapshot()
+{
+    std::vector<CMetricSnapshot> vSnapshots = GetMetricsRegistry().Snapshot();
+    std::stable_sort(vSnapshots.begin(), vSnapshots.end(), [](const CMetricSnapshot& a, const CMetricSnapshot& b) {
+        return a.name < b.name;
+    });
+    return vSnapshots;
+}
+
+std::string FormatMetricsPrometheus(const std::vector<CMetricSnapshot>& vSnapshots)
+{
+    std::string str;
+    for (size_t i = 0; i < vSnapshots.size(); i++) {
+        const CMetricSnapshot& snapshot = vSnapshots[i];
+        // The help and type are given once for the metrics of a family
+        if (i == 0 || vSnapshots[i - 1].name != snapshot.name) {
+            str += strprintf("# HELP %s %s\n", snapshot.name, snapshot.help);
+            str += strprintf("# TYPE %s %s\n", snapshot.name, MetricTypeName(snapshot.type));
+        }
+
+        if (snapshot.type != MetricType::HISTOGRAM) {
+            str += strprintf("%s%s %s\n", snapshot.name, FormatMetricLabels(snapshot), FormatMetricValue(snapshot.value));
+            continue;
+        }
+        for (size_t j = 0; j < snapshot.vCumulativeCounts.size(); j++) {
+            std::string strBound = strprintf("%g", METRIC_LATENCY_BOUNDS[j] * 0.000001);
+            str += strprintf("%s_bucket%s %d\n", snapshot.name, FormatMetricLabels(snapshot, strBound), snapshot.vCumulativeCounts[j]);
+        }
+        str += strprintf("%s_bucket%s %d\n", snapshot.name, FormatMetricLabels(snapshot, "+Inf"), snapshot.nCount);
+        str += strprintf("%s_sum%s %s\n", snapshot.name, FormatMetricLabels(snapshot), FormatMetricValue(snapshot.sum));
+        str += strprintf("%s_count%s %d\n", snapshot.name, FormatMetricLabels(snapshot), snapshot.nCount);
+    }
+    return str;
+}
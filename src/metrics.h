@@ -0,0 +1,183 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_METRICS_H
+#define BITCOIN_METRICS_H
+
+#include "utiltime.h"
+
+#include <atomic>
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Number of shards of the counters and histograms. A thread updates the shard
+ * it is assigned, so threads updating the same metric rarely write to the same
+ * cache line, and the shards are only summed when the metrics are read.
+ */
+static const size_t METRIC_SHARDS = 16;
+
+/** Upper bounds of the buckets of the latency histograms, in microseconds, the last bucket is unbounded */
+static const int64_t METRIC_LATENCY_BOUNDS[] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+    100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+static const size_t METRIC_LATENCY_BUCKETS = sizeof(METRIC_LATENCY_BOUNDS) / sizeof(METRIC_LATENCY_BOUNDS[0]) + 1;
+
+/** The shard the metrics are updated in by this thread */
+size_t GetMetricShard();
+
+enum class MetricType
+{
+    COUNTER,
+    GAUGE,
+    HISTOGRAM,
+};
+
+const char* MetricTypeName(MetricType type);
+
+/** The value of a metric when the metrics were read */
+struct CMetricSnapshot
+{
+    std::string name;
+    std::string help;
+    MetricType type;
+    std::string labelName;
+    std::string labelValue;
+
+    //! Value of a counter or a gauge
+    double value;
+
+    //! Histogram: the number of observations up to each bound of METRIC_LATENCY_BOUNDS, and in total
+    std::vector<uint64_t> vCumulativeCounts;
+    uint64_t nCount;
+    //! Histogram: sum of the observations, in seconds
+    double sum;
+
+    CMetricSnapshot() : type(MetricType::COUNTER), value(0), nCount(0), sum(0) {}
+};
+
+/**
+ * A metric, registered while it exists. Metrics are meant to be static objects,
+ * with a name following the Prometheus conventions and at most one label
+ * telling apart the metrics of a family with the same name.
+ */
+class CMetric
+{
+protected:
+    const std::string name;
+    const std::string help;
+    const std::string labelName;
+    const std::string labelValue;
+
+    void SnapshotInfo(CMetricSnapshot& snapshot, MetricType type) const;
+
+public:
+    CMetric(const std::string& nameIn, const std::string& helpIn, const std::string& labelNameIn, const std::string& labelValueIn);
+    virtual ~CMetric();
+
+    CMetric(const CMetric&) = delete;
+    CMetric& operator=(const CMetric&) = delete;
+
+    virtual void Snapshot(CMetricSnapshot& snapshot) const = 0;
+};
+
+/** A count that only increases */
+class CMetricCounter : public CMetric
+{
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> nValue;
+    };
+    Shard shards[METRIC_SHARDS];
+
+public:
+    CMetricCounter(const std::string& nameIn, const std::string& helpIn,
+                   const std::string& labelNameIn = "", const std::string& labelValueIn = "");
+
+    void Inc(uint64_t n = 1)
+    {
+        shards[GetMetricShard()].nValue.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t Value() const;
+    void Snapshot(CMetricSnapshot& snapshot) const override;
+};
+
+/** A value that is set, or goes up and down */
+class CMetricGauge : public CMetric
+{
+private:
+    std::atomic<int64_t> nValue;
+
+public:
+    CMetricGauge(const std::string& nameIn, const std::string& helpIn,
+                 const std::string& labelNameIn = "", const std::string& labelValueIn = "");
+
+    void Set(int64_t n) { nValue.store(n, std::memory_order_relaxed); }
+    void Add(int64_t n) { nValue.fetch_add(n, std::memory_order_relaxed); }
+
+    int64_t Value() const { return nValue.load(std::memory_order_relaxed); }
+    void Snapshot(CMetricSnapshot& snapshot) const override;
+};
+
+/** A counter or a gauge whose value is computed when the metrics are read */
+class CMetricFunction : public CMetric
+{
+private:
+    const MetricType type;
+    const std::function<double()> func;
+
+public:
+    CMetricFunction(const std::string& nameIn, const std::string& helpIn, MetricType typeIn, std::function<double()> funcIn,
+                    const std::string& labelNameIn = "", const std::string& labelValueIn = "");
+
+    void Snapshot(CMetricSnapshot& snapshot) const override;
+};
+
+/** The distribution of the durations of an operation, over METRIC_LATENCY_BOUNDS */
+class CMetricHistogram : public CMetric
+{
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> vCounts[METRIC_LATENCY_BUCKETS];
+        std::atomic<uint64_t> nSumMicros;
+    };
+    Shard shards[METRIC_SHARDS];
+
+public:
+    CMetricHistogram(const std::string& nameIn, const std::string& helpIn,
+                     const std::string& labelNameIn = "", const std::string& labelValueIn = "");
+
+    void Observe(int64_t nMicros);
+    void Snapshot(CMetricSnapshot& snapshot) const override;
+};
+
+/** Observe the time from its construction to its destruction in a histogram */
+class CMetricTimer
+{
+private:
+    CMetricHistogram& histogram;
+    const int64_t nStart;
+
+public:
+    explicit CMetricTimer(CMetricHistogram& histogramIn) : histogram(histogramIn), nStart(GetTimeMicros()) {}
+    ~CMetricTimer() { histogram.Observe(GetTimeMicros() - nStart); }
+
+    CMetricTimer(const CMetricTimer&) = delete;
+    CMetricTimer& operator=(const CMetricTimer&) = delete;
+};
+
+/** Read every registered metric, ordered by name */
+std::vector<CMetricSnapshot> GetMetricsSnapshot();
+
+/** The metrics in the Prometheus text exposition format */
+std::string FormatMetricsPrometheus(const std::vector<CMetricSnapshot>& vSnapshots);
+
+#endif // BITCOIN_METRICS_H
@@ -0,0 +1,110 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MPSCQUEUE_H
+#define BITCOIN_MPSCQUEUE_H
+
+#include <assert.h>
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A bounded queue any number of threads push to without locking and a single
+ * thread pops from, a ring of cells each tagged with the position it can be
+ * written or read at (D. Vyukov's bounded queue, with a single consumer).
+ *
+ * The capacity is rounded up to a power of two. TryPush fails instead of
+ * waiting when the queue is full.
+ */
+template <typename T>
+class CBoundedMPSCQueue
+{
+private:
+    struct Cell
+    {
+        //! Position the cell is written at next, or that position + 1 once it holds a value to read
+        std::atomic<size_t> nSequence;
+        T value;
+    };
+
+    const size_t nMask;
+    std::unique_ptr<Cell[]> cells;
+    //! Next position to write, shared by the producers
+    std::atomic<size_t> nEnqueuePos;
+    //! Next position to read, only used by the consumer
+    size_t nDequeuePos;
+
+    static size_t RoundCapacity(size_t nCapacity)
+    {
+        size_t n = 2;
+        while (n < nCapacity)
+            n <<= 1;
+        return n;
+    }
+
+public:
+    explicit CBoundedMPSCQueue(size_t nCapacity)
+        : nMask(RoundCapacity(nCapacity) - 1), cells(new Cell[nMask + 1]), nEnqueuePos(0), nDequeuePos(0)
+    {
+        for (size_t i = 0; i <= nMask; i++)
+            cells[i].nSequence.store(i, std::memory_order_relaxed);
+    }
+
+    CBoundedMPSCQueue(const CBoundedMPSCQueue&) = delete;
+    CBoundedMPSCQueue& operator=(const CBoundedMPSCQueue&) = delete;
+
+    size_t Capacity() const { return nMask + 1; }
+
+    /** Push a value from any thread, false if the queue is full. The value is left alone then. */
+    bool TryPush(T&& value)
+    {
+        Cell* cell;
+        size_t nPos = nEnqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells[nPos & nMask];
+            size_t nSequence = cell->nSequence.load(std::memory_order_acquire);
+            intptr_t nDiff = (intptr_t)nSequence - (intptr_t)nPos;
+            if (nDiff == 0) {
+                // The cell is free at this position, claim it
+                if (nEnqueuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (nDiff < 0) {
+                // The cell still holds the value pushed a lap ago
+                return false;
+            } else {
+                // Another producer claimed the position first
+                nPos = nEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->nSequence.store(nPos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Pop the oldest value, only from the consumer thread. False if the queue is empty. */
+    bool TryPop(T& value)
+    {
+        Cell* cell = &cells[nDequeuePos & nMask];
+        size_t nSequence = cell->nSequence.load(std::memory_order_acquire);
+        if ((intptr_t)nSequence - (intptr_t)(nDequeuePos + 1) < 0)
+            return false;
+
+        value = std::move(cell->value);
+        cell->value = T();
+        cell->nSequence.store(nDequeuePos + nMask + 1, std::memory_order_release);
+        nDequeuePos++;
+        return true;
+    }
+
+    /** Whether there is nothing to pop, only from the consumer thread */
+    bool Empty() const
+    {
+        const Cell* cell = &cells[nDequeuePos & nMask];
+        return (intptr_t)cell->nSequence.load(std::memory_order_acquire) - (intptr_t)(nDequeuePos + 1) < 0;
+    }
+};
+
+#endif // BITCOIN_MPSCQUEUE_H
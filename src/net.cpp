@@ -90,7 +90,7 @@ static const uint64_t RANDOMIZER_ID_LOCALHOSTNONCE = 0xd93e69e2bbfa5735ULL; // S
 // Public Dandelion fields.
 
 // All transactions embargoed by dandelion.
-std::map<uint256, int64_t> CNode::mDandelionEmbargo;
+CDandelionEmbargoWheel CNode::dandelionEmbargoes;
 
 // Inbound connections. Transactions from each connection
 // are broadcast to one of 2 dandelion destinations.
@@ -103,6 +103,10 @@ std::vector<CNode*> CNode::vDandelionDestination;
 // Dandelion routes, showing txn from which peer must go to which destination.
 std::map<CNode*, CNode*> CNode::mDandelionRoutes;
 
+// Routing as of the last shuffle, reported by getdandelioninfo.
+CDandelionShuffleStats CNode::dandelionShuffleStats;
+CCriticalSection CNode::cs_dandelionShuffleStats;
+
 // Destination node to which are stem-ed all local transactions.
 CNode* CNode::localDandelionDestination = nullptr;
 
@@ -2586,10 +2590,31 @@ void CNode::DandelionShuffle() {
             }
         }
         localDandelionDestination = CNode::SelectFromDandelionDestinations();
+
+        std::map<CNode*, size_t> mRoutesPerDestination;
+        for (auto const& route : mDandelionRoutes)
+            mRoutesPerDestination[route.second]++;
+        LOCK(cs_dandelionShuffleStats);
+        dandelionShuffleStats.nShuffles++;
+        dandelionShuffleStats.nLastShuffleTime = GetTime();
+        dandelionShuffleStats.nInbound = vDandelionInbound.size();
+        dandelionShuffleStats.nOutbound = vDandelionOutbound.size();
+        dandelionShuffleStats.nDestinations = vDandelionDestination.size();
+        dandelionShuffleStats.nRoutes = mDandelionRoutes.size();
+        dandelionShuffleStats.nMaxRoutesPerDestination = 0;
+        for (auto const& count : mRoutesPerDestination)
+            dandelionShuffleStats.nMaxRoutesPerDestination = std::max(dandelionShuffleStats.nMaxRoutesPerDestination, count.second);
+        dandelionShuffleStats.fLocalDestination = localDandelionDestination != nullptr;
     }
     g_connman->ReleaseNodeVector(vNodes);
 }
 
+CDandelionShuffleStats CNode::GetDandelionShuffleStats()
+{
+    LOCK(cs_dandelionShuffleStats);
+    return dandelionShuffleStats;
+}
+
 void CConnman::ThreadDandelionShuffle() {
     int64_t nNextDandelionShuffle = 0;
     while (!interruptNet) {
@@ -2980,45 +3005,46 @@ void CNode::RelayDandelionTransaction(const CTransaction& tx, CNode* pfrom)
 
 void CNode::CheckDandelionEmbargoes()
 {
-    int64_t nCurrTime = GetTimeMicros();
-    for (auto iter=mDandelionEmbargo.begin(); iter != mDandelionEmbargo.end();) {
-        // If we got the embargoed transaction back, erase it.
-        if (mempool.exists(iter->first)) {
-           iter = mDandelionEmbargo.erase(iter);
-        } else if (iter->second < nCurrTime) {
-            // Embargo time is over, we did not "see" the transaction back in fluff phase,
-            // so start fluffing/relaying it.
-            CValidationState state;
-            shared_ptr<const CTransaction> ptx = txpools.getStemTxPool().get(iter->first);
-            // If txn was not found in Stempool, then something went wrong,
-            // Keep it embargoed for now.
-            if (!ptx) {
-               iter = mDandelionEmbargo.erase(iter);
-                continue;
-            }
-            bool fMissingInputs = false;
-            std::list<CTransactionRef> lRemovedTxn;
-            AcceptToMemoryPool(
-                mempool,
-                state,
-                ptx,
-                true, // fLimitFree
-                &fMissingInputs,
-                &lRemovedTxn,
-                false, /* fOverrideMempoolLimit */
-                0, /* nAbsurdFee */
-                false /*isCheckWalletTransaction*/
-                );
-            LogPrintf("AcceptToMemoryPool: accepted %s (poolsz %u txn, %u kB)\n",
-                      iter->first.ToString(),
-                      mempool.size(),
-                      mempool.DynamicMemoryUsage() / 1000);
-            g_connman->RelayTransaction(*ptx);
-            iter = mDandelionEmbargo.erase(iter);
-        } else {
-            iter++;
-        }
+    AssertLockHeld(cs_main);
+    // Only the embargoes which ended since the last check are looked at. They are fluffed
+    // in one batch, in the order they ended.
+    std::vector<uint256> vExpired = dandelionEmbargoes.PopExpired(GetTimeMicros());
+    std::vector<CTransactionRef> vFluff;
+    for (const uint256& hash : vExpired) {
+        // If we got the embargoed transaction back, there is nothing left to do.
+        if (mempool.exists(hash))
+            continue;
+        // Embargo time is over, we did not "see" the transaction back in fluff phase,
+        // so start fluffing/relaying it.
+        CTransactionRef ptx = txpools.getStemTxPool().get(hash);
+        // If txn was not found in Stempool, then something went wrong.
+        if (!ptx)
+            continue;
+        CValidationState state;
+        bool fMissingInputs = false;
+        std::list<CTransactionRef> lRemovedTxn;
+        AcceptToMemoryPool(
+            mempool,
+            state,
+            ptx,
+            true, // fLimitFree
+            &fMissingInputs,
+            &lRemovedTxn,
+            false, /* fOverrideMempoolLimit */
+            0, /* nAbsurdFee */
+            false /*isCheckWalletTransaction*/
+            );
+        vFluff.push_back(ptx);
     }
+    if (vFluff.empty())
+        return;
+
+    LogPrintf("AcceptToMemoryPool: accepted %u embargoed txn (poolsz %u txn, %u kB)\n",
+              vFluff.size(),
+              mempool.size(),
+              mempool.DynamicMemoryUsage() / 1000);
+    for (const CTransactionRef& ptx : vFluff)
+        g_connman->RelayTransaction(*ptx);
 }
 
 bool CConnman::RemoveAddedNode(const std::string& strNode)
@@ -3656,19 +3682,13 @@ bool CNode::localDandelionDestinationPushInventory(const CInv& inv) {
 }
 
 bool CNode::insertDandelionEmbargo(const uint256& hash, const int64_t& embargo) {
-    auto pair = mDandelionEmbargo.insert(std::make_pair(hash, embargo));
-    return pair.second;
+    return dandelionEmbargoes.Insert(hash, embargo, GetTimeMicros());
 }
 
 bool CNode::isTxDandelionEmbargoed(const uint256& hash) {
-    return mDandelionEmbargo.find(hash) != mDandelionEmbargo.end();
+    return dandelionEmbargoes.Contains(hash);
 }
 
 bool CNode::removeDandelionEmbargo(const uint256& hash) {
-    auto iter = mDandelionEmbargo.find(hash);
-    if (iter != mDandelionEmbargo.end()) {
-        mDandelionEmbargo.erase(iter);
-        return true;
-    }
-    return false;
+    return dandelionEmbargoes.Remove(hash);
 }
@@ -11,6 +11,7 @@
 #include "amount.h"
 #include "bloom.h"
 #include "compat.h"
+#include "dandelion.h"
 #include "hash.h"
 #include "limitedmap.h"
 #include "netaddress.h"
@@ -882,6 +883,8 @@ public:
     static std::vector<CNode*> vDandelionDestination;
     static CNode* localDandelionDestination;
     static std::map<CNode*, CNode*> mDandelionRoutes;
+    static CDandelionShuffleStats dandelionShuffleStats;
+    static CCriticalSection cs_dandelionShuffleStats;
 
     // Dandelion helper functions.
     static CNode* SelectFromDandelionDestinations();
@@ -1012,8 +1015,8 @@ public:
     // in case of no limit, it will always response 0
     static uint64_t GetMaxOutboundTimeLeftInCycle();
 
-    // Public Dandelion field.
-    static std::map<uint256, int64_t> mDandelionEmbargo;
+    // Public Dandelion field, guarded by cs_main.
+    static CDandelionEmbargoWheel dandelionEmbargoes;
 
     // Dandelion methods, they all must be static, as they do not belong to any CNode, they belong
 		// to the currently running node.
@@ -1026,6 +1029,7 @@ public:
     static bool isTxDandelionEmbargoed(const uint256& hash);
     static bool removeDandelionEmbargo(const uint256& hash);
     static void CheckDandelionEmbargoes();
+    static CDandelionShuffleStats GetDandelionShuffleStats();
     static void RelayDandelionTransaction(const CTransaction& tx, CNode* pfrom);
 
     std::string GetAddrName() const;
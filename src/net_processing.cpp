@@ -8,6 +8,8 @@
 #include "addrman.h"
 #include "arith_uint256.h"
 #include "blockencodings.h"
+#include "blockfilter.h"
+#include "blockfilterindex.h"
 #include "chainparams.h"
 #include "consensus/validation.h"
 #include "hash.h"
@@ -45,6 +47,8 @@
 #include "llmq/quorums_signing.h"
 #include "llmq/quorums_signing_shares.h"
 
+#include <limits>
+
 #include <boost/thread.hpp>
 
 #if defined(NDEBUG)
@@ -137,6 +141,52 @@ namespace {
     MapRelay mapRelay;
     /** Expiration-time ordered list of (expire time, relay map entry) pairs, protected by cs_main). */
     std::deque<std::pair<int64_t, MapRelay::iterator>> vRelayExpiration;
+
+    /**
+     * Serialized blocks recently served to peers, most recently used first.
+     * Syncing peers tend to request the same blocks, so keeping their raw bytes
+     * around saves a disk read per request. Has its own lock so that it can be
+     * used while cs_main is not held.
+     */
+    class CRawBlockCache
+    {
+    public:
+        typedef std::shared_ptr<const std::vector<unsigned char>> RawBlockRef;
+
+        RawBlockRef Get(const uint256& hash)
+        {
+            LOCK(cs);
+            auto mi = mapBlocks.find(hash);
+            if (mi == mapBlocks.end())
+                return nullptr;
+            lruBlocks.splice(lruBlocks.begin(), lruBlocks, mi->second);
+            return mi->second->second;
+        }
+
+        void Put(const uint256& hash, const RawBlockRef& block)
+        {
+            static const size_t nMaxSize = (size_t)std::max((int64_t)0, GetArg("-maxrawblockcache", DEFAULT_MAX_RAW_BLOCK_CACHE)) << 20;
+
+            LOCK(cs);
+            if (block->size() > nMaxSize || mapBlocks.count(hash))
+                return;
+            lruBlocks.emplace_front(hash, block);
+            mapBlocks.emplace(hash, lruBlocks.begin());
+            nSize += block->size();
+            while (nSize > nMaxSize) {
+                nSize -= lruBlocks.back().second->size();
+                mapBlocks.erase(lruBlocks.back().first);
+                lruBlocks.pop_back();
+            }
+        }
+
+    private:
+        CCriticalSection cs;
+        std::list<std::pair<uint256, RawBlockRef>> lruBlocks;
+        std::map<uint256, std::list<std::pair<uint256, RawBlockRef>>::iterator> mapBlocks;
+        size_t nSize = 0;
+    };
+    CRawBlockCache rawBlockCache;
 } // anon namespace
 
 //////////////////////////////////////////////////////////////////////////////
@@ -469,25 +519,6 @@ bool PeerHasHeader(CNodeState *state, const CBlockIndex *pindex)
     return false;
 }
 
-/** Find the last common ancestor two blocks have.
- *  Both pa and pb must be non-NULL. */
-const CBlockIndex* LastCommonAncestor(const CBlockIndex* pa, const CBlockIndex* pb) {
-    if (pa->nHeight > pb->nHeight) {
-        pa = pa->GetAncestor(pb->nHeight);
-    } else if (pb->nHeight > pa->nHeight) {
-        pb = pb->GetAncestor(pa->nHeight);
-    }
-
-    while (pa != pb && pa && pb) {
-        pa = pa->pprev;
-        pb = pb->pprev;
-    }
-
-    // Eventually all chain branches meet at the genesis block.
-    assert(pa == pb);
-    return pa;
-}
-
 /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
  *  at most count entries. */
 void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller, const Consensus::Params& consensusParams) {
@@ -1088,53 +1119,82 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
                 // it's available before trying to send.
                 if (send && (mi->second->nStatus & BLOCK_HAVE_DATA))
                 {
-                    // Send block from disk
-                    CBlock block;
-                    if (!ReadBlockFromDisk(block, (*mi).second, consensusParams))
-                        assert(!"cannot load block from disk");
-                    if (inv.type == MSG_BLOCK)
-                        connman.PushMessage(pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::BLOCK, block));
-                    else if (inv.type == MSG_WITNESS_BLOCK)
-                        connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCK, block));
-                    else if (inv.type == MSG_FILTERED_BLOCK)
-                    {
-                        bool sendMerkleBlock = false;
-                        CMerkleBlock merkleBlock;
+                    // Blocks on disk are stored in network format, so unless the peer wants witness data stripped
+                    // from a block that may carry it we can send the stored bytes without deserializing them.
+                    if (inv.type == MSG_WITNESS_BLOCK || (inv.type == MSG_BLOCK && !IsWitnessEnabled(mi->second->pprev, consensusParams))) {
+                        CRawBlockCache::RawBlockRef rawBlock = rawBlockCache.Get(inv.hash);
+                        if (!rawBlock) {
+                            const CDiskBlockPos pos = mi->second->GetBlockPos();
+                            std::shared_ptr<std::vector<unsigned char>> blockData = std::make_shared<std::vector<unsigned char>>();
+                            bool fRead;
+                            // Block files are append-only, don't hold cs_main for the disk read
+                            LEAVE_CRITICAL_SECTION(cs_main);
+                            fRead = ReadRawBlockFromDisk(*blockData, pos, Params().MessageStart());
+                            ENTER_CRITICAL_SECTION(cs_main);
+                            if (fRead) {
+                                rawBlock = blockData;
+                                rawBlockCache.Put(inv.hash, rawBlock);
+                            }
+                        }
+                        if (rawBlock) {
+                            CSerializedNetMsg msg;
+                            msg.command = NetMsgType::BLOCK;
+                            msg.data = *rawBlock;
+                            connman.PushMessage(pfrom, std::move(msg));
+                        } else {
+                            // The block file may have been pruned while cs_main was released
+                            LogPrint("net", "%s: failed to read block %s for peer=%d\n", __func__, inv.hash.ToString(), pfrom->GetId());
+                            vNotFound.push_back(inv);
+                        }
+                    } else {
+                        // Send block from disk
+                        CBlock block;
+                        if (!ReadBlockFromDisk(block, (*mi).second, consensusParams))
+                            assert(!"cannot load block from disk");
+                        if (inv.type == MSG_BLOCK)
+                            connman.PushMessage(pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::BLOCK, block));
+                        else if (inv.type == MSG_WITNESS_BLOCK)
+                            connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCK, block));
+                        else if (inv.type == MSG_FILTERED_BLOCK)
                         {
-                            LOCK(pfrom->cs_filter);
-                            if (pfrom->pfilter) {
-                                sendMerkleBlock = true;
-                                merkleBlock = CMerkleBlock(block, *pfrom->pfilter);
+                            bool sendMerkleBlock = false;
+                            CMerkleBlock merkleBlock;
+                            {
+                                LOCK(pfrom->cs_filter);
+                                if (pfrom->pfilter) {
+                                    sendMerkleBlock = true;
+                                    merkleBlock = CMerkleBlock(block, *pfrom->pfilter);
+                                }
+                            }
+                            if (sendMerkleBlock) {
+                                connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::MERKLEBLOCK, merkleBlock));
+                                // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
+                                // This avoids hurting performance by pointlessly requiring a round-trip
+                                // Note that there is currently no way for a node to request any single transactions we didn't send here -
+                                // they must either disconnect and retry or request the full block.
+                                // Thus, the protocol spec specified allows for us to provide duplicate txn here,
+                                // however we MUST always provide at least what the remote peer needs
+                                typedef std::pair<unsigned int, uint256> PairType;
+                                BOOST_FOREACH(PairType& pair, merkleBlock.vMatchedTxn)
+                                    connman.PushMessage(pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::TX, *block.vtx[pair.first]));
                             }
+                            // else
+                                // no response
                         }
-                        if (sendMerkleBlock) {
-                            connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::MERKLEBLOCK, merkleBlock));
-                            // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
-                            // This avoids hurting performance by pointlessly requiring a round-trip
-                            // Note that there is currently no way for a node to request any single transactions we didn't send here -
-                            // they must either disconnect and retry or request the full block.
-                            // Thus, the protocol spec specified allows for us to provide duplicate txn here,
-                            // however we MUST always provide at least what the remote peer needs
-                            typedef std::pair<unsigned int, uint256> PairType;
-                            BOOST_FOREACH(PairType& pair, merkleBlock.vMatchedTxn)
-                                connman.PushMessage(pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS, NetMsgType::TX, *block.vtx[pair.first]));
+                        else if (inv.type == MSG_CMPCT_BLOCK)
+                        {
+                            // If a peer is asking for old blocks, we're almost guaranteed
+                            // they won't have a useful mempool to match against a compact block,
+                            // and we don't feel like constructing the object for them, so
+                            // instead we respond with the full, non-compact block.
+                            bool fPeerWantsWitness = State(pfrom->GetId())->fWantsCmpctWitness;
+                            int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
+                            if (CanDirectFetch(consensusParams) && mi->second->nHeight >= chainActive.Height() - MAX_CMPCTBLOCK_DEPTH) {
+                                CBlockHeaderAndShortTxIDs cmpctblock(block, fPeerWantsWitness);
+                                connman.PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
+                            } else
+                                connman.PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCK, block));
                         }
-                        // else
-                            // no response
-                    }
-                    else if (inv.type == MSG_CMPCT_BLOCK)
-                    {
-                        // If a peer is asking for old blocks, we're almost guaranteed
-                        // they won't have a useful mempool to match against a compact block,
-                        // and we don't feel like constructing the object for them, so
-                        // instead we respond with the full, non-compact block.
-                        bool fPeerWantsWitness = State(pfrom->GetId())->fWantsCmpctWitness;
-                        int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-                        if (CanDirectFetch(consensusParams) && mi->second->nHeight >= chainActive.Height() - MAX_CMPCTBLOCK_DEPTH) {
-                            CBlockHeaderAndShortTxIDs cmpctblock(block, fPeerWantsWitness);
-                            connman.PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
-                        } else
-                            connman.PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCK, block));
                     }
 
                     // Trigger the peer node to send a getblocks request for the next batch of inventory
@@ -1312,6 +1372,55 @@ inline void static SendBlockTransactions(const CBlock& block, const BlockTransac
     connman.PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCKTXN, resp));
 }
 
+/**
+ * Check a request for the filters of the blocks from nStartHeight up to hashStop
+ * ("getcfilters", "getcfheaders" and "getcfcheckpt"), the peer is disconnected
+ * when it is invalid or the filters aren't served.
+ */
+bool static PrepareBlockFilterRequest(CNode* pfrom, uint8_t nFilterType, uint32_t nStartHeight, const uint256& hashStop,
+                                      uint32_t nMaxHeightDiff, const CBlockIndex*& pindexStop)
+{
+    if (!(pfrom->GetLocalServices() & NODE_COMPACT_FILTERS)) {
+        LogPrint("net", "peer %d requested compact filters, which aren't served, disconnect\n", pfrom->id);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+
+    if (static_cast<BlockFilterType>(nFilterType) != BlockFilterType::BASIC_FILTER) {
+        LogPrint("net", "peer %d requested unsupported block filter type: %d\n", pfrom->id, nFilterType);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+
+    {
+        LOCK(cs_main);
+        BlockMap::const_iterator mi = mapBlockIndex.find(hashStop);
+        // Only the filters of the active chain are served, not to tell which stale blocks the node has seen
+        if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second)) {
+            LogPrint("net", "peer %d requested filters up to a block not in the active chain: %s\n", pfrom->id, hashStop.ToString());
+            pfrom->fDisconnect = true;
+            return false;
+        }
+        pindexStop = mi->second;
+    }
+
+    uint32_t nStopHeight = pindexStop->nHeight;
+    if (nStartHeight > nStopHeight) {
+        LogPrint("net", "peer %d sent invalid getcfilters/getcfheaders with start height %d and stop height %d\n",
+                 pfrom->id, nStartHeight, nStopHeight);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+    if (nStopHeight - nStartHeight >= nMaxHeightDiff) {
+        LogPrint("net", "peer %d requested too many filters or filter headers: %d / %d\n",
+                 pfrom->id, nStopHeight - nStartHeight + 1, nMaxHeightDiff);
+        pfrom->fDisconnect = true;
+        return false;
+    }
+
+    return true;
+}
+
 bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman& connman, const std::atomic<bool>& interruptMsgProc)
 {
     LogPrint("net", "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->id);
@@ -2593,6 +2702,9 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
+        // Lyra2Z hashing is expensive, do it before taking cs_main and on several threads
+        std::vector<uint256> vHashes = GetBlockHeaderHashes(headers);
+
         const CBlockIndex *pindexLast = NULL;
         {
         LOCK(cs_main);
@@ -2610,14 +2722,14 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             nodestate->nUnconnectingHeaders++;
             connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::GETHEADERS, chainActive.GetLocator(pindexBestHeader), uint256()));
             LogPrint("net", "received header %s: missing prev block %s, sending getheaders (%d) to end (peer=%d, nUnconnectingHeaders=%d)\n",
-                    headers[0].GetHash().ToString(),
+                    vHashes[0].ToString(),
                     headers[0].hashPrevBlock.ToString(),
                     pindexBestHeader->nHeight,
                     pfrom->id, nodestate->nUnconnectingHeaders);
             // Set hashLastUnknownBlock for this peer, so that if we
             // eventually get the headers - even from a different peer -
             // we can use this peer to download.
-            UpdateBlockAvailability(pfrom->GetId(), headers.back().GetHash());
+            UpdateBlockAvailability(pfrom->GetId(), vHashes.back());
 
             if (nodestate->nUnconnectingHeaders % MAX_UNCONNECTING_HEADERS == 0) {
                 Misbehaving(pfrom->GetId(), 20);
@@ -2625,18 +2737,16 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
-        uint256 hashLastBlock;
-        for (const CBlockHeader& header : headers) {
-            if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
+        for (size_t i = 1; i < headers.size(); i++) {
+            if (headers[i].hashPrevBlock != vHashes[i - 1]) {
                 Misbehaving(pfrom->GetId(), 20);
                 return error("non-continuous headers sequence");
             }
-            hashLastBlock = header.GetHash();
         }
         }
 
         CValidationState state;
-        if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast)) {
+        if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast, &vHashes)) {
             int nDoS;
             if (state.IsInvalid(nDoS)) {
                 if (nDoS > 0) {
@@ -2946,6 +3056,77 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         }
     }
 
+    else if (strCommand == NetMsgType::GETCFILTERS)
+    {
+        uint8_t nFilterType;
+        uint32_t nStartHeight;
+        uint256 hashStop;
+        vRecv >> nFilterType >> nStartHeight >> hashStop;
+
+        const CBlockIndex* pindexStop;
+        if (!PrepareBlockFilterRequest(pfrom, nFilterType, nStartHeight, hashStop, MAX_BLOCKFILTERS_PER_REQUEST, pindexStop))
+            return true;
+
+        std::vector<BlockFilter> filters;
+        if (!LookupBlockFilterRange(nStartHeight, pindexStop, filters)) {
+            LogPrint("net", "failed to find block filters for heights %d to %d, peer=%d\n", nStartHeight, pindexStop->nHeight, pfrom->id);
+            return true;
+        }
+
+        for (const BlockFilter& filter : filters)
+            connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::CFILTER, filter));
+    }
+
+
+    else if (strCommand == NetMsgType::GETCFHEADERS)
+    {
+        uint8_t nFilterType;
+        uint32_t nStartHeight;
+        uint256 hashStop;
+        vRecv >> nFilterType >> nStartHeight >> hashStop;
+
+        const CBlockIndex* pindexStop;
+        if (!PrepareBlockFilterRequest(pfrom, nFilterType, nStartHeight, hashStop, MAX_BLOCKFILTER_HEADERS_PER_REQUEST, pindexStop))
+            return true;
+
+        uint256 prevHeader;
+        if (nStartHeight > 0 && !LookupBlockFilterHeader(pindexStop->GetAncestor(nStartHeight - 1), prevHeader)) {
+            LogPrint("net", "failed to find block filter header at height %d, peer=%d\n", nStartHeight - 1, pfrom->id);
+            return true;
+        }
+
+        std::vector<uint256> filterHashes;
+        if (!LookupBlockFilterHashRange(nStartHeight, pindexStop, filterHashes)) {
+            LogPrint("net", "failed to find block filter hashes for heights %d to %d, peer=%d\n", nStartHeight, pindexStop->nHeight, pfrom->id);
+            return true;
+        }
+
+        connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::CFHEADERS, nFilterType, pindexStop->GetBlockHash(), prevHeader, filterHashes));
+    }
+
+
+    else if (strCommand == NetMsgType::GETCFCHECKPT)
+    {
+        uint8_t nFilterType;
+        uint256 hashStop;
+        vRecv >> nFilterType >> hashStop;
+
+        const CBlockIndex* pindexStop;
+        if (!PrepareBlockFilterRequest(pfrom, nFilterType, 0, hashStop, std::numeric_limits<uint32_t>::max(), pindexStop))
+            return true;
+
+        std::vector<uint256> headers(pindexStop->nHeight / BLOCKFILTER_CHECKPOINT_INTERVAL);
+        for (size_t i = 0; i < headers.size(); i++) {
+            const CBlockIndex* pindex = pindexStop->GetAncestor((i + 1) * BLOCKFILTER_CHECKPOINT_INTERVAL);
+            if (!LookupBlockFilterHeader(pindex, headers[i])) {
+                LogPrint("net", "failed to find block filter header at height %d, peer=%d\n", pindex->nHeight, pfrom->id);
+                return true;
+            }
+        }
+
+        connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::CFCHECKPT, nFilterType, pindexStop->GetBlockHash(), headers));
+    }
+
     else if (strCommand == NetMsgType::GETMNLISTDIFF) {
         CGetSimplifiedMNListDiff cmd;
         vRecv >> cmd;
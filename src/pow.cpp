@@ -18,6 +18,7 @@
 #include "utilstrencodings.h"
 #include "crypto/MerkleTreeProof/mtp.h"
 #include "mtpstate.h"
+#include "metrics.h"
 #include "fixed.h"
 #include <math.h>
 
@@ -92,6 +93,9 @@ unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHead
     return DarkGravityWave(pindexLast, pblock, params);
 }
 
+static CMetricHistogram metricMtpVerify("tecracoin_mtp_verify_seconds", "Time spent verifying the MTP proofs of blocks");
+static CMetricCounter metricMtpVerifyFailed("tecracoin_mtp_verify_failures_total", "MTP proofs of blocks found invalid");
+
 // TecraCoin - MTP
 bool CheckMerkleTreeProof(const CBlockHeader &block, const Consensus::Params &params) {
     if (!block.IsMTP())
@@ -101,11 +105,15 @@ bool CheckMerkleTreeProof(const CBlockHeader &block, const Consensus::Params &pa
         return false;
 
     uint256 calculatedMtpHashValue;
+    int64_t nTimeStart = GetTimeMicros();
     bool isVerified = mtp::verify(block.nNonce, block, Params().GetConsensus().powLimit, &calculatedMtpHashValue) &&
                       block.mtpHashValue == calculatedMtpHashValue;
+    metricMtpVerify.Observe(GetTimeMicros() - nTimeStart);
 
-    if(!isVerified)
+    if(!isVerified) {
+        metricMtpVerifyFailed.Inc();
         return false;
+    }
 
     return true;
 }
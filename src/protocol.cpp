@@ -58,6 +58,12 @@ namespace NetMsgType {
     const char *CLSIG="clsig";
     const char *ISLOCK="islock";
     const char *MNAUTH="mnauth";
+    const char *GETCFILTERS="getcfilters";
+    const char *CFILTER="cfilter";
+    const char *GETCFHEADERS="getcfheaders";
+    const char *CFHEADERS="cfheaders";
+    const char *GETCFCHECKPT="getcfcheckpt";
+    const char *CFCHECKPT="cfcheckpt";
 };
 
 /** All known message types. Keep this in the same order as the list of
@@ -110,6 +116,12 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::CLSIG,
     NetMsgType::ISLOCK,
     NetMsgType::MNAUTH,
+    NetMsgType::GETCFILTERS,
+    NetMsgType::CFILTER,
+    NetMsgType::GETCFHEADERS,
+    NetMsgType::CFHEADERS,
+    NetMsgType::GETCFCHECKPT,
+    NetMsgType::CFCHECKPT,
 };
 const static std::vector<std::string> allNetMessageTypesVec(allNetMessageTypes, allNetMessageTypes+ARRAYLEN(allNetMessageTypes));
 
@@ -265,6 +265,36 @@ extern const char *QSIGREC;
 extern const char *CLSIG;
 extern const char *ISLOCK;
 extern const char *MNAUTH;
+/**
+ * Contains a filter type, a start height and a stop hash.
+ * Peer should respond with a "cfilter" message for each block from the start
+ * height to the stop hash, as described by BIP 157.
+ */
+extern const char *GETCFILTERS;
+/**
+ * Contains a BlockFilter, sent in response to a "getcfilters" message.
+ */
+extern const char *CFILTER;
+/**
+ * Contains a filter type, a start height and a stop hash.
+ * Peer should respond with a "cfheaders" message.
+ */
+extern const char *GETCFHEADERS;
+/**
+ * Contains a filter type, the stop hash, the filter header preceding the range
+ * and the filter hashes of the range. Sent in response to a "getcfheaders" message.
+ */
+extern const char *CFHEADERS;
+/**
+ * Contains a filter type and a stop hash.
+ * Peer should respond with a "cfcheckpt" message.
+ */
+extern const char *GETCFCHECKPT;
+/**
+ * Contains a filter type, the stop hash and the filter headers at every
+ * 1000th block up to it. Sent in response to a "getcfcheckpt" message.
+ */
+extern const char *CFCHECKPT;
 };
 
 /* Get a vector of all valid message types (see above) */
@@ -292,6 +322,9 @@ enum ServiceFlags : uint64_t {
     // NODE_XTHIN means the node supports Xtreme Thinblocks
     // If this is turned off then the node will not service nor make xthin requests
     NODE_XTHIN = (1 << 4),
+    // NODE_COMPACT_FILTERS means the node will service basic block filter requests.
+    // See BIP157 and BIP158 for details on how this is implemented.
+    NODE_COMPACT_FILTERS = (1 << 6),
 
     // Bits 24-31 are reserved for temporary experiments. Just pick a bit that
     // isn't getting used, or one not being used much, and notify the
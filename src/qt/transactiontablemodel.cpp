@@ -26,6 +26,9 @@
 #include <QIcon>
 #include <QList>
 
+#include <atomic>
+#include <deque>
+
 #include <boost/foreach.hpp>
 
 // Amount column is right-aligned it contains numbers
@@ -55,39 +58,182 @@ struct TxLessThan
     }
 };
 
+/* Decomposes the wallet transactions into records in a background thread, so that the
+   GUI stays responsive while a large wallet is loaded.
+
+   The wallet is walked in hash order, a batch of transactions at a time, taking the
+   locks only for the duration of a batch. Every batch is queued for the model while the
+   wallet lock is still held, so it arrives in the GUI thread in the right order relative
+   to the notifications of transactions changing later.
+*/
+class TransactionTableLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TransactionTableLoader(CWallet *_wallet) :
+        wallet(_wallet),
+        fInterrupted(false)
+    {
+    }
+
+    void interrupt()
+    {
+        fInterrupted = true;
+    }
+
+    bool takeBatch(QList<TransactionRecord> &batch)
+    {
+        LOCK(cs_batches);
+        if(batches.empty())
+            return false;
+        batch.swap(batches.front());
+        batches.pop_front();
+        return true;
+    }
+
+public Q_SLOTS:
+    void load()
+    {
+        qDebug() << "TransactionTableLoader::load";
+        bool fFirst = true;
+        uint256 hashLast;
+        while(!fInterrupted)
+        {
+            LOCK2(cs_main, wallet->cs_wallet);
+            std::map<uint256, CWalletTx>::iterator it = fFirst ? wallet->mapWallet.begin() : wallet->mapWallet.upper_bound(hashLast);
+            QList<TransactionRecord> batch;
+            for(int n = 0; n < LOAD_BATCH_SIZE && it != wallet->mapWallet.end(); ++n, ++it)
+            {
+                if(TransactionRecord::showTransaction(it->second))
+                    batch.append(TransactionRecord::decomposeTransaction(wallet, it->second));
+                hashLast = it->first;
+            }
+            fFirst = false;
+
+            if(!batch.isEmpty())
+            {
+                {
+                    LOCK(cs_batches);
+                    batches.push_back(batch);
+                }
+                Q_EMIT batchLoaded();
+            }
+            if(it == wallet->mapWallet.end())
+                break;
+        }
+        qDebug() << "TransactionTableLoader::load finished";
+    }
+
+Q_SIGNALS:
+    void batchLoaded();
+
+private:
+    /* Wallet transactions decomposed while holding the locks once */
+    static const int LOAD_BATCH_SIZE = 1000;
+
+    CWallet *wallet;
+    std::atomic<bool> fInterrupted;
+    CCriticalSection cs_batches;
+    std::deque<QList<TransactionRecord> > batches;
+};
+
 // Private implementation
 class TransactionTablePriv
 {
 public:
     TransactionTablePriv(CWallet *_wallet, TransactionTableModel *_parent) :
         wallet(_wallet),
-        parent(_parent)
+        parent(_parent),
+        pindexLastTip(0)
     {
     }
 
     CWallet *wallet;
     TransactionTableModel *parent;
 
+    /* Tip of the chain when the confirmations were last refreshed */
+    const CBlockIndex *pindexLastTip;
+
     /* Local cache of wallet.
      * As it is in the same order as the CWallet, by definition
      * this is sorted by sha256.
      */
     QList<TransactionRecord> cachedWallet;
 
-    /* Query entire wallet anew from core.
+    /* Merge a batch of records decomposed by the loader. The batch is sorted by hash and
+     * normally lies after everything in the model; only transactions notified while
+     * loading can be in between, those are skipped as they are already in the model.
      */
-    void refreshWallet()
+    void insertLoaded(const QList<TransactionRecord> &batch)
     {
-        qDebug() << "TransactionTablePriv::refreshWallet";
-        cachedWallet.clear();
+        QList<TransactionRecord>::iterator lower = qLowerBound(
+            cachedWallet.begin(), cachedWallet.end(), batch.front().hash, TxLessThan());
+        QList<TransactionRecord>::iterator upper = qUpperBound(
+            cachedWallet.begin(), cachedWallet.end(), batch.back().hash, TxLessThan());
+        if(lower == upper)
         {
-            LOCK2(cs_main, wallet->cs_wallet);
-            for(std::map<uint256, CWalletTx>::iterator it = wallet->mapWallet.begin(); it != wallet->mapWallet.end(); ++it)
+            insertRecords(lower - cachedWallet.begin(), batch);
+            return;
+        }
+
+        for(int i = 0; i < batch.size(); )
+        {
+            int j = i + 1;
+            while(j < batch.size() && batch[j].hash == batch[i].hash)
+                j++;
+            lower = qLowerBound(cachedWallet.begin(), cachedWallet.end(), batch[i].hash, TxLessThan());
+            if(lower == cachedWallet.end() || lower->hash != batch[i].hash)
+                insertRecords(lower - cachedWallet.begin(), batch.mid(i, j - i));
+            i = j;
+        }
+    }
+
+    void insertRecords(int idx, const QList<TransactionRecord> &toInsert)
+    {
+        if(toInsert.isEmpty())
+            return;
+        parent->beginInsertRows(QModelIndex(), idx, idx+toInsert.size()-1);
+        if(idx == cachedWallet.size())
+        {
+            cachedWallet.append(toInsert);
+        }
+        else
+        {
+            Q_FOREACH(const TransactionRecord &rec, toInsert)
             {
-                if(TransactionRecord::showTransaction(it->second))
-                    cachedWallet.append(TransactionRecord::decomposeTransaction(wallet, it->second));
+                cachedWallet.insert(idx, rec);
+                idx += 1;
             }
         }
+        parent->endInsertRows();
+    }
+
+    /* Ranges of rows whose status can still change with the new tip. Confirmed
+     * transactions keep their status unless the block they are in was reorganized
+     * away, so they are only refreshed when the chain forked below them since the
+     * last refresh.
+     */
+    QList<QPair<int, int> > unsettledRanges()
+    {
+        AssertLockHeld(cs_main);
+        const CBlockIndex *pindexFork = pindexLastTip ? chainActive.FindFork(pindexLastTip) : 0;
+        const int nForkHeight = pindexFork ? pindexFork->nHeight : -1;
+        pindexLastTip = chainActive.Tip();
+
+        QList<QPair<int, int> > ranges;
+        for(int i = 0; i < cachedWallet.size(); i++)
+        {
+            const TransactionStatus &status = cachedWallet[i].status;
+            // Height of the block the transaction was in at its last refresh
+            if(status.status == TransactionStatus::Confirmed && status.cur_num_blocks - status.depth + 1 <= nForkHeight)
+                continue;
+            if(!ranges.isEmpty() && ranges.back().second == i - 1)
+                ranges.back().second = i;
+            else
+                ranges.append(qMakePair(i, i));
+        }
+        return ranges;
     }
 
     /* Update our model of the wallet incrementally, to synchronize our model of the wallet
@@ -139,19 +285,7 @@ public:
                     break;
                 }
                 // Added -- insert at the right position
-                QList<TransactionRecord> toInsert =
-                        TransactionRecord::decomposeTransaction(wallet, mi->second);
-                if(!toInsert.isEmpty()) /* only if something to insert */
-                {
-                    parent->beginInsertRows(QModelIndex(), lowerIndex, lowerIndex+toInsert.size()-1);
-                    int insert_idx = lowerIndex;
-                    Q_FOREACH(const TransactionRecord &rec, toInsert)
-                    {
-                        cachedWallet.insert(insert_idx, rec);
-                        insert_idx += 1;
-                    }
-                    parent->endInsertRows();
-                }
+                insertRecords(lowerIndex, TransactionRecord::decomposeTransaction(wallet, mi->second));
             }
             break;
         case CT_DELETED:
@@ -244,19 +378,41 @@ TransactionTableModel::TransactionTableModel(const PlatformStyle *_platformStyle
         platformStyle(_platformStyle)
 {
     columns << QString() << QString() << tr("Date") << tr("Type") << tr("Label") << BitcoinUnits::getAmountColumnTitle(walletModel->getOptionsModel()->getDisplayUnit());
-    priv->refreshWallet();
 
     connect(walletModel->getOptionsModel(), SIGNAL(displayUnitChanged(int)), this, SLOT(updateDisplayUnit()));
 
+    // Subscribe before loading, transactions changing meanwhile are merged with the loaded ones
     subscribeToCoreSignals();
+    startLoader();
 }
 
 TransactionTableModel::~TransactionTableModel()
 {
     unsubscribeFromCoreSignals();
+    loader->interrupt();
+    loaderThread.quit();
+    loaderThread.wait();
+    delete loader;
     delete priv;
 }
 
+void TransactionTableModel::startLoader()
+{
+    loader = new TransactionTableLoader(wallet);
+    loader->moveToThread(&loaderThread);
+    connect(&loaderThread, SIGNAL(started()), loader, SLOT(load()));
+    connect(loader, SIGNAL(batchLoaded()), this, SLOT(processLoadedTransactions()));
+    loaderThread.start();
+}
+
+void TransactionTableModel::processLoadedTransactions()
+{
+    // One batch per signal, keeping the order relative to updateTransaction
+    QList<TransactionRecord> batch;
+    if(loader->takeBatch(batch))
+        priv->insertLoaded(batch);
+}
+
 /** Updates the column title to "Amount (DisplayUnit)" and emits headerDataChanged() signal for table headers to react. */
 void TransactionTableModel::updateAmountColumnTitle()
 {
@@ -276,10 +432,16 @@ void TransactionTableModel::updateConfirmations()
 {
     // Blocks came in since last poll.
     // Invalidate status (number of confirmations) and (possibly) description
-    //  for all rows. Qt is smart enough to only actually request the data for the
-    //  visible rows.
-    Q_EMIT dataChanged(index(0, Status), index(priv->size()-1, Status));
-    Q_EMIT dataChanged(index(0, ToAddress), index(priv->size()-1, ToAddress));
+    //  for the rows that are not confirmed yet or were confirmed in blocks that
+    //  may have been reorganized away. Invalidating all rows would make the
+    //  filter proxy re-check every transaction of the wallet on each block.
+    //  Qt is smart enough to only actually request the data for the visible rows.
+    typedef QPair<int, int> RowRange;
+    Q_FOREACH(const RowRange &range, priv->unsettledRanges())
+    {
+        Q_EMIT dataChanged(index(range.first, Status), index(range.second, Status));
+        Q_EMIT dataChanged(index(range.first, ToAddress), index(range.second, ToAddress));
+    }
 }
 
 int TransactionTableModel::rowCount(const QModelIndex &parent) const
@@ -713,7 +875,7 @@ QModelIndex TransactionTableModel::index(int row, int column, const QModelIndex
     TransactionRecord *data = priv->index(row);
     if(data)
     {
-        return createIndex(row, column, priv->index(row));
+        return createIndex(row, column, data);
     }
     return QModelIndex();
 }
@@ -803,3 +965,5 @@ void TransactionTableModel::unsubscribeFromCoreSignals()
     wallet->NotifyTransactionChanged.disconnect(boost::bind(NotifyTransactionChanged, this, _1, _2, _3));
     wallet->ShowProgress.disconnect(boost::bind(ShowProgress, this, _1, _2));
 }
+
+#include "transactiontablemodel.moc"
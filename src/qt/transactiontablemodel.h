@@ -9,9 +9,11 @@
 
 #include <QAbstractTableModel>
 #include <QStringList>
+#include <QThread>
 
 class PlatformStyle;
 class TransactionRecord;
+class TransactionTableLoader;
 class TransactionTablePriv;
 class WalletModel;
 
@@ -88,7 +90,10 @@ private:
     TransactionTablePriv *priv;
     bool fProcessingQueuedTransactions;
     const PlatformStyle *platformStyle;
+    QThread loaderThread;
+    TransactionTableLoader *loader;
 
+    void startLoader();
     void subscribeToCoreSignals();
     void unsubscribeFromCoreSignals();
 
@@ -107,6 +112,9 @@ private:
 public Q_SLOTS:
     /* New transaction, or transaction changed status */
     void updateTransaction(const QString &hash, int status, bool showTransaction);
+    /* Merge the next batch of transactions decomposed by the loader thread */
+    void processLoadedTransactions();
+    /* Blocks came in, requires cs_main */
     void updateConfirmations();
     void updateDisplayUnit();
     /** Updates the column title to "Amount (DisplayUnit)" and emits headerDataChanged() signal for table headers to react. */
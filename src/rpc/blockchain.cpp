@@ -4,8 +4,11 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "amount.h"
+#include "blockfilter.h"
+#include "blockfilterindex.h"
 #include "chain.h"
 #include "chainparams.h"
+#include "chainsnapshot.h"
 #include "checkpoints.h"
 #include "coins.h"
 #include "core_io.h"
@@ -14,11 +17,13 @@
 #include "policy/policy.h"
 #include "primitives/transaction.h"
 #include "rpc/server.h"
+#include "spendcache.h"
 #include "streams.h"
 #include "sync.h"
 #include "txmempool.h"
 #include "util.h"
 #include "utilstrencodings.h"
+#include "utxostats.h"
 #include "hash.h"
 
 #include "evo/specialtx.h"
@@ -767,6 +772,57 @@ UniValue getblockheader(const JSONRPCRequest& request)
     return blockheaderToJSON(pblockindex);
 }
 
+UniValue getblockfilter(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw runtime_error(
+            "getblockfilter \"blockhash\" ( \"filtertype\" )\n"
+            "\nRetrieve a BIP 157 content filter for a particular block.\n"
+            "\nArguments:\n"
+            "1. \"blockhash\"     (string, required) The hash of the block\n"
+            "2. \"filtertype\"    (string, optional, default=basic) The type name of the filter\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"filter\" : \"xxxx\",  (string) the hex-encoded filter data\n"
+            "  \"header\" : \"xxxx\",  (string) the hex-encoded filter header\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\" \"basic\"")
+            + HelpExampleRpc("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\", \"basic\"")
+        );
+
+    uint256 hash(uint256S(request.params[0].get_str()));
+    std::string strFilterType = "basic";
+    if (request.params.size() > 1)
+        strFilterType = request.params[1].get_str();
+
+    BlockFilterType filterType;
+    if (!BlockFilterTypeByName(strFilterType, filterType))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown filtertype");
+
+    if (!fBlockFilterIndex)
+        throw JSONRPCError(RPC_MISC_ERROR, "Index is not enabled for filtertype " + strFilterType);
+
+    const CBlockIndex* pblockindex;
+    {
+        LOCK(cs_main);
+        BlockMap::const_iterator it = mapBlockIndex.find(hash);
+        if (it == mapBlockIndex.end())
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        pblockindex = it->second;
+    }
+
+    BlockFilter filter;
+    uint256 header;
+    if (!LookupBlockFilter(pblockindex, filter) || !LookupBlockFilterHeader(pblockindex, header))
+        throw JSONRPCError(RPC_MISC_ERROR, "Filter not found, the index may still be building");
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("filter", HexStr(filter.GetEncodedFilter())));
+    ret.push_back(Pair("header", header.GetHex()));
+    return ret;
+}
+
 UniValue getblock(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
@@ -966,43 +1022,133 @@ UniValue pruneblockchain(const JSONRPCRequest& request)
     return uint64_t(height);
 }
 
+UniValue dumpchainstate(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw runtime_error(
+            "dumpchainstate \"path\"\n"
+            "\nWrite a snapshot of the chain state at the tip, which a new node can be started from with -loadchainstate.\n"
+            "It holds the block index of the active chain, the UTXO set, the evo database and the Elysium state.\n"
+            "\nArguments:\n"
+            "1. \"path\"          (string, required) The file to write, relative to the data directory if not absolute\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"path\": \"path\",        (string) The file written\n"
+            "  \"bestblock\": \"hex\",     (string) the hash of the block of the snapshot\n"
+            "  \"height\": n,            (numeric) The height of the block of the snapshot\n"
+            "  \"txouts\": n,            (numeric) The number of unspent transaction outputs\n"
+            "  \"total_amount\": x.xxx,  (numeric) The total amount\n"
+            "  \"muhash\": \"hash\",      (string) The MuHash of the UTXO set, as returned by gettxoutsetinfo \"muhash\"\n"
+            "  \"elysium\": true|false,  (boolean) If the snapshot holds the Elysium state\n"
+            "  \"hash\": \"hash\"         (string) The hash of the snapshot, to pass to -loadchainstatehash\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumpchainstate", "\"chainstate.snapshot\"")
+            + HelpExampleRpc("dumpchainstate", "\"chainstate.snapshot\""));
+
+    boost::filesystem::path path = boost::filesystem::absolute(request.params[0].get_str(), GetDataDir());
+    if (boost::filesystem::exists(path))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, path.string() + " already exists");
+
+    CChainSnapshotInfo info;
+    if (!DumpChainSnapshot(path, info))
+        throw JSONRPCError(RPC_MISC_ERROR, "Unable to write the chain state snapshot");
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("path", path.string()));
+    ret.push_back(Pair("bestblock", info.hashBlock.GetHex()));
+    ret.push_back(Pair("height", info.nHeight));
+    ret.push_back(Pair("txouts", (int64_t)info.nTransactionOutputs));
+    ret.push_back(Pair("total_amount", ValueFromAmount(info.nTotalAmount)));
+    ret.push_back(Pair("muhash", info.hashUTXOSet.GetHex()));
+    ret.push_back(Pair("elysium", info.fElysium));
+    ret.push_back(Pair("hash", info.hashContent.GetHex()));
+    return ret;
+}
+
 UniValue gettxoutsetinfo(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() != 0)
+    if (request.fHelp || request.params.size() > 2)
         throw runtime_error(
-            "gettxoutsetinfo\n"
+            "gettxoutsetinfo ( \"hash_type\" height )\n"
             "\nReturns statistics about the unspent transaction output set.\n"
-            "Note this call may take some time.\n"
+            "With the default hash_type this walks the whole set and may take some time. The \"muhash\" and \"none\"\n"
+            "hash types return the statistics kept up to date with each block (-utxostats) at once.\n"
+            "\nArguments:\n"
+            "1. \"hash_type\"    (string, optional, default=hash_serialized_2) Which UTXO set hash to compute:\n"
+            "                    \"hash_serialized_2\", \"muhash\" or \"none\"\n"
+            "2. height         (numeric, optional) The height of the block to return the statistics of, only with\n"
+            "                    the \"muhash\" and \"none\" hash types, for the tip and the " + strprintf("%d", UTXO_STATS_BLOCKS_TO_KEEP) + " blocks below it\n"
             "\nResult:\n"
             "{\n"
             "  \"height\":n,     (numeric) The current block height (index)\n"
             "  \"bestblock\": \"hex\",   (string) the best block hash hex\n"
-            "  \"transactions\": n,      (numeric) The number of transactions\n"
+            "  \"transactions\": n,      (numeric) The number of transactions, only with hash_serialized_2\n"
             "  \"txouts\": n,            (numeric) The number of output transactions\n"
-            "  \"hash_serialized\": \"hash\",   (string) The serialized hash\n"
-            "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk\n"
+            "  \"bogosize\": n,          (numeric) The size of the set estimated from its outputs, only with muhash and none\n"
+            "  \"hash_serialized_2\": \"hash\",   (string) The serialized hash, only with hash_serialized_2\n"
+            "  \"muhash\": \"hash\",       (string) The MuHash3072 of the set, only with muhash\n"
+            "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk, only with hash_serialized_2\n"
             "  \"total_amount\": x.xxx          (numeric) The total amount\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("gettxoutsetinfo", "")
+            + HelpExampleCli("gettxoutsetinfo", "\"muhash\" 1000")
             + HelpExampleRpc("gettxoutsetinfo", "")
+            + HelpExampleRpc("gettxoutsetinfo", "\"muhash\", 1000")
         );
 
+    std::string strHashType = "hash_serialized_2";
+    if (request.params.size() > 0 && !request.params[0].isNull())
+        strHashType = request.params[0].get_str();
+    if (strHashType != "hash_serialized_2" && strHashType != "muhash" && strHashType != "none")
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown hash type " + strHashType);
+
     UniValue ret(UniValue::VOBJ);
 
-    CCoinsStats stats;
-    FlushStateToDisk();
-    if (GetUTXOStats(pcoinsTip, stats)) {
-        ret.push_back(Pair("height", (int64_t)stats.nHeight));
-        ret.push_back(Pair("bestblock", stats.hashBlock.GetHex()));
-        ret.push_back(Pair("transactions", (int64_t)stats.nTransactions));
-        ret.push_back(Pair("txouts", (int64_t)stats.nTransactionOutputs));
-        ret.push_back(Pair("hash_serialized_2", stats.hashSerialized.GetHex()));
-        ret.push_back(Pair("disk_size", stats.nDiskSize));
-        ret.push_back(Pair("total_amount", ValueFromAmount(stats.nTotalAmount)));
-    } else {
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+    if (strHashType == "hash_serialized_2") {
+        if (request.params.size() > 1 && !request.params[1].isNull())
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "The statistics of other blocks need the muhash or none hash type");
+        CCoinsStats stats;
+        FlushStateToDisk();
+        if (GetUTXOStats(pcoinsTip, stats)) {
+            ret.push_back(Pair("height", (int64_t)stats.nHeight));
+            ret.push_back(Pair("bestblock", stats.hashBlock.GetHex()));
+            ret.push_back(Pair("transactions", (int64_t)stats.nTransactions));
+            ret.push_back(Pair("txouts", (int64_t)stats.nTransactionOutputs));
+            ret.push_back(Pair("hash_serialized_2", stats.hashSerialized.GetHex()));
+            ret.push_back(Pair("disk_size", stats.nDiskSize));
+            ret.push_back(Pair("total_amount", ValueFromAmount(stats.nTotalAmount)));
+        } else {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+        }
+        return ret;
     }
+
+    if (!fUTXOStats)
+        throw JSONRPCError(RPC_MISC_ERROR, "The UTXO set statistics aren't kept, start with -utxostats");
+
+    CUTXOStats stats;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = chainActive.Tip();
+        if (request.params.size() > 1 && !request.params[1].isNull()) {
+            int nHeight = request.params[1].get_int();
+            if (nHeight < 0 || nHeight > chainActive.Height())
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+            pindex = chainActive[nHeight];
+        }
+        if (pindex == NULL || !GetBlockUTXOStats(pindex, stats))
+            throw JSONRPCError(RPC_MISC_ERROR, "No UTXO set statistics for this block, they are kept for the recent blocks once built");
+    }
+
+    ret.push_back(Pair("height", (int64_t)stats.nHeight));
+    ret.push_back(Pair("bestblock", stats.hashBlock.GetHex()));
+    ret.push_back(Pair("txouts", (int64_t)stats.nTransactionOutputs));
+    ret.push_back(Pair("bogosize", (int64_t)stats.nBogoSize));
+    if (strHashType == "muhash")
+        ret.push_back(Pair("muhash", stats.GetMuHash().GetHex()));
+    ret.push_back(Pair("total_amount", ValueFromAmount(stats.nTotalAmount)));
     return ret;
 }
 
@@ -1380,6 +1526,14 @@ UniValue mempoolInfoToJSON()
     ret.push_back(Pair("maxmempool", (int64_t) maxmempool));
     ret.push_back(Pair("mempoolminfee", ValueFromAmount(mempool.GetMinFee(maxmempool).GetFeePerK())));
 
+    CSpendCacheStats spendCacheStats = GetSpendVerificationCacheStats();
+    uint64_t nLookups = spendCacheStats.nHits + spendCacheStats.nMisses;
+    UniValue spendCache(UniValue::VOBJ);
+    spendCache.push_back(Pair("hits", spendCacheStats.nHits));
+    spendCache.push_back(Pair("misses", spendCacheStats.nMisses));
+    spendCache.push_back(Pair("hitrate", nLookups ? (double)spendCacheStats.nHits / nLookups : 0.0));
+    ret.push_back(Pair("spendcache", spendCache));
+
     return ret;
 }
 
@@ -1395,7 +1549,12 @@ UniValue getmempoolinfo(const JSONRPCRequest& request)
             "  \"bytes\": xxxxx,              (numeric) Sum of all virtual transaction sizes as defined in BIP 141. Differs from actual serialized size because witness data is discounted\n"
             "  \"usage\": xxxxx,              (numeric) Total memory usage for the mempool\n"
             "  \"maxmempool\": xxxxx,         (numeric) Maximum memory usage for the mempool\n"
-            "  \"mempoolminfee\": xxxxx       (numeric) Minimum fee for tx to be accepted\n"
+            "  \"mempoolminfee\": xxxxx,      (numeric) Minimum fee for tx to be accepted\n"
+            "  \"spendcache\": {              (json object) Sigma and zerocoin spend verification cache\n"
+            "     \"hits\": xxxxx,             (numeric) Spends found verified in the cache\n"
+            "     \"misses\": xxxxx,           (numeric) Spends not found in the cache\n"
+            "     \"hitrate\": x.xxx           (numeric) Fraction of lookups that were hits\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getmempoolinfo", "")
@@ -1635,6 +1794,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getblockhash",           &getblockhash,           true,  {"height"} },
     { "blockchain",         "getblockhashes",         &getblockhashes,         true,  {"high", "low"} },
     { "blockchain",         "getblockheader",         &getblockheader,         true,  {"blockhash","verbose"} },
+    { "blockchain",         "getblockfilter",         &getblockfilter,         true,  {"blockhash","filtertype"} },
     { "blockchain",         "getchaintips",           &getchaintips,           true,  {} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          true,  {} },
     { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    true,  {"txid","verbose"} },
@@ -1645,8 +1805,9 @@ static const CRPCCommand commands[] =
     { "blockchain",         "clearmempool",           &clearmempool,           true,  {} },
     { "blockchain",         "getspecialtxes",         &getspecialtxes,         true,  {"blockhash", "type", "count", "skip", "verbosity"} },
     { "blockchain",         "gettxout",               &gettxout,               true,  {"txid","n","include_mempool"} },
-    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true,  {} },
+    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true,  {"hash_type","height"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        true,  {"height"} },
+    { "blockchain",         "dumpchainstate",         &dumpchainstate,         true,  {"path"} },
     { "blockchain",         "verifychain",            &verifychain,            true,  {"checklevel","nblocks"} },
 
     { "blockchain",         "preciousblock",          &preciousblock,          true,  {"blockhash"} },
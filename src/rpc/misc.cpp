@@ -5,7 +5,9 @@
 
 #include "base58.h"
 #include "clientversion.h"
+#include "dbwrapper.h"
 #include "init.h"
+#include "metrics.h"
 #include "validation.h"
 #include "net.h"
 #include "netbase.h"
@@ -21,6 +23,7 @@
 #endif
 #include "txdb.h"
 #include "zerocoin.h"
+#include "sigma.h"
 
 #include "masternode-sync.h"
 
@@ -1040,6 +1043,45 @@ UniValue getmintmetadata(const JSONRPCRequest& request)
     return ret;
 }
 
+UniValue getsigmamintoutpoint(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw runtime_error(
+                "getsigmamintoutpoint \"pubcoinhash\"\n"
+                "\nReturns where the sigma mint with the given pubcoin value hash is on the chain.\n"
+                "\nArguments:\n"
+                "1. \"pubcoinhash\"  (string, required) The hash of the pubcoin value\n"
+                "\nResult:\n"
+                "{\n"
+                "  \"txid\"         (string) The mint transaction id\n"
+                "  \"index\"        (number) The mint output index\n"
+                "  \"height\"       (number) The height of the block containing the mint\n"
+                "  \"denomination\" (number) The mint denomination\n"
+                "  \"coinGroupId\"  (number) The id of the anonymity set of the mint\n"
+                "}\n"
+                + HelpExampleCli("getsigmamintoutpoint", "\"b476ed2b374bb081ea51d111f68f0136252521214e213d119b8dc67b92f5a390\"")
+                + HelpExampleRpc("getsigmamintoutpoint", "\"b476ed2b374bb081ea51d111f68f0136252521214e213d119b8dc67b92f5a390\"")
+        );
+
+    uint256 pubCoinValueHash = ParseHashV(request.params[0], "pubcoinhash");
+
+    CSigmaMintIndexValue value;
+    {
+        LOCK(cs_main);
+        if (!sigma::GetSigmaMintIndexValue(pubCoinValueHash, value))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No indexed sigma mint with this pubcoin hash");
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("txid", value.outpoint.hash.GetHex()));
+    ret.push_back(Pair("index", (int)value.outpoint.n));
+    ret.push_back(Pair("height", value.blockHeight));
+    ret.push_back(Pair("denomination", value.denomination));
+    ret.push_back(Pair("coinGroupId", value.coinGroupId));
+
+    return ret;
+}
+
 UniValue getusedcoinserials(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -1447,6 +1489,131 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     return obj;
 }
 
+UniValue getdbstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw runtime_error(
+            "getdbstats\n"
+            "Returns tuning and usage statistics of every open LevelDB database.\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"name\": \"name\",          (string) Database name as used by -dbprofile\n"
+            "    \"path\": \"path\",          (string) Location of the database\n"
+            "    \"profile\": \"profile\",    (string) Tuning profile in use\n"
+            "    \"max_open_files\": xxx,   (numeric) Table files kept open at most\n"
+            "    \"cache\": {\n"
+            "      \"capacity\": xxxxx,     (numeric) Block cache capacity in bytes\n"
+            "      \"usage\": xxxxx,        (numeric) Bytes currently held in the block cache\n"
+            "      \"hits\": xxxxx,         (numeric) Block cache lookups that hit\n"
+            "      \"misses\": xxxxx,       (numeric) Block cache lookups that missed\n"
+            "      \"hitrate\": x.xxx       (numeric) Fraction of lookups that hit\n"
+            "    },\n"
+            "    \"memory\": xxxxx,         (numeric) Approximate memory used by memtables and caches\n"
+            "    \"disksize\": xxxxx,       (numeric) Approximate size of the data on disk in bytes\n"
+            "    \"files_per_level\": [ n, ... ], (array) Number of table files at each level\n"
+            "    \"compaction_stats\": \"...\" (string) LevelDB compaction statistics\n"
+            "  },\n"
+            "  ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdbstats", "")
+            + HelpExampleRpc("getdbstats", "")
+        );
+
+    UniValue result(UniValue::VARR);
+    for (const CDBStats& stats : GetDBStats()) {
+        UniValue cache(UniValue::VOBJ);
+        uint64_t nLookups = stats.nCacheHits + stats.nCacheMisses;
+        cache.push_back(Pair("capacity", (uint64_t)stats.nCacheCapacity));
+        cache.push_back(Pair("usage", (uint64_t)stats.nCacheUsage));
+        cache.push_back(Pair("hits", stats.nCacheHits));
+        cache.push_back(Pair("misses", stats.nCacheMisses));
+        cache.push_back(Pair("hitrate", nLookups ? (double)stats.nCacheHits / nLookups : 0.0));
+
+        UniValue levels(UniValue::VARR);
+        for (int nFiles : stats.vFilesPerLevel)
+            levels.push_back(nFiles);
+
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("name", stats.name));
+        obj.push_back(Pair("path", stats.path));
+        obj.push_back(Pair("profile", DBProfileToString(stats.profile)));
+        obj.push_back(Pair("max_open_files", stats.nMaxOpenFiles));
+        obj.push_back(Pair("cache", cache));
+        obj.push_back(Pair("memory", stats.nApproxMemoryUsage));
+        obj.push_back(Pair("disksize", stats.nApproxDiskSize));
+        obj.push_back(Pair("files_per_level", levels));
+        obj.push_back(Pair("compaction_stats", stats.strCompactionStats));
+        result.push_back(obj);
+    }
+    return result;
+}
+
+UniValue metricsToJSON()
+{
+    UniValue result(UniValue::VARR);
+    for (const CMetricSnapshot& snapshot : GetMetricsSnapshot()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("name", snapshot.name));
+        obj.push_back(Pair("type", MetricTypeName(snapshot.type)));
+        if (!snapshot.labelName.empty()) {
+            UniValue labels(UniValue::VOBJ);
+            labels.push_back(Pair(snapshot.labelName, snapshot.labelValue));
+            obj.push_back(Pair("labels", labels));
+        }
+        if (snapshot.type != MetricType::HISTOGRAM) {
+            obj.push_back(Pair("value", snapshot.value));
+        } else {
+            UniValue buckets(UniValue::VARR);
+            for (size_t i = 0; i < snapshot.vCumulativeCounts.size(); i++) {
+                UniValue bucket(UniValue::VOBJ);
+                bucket.push_back(Pair("le", METRIC_LATENCY_BOUNDS[i] * 0.000001));
+                bucket.push_back(Pair("count", snapshot.vCumulativeCounts[i]));
+                buckets.push_back(bucket);
+            }
+            obj.push_back(Pair("count", snapshot.nCount));
+            obj.push_back(Pair("sum", snapshot.sum));
+            obj.push_back(Pair("buckets", buckets));
+        }
+        result.push_back(obj);
+    }
+    return result;
+}
+
+UniValue getmetrics(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw runtime_error(
+            "getmetrics\n"
+            "Returns the counters, gauges and latency histograms of the node, also served in the Prometheus format on /rest/metrics.\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"name\": \"name\",          (string) Metric name\n"
+            "    \"type\": \"type\",          (string) counter, gauge or histogram\n"
+            "    \"labels\": { \"label\": \"value\" }, (json object, optional) Label telling apart the metrics with the same name\n"
+            "    \"value\": x.xxx,          (numeric) Value of a counter or a gauge\n"
+            "    \"count\": xxxxx,          (numeric) Histogram: number of observations\n"
+            "    \"sum\": x.xxx,            (numeric) Histogram: sum of the observations, in seconds\n"
+            "    \"buckets\": [             (array) Histogram: observations up to each bound, the others are only in count\n"
+            "      {\n"
+            "        \"le\": x.xxx,         (numeric) Upper bound of the bucket, in seconds\n"
+            "        \"count\": xxxxx       (numeric) Number of observations up to the bound\n"
+            "      },\n"
+            "      ...\n"
+            "    ]\n"
+            "  },\n"
+            "  ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getmetrics", "")
+            + HelpExampleRpc("getmetrics", "")
+        );
+
+    return metricsToJSON();
+}
+
 UniValue echo(const JSONRPCRequest& request)
 {
     if (request.fHelp)
@@ -1465,6 +1632,8 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------  -----------------------  ----------
     { "control",            "getinfo",                &getinfo,                true,  {} }, /* uses wallet if enabled */
     { "control",            "getmemoryinfo",          &getmemoryinfo,          true,  {} },
+    { "control",            "getdbstats",             &getdbstats,             true,  {} },
+    { "control",            "getmetrics",             &getmetrics,             true,  {} },
     { "util",               "validateaddress",        &validateaddress,        true,  {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         &createmultisig,         true,  {"nrequired","keys"} },
     { "util",               "verifymessage",          &verifymessage,          true,  {"address","signature","message"} },
@@ -1478,6 +1647,9 @@ static const CRPCCommand commands[] =
     { "addressindex",       "getaddressbalance",      &getaddressbalance,      false,   {"addresses"} },
     { "addressindex",       "gettotalsupply",         &gettotalsupply,         false,   {} },
 
+        /* Sigma */
+    { "sigma",              "getsigmamintoutpoint",   &getsigmamintoutpoint,   false,   {"pubcoinhash"} },
+
     /* Tnode features */
     { "tnode",              "evotnsync",              &mnsync,                 true,  {"command"} },
     { "tnode",              "tnsync",                 &mnsync,                 true,  {"command"} },
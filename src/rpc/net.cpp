@@ -608,6 +608,97 @@ UniValue setnetworkactive(const JSONRPCRequest& request)
     return g_connman->GetNetworkActive();
 }
 
+UniValue getdandelioninfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw runtime_error(
+            "getdandelioninfo\n"
+            "\nReturns the state of the Dandelion stem pool, embargoes and routes.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"enabled\": true|false,        (boolean) Whether Dandelion relay is enabled\n"
+            "  \"stempool\": {\n"
+            "    \"size\": n,                  (numeric) Number of transactions in the stem pool\n"
+            "    \"bytes\": n,                 (numeric) Sum of their sizes\n"
+            "    \"usage\": n                  (numeric) Memory usage of the stem pool\n"
+            "  },\n"
+            "  \"embargoes\": {\n"
+            "    \"pending\": n,               (numeric) Number of embargoed transactions\n"
+            "    \"remaining\": [              (array) Pending embargoes by seconds left\n"
+            "      {\"below\": n, \"count\": n}, (the last entry has no upper bound)\n"
+            "      ...\n"
+            "    ],\n"
+            "    \"expired\": n,               (numeric) Embargoes which ended, the transaction was fluffed by us\n"
+            "    \"removed\": n,               (numeric) Embargoes ended by seeing the transaction in fluff phase\n"
+            "    \"avgfluffdelay\": n,         (numeric) Average time in milliseconds from embargo start to fluff\n"
+            "    \"maxfluffdelay\": n,         (numeric) Maximum of that time\n"
+            "    \"avgexpirylag\": n,          (numeric) Average time in milliseconds an ended embargo waited to be processed\n"
+            "    \"maxexpirylag\": n           (numeric) Maximum of that time\n"
+            "  },\n"
+            "  \"routes\": {                  (json object) Routing as of the last shuffle\n"
+            "    \"shuffles\": n,              (numeric) Number of route shuffles\n"
+            "    \"lastshuffle\": t,           (numeric) Time of the last shuffle\n"
+            "    \"inbound\": n,               (numeric) Number of inbound Dandelion peers\n"
+            "    \"outbound\": n,              (numeric) Number of outbound Dandelion peers\n"
+            "    \"destinations\": n,          (numeric) Number of stem destinations\n"
+            "    \"routes\": n,                (numeric) Number of inbound peers routed to a destination\n"
+            "    \"maxroutesperdestination\": n, (numeric) Most inbound peers routed to one destination\n"
+            "    \"localdestination\": true|false (boolean) Whether local transactions have a destination\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdandelioninfo", "")
+            + HelpExampleRpc("getdandelioninfo", "")
+        );
+
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("enabled", GetBoolArg("-dandelion", true)));
+
+    LOCK(cs_main);
+    CTxMemPool& stempool = txpools.getStemTxPool();
+    UniValue stem(UniValue::VOBJ);
+    stem.push_back(Pair("size", (int64_t)stempool.size()));
+    stem.push_back(Pair("bytes", (int64_t)stempool.GetTotalTxSize()));
+    stem.push_back(Pair("usage", (int64_t)stempool.DynamicMemoryUsage()));
+    obj.push_back(Pair("stempool", stem));
+
+    const CDandelionEmbargoWheel& embargoes = CNode::dandelionEmbargoes;
+    const CDandelionEmbargoStats& stats = embargoes.GetStats();
+    const std::vector<int64_t> vBoundaries = {0, 5, 10, 20, 30, 60, 120};
+    std::vector<size_t> vRemaining = embargoes.GetRemainingHistogram(GetTimeMicros(), vBoundaries);
+    UniValue remaining(UniValue::VARR);
+    for (size_t i = 0; i < vRemaining.size(); i++) {
+        UniValue bucket(UniValue::VOBJ);
+        if (i < vBoundaries.size())
+            bucket.push_back(Pair("below", vBoundaries[i]));
+        bucket.push_back(Pair("count", (int64_t)vRemaining[i]));
+        remaining.push_back(bucket);
+    }
+    UniValue embargo(UniValue::VOBJ);
+    embargo.push_back(Pair("pending", (int64_t)embargoes.Size()));
+    embargo.push_back(Pair("remaining", remaining));
+    embargo.push_back(Pair("expired", stats.nExpired));
+    embargo.push_back(Pair("removed", stats.nRemoved));
+    embargo.push_back(Pair("avgfluffdelay", stats.nExpired ? stats.nTotalFluffLatency / 1000 / (int64_t)stats.nExpired : 0));
+    embargo.push_back(Pair("maxfluffdelay", stats.nMaxFluffLatency / 1000));
+    embargo.push_back(Pair("avgexpirylag", stats.nExpired ? stats.nTotalExpiryDelay / 1000 / (int64_t)stats.nExpired : 0));
+    embargo.push_back(Pair("maxexpirylag", stats.nMaxExpiryDelay / 1000));
+    obj.push_back(Pair("embargoes", embargo));
+
+    CDandelionShuffleStats shuffleStats = CNode::GetDandelionShuffleStats();
+    UniValue routes(UniValue::VOBJ);
+    routes.push_back(Pair("shuffles", shuffleStats.nShuffles));
+    routes.push_back(Pair("lastshuffle", shuffleStats.nLastShuffleTime));
+    routes.push_back(Pair("inbound", (int64_t)shuffleStats.nInbound));
+    routes.push_back(Pair("outbound", (int64_t)shuffleStats.nOutbound));
+    routes.push_back(Pair("destinations", (int64_t)shuffleStats.nDestinations));
+    routes.push_back(Pair("routes", (int64_t)shuffleStats.nRoutes));
+    routes.push_back(Pair("maxroutesperdestination", (int64_t)shuffleStats.nMaxRoutesPerDestination));
+    routes.push_back(Pair("localdestination", shuffleStats.fLocalDestination));
+    obj.push_back(Pair("routes", routes));
+    return obj;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         okSafeMode
   //  --------------------- ------------------------  -----------------------  ----------
@@ -623,6 +714,7 @@ static const CRPCCommand commands[] =
     { "network",            "listbanned",             &listbanned,             true,  {} },
     { "network",            "clearbanned",            &clearbanned,            true,  {} },
     { "network",            "setnetworkactive",       &setnetworkactive,       true,  {"state"} },
+    { "network",            "getdandelioninfo",       &getdandelioninfo,       true,  {} },
 };
 
 void RegisterNetRPCCommands(CRPCTable &t)
@@ -2,6 +2,7 @@
 #include "sigma.h"
 #include "zerocoin.h" // Mostly for reusing class libzerocoin::SpendMetaData
 #include "timedata.h"
+#include "init.h"
 #include "chainparams.h"
 #include "util.h"
 #include "base58.h"
@@ -14,7 +15,10 @@
 #include "sigma/coin.h"
 #include "sigma/remint.h"
 #include "primitives/zerocoin.h"
+#include "spendcache.h"
+#include "txdb.h"
 #include "batchproof_container.h"
+#include "metrics.h"
 
 #include "blacklists.h"
 
@@ -22,6 +26,7 @@
 #include <sstream>
 #include <chrono>
 
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <boost/scope_exit.hpp>
 
@@ -29,8 +34,14 @@
 
 namespace sigma {
 
+static CMetricHistogram metricSpendVerify("tecracoin_sigma_spend_verify_seconds", "Time spent verifying sigma spend proofs");
+static CMetricCounter metricSpendVerifyCached("tecracoin_sigma_spend_verify_cached_total", "Sigma spend proofs found verified in the spend cache");
+
 static CSigmaState sigmaState;
 
+static const char *SIGMA_STATE_FILE = "sigmastate.dat";
+static const uint64_t SIGMA_STATE_FILE_VERSION = 1;
+
 bool CheckSigmaSpendSerial(
         CValidationState &state,
         CSigmaTxInfo *sigmaTxInfo,
@@ -177,6 +188,91 @@ bool CheckSigmaBlock(CValidationState &state, const CBlock& block) {
     return true;
 }
 
+namespace {
+
+// Hash of a sigma spend together with the anonymity set it's verified against, the key of
+// the spend verification cache
+uint256 GetSigmaSpendHash(
+        const CTxIn& txin,
+        const uint256& txHashForMetadata,
+        sigma::CoinDenomination denomination,
+        uint32_t coinGroupId,
+        const CBlockIndex *index,
+        const CSigmaState::SigmaCoinGroupInfo& coinGroup,
+        bool fPadding,
+        bool fBlacklist) {
+    CHashWriter spendHasher(SER_GETHASH, 0);
+    spendHasher << txin.scriptSig << txHashForMetadata << (int64_t)denomination << coinGroupId;
+    spendHasher << index->GetBlockHash() << coinGroup.firstBlock->GetBlockHash() << fPadding << fBlacklist;
+    return spendHasher.GetHash();
+}
+
+// Public coins minted with the given denomination and group id from index back to the first
+// block of the group
+void GetSigmaAnonymitySet(
+        CBlockIndex *index,
+        const CSigmaState::SigmaCoinGroupInfo& coinGroup,
+        const pair<sigma::CoinDenomination, int>& denominationAndId,
+        bool fBlacklist,
+        std::vector<sigma::PublicCoin>& anonymity_set) {
+    while(true) {
+        if (index->sigmaMintedPubCoins.count(denominationAndId) > 0) {
+            BOOST_FOREACH(const sigma::PublicCoin& pubCoinValue,
+                    index->sigmaMintedPubCoins[denominationAndId]) {
+                if (fBlacklist) {
+                    std::vector<unsigned char> vch = pubCoinValue.getValue().getvch();
+                    if(sigma_blacklist.count(HexStr(vch.begin(), vch.end())) > 0) {
+                        continue;
+                    }
+                }
+                anonymity_set.push_back(pubCoinValue);
+            }
+        }
+        if (index == coinGroup.firstBlock)
+            break;
+        index = index->pprev;
+    }
+}
+
+// Entries of the sigma mint index for the mints of a block, which must already be in
+// index->sigmaMintedPubCoins. A pubcoin minted twice in the block maps to its first output.
+std::vector<std::pair<uint256, CSigmaMintIndexValue>> GetSigmaMintIndexEntries(
+        const CBlockIndex *index,
+        const CBlock &block) {
+    std::vector<std::pair<uint256, CSigmaMintIndexValue>> entries;
+    std::unordered_map<uint256, std::pair<sigma::CoinDenomination, int>, StaticSaltedHasher> mints;
+    for (const auto& denominationAndId : index->sigmaMintedPubCoins) {
+        for (const sigma::PublicCoin& pubCoin : denominationAndId.second)
+            mints.emplace(primitives::GetPubCoinValueHash(pubCoin.getValue()), denominationAndId.first);
+    }
+
+    for (const CTransactionRef& tx : block.vtx) {
+        for (uint32_t n = 0; n < tx->vout.size() && !mints.empty(); n++) {
+            if (!tx->vout[n].scriptPubKey.IsSigmaMint())
+                continue;
+
+            GroupElement pubCoinValue;
+            try {
+                pubCoinValue = ParseSigmaMintScript(tx->vout[n].scriptPubKey);
+            } catch (std::invalid_argument&) {
+                continue;
+            }
+
+            auto mint = mints.find(primitives::GetPubCoinValueHash(pubCoinValue));
+            if (mint == mints.end())
+                continue;
+            int64_t denomination;
+            DenominationToInteger(mint->second.first, denomination);
+            entries.emplace_back(mint->first, CSigmaMintIndexValue(
+                    COutPoint(tx->GetHash(), n), index->nHeight, denomination, mint->second.second));
+            mints.erase(mint);
+        }
+    }
+    return entries;
+}
+
+} // anon namespace
+
 // Will return false for V1, V1.5 and V2 spends.
 // Mixing V2 and sigma spends into the same transaction will fail.
 bool CheckSigmaSpendTransaction(
@@ -270,28 +366,6 @@ bool CheckSigmaSpendTransaction(
         while (index != coinGroup.firstBlock && index->GetBlockHash() != accumulatorBlockHash)
             index = index->pprev;
 
-        // Build a vector with all the public coins with given denomination and accumulator id before
-        // the block on which the spend occured.
-        // This list of public coins is required by function "Verify" of CoinSpend.
-        std::vector<sigma::PublicCoin> anonymity_set;
-        while(true) {
-            if (index->sigmaMintedPubCoins.count(denominationAndId) > 0) {
-                BOOST_FOREACH(const sigma::PublicCoin& pubCoinValue,
-                        index->sigmaMintedPubCoins[denominationAndId]) {
-                    if (nHeight >= params.nStartSigmaBlacklist) {
-                        std::vector<unsigned char> vch = pubCoinValue.getValue().getvch();
-                        if(sigma_blacklist.count(HexStr(vch.begin(), vch.end())) > 0) {
-                            continue;
-                        }
-                    }
-                    anonymity_set.push_back(pubCoinValue);
-                }
-            }
-            if (index == coinGroup.firstBlock)
-                break;
-            index = index->pprev;
-        }
-
         bool fPadding = spend->getVersion() >= ZEROCOIN_TX_VERSION_3_1;
         if (!isVerifyDB) {
             bool fShouldPad = nHeight >= params.nSigmaPaddingBlock;
@@ -299,13 +373,38 @@ bool CheckSigmaSpendTransaction(
                 return state.DoS(1, error("Incorrect sigma spend transaction version"));
         }
 
-        BatchProofContainer* batchProofContainer = BatchProofContainer::get_instance();
-        // if we are collecting proofs, skip verification and collect proofs
-        passVerify = spend->Verify(anonymity_set, newMetaData, fPadding, batchProofContainer->fCollectProofs);
+        // The anonymity set is made of the coins minted from the first block of the group up to index,
+        // a spend already verified against the same set (e.g. when it entered the mempool) is valid
+        bool fBlacklist = nHeight >= params.nStartSigmaBlacklist;
+        uint256 spendHash = GetSigmaSpendHash(txin, txHashForMetadata, targetDenominations[vinIndex], coinGroupId,
+                                              index, coinGroup, fPadding, fBlacklist);
+
+        if (IsSpendVerificationCached(spendHash)) {
+            metricSpendVerifyCached.Inc();
+            passVerify = true;
+        } else {
+            // Build a vector with all the public coins with given denomination and accumulator id before
+            // the block on which the spend occured.
+            // This list of public coins is required by function "Verify" of CoinSpend.
+            std::vector<sigma::PublicCoin> anonymity_set;
+            GetSigmaAnonymitySet(index, coinGroup, denominationAndId, fBlacklist, anonymity_set);
+
+            BatchProofContainer* batchProofContainer = BatchProofContainer::get_instance();
+            // if we are collecting proofs, skip verification and collect proofs
+            if (batchProofContainer->fCollectProofs) {
+                // only the signature is checked here, the proof is verified with the batch and not timed
+                passVerify = spend->Verify(anonymity_set, newMetaData, fPadding, true);
+            } else {
+                CMetricTimer timer(metricSpendVerify);
+                passVerify = spend->Verify(anonymity_set, newMetaData, fPadding, false);
+            }
 
-        // add proofs into container
-        if(batchProofContainer->fCollectProofs) {
-            batchProofContainer->add(spend.get(), fPadding, coinGroupId, anonymity_set.size(), nHeight >= params.nStartSigmaBlacklist);
+            // add proofs into container
+            if(batchProofContainer->fCollectProofs) {
+                batchProofContainer->add(spend.get(), fPadding, coinGroupId, anonymity_set.size(), fBlacklist);
+            } else if (passVerify) {
+                AddSpendVerificationToCache(spendHash);
+            }
         }
 
         if (passVerify) {
@@ -522,6 +621,83 @@ bool CheckSigmaTransaction(
     return true;
 }
 
+bool CSigmaSpendProofCheck::operator()() const {
+    CMetricTimer timer(metricSpendVerify);
+    if (!spend->Verify(*anonymitySet, metaData, fPadding))
+        return false;
+    AddSpendVerificationToCache(spendHash);
+    return true;
+}
+
+void GetSigmaSpendProofChecks(
+        const CTransaction& tx,
+        std::vector<CSigmaSpendProofCheck>& vChecks,
+        SigmaAnonymitySetMap& mapAnonymitySets) {
+    AssertLockHeld(cs_main);
+    if (!tx.IsSigmaSpend())
+        return;
+
+    // AcceptToMemoryPool checks spends with a height of INT_MAX, padding is required and
+    // the blacklist applies
+    Consensus::Params const & params = ::Params().GetConsensus();
+    const bool fBlacklist = INT_MAX >= params.nStartSigmaBlacklist;
+
+    CMutableTransaction txTemp = tx;
+    BOOST_FOREACH(CTxIn &txTempIn, txTemp.vin) {
+        if (txTempIn.scriptSig.IsSigmaSpend()) {
+            txTempIn.scriptSig.clear();
+        }
+    }
+    uint256 txHashForMetadata = txTemp.GetHash();
+
+    std::vector<CSigmaSpendProofCheck> vTxChecks;
+    for (const CTxIn &txin : tx.vin) {
+        if (!txin.scriptSig.IsSigmaSpend())
+            return;
+
+        std::unique_ptr<sigma::CoinSpend> spend;
+        uint32_t coinGroupId;
+        try {
+            std::tie(spend, coinGroupId) = ParseSigmaSpend(txin);
+        }
+        catch (CBadTxIn&) {
+            return;
+        }
+        if (spend->getVersion() != ZEROCOIN_TX_VERSION_3_1)
+            return;
+
+        sigma::CoinDenomination denomination = spend->getDenomination();
+        CSigmaState::SigmaCoinGroupInfo coinGroup;
+        if (!sigmaState.GetCoinGroupInfo(denomination, coinGroupId, coinGroup))
+            return;
+
+        CBlockIndex *index = coinGroup.lastBlock;
+        uint256 accumulatorBlockHash = spend->getAccumulatorBlockHash();
+        while (index != coinGroup.firstBlock && index->GetBlockHash() != accumulatorBlockHash)
+            index = index->pprev;
+
+        CSigmaSpendProofCheck check{
+            nullptr,
+            sigma::SpendMetaData(coinGroupId, accumulatorBlockHash, txHashForMetadata),
+            true,
+            nullptr,
+            GetSigmaSpendHash(txin, txHashForMetadata, denomination, coinGroupId, index, coinGroup, true, fBlacklist)};
+
+        CHashWriter setHasher(SER_GETHASH, 0);
+        setHasher << index->GetBlockHash() << (int64_t)denomination << coinGroupId << fBlacklist;
+        std::shared_ptr<const std::vector<sigma::PublicCoin>>& anonymitySet = mapAnonymitySets[setHasher.GetHash()];
+        if (!anonymitySet) {
+            std::shared_ptr<std::vector<sigma::PublicCoin>> newSet = std::make_shared<std::vector<sigma::PublicCoin>>();
+            GetSigmaAnonymitySet(index, coinGroup, std::make_pair(denomination, (int)coinGroupId), fBlacklist, *newSet);
+            anonymitySet = newSet;
+        }
+        check.spend = std::move(spend);
+        check.anonymitySet = anonymitySet;
+        vTxChecks.push_back(std::move(check));
+    }
+    vChecks.insert(vChecks.end(), vTxChecks.begin(), vTxChecks.end());
+}
+
 void RemoveSigmaSpendsReferencingBlock(CTxMemPool& pool, CBlockIndex* blockIndex) {
     LOCK2(cs_main, pool.cs);
     std::vector<CTransaction> txn_to_remove;
@@ -553,6 +729,15 @@ void RemoveSigmaSpendsReferencingBlock(CTxMemPool& pool, CBlockIndex* blockIndex
 }
 
 void DisconnectTipSigma(CBlock& block, CBlockIndex *pindexDelete) {
+    std::vector<uint256> pubCoinValueHashes;
+    for (const auto& denominationAndId : pindexDelete->sigmaMintedPubCoins) {
+        for (const sigma::PublicCoin& pubCoin : denominationAndId.second)
+            pubCoinValueHashes.push_back(primitives::GetPubCoinValueHash(pubCoin.getValue()));
+    }
+    // Lookups check the entries against the state, a stale one is only a missed shortcut
+    if (!pubCoinValueHashes.empty() && !pblocktree->EraseSigmaMintIndex(pubCoinValueHashes))
+        LogPrintf("DisconnectTipSigma: failed to erase sigma mint index entries\n");
+
     sigmaState.RemoveBlock(pindexDelete);
 
     // Also remove from mempool sigma spends that reference given block hash.
@@ -647,6 +832,11 @@ bool ConnectBlockSigma(
             return true;
 
         sigmaState.AddMintsToStateAndBlockIndex(pindexNew, pblock);
+
+        if (!pindexNew->sigmaMintedPubCoins.empty()
+                && !pblocktree->WriteSigmaMintIndex(GetSigmaMintIndexEntries(pindexNew, *pblock))) {
+            return state.Error("Failed to write sigma mint index");
+        }
     }
     else if (!fJustCheck) { // TODO(martun): not sure if this else is necessary here. Check again later.
         sigmaState.AddBlock(pindexNew);
@@ -679,7 +869,27 @@ bool GetOutPointFromBlock(COutPoint& outPoint, const GroupElement &pubCoinValue,
     return false;
 }
 
+bool GetSigmaMintIndexValue(const uint256 &pubCoinValueHash, CSigmaMintIndexValue &value) {
+    GroupElement pubCoinValue;
+    sigma::CoinDenomination denomination;
+    if (!pblocktree->ReadSigmaMintIndex(pubCoinValueHash, value)
+            || !sigmaState.HasCoinHash(pubCoinValue, pubCoinValueHash)
+            || !IntegerToDenomination(value.denomination, denomination))
+        return false;
+
+    auto mintedCoinHeightAndId = sigmaState.GetMintedCoinHeightAndId(sigma::PublicCoin(pubCoinValue, denomination));
+    return mintedCoinHeightAndId == std::make_pair(value.blockHeight, value.coinGroupId);
+}
+
 bool GetOutPoint(COutPoint& outPoint, const sigma::PublicCoin &pubCoin) {
+    CSigmaMintIndexValue mintIndexValue;
+    int64_t denomination;
+    if (GetSigmaMintIndexValue(primitives::GetPubCoinValueHash(pubCoin.getValue()), mintIndexValue)
+            && DenominationToInteger(pubCoin.getDenomination(), denomination)
+            && mintIndexValue.denomination == denomination) {
+        outPoint = mintIndexValue.outpoint;
+        return true;
+    }
 
     sigma::CSigmaState *sigmaState = sigma::CSigmaState::GetState();
     auto mintedCoinHeightAndId = sigmaState->GetMintedCoinHeightAndId(pubCoin);
@@ -699,6 +909,12 @@ bool GetOutPoint(COutPoint& outPoint, const sigma::PublicCoin &pubCoin) {
 }
 
 bool GetOutPoint(COutPoint& outPoint, const GroupElement &pubCoinValue) {
+    CSigmaMintIndexValue mintIndexValue;
+    if (GetSigmaMintIndexValue(primitives::GetPubCoinValueHash(pubCoinValue), mintIndexValue)) {
+        outPoint = mintIndexValue.outpoint;
+        return true;
+    }
+
     int mintHeight = 0;
     int coinId = 0;
 
@@ -727,6 +943,12 @@ bool GetOutPoint(COutPoint& outPoint, const GroupElement &pubCoinValue) {
 }
 
 bool GetOutPoint(COutPoint& outPoint, const uint256 &pubCoinValueHash) {
+    CSigmaMintIndexValue mintIndexValue;
+    if (GetSigmaMintIndexValue(pubCoinValueHash, mintIndexValue)) {
+        outPoint = mintIndexValue.outpoint;
+        return true;
+    }
+
     GroupElement pubCoinValue;
     sigma::CSigmaState *sigmaState = sigma::CSigmaState::GetState();
     if(!sigmaState->HasCoinHash(pubCoinValue, pubCoinValueHash)){
@@ -736,6 +958,115 @@ bool GetOutPoint(COutPoint& outPoint, const uint256 &pubCoinValueHash) {
     return GetOutPoint(outPoint, pubCoinValue);
 }
 
+void BuildSigmaMintIndex() {
+    bool fIndexed = false;
+    if (pblocktree->ReadFlag("sigmamintindex", fIndexed) && fIndexed)
+        return;
+
+    LogPrintf("Building the sigma mint index...\n");
+    int nIndexed = 0;
+    const CBlockIndex *pindex;
+    {
+        LOCK(cs_main);
+        pindex = chainActive[::Params().GetConsensus().nSigmaStartBlock];
+        // Sigma blocks still to come are indexed as they are connected
+        if (!pindex) {
+            pblocktree->WriteFlag("sigmamintindex", true);
+            return;
+        }
+    }
+    // Blocks are read without holding cs_main, the ones disconnected meanwhile are skipped
+    // and the ones connected meanwhile are indexed by ConnectBlockSigma
+    while (pindex) {
+        if (ShutdownRequested())
+            return;
+
+        bool fHasMints;
+        {
+            LOCK(cs_main);
+            fHasMints = !pindex->sigmaMintedPubCoins.empty();
+        }
+        CBlock block;
+        if (fHasMints && !ReadBlockFromDisk(block, pindex, ::Params().GetConsensus())) {
+            LogPrintf("%s: can't read block at height %d from disk.\n", __func__, pindex->nHeight);
+            return;
+        }
+
+        LOCK(cs_main);
+        if (!chainActive.Contains(pindex)) {
+            pindex = chainActive.FindFork(pindex);
+        } else if (fHasMints) {
+            std::vector<std::pair<uint256, CSigmaMintIndexValue>> entries = GetSigmaMintIndexEntries(pindex, block);
+            if (!pblocktree->WriteSigmaMintIndex(entries)) {
+                LogPrintf("%s: failed to write the sigma mint index\n", __func__);
+                return;
+            }
+            nIndexed += entries.size();
+        }
+
+        if (pindex == chainActive.Tip()) {
+            pblocktree->WriteFlag("sigmamintindex", true);
+            break;
+        }
+        pindex = chainActive.Next(pindex);
+    }
+    LogPrintf("Sigma mint index built, %d mints indexed\n", nIndexed);
+}
+
+void GetMintsOnChain(const std::set<uint256>& pubCoinValueHashes, std::map<uint256, CMintOnChain>& mapMints) {
+    if (pubCoinValueHashes.empty())
+        return;
+
+    // Group the wanted coins by the block containing them
+    std::map<int, std::pair<CBlockIndex*, std::vector<std::pair<sigma::PublicCoin, uint256>>>> mapBlockMints;
+    {
+        LOCK(cs_main);
+        for (const auto& mint : sigmaState.GetMints()) {
+            uint256 pubCoinValueHash = primitives::GetPubCoinValueHash(mint.first.getValue());
+            if (!pubCoinValueHashes.count(pubCoinValueHash))
+                continue;
+            auto& blockMints = mapBlockMints[mint.second.nHeight];
+            blockMints.first = chainActive[mint.second.nHeight];
+            blockMints.second.emplace_back(mint.first, pubCoinValueHash);
+        }
+    }
+
+    for (const auto& blockMints : mapBlockMints) {
+        CBlockIndex *pindex = blockMints.second.first;
+        CBlock block;
+        if (!pindex || !ReadBlockFromDisk(block, pindex, ::Params().GetConsensus())) {
+            LogPrintf("%s: can't read block at height %d from disk.\n", __func__, blockMints.first);
+            continue;
+        }
+
+        for (size_t nTx = 0; nTx < block.vtx.size(); nTx++) {
+            const CTransactionRef& tx = block.vtx[nTx];
+            for (uint32_t n = 0; n < tx->vout.size(); n++) {
+                if (!tx->vout[n].scriptPubKey.IsSigmaMint())
+                    continue;
+
+                GroupElement txPubCoinValue;
+                try {
+                    txPubCoinValue = ParseSigmaMintScript(tx->vout[n].scriptPubKey);
+                } catch (std::invalid_argument&) {
+                    continue;
+                }
+
+                for (const auto& mint : blockMints.second.second) {
+                    if (mint.first.getValue() != txPubCoinValue || mapMints.count(mint.second))
+                        continue;
+                    CMintOnChain& mintOnChain = mapMints[mint.second];
+                    mintOnChain.outPoint = COutPoint(tx->GetHash(), n);
+                    mintOnChain.tx = tx;
+                    mintOnChain.pindex = pindex;
+                    mintOnChain.nTxIndex = nTx;
+                    mintOnChain.pubCoin = mint.first;
+                }
+            }
+        }
+    }
+}
+
 bool BuildSigmaStateFromIndex(CChain *chain) {
     for (CBlockIndex *blockIndex = chain->Genesis(); blockIndex; blockIndex=chain->Next(blockIndex))
     {
@@ -752,6 +1083,21 @@ bool BuildSigmaStateFromIndex(CChain *chain) {
     return true;
 }
 
+void LoadSigmaState(CChain *chain) {
+    int64_t nStart = GetTimeMillis();
+    if (sigmaState.LoadFromFile(GetDataDir() / SIGMA_STATE_FILE, chain)) {
+        LogPrintf("Loaded sigma state from %s in %dms\n", SIGMA_STATE_FILE, GetTimeMillis() - nStart);
+        return;
+    }
+    BuildSigmaStateFromIndex(chain);
+    LogPrintf("Built sigma state from the block index in %dms\n", GetTimeMillis() - nStart);
+}
+
+bool WriteSigmaStateFile(const CChain &chain) {
+    AssertLockHeld(cs_main);
+    return sigmaState.WriteToFile(GetDataDir() / SIGMA_STATE_FILE, chain);
+}
+
 // CZerocoinTxInfoV3
 
 void CSigmaTxInfo::Complete() {
@@ -779,6 +1125,7 @@ CSigmaState::Containers::Containers(std::atomic<bool> & surgeCondition)
 
 void CSigmaState::Containers::AddMint(sigma::PublicCoin const & pubCoin, CMintedCoinInfo const & coinInfo) {
     mintedPubCoins.insert(std::make_pair(pubCoin, coinInfo));
+    mintedPubCoinHashes.insert(std::make_pair(pubCoin.getValueHash(), pubCoin));
     mintMetaInfo[coinInfo.coinGroupId][coinInfo.denomination] += 1;
     CheckSurgeCondition(coinInfo.coinGroupId, coinInfo.denomination);
 }
@@ -788,6 +1135,9 @@ void CSigmaState::Containers::RemoveMint(sigma::PublicCoin const & pubCoin) {
     if (iter != mintedPubCoins.end()) {
         mintMetaInfo[iter->second.coinGroupId][iter->second.denomination] -= 1;
         CMintedCoinInfo tmpMintInfo(iter->second);
+        auto hashIter = mintedPubCoinHashes.find(pubCoin.getValueHash());
+        if (hashIter != mintedPubCoinHashes.end() && hashIter->second == pubCoin)
+            mintedPubCoinHashes.erase(hashIter);
         mintedPubCoins.erase(iter);
         CheckSurgeCondition(tmpMintInfo.coinGroupId, tmpMintInfo.denomination);
     }
@@ -795,6 +1145,7 @@ void CSigmaState::Containers::RemoveMint(sigma::PublicCoin const & pubCoin) {
 
 void CSigmaState::Containers::AddSpend(Scalar const & serial, CSpendCoinInfo const & coinInfo) {
     usedCoinSerials[serial] = coinInfo;
+    usedCoinSerialHashes[primitives::GetSerialHash(serial)] = serial;
     spendMetaInfo[coinInfo.coinGroupId][coinInfo.denomination] += 1;
     CheckSurgeCondition(coinInfo.coinGroupId, coinInfo.denomination);
 }
@@ -804,6 +1155,7 @@ void CSigmaState::Containers::RemoveSpend(Scalar const & serial) {
     if (iter != usedCoinSerials.end()) {
         spendMetaInfo[iter->second.coinGroupId][iter->second.denomination] -= 1;
         CSpendCoinInfo tmpSpendInfo(iter->second);
+        usedCoinSerialHashes.erase(primitives::GetSerialHash(serial));
         usedCoinSerials.erase(iter);
         CheckSurgeCondition(tmpSpendInfo.coinGroupId, tmpSpendInfo.denomination);
     }
@@ -821,9 +1173,25 @@ bool CSigmaState::Containers::IsSurgeCondition() const {
     return surgeCondition;
 }
 
+sigma::PublicCoin const * CSigmaState::Containers::GetMintByHash(uint256 const & pubCoinValueHash) const {
+    auto iter = mintedPubCoinHashes.find(pubCoinValueHash);
+    if (iter == mintedPubCoinHashes.end())
+        return nullptr;
+    return &iter->second;
+}
+
+Scalar const * CSigmaState::Containers::GetSpendByHash(uint256 const & serialHash) const {
+    auto iter = usedCoinSerialHashes.find(serialHash);
+    if (iter == usedCoinSerialHashes.end())
+        return nullptr;
+    return &iter->second;
+}
+
 void CSigmaState::Containers::Reset() {
     mintedPubCoins.clear();
     usedCoinSerials.clear();
+    mintedPubCoinHashes.clear();
+    usedCoinSerialHashes.clear();
     mintMetaInfo.clear();
     spendMetaInfo.clear();
     surgeCondition = false;
@@ -1015,13 +1383,11 @@ bool CSigmaState::IsUsedCoinSerial(const Scalar &coinSerial) {
 }
 
 bool CSigmaState::IsUsedCoinSerialHash(Scalar &coinSerial, const uint256 &coinSerialHash) {
-    for ( auto it = GetSpends().begin(); it != GetSpends().end(); ++it ){
-        if(primitives::GetSerialHash(it->first)==coinSerialHash){
-            coinSerial = it->first;
-            return true;
-        }
-    }
-    return false;
+    Scalar const * serial = containers.GetSpendByHash(coinSerialHash);
+    if (!serial)
+        return false;
+    coinSerial = *serial;
+    return true;
 }
 
 bool CSigmaState::HasCoin(const sigma::PublicCoin& pubCoin) {
@@ -1029,14 +1395,11 @@ bool CSigmaState::HasCoin(const sigma::PublicCoin& pubCoin) {
 }
 
 bool CSigmaState::HasCoinHash(GroupElement &pubCoinValue, const uint256 &pubCoinValueHash) {
-    for ( auto it = GetMints().begin(); it != GetMints().end(); ++it ){
-        const sigma::PublicCoin & pubCoin = (*it).first;
-        if(pubCoin.getValueHash()==pubCoinValueHash){
-            pubCoinValue = pubCoin.getValue();
-            return true;
-        }
-    }
-    return false;
+    sigma::PublicCoin const * pubCoin = containers.GetMintByHash(pubCoinValueHash);
+    if (!pubCoin)
+        return false;
+    pubCoinValue = pubCoin->getValue();
+    return true;
 }
 
 int CSigmaState::GetCoinSetForSpend(
@@ -1195,6 +1558,154 @@ void CSigmaState::Reset() {
     containers.Reset();
 }
 
+bool CSigmaState::WriteToFile(const boost::filesystem::path &path, const CChain &chain) const {
+    const CBlockIndex *tip = chain.Tip();
+    if (!tip)
+        return false;
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << SIGMA_STATE_FILE_VERSION << tip->GetBlockHash() << tip->nHeight;
+
+    ss << (uint64_t)containers.GetMints().size();
+    for (const auto& mint : containers.GetMints())
+        ss << mint.first << (int64_t)mint.second.denomination << mint.second.coinGroupId << mint.second.nHeight;
+    ss << (uint64_t)containers.GetSpends().size();
+    for (const auto& spend : containers.GetSpends())
+        ss << spend.first << spend.second;
+
+    // Blocks are referred to by height, their hashes are kept to check they're still on the chain
+    ss << (uint64_t)coinGroups.size();
+    for (const auto& coinGroup : coinGroups) {
+        const SigmaCoinGroupInfo& info = coinGroup.second;
+        ss << (int64_t)coinGroup.first.first << coinGroup.first.second << info.nCoins;
+        ss << info.firstBlock->nHeight << info.firstBlock->GetBlockHash();
+        ss << info.lastBlock->nHeight << info.lastBlock->GetBlockHash();
+    }
+    ss << (uint64_t)latestCoinIds.size();
+    for (const auto& latestCoinId : latestCoinIds)
+        ss << (int64_t)latestCoinId.first << latestCoinId.second;
+
+    ss << Hash(ss.begin(), ss.end());
+
+    boost::filesystem::path pathTmp = path;
+    pathTmp += ".new";
+    FILE *filestr = fopen(pathTmp.string().c_str(), "wb");
+    if (!filestr)
+        return error("%s: failed to open %s", __func__, pathTmp.string());
+    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+    try {
+        file.write(&ss[0], ss.size());
+        FileCommit(file.Get());
+        file.fclose();
+    } catch (const std::exception& e) {
+        boost::filesystem::remove(pathTmp);
+        return error("%s: failed to write %s: %s", __func__, pathTmp.string(), e.what());
+    }
+    if (!RenameOver(pathTmp, path))
+        return error("%s: failed to rename %s", __func__, pathTmp.string());
+    return true;
+}
+
+bool CSigmaState::LoadFromFile(const boost::filesystem::path &path, CChain *chain) {
+    FILE *filestr = fopen(path.string().c_str(), "rb");
+    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+    if (file.IsNull())
+        return false;
+
+    // The block of chain at the given height, if it has the given hash
+    auto getBlock = [chain](int nHeight, const uint256& hash) -> CBlockIndex* {
+        CBlockIndex *index = (*chain)[nHeight];
+        if (!index || index->GetBlockHash() != hash)
+            throw std::runtime_error("block not on the chain");
+        return index;
+    };
+
+    std::vector<std::pair<sigma::PublicCoin, CMintedCoinInfo>> mints;
+    std::vector<std::pair<Scalar, CSpendCoinInfo>> spends;
+    std::unordered_map<pair<CoinDenomination, int>, SigmaCoinGroupInfo, pairhash> newCoinGroups;
+    std::unordered_map<CoinDenomination, int> newLatestCoinIds;
+    CBlockIndex *tip;
+
+    try {
+        // The whole file is read at once and checked before anything is deserialized
+        std::vector<char> data(boost::filesystem::file_size(path));
+        file.read(data.data(), data.size());
+        if (data.size() < sizeof(uint256))
+            return error("%s: %s is corrupted", __func__, path.string());
+        const char *end = data.data() + data.size() - sizeof(uint256);
+        uint256 checksum;
+        memcpy(checksum.begin(), end, sizeof(uint256));
+        if (Hash((const char*)data.data(), end) != checksum)
+            return error("%s: %s is corrupted", __func__, path.string());
+        CDataStream ss(data.data(), end, SER_DISK, CLIENT_VERSION);
+
+        uint64_t version;
+        ss >> version;
+        if (version != SIGMA_STATE_FILE_VERSION)
+            return false;
+
+        uint256 tipHash;
+        int nTipHeight;
+        ss >> tipHash >> nTipHeight;
+        tip = getBlock(nTipHeight, tipHash);
+
+        uint64_t count;
+        ss >> count;
+        mints.reserve(count);
+        while (count--) {
+            sigma::PublicCoin pubCoin;
+            int64_t denomination;
+            CMintedCoinInfo info;
+            ss >> pubCoin >> denomination >> info.coinGroupId >> info.nHeight;
+            info.denomination = CoinDenomination(denomination);
+            mints.emplace_back(pubCoin, info);
+        }
+        ss >> count;
+        spends.reserve(count);
+        while (count--) {
+            Scalar serial;
+            CSpendCoinInfo info;
+            ss >> serial >> info;
+            spends.emplace_back(serial, info);
+        }
+        ss >> count;
+        while (count--) {
+            int64_t denomination;
+            int coinGroupId, nFirstHeight, nLastHeight;
+            uint256 firstHash, lastHash;
+            SigmaCoinGroupInfo info;
+            ss >> denomination >> coinGroupId >> info.nCoins;
+            ss >> nFirstHeight >> firstHash >> nLastHeight >> lastHash;
+            info.firstBlock = getBlock(nFirstHeight, firstHash);
+            info.lastBlock = getBlock(nLastHeight, lastHash);
+            newCoinGroups[std::make_pair(CoinDenomination(denomination), coinGroupId)] = info;
+        }
+        ss >> count;
+        while (count--) {
+            int64_t denomination;
+            int coinGroupId;
+            ss >> denomination >> coinGroupId;
+            newLatestCoinIds[CoinDenomination(denomination)] = coinGroupId;
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("%s: can't use %s: %s\n", __func__, path.string(), e.what());
+        return false;
+    }
+
+    Reset();
+    coinGroups = std::move(newCoinGroups);
+    latestCoinIds = std::move(newLatestCoinIds);
+    for (const auto& mint : mints)
+        containers.AddMint(mint.first, mint.second);
+    for (const auto& spend : spends)
+        containers.AddSpend(spend.first, spend.second);
+
+    // The chain may have been flushed after the file was written
+    for (CBlockIndex *index = chain->Next(tip); index; index = chain->Next(index))
+        AddBlock(index);
+    return true;
+}
+
 CSigmaState* CSigmaState::GetState() {
     return &sigmaState;
 }
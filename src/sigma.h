@@ -6,19 +6,26 @@
 #include "sigma/coin.h"
 #include "sigma/coinspend.h"
 #include "consensus/validation.h"
+#include "primitives/transaction.h"
 #include <secp256k1/include/Scalar.h>
 #include <secp256k1/include/GroupElement.h>
 #include "sigma/params.h"
+#include "saltedhasher.h"
+#include "sigmamintindex.h"
 #include <unordered_set>
 #include <unordered_map>
 #include <functional>
 #include "coin_containers.h"
 
+#include <boost/filesystem/path.hpp>
+
 //tests
 namespace sigma_mintspend_many { class sigma_mintspend_many; }
 namespace sigma_mintspend { class sigma_mintspend_test; }
 namespace sigma_partialspend_mempool_tests { class partialspend; }
 namespace zerocoin_tests3_v3 { class zerocoin_mintspend_v3; }
+namespace sigma { class CSigmaState; }
+void SetSigmaSpends(sigma::CSigmaState *sigmaState, sigma::spend_info_container const &spends);
 
 namespace sigma {
 
@@ -89,8 +96,78 @@ bool GetOutPoint(COutPoint& outPoint, const sigma::PublicCoin &pubCoin);
 bool GetOutPoint(COutPoint& outPoint, const GroupElement &pubCoinValue);
 bool GetOutPoint(COutPoint& outPoint, const uint256 &pubCoinValueHash);
 
+/*
+ * Look the mint with the given pubcoin value hash up in the sigma mint index. Entries which
+ * don't match the sigma state are ignored, the GetOutPoint functions then read the block.
+ */
+bool GetSigmaMintIndexValue(const uint256 &pubCoinValueHash, CSigmaMintIndexValue &value);
+
+/*
+ * Add the mints of the blocks connected before the sigma mint index existed to it. Runs once,
+ * reading every block with mints without holding cs_main.
+ */
+void BuildSigmaMintIndex();
+
+/*
+ * Mint found on the chain by GetMintsOnChain.
+ */
+struct CMintOnChain {
+    COutPoint outPoint;
+    CTransactionRef tx;
+    const CBlockIndex *pindex;
+    // Position of the mint transaction in its block
+    int nTxIndex;
+    sigma::PublicCoin pubCoin;
+};
+
+/*
+ * Look up all the mints with the given pubcoin value hashes at once. Makes a single pass over
+ * the minted coins and reads every block containing any of them only once. Found mints are
+ * added to mapMints, keyed by pubcoin value hash.
+ */
+void GetMintsOnChain(const std::set<uint256>& pubCoinValueHashes, std::map<uint256, CMintOnChain>& mapMints);
+
+/*
+ * Proof of a sigma spend together with the anonymity set it's checked against, which can
+ * be verified without holding cs_main. A successful verification is added to the spend
+ * verification cache, so the transaction is not verified again when it's accepted.
+ */
+struct CSigmaSpendProofCheck {
+    std::shared_ptr<const sigma::CoinSpend> spend;
+    sigma::SpendMetaData metaData;
+    bool fPadding;
+    std::shared_ptr<const std::vector<sigma::PublicCoin>> anonymitySet;
+    uint256 spendHash;
+
+    bool operator()() const;
+};
+
+typedef std::map<uint256, std::shared_ptr<const std::vector<sigma::PublicCoin>>> SigmaAnonymitySetMap;
+
+/*
+ * Collect the proofs of the sigma spends of tx as they are verified by AcceptToMemoryPool at
+ * the current tip. Nothing is added for a transaction AcceptToMemoryPool would reject without
+ * verifying the proofs. Anonymity sets are shared between calls through mapAnonymitySets.
+ * Requires cs_main.
+ */
+void GetSigmaSpendProofChecks(
+        const CTransaction& tx,
+        std::vector<CSigmaSpendProofCheck>& vChecks,
+        SigmaAnonymitySetMap& mapAnonymitySets);
+
 bool BuildSigmaStateFromIndex(CChain *chain);
 
+/*
+ * Fill the sigma state from the snapshot in the data directory if it was written at a block of
+ * chain, adding the blocks after that one, otherwise from the block index.
+ */
+void LoadSigmaState(CChain *chain);
+
+/*
+ * Snapshot the sigma state at the tip of chain into the data directory. Requires cs_main.
+ */
+bool WriteSigmaStateFile(const CChain &chain);
+
 Scalar GetSigmaSpendSerialNumber(const CTransaction &tx, const CTxIn &txin);
 CAmount GetSigmaSpendInput(const CTransaction &tx);
 
@@ -171,6 +248,14 @@ public:
     // Reset to initial values
     void Reset();
 
+    // Write the mints, spends and coin groups, which must be the ones at the tip of chain, to
+    // a file replaced atomically. Coins in the mempool aren't written.
+    bool WriteToFile(const boost::filesystem::path &path, const CChain &chain) const;
+
+    // Replace the state with the one written by WriteToFile at a block of chain and add the
+    // blocks of chain after that block. The state is unchanged if the file can't be used.
+    bool LoadFromFile(const boost::filesystem::path &path, CChain *chain);
+
     // Check if there is a conflicting tx in the blockchain or mempool
     bool CanAddSpendToMempool(const Scalar& coinSerial);
 
@@ -238,6 +323,10 @@ private:
         mint_info_container const & GetMints() const;
         spend_info_container const & GetSpends() const;
         bool IsSurgeCondition() const;
+
+        // Lookups by the hash of the public coin value or of the serial, null if not found
+        sigma::PublicCoin const * GetMintByHash(uint256 const & pubCoinValueHash) const;
+        Scalar const * GetSpendByHash(uint256 const & serialHash) const;
     private:
         // Set of all minted pubCoin values, keyed by the public coin.
         // Used for checking if the given coin already exists.
@@ -245,6 +334,11 @@ private:
         // Set of all used coin serials.
         spend_info_container usedCoinSerials;
 
+        // Indexes of the two sets above by the hash of the public coin value and by the hash of
+        // the serial, so the wallet can look coins up by hash without scanning the sets.
+        std::unordered_map<uint256, sigma::PublicCoin, StaticSaltedHasher> mintedPubCoinHashes;
+        std::unordered_map<uint256, Scalar, StaticSaltedHasher> usedCoinSerialHashes;
+
         std::atomic<bool> & surgeCondition;
 
         typedef std::map<int, std::map<CoinDenomination, size_t>> metainfo_container_t;
@@ -264,6 +358,7 @@ private:
     friend class zerocoin_tests3_v3::zerocoin_mintspend_v3;
     friend class sigma_mintspend::sigma_mintspend_test;
     friend class sigma_partialspend_mempool_tests::partialspend;
+    friend void ::SetSigmaSpends(sigma::CSigmaState *sigmaState, sigma::spend_info_container const &spends);
 };
 
 } // end of namespace sigma.
@@ -0,0 +1,51 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SIGMAMINTINDEX_H
+#define BITCOIN_SIGMAMINTINDEX_H
+
+#include "primitives/transaction.h"
+#include "serialize.h"
+
+/** Where a sigma mint is on the chain, keyed by the hash of its pubcoin value */
+struct CSigmaMintIndexValue {
+    COutPoint outpoint;
+    int blockHeight;
+    int64_t denomination;
+    int coinGroupId;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(outpoint);
+        READWRITE(blockHeight);
+        READWRITE(denomination);
+        READWRITE(coinGroupId);
+    }
+
+    CSigmaMintIndexValue(const COutPoint& o, int h, int64_t d, int g) {
+        outpoint = o;
+        blockHeight = h;
+        denomination = d;
+        coinGroupId = g;
+    }
+
+    CSigmaMintIndexValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        outpoint.SetNull();
+        blockHeight = 0;
+        denomination = 0;
+        coinGroupId = 0;
+    }
+
+    bool IsNull() const {
+        return outpoint.IsNull();
+    }
+};
+
+#endif // BITCOIN_SIGMAMINTINDEX_H
@@ -0,0 +1,118 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "spendcache.h"
+
+#include "crypto/sha256.h"
+#include "random.h"
+#include "util.h"
+
+#include "cuckoocache.h"
+
+#include <atomic>
+#include <cstring>
+
+#include <boost/thread.hpp>
+
+namespace {
+
+/**
+ * Entries are salted hashes, like in the signature cache no extra blinding is needed.
+ */
+class SpendCacheHasher
+{
+public:
+    template <uint8_t hash_select>
+    uint32_t operator()(const uint256& key) const
+    {
+        static_assert(hash_select <8, "SpendCacheHasher only has 8 hashes available.");
+        uint32_t u;
+        std::memcpy(&u, key.begin()+4*hash_select, 4);
+        return u;
+    }
+};
+
+class CSpendVerificationCache
+{
+private:
+    //! Entries are SHA256(nonce || spend hash)
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SpendCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_spendcache;
+
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+
+public:
+    CSpendVerificationCache() : nHits(0), nMisses(0)
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    void ComputeEntry(uint256& entry, const uint256& spendHash)
+    {
+        CSHA256().Write(nonce.begin(), 32).Write(spendHash.begin(), 32).Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry)
+    {
+        bool fFound;
+        {
+            boost::shared_lock<boost::shared_mutex> lock(cs_spendcache);
+            fFound = setValid.contains(entry, false);
+        }
+        ++(fFound ? nHits : nMisses);
+        return fFound;
+    }
+
+    void Set(uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_spendcache);
+        setValid.insert(entry);
+    }
+
+    uint32_t setup_bytes(size_t n)
+    {
+        return setValid.setup_bytes(n);
+    }
+
+    CSpendCacheStats GetStats() const
+    {
+        CSpendCacheStats stats;
+        stats.nHits = nHits;
+        stats.nMisses = nMisses;
+        return stats;
+    }
+};
+
+static CSpendVerificationCache spendCache;
+}
+
+void InitSpendVerificationCache()
+{
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, GetArg("-maxspendcachesize", DEFAULT_MAX_SPEND_CACHE_SIZE)), MAX_MAX_SPEND_CACHE_SIZE) * ((size_t) 1 << 20);
+    size_t nElems = spendCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for spend verification cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
+
+bool IsSpendVerificationCached(const uint256& spendHash)
+{
+    uint256 entry;
+    spendCache.ComputeEntry(entry, spendHash);
+    return spendCache.Get(entry);
+}
+
+void AddSpendVerificationToCache(const uint256& spendHash)
+{
+    uint256 entry;
+    spendCache.ComputeEntry(entry, spendHash);
+    spendCache.Set(entry);
+}
+
+CSpendCacheStats GetSpendVerificationCacheStats()
+{
+    return spendCache.GetStats();
+}
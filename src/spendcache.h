@@ -0,0 +1,39 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SPENDCACHE_H
+#define BITCOIN_SPENDCACHE_H
+
+#include "uint256.h"
+
+#include <stdint.h>
+
+// Limit the spend verification cache to 8MB by default, an entry is a 32 byte hash
+static const unsigned int DEFAULT_MAX_SPEND_CACHE_SIZE = 8;
+// Maximum spend verification cache size allowed
+static const int64_t MAX_MAX_SPEND_CACHE_SIZE = 16384;
+
+struct CSpendCacheStats
+{
+    uint64_t nHits;
+    uint64_t nMisses;
+};
+
+/**
+ * Cache of successful sigma and zerocoin spend proof verifications. A spend accepted to the
+ * mempool isn't verified again when the block containing it is connected.
+ *
+ * spendHash must commit to the spend input, the metadata it signs and the anonymity set it
+ * was verified against (denomination, group id and the blocks the set was built from). The
+ * cache salts it before use.
+ */
+bool IsSpendVerificationCached(const uint256& spendHash);
+void AddSpendVerificationToCache(const uint256& spendHash);
+
+CSpendCacheStats GetSpendVerificationCacheStats();
+
+// To be called once in AppInit2/TestingSetup to initialize the spend verification cache
+void InitSpendVerificationCache();
+
+#endif // BITCOIN_SPENDCACHE_H
@@ -0,0 +1,217 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SUPPORT_ALLOCATORS_POOL_H
+#define BITCOIN_SUPPORT_ALLOCATORS_POOL_H
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <list>
+#include <new>
+
+/**
+ * Memory resource for many allocations of the same few small sizes, like the
+ * nodes of a std::unordered_map.
+ *
+ * Memory is taken from the heap in chunks and handed out in blocks of a
+ * multiple of ELEM_ALIGN_BYTES. A freed block goes to the free list of its
+ * size and is given to the next allocation of that size, the chunks are only
+ * released with the resource. Allocations larger than MAX_BLOCK_SIZE_BYTES,
+ * or aligned on more than ALIGN_BYTES, come from the heap.
+ *
+ * Compared to a heap allocation per node this saves the malloc overhead of
+ * each node and keeps the nodes close together. It is not thread safe, like
+ * the containers using it.
+ */
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+class PoolResource
+{
+    //! A free block holds the next free block of its size
+    struct ListNode {
+        ListNode* m_next;
+
+        explicit ListNode(ListNode* next) : m_next(next) {}
+    };
+
+public:
+    //! Blocks are handed out in multiples of this size
+    static constexpr std::size_t ELEM_ALIGN_BYTES = alignof(ListNode) > ALIGN_BYTES ? alignof(ListNode) : ALIGN_BYTES;
+
+    //! Size of the chunks taken from the heap by default
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE_BYTES = 256 << 10;
+
+private:
+    static_assert((ELEM_ALIGN_BYTES & (ELEM_ALIGN_BYTES - 1)) == 0, "ELEM_ALIGN_BYTES must be a power of two");
+    static_assert(ELEM_ALIGN_BYTES <= alignof(std::max_align_t), "the chunks are only aligned for std::max_align_t");
+    static_assert(sizeof(ListNode) <= ELEM_ALIGN_BYTES, "a block must be able to hold a ListNode");
+    static_assert(MAX_BLOCK_SIZE_BYTES % ELEM_ALIGN_BYTES == 0, "MAX_BLOCK_SIZE_BYTES must be a multiple of the alignment");
+
+    //! One free list per block size, in units of ELEM_ALIGN_BYTES
+    static constexpr std::size_t NUM_LISTS = MAX_BLOCK_SIZE_BYTES / ELEM_ALIGN_BYTES + 1;
+
+    const std::size_t m_chunk_size_bytes;
+    std::list<char*> m_allocated_chunks;
+    std::array<ListNode*, NUM_LISTS> m_free_lists;
+    //! Part of the last chunk which was never handed out
+    char* m_available_memory_it;
+    char* m_available_memory_end;
+    //! Size of the blocks handed out and not freed yet
+    std::size_t m_used_bytes;
+
+    static std::size_t NumElemAlignBytes(std::size_t bytes)
+    {
+        return (bytes + ELEM_ALIGN_BYTES - 1) / ELEM_ALIGN_BYTES + (bytes == 0);
+    }
+
+    static bool IsFreeListUsable(std::size_t bytes, std::size_t alignment)
+    {
+        return alignment <= ELEM_ALIGN_BYTES && bytes <= MAX_BLOCK_SIZE_BYTES;
+    }
+
+    void AddToList(void* p, ListNode*& head)
+    {
+        head = new (p) ListNode(head);
+    }
+
+    void AllocateChunk()
+    {
+        // The rest of the last chunk is smaller than any block that didn't fit, it can still serve its own size
+        if (m_available_memory_it != m_available_memory_end) {
+            const std::size_t num_alignments = (m_available_memory_end - m_available_memory_it) / ELEM_ALIGN_BYTES;
+            AddToList(m_available_memory_it, m_free_lists[num_alignments]);
+        }
+        m_available_memory_it = static_cast<char*>(::operator new(m_chunk_size_bytes));
+        m_available_memory_end = m_available_memory_it + m_chunk_size_bytes;
+        m_allocated_chunks.push_back(m_available_memory_it);
+    }
+
+public:
+    explicit PoolResource(std::size_t chunk_size_bytes)
+        : m_chunk_size_bytes(NumElemAlignBytes(chunk_size_bytes) * ELEM_ALIGN_BYTES),
+          m_available_memory_it(nullptr), m_available_memory_end(nullptr), m_used_bytes(0)
+    {
+        assert(m_chunk_size_bytes >= MAX_BLOCK_SIZE_BYTES);
+        m_free_lists.fill(nullptr);
+        AllocateChunk();
+    }
+
+    PoolResource() : PoolResource(DEFAULT_CHUNK_SIZE_BYTES) {}
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    ~PoolResource()
+    {
+        for (char* chunk : m_allocated_chunks)
+            ::operator delete(chunk);
+    }
+
+    void* Allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (!IsFreeListUsable(bytes, alignment)) {
+            assert(alignment <= alignof(std::max_align_t));
+            return ::operator new(bytes);
+        }
+        const std::size_t num_alignments = NumElemAlignBytes(bytes);
+        const std::size_t round_bytes = num_alignments * ELEM_ALIGN_BYTES;
+        m_used_bytes += round_bytes;
+        ListNode*& head = m_free_lists[num_alignments];
+        if (head != nullptr) {
+            ListNode* node = head;
+            head = node->m_next;
+            return node;
+        }
+        if (round_bytes > static_cast<std::size_t>(m_available_memory_end - m_available_memory_it))
+            AllocateChunk();
+        char* p = m_available_memory_it;
+        m_available_memory_it += round_bytes;
+        return p;
+    }
+
+    void Deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if (!IsFreeListUsable(bytes, alignment)) {
+            ::operator delete(p);
+            return;
+        }
+        const std::size_t num_alignments = NumElemAlignBytes(bytes);
+        m_used_bytes -= num_alignments * ELEM_ALIGN_BYTES;
+        AddToList(p, m_free_lists[num_alignments]);
+    }
+
+    std::size_t NumAllocatedChunks() const { return m_allocated_chunks.size(); }
+    std::size_t ChunkSizeBytes() const { return m_chunk_size_bytes; }
+    //! Bytes of the blocks in use, which is less than the chunks once blocks are freed
+    std::size_t UsedBytes() const { return m_used_bytes; }
+};
+
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+constexpr std::size_t PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>::ELEM_ALIGN_BYTES;
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+constexpr std::size_t PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>::DEFAULT_CHUNK_SIZE_BYTES;
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+constexpr std::size_t PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>::NUM_LISTS;
+
+/**
+ * Allocator taking its memory from a PoolResource, which has to outlive the
+ * containers using it. A default constructed allocator has no resource and
+ * uses the heap, like std::allocator.
+ */
+template <class T, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES = alignof(T)>
+class PoolAllocator
+{
+public:
+    typedef T value_type;
+    typedef PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES> ResourceType;
+
+    template <class U>
+    struct rebind {
+        typedef PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES> other;
+    };
+
+    PoolAllocator() noexcept : m_resource(nullptr) {}
+
+    //! Not explicit, so that containers can be constructed from a resource
+    PoolAllocator(ResourceType* resource) noexcept : m_resource(resource) {}
+
+    template <class U>
+    PoolAllocator(const PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& other) noexcept : m_resource(other.resource()) {}
+
+    T* allocate(std::size_t n)
+    {
+        if (m_resource == nullptr)
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(m_resource->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (m_resource == nullptr)
+            ::operator delete(p);
+        else
+            m_resource->Deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    ResourceType* resource() const noexcept { return m_resource; }
+
+private:
+    ResourceType* m_resource;
+};
+
+template <class T1, class T2, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+bool operator==(const PoolAllocator<T1, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& a,
+                const PoolAllocator<T2, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& b) noexcept
+{
+    return a.resource() == b.resource();
+}
+
+template <class T1, class T2, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+bool operator!=(const PoolAllocator<T1, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& a,
+                const PoolAllocator<T2, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& b) noexcept
+{
+    return !(a == b);
+}
+
+#endif // BITCOIN_SUPPORT_ALLOCATORS_POOL_H
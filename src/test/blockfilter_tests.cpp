@@ -0,0 +1,151 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilter.h"
+
+#include "coins.h"
+#include "hash.h"
+#include "primitives/block.h"
+#include "script/script.h"
+#include "streams.h"
+#include "undo.h"
+#include "version.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockfilter_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(gcsfilter_test)
+{
+    GCSFilter::ElementSet included;
+    for (int i = 0; i < 100; ++i) {
+        GCSFilter::Element element(32);
+        element[0] = i;
+        included.insert(std::move(element));
+    }
+
+    GCSFilter filter(GCSFilter::Params(0, 0, 10, 1 << 10), included);
+    for (const GCSFilter::Element& element : included) {
+        BOOST_CHECK(filter.Match(element));
+
+        GCSFilter::ElementSet single;
+        single.insert(element);
+        BOOST_CHECK(filter.MatchAny(single));
+    }
+    BOOST_CHECK(filter.MatchAny(included));
+
+    // Check the filter as it is transmitted, reconstructed from its encoding
+    GCSFilter filter2(filter.GetParams(), filter.GetEncoded());
+    BOOST_CHECK_EQUAL(filter2.GetN(), 100);
+    BOOST_CHECK(filter2.MatchAny(included));
+    BOOST_CHECK(filter2.GetEncoded() == filter.GetEncoded());
+
+    // An encoding with missing or extra data is rejected
+    std::vector<unsigned char> encoded = filter.GetEncoded();
+    encoded.push_back(0);
+    BOOST_CHECK_THROW(GCSFilter(filter.GetParams(), encoded), std::ios_base::failure);
+    encoded.resize(encoded.size() - 2);
+    BOOST_CHECK_THROW(GCSFilter(filter.GetParams(), encoded), std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_default_constructor)
+{
+    GCSFilter filter;
+    BOOST_CHECK_EQUAL(filter.GetN(), 0);
+    BOOST_CHECK_EQUAL(filter.GetEncoded().size(), 1);
+
+    const GCSFilter::Params& params = filter.GetParams();
+    BOOST_CHECK_EQUAL(params.nSipHashK0, 0);
+    BOOST_CHECK_EQUAL(params.nSipHashK1, 0);
+    BOOST_CHECK_EQUAL(params.nP, 0);
+    BOOST_CHECK_EQUAL(params.nM, 1);
+
+    BOOST_CHECK(!filter.Match(GCSFilter::Element(32)));
+}
+
+BOOST_AUTO_TEST_CASE(blockfilter_basic_test)
+{
+    CScript includedScript1 = CScript() << OP_1 << std::vector<unsigned char>(33, 1) << OP_1 << OP_CHECKMULTISIG;
+    CScript includedScript2 = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 2) << OP_EQUALVERIFY << OP_CHECKSIG;
+    CScript excludedScript = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 3) << OP_EQUALVERIFY << OP_CHECKSIG;
+    CScript spentScript = CScript() << OP_0 << std::vector<unsigned char>(32, 4);
+
+    std::vector<unsigned char> pubCoin(34, 5);
+    CScript sigmaMintScript = CScript() << OP_SIGMAMINT;
+    sigmaMintScript.insert(sigmaMintScript.end(), pubCoin.begin(), pubCoin.end());
+
+    std::vector<unsigned char> elysiumMarker = { 0x65, 0x78, 0x6f, 0x64, 0x75, 0x73 };
+    std::vector<unsigned char> elysiumPayload = elysiumMarker;
+    elysiumPayload.push_back(0x01);
+    CScript elysiumScript = CScript() << OP_RETURN << elysiumPayload;
+    CScript nullDataScript = CScript() << OP_RETURN << std::vector<unsigned char>(4, 6);
+
+    CMutableTransaction tx;
+    tx.vout.emplace_back(100, includedScript1);
+    tx.vout.emplace_back(200, includedScript2);
+    tx.vout.emplace_back(300, sigmaMintScript);
+    tx.vout.emplace_back(0, elysiumScript);
+    tx.vout.emplace_back(0, nullDataScript);
+    tx.vout.emplace_back(0, CScript());
+
+    CBlock block;
+    block.vtx.push_back(MakeTransactionRef(tx));
+
+    CBlockUndo blockUndo;
+    blockUndo.vtxundo.emplace_back();
+    blockUndo.vtxundo.back().vprevout.emplace_back(CTxOut(500, spentScript), 1000, true);
+
+    BlockFilter blockFilter(BlockFilterType::BASIC_FILTER, block, blockUndo);
+    const GCSFilter& filter = blockFilter.GetFilter();
+
+    BOOST_CHECK(filter.Match(GCSFilter::Element(includedScript1.begin(), includedScript1.end())));
+    BOOST_CHECK(filter.Match(GCSFilter::Element(includedScript2.begin(), includedScript2.end())));
+    BOOST_CHECK(filter.Match(GCSFilter::Element(spentScript.begin(), spentScript.end())));
+    BOOST_CHECK(filter.Match(pubCoin));
+    BOOST_CHECK(filter.Match(elysiumMarker));
+
+    BOOST_CHECK(!filter.Match(GCSFilter::Element(excludedScript.begin(), excludedScript.end())));
+    BOOST_CHECK(!filter.Match(GCSFilter::Element(sigmaMintScript.begin(), sigmaMintScript.end())));
+    BOOST_CHECK(!filter.Match(GCSFilter::Element(elysiumScript.begin(), elysiumScript.end())));
+    BOOST_CHECK(!filter.Match(GCSFilter::Element(nullDataScript.begin(), nullDataScript.end())));
+
+    // Two output scripts, the spent one, the public coin and the marker
+    BOOST_CHECK_EQUAL(filter.GetN(), 5);
+
+    // Serialization round trip, as in "cfilter" messages
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << blockFilter;
+
+    BlockFilter blockFilter2;
+    stream >> blockFilter2;
+
+    BOOST_CHECK(blockFilter2.GetFilterType() == blockFilter.GetFilterType());
+    BOOST_CHECK_EQUAL(blockFilter2.GetBlockHash(), blockFilter.GetBlockHash());
+    BOOST_CHECK(blockFilter2.GetEncodedFilter() == blockFilter.GetEncodedFilter());
+
+    // The header commits to the filter hash and the previous header
+    uint256 prevHeader = uint256S("0x1234");
+    uint256 filterHash = blockFilter.GetHash();
+    BOOST_CHECK_EQUAL(blockFilter.ComputeHeader(prevHeader), Hash(filterHash.begin(), filterHash.end(), prevHeader.begin(), prevHeader.end()));
+    BOOST_CHECK(blockFilter.ComputeHeader(prevHeader) != blockFilter.ComputeHeader(uint256()));
+
+    // An empty filter matches nothing
+    BlockFilter emptyFilter(BlockFilterType::BASIC_FILTER, block.GetHash(), GCSFilter().GetEncoded());
+    BOOST_CHECK_EQUAL(emptyFilter.GetFilter().GetN(), 0);
+    BOOST_CHECK(!emptyFilter.GetFilter().Match(pubCoin));
+}
+
+BOOST_AUTO_TEST_CASE(blockfilter_type_names)
+{
+    BOOST_CHECK_EQUAL(BlockFilterTypeName(BlockFilterType::BASIC_FILTER), "basic");
+    BOOST_CHECK_EQUAL(BlockFilterTypeName(static_cast<BlockFilterType>(5)), "");
+
+    BlockFilterType filterType;
+    BOOST_CHECK(BlockFilterTypeByName("basic", filterType));
+    BOOST_CHECK(filterType == BlockFilterType::BASIC_FILTER);
+    BOOST_CHECK(!BlockFilterTypeByName("unknown", filterType));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
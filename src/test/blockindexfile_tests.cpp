@@ -0,0 +1,90 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockindexfile.h"
+#include "chain.h"
+#include "random.h"
+#include "test/test_bitcoin.h"
+
+#include <map>
+#include <memory>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockindexfile_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(blockindexfile_roundtrip)
+{
+    boost::filesystem::path ph = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    CBlockIndexFile file(ph);
+
+    std::vector<uint256> vHashes(100);
+    std::vector<CBlockIndex> vIndex(vHashes.size());
+    std::vector<const CBlockIndex*> vpindex;
+    for (size_t i = 0; i < vIndex.size(); i++) {
+        vHashes[i] = GetRandHash();
+        CBlockIndex& index = vIndex[i];
+        index.phashBlock = &vHashes[i];
+        index.pprev = i > 0 ? &vIndex[i - 1] : NULL;
+        index.nHeight = i;
+        index.nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO;
+        index.nTx = i + 1;
+        index.nFile = i / 10;
+        index.nDataPos = 1000 * i + 8;
+        index.nUndoPos = 500 * i + 8;
+        index.nVersion = 0x20000000;
+        index.hashMerkleRoot = GetRandHash();
+        index.nTime = 1600000000 + 300 * i;
+        index.nBits = 0x1e0ffff0;
+        index.nNonce = GetRand(1 << 30);
+        index.nVersionMTP = 0x1000;
+        index.mtpHashValue = GetRandHash();
+        if (i % 7 == 0)
+            index.sigmaSpentSerials.emplace(Scalar(uint64_t(i + 1)), sigma::CSpendCoinInfo::make(sigma::CoinDenomination::SIGMA_DENOM_1, 1));
+        vpindex.push_back(&index);
+    }
+
+    uint256 token = GetRandHash();
+    BOOST_CHECK(file.Write(vpindex, token));
+
+    std::map<uint256, std::unique_ptr<CBlockIndex>> mapLoaded;
+    auto insertBlockIndex = [&mapLoaded](const uint256& hash) {
+        std::unique_ptr<CBlockIndex>& pindex = mapLoaded[hash];
+        if (!pindex)
+            pindex.reset(new CBlockIndex());
+        return pindex.get();
+    };
+
+    // A file written with another token is never used
+    std::vector<CBlockIndex*> vExtended;
+    BOOST_CHECK(!file.Load(GetRandHash(), insertBlockIndex, vExtended));
+    BOOST_CHECK(mapLoaded.empty());
+
+    BOOST_CHECK(file.Load(token, insertBlockIndex, vExtended));
+    BOOST_CHECK_EQUAL(mapLoaded.size(), vIndex.size());
+    BOOST_CHECK_EQUAL(vExtended.size(), (vIndex.size() + 6) / 7);
+    for (size_t i = 0; i < vIndex.size(); i++) {
+        const CBlockIndex& index = vIndex[i];
+        const CBlockIndex& loaded = *mapLoaded[vHashes[i]];
+        BOOST_CHECK(loaded.pprev == (i > 0 ? mapLoaded[vHashes[i - 1]].get() : NULL));
+        BOOST_CHECK_EQUAL(loaded.nHeight, index.nHeight);
+        BOOST_CHECK_EQUAL(loaded.nStatus, index.nStatus);
+        BOOST_CHECK_EQUAL(loaded.nTx, index.nTx);
+        BOOST_CHECK_EQUAL(loaded.nFile, index.nFile);
+        BOOST_CHECK_EQUAL(loaded.nDataPos, index.nDataPos);
+        BOOST_CHECK_EQUAL(loaded.nUndoPos, index.nUndoPos);
+        BOOST_CHECK_EQUAL(loaded.nVersion, index.nVersion);
+        BOOST_CHECK(loaded.hashMerkleRoot == index.hashMerkleRoot);
+        BOOST_CHECK_EQUAL(loaded.nTime, index.nTime);
+        BOOST_CHECK_EQUAL(loaded.nBits, index.nBits);
+        BOOST_CHECK_EQUAL(loaded.nNonce, index.nNonce);
+        BOOST_CHECK_EQUAL(loaded.nVersionMTP, index.nVersionMTP);
+        BOOST_CHECK(loaded.mtpHashValue == index.mtpHashValue);
+    }
+
+    boost::filesystem::remove(ph);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,82 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockprefetch.h"
+#include "chainparams.h"
+#include "random.h"
+#include "validation.h"
+
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockprefetch_tests, BasicTestingSetup)
+
+namespace {
+
+/** A chain of block indexes with data, forking from another one when pindexFork is given */
+struct CTestChain
+{
+    std::vector<uint256> vHashes;
+    std::vector<CBlockIndex> vIndexes;
+
+    CTestChain(int nLength, CBlockIndex* pindexFork = nullptr) : vHashes(nLength), vIndexes(nLength)
+    {
+        for (int i = 0; i < nLength; i++) {
+            vHashes[i] = GetRandHash();
+            CBlockIndex& index = vIndexes[i];
+            index.phashBlock = &vHashes[i];
+            index.pprev = i > 0 ? &vIndexes[i - 1] : pindexFork;
+            index.nHeight = index.pprev ? index.pprev->nHeight + 1 : 0;
+            index.nStatus = BLOCK_HAVE_DATA;
+            index.BuildSkip();
+        }
+    }
+
+    std::vector<const CBlockIndex*> Range(int nBegin, int nEnd) const
+    {
+        std::vector<const CBlockIndex*> vpindex;
+        for (int i = nBegin; i < nEnd; i++)
+            vpindex.push_back(&vIndexes[i]);
+        return vpindex;
+    }
+};
+
+} // anon namespace
+
+BOOST_AUTO_TEST_CASE(blockprefetch_prune)
+{
+    CTestChain chain(20);
+    CTestChain fork(10, &chain.vIndexes[9]);
+    CBlockPrefetcher prefetcher(Params().GetConsensus(), 2, 8);
+
+    LOCK(cs_main);
+    // Scheduling stops at the maximum, blocks already scheduled are skipped
+    prefetcher.Prefetch(chain.Range(10, 20));
+    BOOST_CHECK_EQUAL(prefetcher.InFlight(), 8);
+    prefetcher.Prefetch(chain.Range(10, 12));
+    BOOST_CHECK_EQUAL(prefetcher.InFlight(), 8);
+
+    // A block that was given instead of taken is dropped too
+    prefetcher.Forget(&chain.vIndexes[10]);
+    BOOST_CHECK_EQUAL(prefetcher.InFlight(), 7);
+
+    // Blocks at or below the tip are dropped
+    prefetcher.Prune(&chain.vIndexes[12], &chain.vIndexes[19]);
+    BOOST_CHECK_EQUAL(prefetcher.InFlight(), 5);
+
+    // After a reorg to the fork nothing of the old branch is kept, and the fork can be read
+    prefetcher.Prune(&chain.vIndexes[9], &fork.vIndexes[9]);
+    BOOST_CHECK_EQUAL(prefetcher.InFlight(), 0);
+    prefetcher.Prefetch(fork.Range(0, 10));
+    BOOST_CHECK_EQUAL(prefetcher.InFlight(), 8);
+    prefetcher.Prune(&chain.vIndexes[9], &fork.vIndexes[9]);
+    BOOST_CHECK_EQUAL(prefetcher.InFlight(), 8);
+
+    // Blocks that can't be read are taken as missing
+    BOOST_CHECK(!prefetcher.Take(&fork.vIndexes[0]));
+    BOOST_CHECK_EQUAL(prefetcher.InFlight(), 7);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,9 +4,11 @@
 
 #include "coins.h"
 #include "script/standard.h"
+#include "txdb.h"
 #include "uint256.h"
 #include "undo.h"
 #include "utilstrencodings.h"
+#include "utxostats.h"
 #include "test/test_bitcoin.h"
 #include "test/test_random.h"
 #include "validation.h"
@@ -848,4 +850,204 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_FIXTURE_TEST_CASE(ccoins_partial_flush, TestingSetup)
+{
+    CCoinsViewDB db(1 << 20, true, true);
+    const uint256 hashOld = GetRandHash();
+    const uint256 hashNew = GetRandHash();
+    std::vector<COutPoint> vOld, vNew;
+
+    CCoinsViewCache base(&db);
+    for (int i = 0; i < 10; i++) {
+        vOld.push_back(COutPoint(GetRandHash(), 0));
+        base.AddCoin(vOld.back(), Coin(CTxOut(1000 + i, CScript() << OP_TRUE), 1, false), false);
+    }
+    base.SetBestBlock(hashOld);
+    BOOST_CHECK(base.Flush());
+    BOOST_CHECK(db.GetBestBlock() == hashOld);
+    BOOST_CHECK(db.GetHeadBlocks().empty());
+
+    // Write the changes in batches of a few coins
+    ForceSetArg("-dbbatchsize", "256");
+    CCoinsViewCache cache(&db);
+    cache.SpendCoin(vOld[0]);
+    cache.SpendCoin(vOld[1]);
+    for (int i = 0; i < 200; i++) {
+        vNew.push_back(COutPoint(GetRandHash(), i));
+        cache.AddCoin(vNew.back(), Coin(CTxOut(2000 + i, CScript() << OP_TRUE), 2 + i, false), false);
+    }
+    cache.SetBestBlock(hashNew);
+
+    size_t nTarget = cache.DynamicMemoryUsage() / 2;
+    BOOST_CHECK(cache.PartialFlush(nTarget));
+    BOOST_CHECK(cache.DynamicMemoryUsage() <= nTarget);
+    BOOST_CHECK(cache.GetBestBlock() == hashNew);
+
+    // The best block stays where it was, the heads cover the partly written blocks
+    BOOST_CHECK(db.GetBestBlock() == hashOld);
+    std::vector<uint256> vHeads = db.GetHeadBlocks();
+    BOOST_CHECK_EQUAL(vHeads.size(), 2U);
+    BOOST_CHECK(vHeads[0] == hashNew);
+    BOOST_CHECK(vHeads[1] == hashOld);
+
+    // Spent coins are written first, then the oldest ones
+    BOOST_CHECK(!db.HaveCoin(vOld[0]));
+    BOOST_CHECK(!db.HaveCoin(vOld[1]));
+    BOOST_CHECK(db.HaveCoin(vNew[0]));
+    BOOST_CHECK(!db.HaveCoin(vNew.back()));
+    for (size_t i = 1; i < vNew.size(); i++) {
+        if (db.HaveCoin(vNew[i]))
+            BOOST_CHECK(db.HaveCoin(vNew[i - 1]));
+    }
+
+    // The cache still sees all of the coins
+    for (size_t i = 0; i < vNew.size(); i++) {
+        Coin coin;
+        BOOST_CHECK(cache.GetCoin(vNew[i], coin));
+        BOOST_CHECK_EQUAL((size_t)coin.nHeight, 2 + i);
+    }
+    BOOST_CHECK(!cache.HaveCoin(vOld[0]));
+    BOOST_CHECK(cache.HaveCoin(vOld[2]));
+
+    // A full flush finishes the write
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(db.GetBestBlock() == hashNew);
+    BOOST_CHECK(db.GetHeadBlocks().empty());
+    for (const COutPoint& outpoint : vNew)
+        BOOST_CHECK(db.HaveCoin(outpoint));
+    ForceSetArg("-dbbatchsize", std::to_string(nDefaultDbBatchSize));
+}
+
+BOOST_FIXTURE_TEST_CASE(ccoins_interrupted_replay, TestingSetup)
+{
+    CCoinsViewDB db(1 << 20, true, true);
+    const uint256 hashOld = GetRandHash();
+    const uint256 hashNew = GetRandHash();
+    std::vector<COutPoint> vNew;
+
+    CCoinsViewCache base(&db);
+    base.AddCoin(COutPoint(GetRandHash(), 0), Coin(CTxOut(1000, CScript() << OP_TRUE), 1, false), false);
+    base.SetBestBlock(hashOld);
+    BOOST_CHECK(base.Flush());
+
+    ForceSetArg("-dbbatchsize", "256");
+    {
+        // The node stops half way through a flush to hashNew
+        CCoinsViewCache cache(&db);
+        for (int i = 0; i < 200; i++) {
+            vNew.push_back(COutPoint(GetRandHash(), i));
+            cache.AddCoin(vNew.back(), Coin(CTxOut(2000 + i, CScript() << OP_TRUE), 2, false), false);
+        }
+        cache.SetBestBlock(hashNew);
+        BOOST_CHECK(cache.PartialFlush(cache.DynamicMemoryUsage() / 2));
+    }
+    std::vector<uint256> vHeads = db.GetHeadBlocks();
+    BOOST_CHECK_EQUAL(vHeads.size(), 2U);
+    BOOST_CHECK(vHeads[0] == hashNew);
+    BOOST_CHECK(vHeads[1] == hashOld);
+
+    {
+        // and again before the coins replayed back to hashOld are marked as flushed
+        CCoinsViewCache cache(&db);
+        size_t nWritten = 0;
+        for (const COutPoint& outpoint : vNew) {
+            nWritten += cache.HaveCoin(outpoint);
+            cache.SpendCoin(outpoint);
+        }
+        BOOST_CHECK(nWritten > 0);
+        BOOST_CHECK(cache.GetBestBlock() == hashOld);
+        BOOST_CHECK(cache.PartialFlush(0));
+    }
+    for (const COutPoint& outpoint : vNew)
+        BOOST_CHECK(!db.HaveCoin(outpoint));
+
+    // The heads still cover the first flush, so the next replay undoes all of it
+    vHeads = db.GetHeadBlocks();
+    BOOST_CHECK_EQUAL(vHeads.size(), 2U);
+    BOOST_CHECK(vHeads[0] == hashNew);
+    BOOST_CHECK(vHeads[1] == hashOld);
+    BOOST_CHECK(db.GetBestBlock() == hashOld);
+
+    {
+        // The replay completes
+        CCoinsViewCache cache(&db);
+        for (const COutPoint& outpoint : vNew)
+            cache.SpendCoin(outpoint);
+        BOOST_CHECK(cache.Flush());
+    }
+    BOOST_CHECK(db.GetHeadBlocks().empty());
+    BOOST_CHECK(db.GetBestBlock() == hashOld);
+    ForceSetArg("-dbbatchsize", std::to_string(nDefaultDbBatchSize));
+}
+
+static CUTXOStats ComputeUTXOStats(const std::map<COutPoint, Coin>& utxo)
+{
+    CUTXOStats stats;
+    for (const std::pair<const COutPoint, Coin>& entry : utxo)
+        stats.AddCoin(entry.first, entry.second);
+    return stats;
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_utxo_stats)
+{
+    // Statistics moved along with the changes of caches match the ones of the whole set
+    CCoinsViewTest viewTest;
+    CCoinsViewCache base(&viewTest);
+    std::map<COutPoint, Coin> utxo;
+    CUTXOStats stats;
+    const uint256 hashEmpty = stats.GetMuHash();
+
+    for (int nBlock = 1; nBlock <= 20; nBlock++) {
+        CCoinsViewCache cache(&base);
+        for (int i = 0; i < 50; i++) {
+            int nOp = insecure_rand() % 4;
+            if (nOp == 0 || utxo.empty()) {
+                COutPoint outpoint(GetRandHash(), i);
+                Coin coin(CTxOut(insecure_rand() % 1000000, CScript() << OP_TRUE), nBlock, i == 0);
+                utxo[outpoint] = coin;
+                cache.AddCoin(outpoint, std::move(coin), false);
+                continue;
+            }
+            std::map<COutPoint, Coin>::iterator it = utxo.begin();
+            std::advance(it, insecure_rand() % utxo.size());
+            if (nOp == 1) {
+                cache.SpendCoin(it->first);
+                utxo.erase(it);
+            } else if (nOp == 2) {
+                Coin coin(CTxOut(insecure_rand() % 1000000, CScript() << OP_2), nBlock, false);
+                it->second = coin;
+                cache.AddCoin(it->first, std::move(coin), true);
+            } else {
+                // Created and spent in the same block
+                COutPoint outpoint(GetRandHash(), i);
+                cache.AddCoin(outpoint, Coin(CTxOut(1, CScript() << OP_TRUE), nBlock, false), false);
+                cache.SpendCoin(outpoint);
+            }
+        }
+        stats.ApplyChanges(cache);
+        BOOST_CHECK(cache.Flush());
+
+        CUTXOStats expected = ComputeUTXOStats(utxo);
+        BOOST_CHECK_EQUAL(stats.nTransactionOutputs, utxo.size());
+        BOOST_CHECK_EQUAL(stats.nTransactionOutputs, expected.nTransactionOutputs);
+        BOOST_CHECK_EQUAL(stats.nBogoSize, expected.nBogoSize);
+        BOOST_CHECK_EQUAL(stats.nTotalAmount, expected.nTotalAmount);
+        BOOST_CHECK(stats.GetMuHash() == expected.GetMuHash());
+    }
+
+    // The stored statistics carry on with the same hash
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << stats;
+    CUTXOStats statsRead;
+    ss >> statsRead;
+    BOOST_CHECK(statsRead.GetMuHash() == stats.GetMuHash());
+
+    // Removing every coin gets back to the empty set
+    for (const std::pair<const COutPoint, Coin>& entry : utxo)
+        statsRead.RemoveCoin(entry.first, entry.second);
+    BOOST_CHECK_EQUAL(statsRead.nTransactionOutputs, 0U);
+    BOOST_CHECK_EQUAL(statsRead.nTotalAmount, 0);
+    BOOST_CHECK(statsRead.GetMuHash() == hashEmpty);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "dandelion.h"
+#include "random.h"
+#include "test/test_bitcoin.h"
+#include "test/test_random.h"
+
+#include <map>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(dandelion_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(embargo_wheel_expiry)
+{
+    const int64_t nTick = CDandelionEmbargoWheel::TICK_MICROS;
+    CDandelionEmbargoWheel wheel;
+    int64_t nNow = 1600000000LL * 1000000;
+
+    uint256 hashSoon = GetRandHash(), hashLater = GetRandHash(), hashRemoved = GetRandHash();
+    BOOST_CHECK(wheel.Insert(hashSoon, nNow + 10 * 1000000, nNow));
+    BOOST_CHECK(wheel.Insert(hashLater, nNow + 3 * 3600 * 1000000LL, nNow));
+    BOOST_CHECK(wheel.Insert(hashRemoved, nNow + 5 * 1000000, nNow));
+    BOOST_CHECK(!wheel.Insert(hashSoon, nNow + 20 * 1000000, nNow));
+    BOOST_CHECK_EQUAL(wheel.Size(), 3U);
+
+    BOOST_CHECK(wheel.Remove(hashRemoved));
+    BOOST_CHECK(!wheel.Contains(hashRemoved));
+    BOOST_CHECK(wheel.PopExpired(nNow + 9 * 1000000).empty());
+
+    std::vector<uint256> vExpired = wheel.PopExpired(nNow + 10 * 1000000);
+    BOOST_CHECK(vExpired.size() == 1 && vExpired[0] == hashSoon);
+    BOOST_CHECK(wheel.PopExpired(nNow + 3 * 3600 * 1000000LL - nTick).empty());
+    vExpired = wheel.PopExpired(nNow + 3 * 3600 * 1000000LL);
+    BOOST_CHECK(vExpired.size() == 1 && vExpired[0] == hashLater);
+    BOOST_CHECK_EQUAL(wheel.Size(), 0U);
+    BOOST_CHECK_EQUAL(wheel.GetStats().nExpired, 2U);
+    BOOST_CHECK_EQUAL(wheel.GetStats().nRemoved, 1U);
+}
+
+BOOST_AUTO_TEST_CASE(embargo_wheel_random)
+{
+    // Compare against a plain map, with embargoes spread over all levels of the wheel
+    const int64_t nTick = CDandelionEmbargoWheel::TICK_MICROS;
+    CDandelionEmbargoWheel wheel;
+    std::map<uint256, int64_t> mapDue;
+    int64_t nNow = 1600000000LL * 1000000;
+
+    for (int i = 0; i < 5000; i++) {
+        int nAction = insecure_rand() % 10;
+        if (nAction < 4) {
+            uint256 hash = GetRandHash();
+            int64_t nEmbargo = nNow + (insecure_rand() % 3 == 0 ? (int64_t)(insecure_rand() % 20000) * 1000000 : (int64_t)(insecure_rand() % 60000000));
+            BOOST_CHECK(wheel.Insert(hash, nEmbargo, nNow));
+            mapDue[hash] = nEmbargo;
+        } else if (nAction < 5 && !mapDue.empty()) {
+            auto it = mapDue.lower_bound(GetRandHash());
+            if (it == mapDue.end())
+                it = mapDue.begin();
+            BOOST_CHECK(wheel.Remove(it->first));
+            mapDue.erase(it);
+        } else {
+            nNow += insecure_rand() % 5 == 0 ? (int64_t)(insecure_rand() % 100000) * 10000 : insecure_rand() % 300000;
+            std::vector<uint256> vExpired = wheel.PopExpired(nNow);
+            std::set<uint256> setExpired(vExpired.begin(), vExpired.end());
+            for (auto it = mapDue.begin(); it != mapDue.end();) {
+                bool fExpired = setExpired.count(it->first) != 0;
+                // Never early, and at most one tick late
+                BOOST_CHECK(!fExpired || it->second <= nNow);
+                BOOST_CHECK(fExpired || it->second > nNow - nTick);
+                it = fExpired ? mapDue.erase(it) : std::next(it);
+            }
+            BOOST_CHECK_EQUAL(wheel.Size(), mapDue.size());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,7 @@
 #include "test/test_bitcoin.h"
 
 #include <boost/assign/std/vector.hpp> // for 'operator+=()'
+#include <boost/filesystem/fstream.hpp>
 #include <boost/assert.hpp>
 #include <boost/test/unit_test.hpp>
 
@@ -122,6 +123,34 @@ BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
     }
 }
 
+// Test copying entries as raw data between databases with different obfuscation keys
+BOOST_AUTO_TEST_CASE(dbwrapper_raw_copy)
+{
+    for (int i = 0; i < 2; i++) {
+        bool obfuscate = (bool)i;
+        boost::filesystem::path ph = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        boost::filesystem::path ph2 = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        CDBWrapper dbw(ph, (1 << 20), true, false, obfuscate);
+        CDBWrapper dbw2(ph2, (1 << 20), true, false, true);
+
+        char key = 'j';
+        uint256 in = GetRandHash();
+        BOOST_CHECK(dbw.Write(key, in));
+
+        std::unique_ptr<CDBIterator> it(const_cast<CDBWrapper*>(&dbw)->NewIterator());
+        it->Seek(key);
+        BOOST_CHECK(it->Valid());
+
+        CDBBatch batch(dbw2);
+        batch.Write(it->GetKey(), it->GetValue());
+        BOOST_CHECK(dbw2.WriteBatch(batch));
+
+        uint256 res;
+        BOOST_CHECK(dbw2.Read(key, res));
+        BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
+    }
+}
+
 // Test that we do not obfuscation if there is existing data.
 BOOST_AUTO_TEST_CASE(existing_data_no_obfuscate)
 {
@@ -320,4 +349,76 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
 
 
 
+BOOST_AUTO_TEST_CASE(dbwrapper_profiles)
+{
+    DBProfile profile;
+    for (DBProfile p : {DBProfile::DEFAULT, DBProfile::POINT_LOOKUP, DBProfile::SCAN}) {
+        BOOST_CHECK(DBProfileFromString(DBProfileToString(p), profile));
+        BOOST_CHECK(profile == p);
+    }
+    BOOST_CHECK(!DBProfileFromString("unknown", profile));
+
+    boost::filesystem::path ph = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    {
+        CDBWrapper dbw(ph, (1 << 20), false, false, false, DBProfile::SCAN, "profiletest");
+        char key = 'k';
+        uint256 in = GetRandHash();
+        uint256 res;
+        BOOST_CHECK(dbw.Write(key, in));
+        BOOST_CHECK(dbw.Read(key, res));
+
+        int nFound = 0;
+        for (const CDBStats& stats : GetDBStats()) {
+            if (stats.name != "profiletest")
+                continue;
+            nFound++;
+            BOOST_CHECK(stats.profile == DBProfile::SCAN);
+            BOOST_CHECK(stats.nCacheCapacity > 0);
+        }
+        BOOST_CHECK_EQUAL(nFound, 1);
+    }
+
+    // Closed databases are no longer reported
+    for (const CDBStats& stats : GetDBStats())
+        BOOST_CHECK(stats.name != "profiletest");
+}
+
+static int GetDBMaxOpenFiles(const std::string& name)
+{
+    for (const CDBStats& stats : GetDBStats()) {
+        if (stats.name == name)
+            return stats.nMaxOpenFiles;
+    }
+    return -1;
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_open_files)
+{
+    boost::filesystem::path ph = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    SetDBExtraOpenFiles(100);
+    {
+        // The extra open files are handed out while some are left
+        CDBWrapper dbw1(ph / "1", (1 << 20), false, false, false, DBProfile::POINT_LOOKUP, "openfiles1");
+        BOOST_CHECK_EQUAL(GetDBMaxOpenFiles("openfiles1"), DB_DEFAULT_MAX_OPEN_FILES + 100);
+        {
+            CDBWrapper dbw2(ph / "2", (1 << 20), false, false, false, DBProfile::POINT_LOOKUP, "openfiles2");
+            BOOST_CHECK_EQUAL(GetDBMaxOpenFiles("openfiles2"), DB_DEFAULT_MAX_OPEN_FILES);
+        }
+    }
+    {
+        // and given back when a database is closed
+        CDBWrapper dbw3(ph / "3", (1 << 20), false, false, false, DBProfile::SCAN, "openfiles3");
+        BOOST_CHECK_EQUAL(GetDBMaxOpenFiles("openfiles3"), 128);
+    }
+    {
+        // or when it fails to open, a file is in the way of its directory
+        boost::filesystem::create_directories(ph);
+        boost::filesystem::ofstream(ph / "4");
+        BOOST_CHECK_THROW(CDBWrapper(ph / "4", (1 << 20), false, false, false, DBProfile::POINT_LOOKUP, "openfiles4"), std::exception);
+        CDBWrapper dbw5(ph / "5", (1 << 20), false, false, false, DBProfile::POINT_LOOKUP, "openfiles5");
+        BOOST_CHECK_EQUAL(GetDBMaxOpenFiles("openfiles5"), DB_DEFAULT_MAX_OPEN_FILES + 100);
+    }
+    SetDBExtraOpenFiles(DB_EXTRA_OPEN_FILES);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -312,4 +312,12 @@ CPubKey LelantusTestingSetup::GenerateAddress() {
 
 LelantusTestingSetup::~LelantusTestingSetup() {
     lelantus::CLelantusState::GetState()->Reset();
-}
\ No newline at end of file
+}
+
+void SetSigmaSpends(sigma::CSigmaState *sigmaState, sigma::spend_info_container const &spends) {
+    sigma::spend_info_container current = sigmaState->GetSpends();
+    for (auto const &spend : current)
+        sigmaState->containers.RemoveSpend(spend.first);
+    for (auto const &spend : spends)
+        sigmaState->containers.AddSpend(spend.first, spend.second);
+}
@@ -5,6 +5,7 @@
 #include "test/testutil.h"
 #include "consensus/params.h"
 #include "liblelantus/coin.h"
+#include "sigma.h"
 
 #include <boost/test/unit_test.hpp>
 
@@ -78,6 +79,9 @@ public:
     CScript script;
 };
 
+// Replace the used coin serials of the state through its containers, so that their indexes stay consistent
+void SetSigmaSpends(sigma::CSigmaState *sigmaState, sigma::spend_info_container const &spends);
+
 // for the duration of the test set network type to testnet
 class FakeTestnet {
     Consensus::Params &params;
@@ -0,0 +1,75 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainparams.h"
+#include "chainparamsbase.h"
+#include "crypto/Lyra2Z/Lyra2Z.h"
+#include "primitives/block.h"
+#include "random.h"
+#include "validation.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(lyra2z_tests, BasicTestingSetup)
+
+static CBlockHeader RandomHeader(uint32_t nTime)
+{
+    CBlockHeader header;
+    header.nVersion = GetRand(0x7fffffff);
+    header.hashPrevBlock = GetRandHash();
+    header.hashMerkleRoot = GetRandHash();
+    header.nTime = nTime;
+    header.nBits = 0x1e0ffff0;
+    header.nNonce = GetRand(0xffffffff);
+    return header;
+}
+
+BOOST_AUTO_TEST_CASE(lyra2z_implementations)
+{
+    // Genesis block hashes are the reference vectors, plus random headers hashed by the generic code
+    std::vector<std::pair<CBlockHeader, uint256>> vectors;
+    for (const std::string& chain : {CBaseChainParams::MAIN, CBaseChainParams::TESTNET, CBaseChainParams::REGTEST}) {
+        const CChainParams& params = Params(chain);
+        vectors.emplace_back(params.GenesisBlock().GetBlockHeader(), params.GetConsensus().hashGenesisBlock);
+    }
+    BOOST_CHECK(lyra2z_select(LYRA2Z_IMPL_GENERIC));
+    for (int i = 0; i < 50; i++) {
+        CBlockHeader header = RandomHeader(GetRand(SWITCH_TO_MTP_BLOCK_HEADER));
+        vectors.emplace_back(header, header.GetHash());
+    }
+
+    for (int impl : {LYRA2Z_IMPL_GENERIC, LYRA2Z_IMPL_SSE2, LYRA2Z_IMPL_AVX2}) {
+        if (!lyra2z_supported(impl)) {
+            BOOST_CHECK(!lyra2z_select(impl));
+            continue;
+        }
+        BOOST_CHECK(lyra2z_select(impl));
+        for (const auto& vector : vectors)
+            BOOST_CHECK_EQUAL(vector.first.GetHash().GetHex(), vector.second.GetHex());
+    }
+
+    lyra2z_autodetect();
+}
+
+BOOST_AUTO_TEST_CASE(lyra2z_header_hashes)
+{
+    // Enough headers to be hashed on several threads, half of them after the switch to MTP
+    std::vector<CBlockHeader> headers;
+    for (int i = 0; i < 1000; i++)
+        headers.push_back(RandomHeader(i % 2 == 0 ? SWITCH_TO_MTP_BLOCK_HEADER - 1 - i : SWITCH_TO_MTP_BLOCK_HEADER + i));
+
+    for (size_t nCount : {(size_t)0, (size_t)1, (size_t)10, headers.size()}) {
+        std::vector<CBlockHeader> batch(headers.begin(), headers.begin() + nCount);
+        std::vector<uint256> hashes = GetBlockHeaderHashes(batch);
+        BOOST_CHECK_EQUAL(hashes.size(), nCount);
+        for (size_t i = 0; i < nCount; i++) {
+            BOOST_CHECK(hashes[i] == batch[i].GetHash());
+            // The proof of work hash of pre-MTP headers is cached, MTP ones have their own
+            BOOST_CHECK(batch[i].cachedPoWHash == (batch[i].IsMTP() ? uint256() : hashes[i]));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "metrics.h"
+
+#include "test/test_bitcoin.h"
+
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(metrics_tests, BasicTestingSetup)
+
+static const CMetricSnapshot* FindMetric(const std::vector<CMetricSnapshot>& vSnapshots, const std::string& name, const std::string& labelValue = "")
+{
+    for (const CMetricSnapshot& snapshot : vSnapshots) {
+        if (snapshot.name == name && snapshot.labelValue == labelValue)
+            return &snapshot;
+    }
+    return nullptr;
+}
+
+BOOST_AUTO_TEST_CASE(metrics_counter_threads)
+{
+    CMetricCounter counter("test_counter_total", "Test counter");
+    std::vector<std::thread> threads;
+    for (int n = 0; n < 8; n++) {
+        threads.emplace_back([&counter] {
+            for (int i = 0; i < 10000; i++)
+                counter.Inc();
+            counter.Inc(5);
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    // The shards of every thread are summed
+    BOOST_CHECK_EQUAL(counter.Value(), 8 * 10005);
+
+    std::vector<CMetricSnapshot> vSnapshots = GetMetricsSnapshot();
+    const CMetricSnapshot* snapshot = FindMetric(vSnapshots, "test_counter_total");
+    BOOST_REQUIRE(snapshot);
+    BOOST_CHECK(snapshot->type == MetricType::COUNTER);
+    BOOST_CHECK_EQUAL(snapshot->value, 8 * 10005);
+}
+
+BOOST_AUTO_TEST_CASE(metrics_gauge_function)
+{
+    CMetricGauge gauge("test_gauge", "Test gauge");
+    gauge.Set(10);
+    gauge.Add(-3);
+    BOOST_CHECK_EQUAL(gauge.Value(), 7);
+
+    int64_t nValue = 42;
+    CMetricFunction function("test_function", "Test function", MetricType::GAUGE, [&nValue] { return (double)nValue; });
+
+    std::vector<CMetricSnapshot> vSnapshots = GetMetricsSnapshot();
+    BOOST_REQUIRE(FindMetric(vSnapshots, "test_gauge"));
+    BOOST_CHECK_EQUAL(FindMetric(vSnapshots, "test_gauge")->value, 7);
+    BOOST_REQUIRE(FindMetric(vSnapshots, "test_function"));
+    BOOST_CHECK_EQUAL(FindMetric(vSnapshots, "test_function")->value, 42);
+
+    // A function is evaluated when the metrics are read
+    nValue = 43;
+    vSnapshots = GetMetricsSnapshot();
+    BOOST_REQUIRE(FindMetric(vSnapshots, "test_function"));
+    BOOST_CHECK_EQUAL(FindMetric(vSnapshots, "test_function")->value, 43);
+}
+
+BOOST_AUTO_TEST_CASE(metrics_histogram)
+{
+    CMetricHistogram histogram("test_seconds", "Test histogram", "step", "a");
+    histogram.Observe(50);
+    histogram.Observe(100);
+    histogram.Observe(101);
+    histogram.Observe(20000000);
+
+    std::vector<CMetricSnapshot> vSnapshots = GetMetricsSnapshot();
+    const CMetricSnapshot* snapshot = FindMetric(vSnapshots, "test_seconds", "a");
+    BOOST_REQUIRE(snapshot);
+    BOOST_CHECK(snapshot->type == MetricType::HISTOGRAM);
+    BOOST_CHECK_EQUAL(snapshot->nCount, 4);
+    BOOST_CHECK_CLOSE(snapshot->sum, 20.000251, 0.0001);
+
+    // The counts are cumulative and the bounds inclusive, the last observation is above every bound
+    BOOST_REQUIRE_EQUAL(snapshot->vCumulativeCounts.size(), METRIC_LATENCY_BUCKETS - 1);
+    BOOST_CHECK_EQUAL(snapshot->vCumulativeCounts[0], 2);
+    BOOST_CHECK_EQUAL(snapshot->vCumulativeCounts[1], 3);
+    BOOST_CHECK_EQUAL(snapshot->vCumulativeCounts.back(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(metrics_unregister)
+{
+    {
+        CMetricCounter counter("test_unregistered_total", "Test counter");
+        BOOST_CHECK(FindMetric(GetMetricsSnapshot(), "test_unregistered_total"));
+    }
+    BOOST_CHECK(!FindMetric(GetMetricsSnapshot(), "test_unregistered_total"));
+}
+
+BOOST_AUTO_TEST_CASE(metrics_prometheus_format)
+{
+    std::vector<CMetricSnapshot> vSnapshots(3);
+    vSnapshots[0].name = "test_requests_total";
+    vSnapshots[0].help = "Requests";
+    vSnapshots[0].type = MetricType::COUNTER;
+    vSnapshots[0].labelName = "result";
+    vSnapshots[0].labelValue = "ok";
+    vSnapshots[0].value = 3;
+    vSnapshots[1] = vSnapshots[0];
+    vSnapshots[1].labelValue = "failed";
+    vSnapshots[1].value = 1;
+    vSnapshots[2].name = "test_seconds";
+    vSnapshots[2].help = "Latency";
+    vSnapshots[2].type = MetricType::HISTOGRAM;
+    vSnapshots[2].vCumulativeCounts.assign(METRIC_LATENCY_BUCKETS - 1, 2);
+    vSnapshots[2].vCumulativeCounts[0] = 1;
+    vSnapshots[2].nCount = 3;
+    vSnapshots[2].sum = 12.5;
+
+    std::string str = FormatMetricsPrometheus(vSnapshots);
+
+    // The help and type of a family are given once
+    BOOST_CHECK_EQUAL(str.find("# HELP test_requests_total Requests\n# TYPE test_requests_total counter\n"
+                               "test_requests_total{result=\"ok\"} 3\ntest_requests_total{result=\"failed\"} 1\n"), 0);
+    BOOST_CHECK(str.find("# TYPE test_seconds histogram\ntest_seconds_bucket{le=\"0.0001\"} 1\ntest_seconds_bucket{le=\"0.00025\"} 2\n") != std::string::npos);
+    BOOST_CHECK(str.find("test_seconds_bucket{le=\"10\"} 2\ntest_seconds_bucket{le=\"+Inf\"} 3\ntest_seconds_sum 12.500000\ntest_seconds_count 3\n") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
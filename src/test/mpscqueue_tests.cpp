@@ -0,0 +1,129 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "asynclog.h"
+#include "mpscqueue.h"
+#include "util.h"
+
+#include "test/test_bitcoin.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(mpscqueue_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(mpscqueue_push_pop)
+{
+    CBoundedMPSCQueue<std::string> queue(3);
+    BOOST_CHECK_EQUAL(queue.Capacity(), 4);
+    BOOST_CHECK(queue.Empty());
+
+    std::string str;
+    BOOST_CHECK(!queue.TryPop(str));
+
+    // Values are popped in the order they are pushed, around the ring several times
+    for (int nLap = 0; nLap < 3; nLap++) {
+        for (int i = 0; i < 4; i++)
+            BOOST_CHECK(queue.TryPush(strprintf("%d-%d", nLap, i)));
+
+        str = "kept";
+        BOOST_CHECK(!queue.TryPush(std::move(str)));
+        BOOST_CHECK_EQUAL(str, "kept");
+
+        for (int i = 0; i < 4; i++) {
+            BOOST_CHECK(!queue.Empty());
+            BOOST_CHECK(queue.TryPop(str));
+            BOOST_CHECK_EQUAL(str, strprintf("%d-%d", nLap, i));
+        }
+        BOOST_CHECK(queue.Empty());
+        BOOST_CHECK(!queue.TryPop(str));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mpscqueue_producers)
+{
+    const int nProducers = 4;
+    const int nPerProducer = 10000;
+    CBoundedMPSCQueue<int> queue(64);
+
+    std::vector<std::thread> producers;
+    for (int n = 0; n < nProducers; n++) {
+        producers.emplace_back([&queue, n] {
+            for (int i = 0; i < nPerProducer; i++) {
+                int value = n * nPerProducer + i;
+                while (!queue.TryPush(std::move(value)))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // Every value is popped once, and the values of each producer in order
+    std::vector<int> vLast(nProducers, -1);
+    int nPopped = 0;
+    while (nPopped < nProducers * nPerProducer) {
+        int value;
+        if (!queue.TryPop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        int n = value / nPerProducer;
+        BOOST_CHECK_EQUAL(value % nPerProducer, vLast[n] + 1);
+        vLast[n] = value % nPerProducer;
+        nPopped++;
+    }
+    for (std::thread& producer : producers)
+        producer.join();
+
+    BOOST_CHECK(queue.Empty());
+    for (int n = 0; n < nProducers; n++)
+        BOOST_CHECK_EQUAL(vLast[n], nPerProducer - 1);
+}
+
+namespace {
+
+class CTestLogSink : public CLogSink
+{
+public:
+    std::mutex mutex;
+    std::string strWritten;
+    int nWrites = 0;
+
+    std::string Stamp(const std::string& str, int64_t nTimeMicros) override
+    {
+        return strprintf("%d ", nTimeMicros) + str;
+    }
+
+    int Write(const std::string& str) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        strWritten += str;
+        nWrites++;
+        return str.size();
+    }
+};
+
+} // anon namespace
+
+BOOST_AUTO_TEST_CASE(asynclog_write)
+{
+    CTestLogSink sink;
+    BOOST_CHECK(!AsyncLogPush(&sink, 1, "not queued\n", std::function<std::string()>()));
+
+    StartAsyncLogging(1024);
+    BOOST_CHECK(AsyncLogPush(&sink, 1, "first\n", std::function<std::string()>()));
+    BOOST_CHECK(AsyncLogPush(&sink, 2, std::string(), MakeDeferredLogFormat("%s %d\n", "deferred", 2)));
+    BOOST_CHECK(AsyncLogPush(&sink, 3, "last\n", std::function<std::string()>()));
+    StopAsyncLogging();
+
+    // The queued messages are written on stop, the deferred one formatted by the logging thread
+    BOOST_CHECK_EQUAL(sink.strWritten, "1 first\n2 deferred 2\n3 last\n");
+    BOOST_CHECK(sink.nWrites >= 1 && sink.nWrites <= 3);
+    BOOST_CHECK(!AsyncLogPush(&sink, 4, "not queued\n", std::function<std::string()>()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
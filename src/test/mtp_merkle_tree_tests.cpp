@@ -0,0 +1,168 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/MerkleTreeProof/merkle-tree.hpp"
+#include "random.h"
+#include "test/test_bitcoin.h"
+#include "test/test_random.h"
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+typedef MerkleTree::Buffer Buffer;
+typedef MerkleTree::Elements Elements;
+
+Buffer RandomElement()
+{
+    Buffer element(MERKLE_TREE_ELEMENT_SIZE_B);
+    GetRandBytes(element.data(), element.size());
+    return element;
+}
+
+// Older version of the tree, a vector of hashes per layer, for comparison.
+std::vector<Elements> BuildLayers(Elements elements, bool preserveOrder)
+{
+    if (!preserveOrder) {
+        std::sort(elements.begin(), elements.end());
+        elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
+    }
+    std::vector<Elements> layers(1, elements);
+    while (layers.back().size() > 1) {
+        const Elements previous = layers.back();
+        Elements current;
+        for (size_t i = 0; i + 1 < previous.size(); i += 2)
+            current.push_back(MerkleTree::combinedHash(previous[i], previous[i + 1], preserveOrder));
+        if (previous.size() & 1)
+            current.push_back(previous.back());
+        layers.push_back(current);
+    }
+    return layers;
+}
+
+Elements LayersProof(const std::vector<Elements>& layers, size_t index)
+{
+    Elements proof;
+    for (const Elements& layer : layers) {
+        if ((index ^ 1) < layer.size())
+            proof.push_back(layer[index ^ 1]);
+        index /= 2;
+    }
+    return proof;
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(mtp_merkle_tree_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(mtp_merkle_tree_layers)
+{
+    for (size_t nSize = 1; nSize <= 70; nSize++) {
+        Elements elements;
+        for (size_t i = 0; i < nSize; i++)
+            elements.push_back(RandomElement());
+        if (nSize > 3)
+            elements[2] = elements[1]; // duplicates are ignored by unordered trees
+
+        for (bool fPreserveOrder : {true, false}) {
+            std::vector<Elements> layers = BuildLayers(elements, fPreserveOrder);
+            MerkleTree tree(elements, fPreserveOrder);
+            BOOST_CHECK(tree.getRoot() == layers.back()[0]);
+            for (size_t i = 0; i < layers[0].size(); i++) {
+                if (fPreserveOrder) {
+                    BOOST_CHECK(tree.getProofOrdered(layers[0][i], i + 1) == LayersProof(layers, i));
+                } else {
+                    Elements proof = tree.getProof(layers[0][i]);
+                    BOOST_CHECK(proof == LayersProof(layers, i));
+                    BOOST_CHECK(MerkleTree::checkProof(proof, tree.getRoot(), layers[0][i]));
+                }
+            }
+        }
+
+        // The leaves can be given as contiguous bytes
+        std::vector<uint8_t> leaves;
+        for (const Buffer& element : elements)
+            leaves.insert(leaves.end(), element.begin(), element.end());
+        BOOST_CHECK(MerkleTree(std::move(leaves)).getRoot() == MerkleTree(elements, true).getRoot());
+    }
+
+    BOOST_CHECK_THROW(MerkleTree(std::vector<uint8_t>()), std::runtime_error);
+    BOOST_CHECK_THROW(MerkleTree(std::vector<uint8_t>(MERKLE_TREE_ELEMENT_SIZE_B + 1)), std::runtime_error);
+    BOOST_CHECK_THROW(MerkleTree(Elements(3, Buffer()), true), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(mtp_merkle_tree_batch_proofs)
+{
+    // MTP trees have a power of 2 number of leaves, every opening of those is valid
+    const size_t nSize = 256;
+    Elements elements;
+    for (size_t i = 0; i < nSize; i++)
+        elements.push_back(RandomElement());
+    MerkleTree tree(elements, true);
+    const Buffer root = tree.getRoot();
+
+    // Openings share their upper paths, some of them are the same
+    std::vector<Elements> proofs(200);
+    std::vector<MerkleTree::OrderedProof> openings;
+    for (size_t i = 0; i < proofs.size(); i++) {
+        size_t index = (i % 3 == 0) ? (i % 7) : insecure_rand() % nSize;
+        proofs[i] = tree.getProofOrdered(elements[index], index + 1);
+        BOOST_CHECK(MerkleTree::checkProofOrdered(proofs[i], root, elements[index], index + 1));
+        openings.push_back({&proofs[i], elements[index], index + 1});
+    }
+    size_t nInvalid = openings.size();
+    BOOST_CHECK(MerkleTree::checkProofsOrdered(openings, root, &nInvalid));
+    BOOST_CHECK_EQUAL(nInvalid, openings.size());
+    BOOST_CHECK(MerkleTree::checkProofsOrdered(std::vector<MerkleTree::OrderedProof>(), root));
+
+    // The first invalid opening is reported, whatever is wrong in it
+    std::vector<MerkleTree::OrderedProof> tampered = openings;
+    tampered[150].element = RandomElement();
+    tampered[170].index = (tampered[170].index % nSize) + 1;
+    BOOST_CHECK(!MerkleTree::checkProofsOrdered(tampered, root, &nInvalid));
+    BOOST_CHECK_EQUAL(nInvalid, 150U);
+
+    tampered = openings;
+    Elements badProof = proofs[42];
+    badProof[3][0] ^= 1;
+    tampered[42].proof = &badProof;
+    BOOST_CHECK(!MerkleTree::checkProofsOrdered(tampered, root, &nInvalid));
+    BOOST_CHECK_EQUAL(nInvalid, 42U);
+
+    // Hashes of another size don't go through the batches, and can't match
+    tampered = openings;
+    Elements shortProof = proofs[7];
+    shortProof[0].pop_back();
+    tampered[7].proof = &shortProof;
+    BOOST_CHECK(!MerkleTree::checkProofsOrdered(tampered, root, &nInvalid));
+    BOOST_CHECK_EQUAL(nInvalid, 7U);
+}
+
+BOOST_AUTO_TEST_CASE(mtp_merkle_tree_batch_matches_single)
+{
+    // Trees of other sizes: the batch agrees with the single proof checks
+    for (size_t nSize : {3, 5, 12, 21, 100}) {
+        Elements elements;
+        for (size_t i = 0; i < nSize; i++)
+            elements.push_back(RandomElement());
+        MerkleTree tree(elements, true);
+
+        std::vector<Elements> proofs(nSize);
+        std::vector<MerkleTree::OrderedProof> openings;
+        size_t nFirstInvalid = nSize;
+        for (size_t i = 0; i < nSize; i++) {
+            proofs[i] = tree.getProofOrdered(elements[i], i + 1);
+            openings.push_back({&proofs[i], elements[i], i + 1});
+            if (nFirstInvalid == nSize && !MerkleTree::checkProofOrdered(proofs[i], tree.getRoot(), elements[i], i + 1))
+                nFirstInvalid = i;
+        }
+        size_t nInvalid = nSize;
+        BOOST_CHECK_EQUAL(MerkleTree::checkProofsOrdered(openings, tree.getRoot(), &nInvalid), nFirstInvalid == nSize);
+        BOOST_CHECK_EQUAL(nInvalid, nFirstInvalid);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
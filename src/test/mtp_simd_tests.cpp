@@ -0,0 +1,170 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/MerkleTreeProof/mtp.h"
+#include "random.h"
+#include "test/test_bitcoin.h"
+#include "test/test_random.h"
+
+extern "C" {
+#include "crypto/MerkleTreeProof/blake2/blake2.h"
+#include "crypto/MerkleTreeProof/opt.h"
+#include "crypto/MerkleTreeProof/ref.h"
+}
+
+#include <algorithm>
+#include <string.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+const int mtpImpls[] = { MTP_IMPL_REF, MTP_IMPL_SSE41, MTP_IMPL_AVX2, MTP_IMPL_AVX512 };
+
+void RandomBlock(block& b)
+{
+    GetRandBytes((unsigned char*)b.v, sizeof(b.v));
+}
+
+std::vector<uint8_t> Blake2b(const std::vector<uint8_t>& data, size_t nOutLen, bool fFourRounds)
+{
+    std::vector<uint8_t> digest(nOutLen);
+    blake2b_state state;
+    blake2b_init(&state, nOutLen);
+    // Feed the data in uneven pieces to go through the buffered and the direct paths
+    for (size_t nPos = 0; nPos < data.size();) {
+        size_t nLen = std::min(data.size() - nPos, size_t(1 + insecure_rand() % 300));
+        if (fFourRounds)
+            blake2b_4r_update(&state, &data[nPos], nLen);
+        else
+            blake2b_update(&state, &data[nPos], nLen);
+        nPos += nLen;
+    }
+    if (fFourRounds)
+        blake2b_4r_final(&state, digest.data(), nOutLen);
+    else
+        blake2b_final(&state, digest.data(), nOutLen);
+    return digest;
+}
+
+}
+
+BOOST_FIXTURE_TEST_SUITE(mtp_simd_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(mtp_fill_block)
+{
+    for (int impl : mtpImpls) {
+        if (!mtp_impl_select(impl))
+            continue;
+        BOOST_TEST_MESSAGE("testing " << mtp_impl_name());
+        for (int i = 0; i < 100; i++) {
+            block prev, ref, next;
+            RandomBlock(prev);
+            RandomBlock(ref);
+            RandomBlock(next);
+            uint8_t hash_zero[ARGON2_PREHASH_SEED_LENGTH];
+            GetRandBytes(hash_zero, sizeof(hash_zero));
+            uint32_t nIndex = insecure_rand();
+            int fWithXor = i % 2;
+
+            block expected = next;
+            fill_block_mtp_ref(&prev, &ref, &expected, fWithXor, nIndex, hash_zero);
+            fill_block_mtp(&prev, &ref, &next, fWithXor, nIndex, hash_zero);
+            BOOST_CHECK(memcmp(next.v, expected.v, sizeof(next.v)) == 0);
+
+            // The output may alias the previous block, as in next_addresses()
+            expected = prev;
+            fill_block_mtp_ref(&ref, &expected, &expected, 0, nIndex, hash_zero);
+            fill_block_mtp(&ref, &prev, &prev, 0, nIndex, hash_zero);
+            BOOST_CHECK(memcmp(prev.v, expected.v, sizeof(prev.v)) == 0);
+        }
+    }
+    mtp_autodetect();
+}
+
+BOOST_AUTO_TEST_CASE(mtp_blake2b)
+{
+    std::vector<std::vector<uint8_t>> vData;
+    std::vector<size_t> vOutLen;
+    for (size_t nLen : {0, 1, 32, 127, 128, 129, 256, 1024, 1025, 3000}) {
+        std::vector<uint8_t> data(nLen);
+        if (nLen > 0)
+            GetRandBytes(data.data(), nLen);
+        vData.push_back(data);
+        vOutLen.push_back(1 + insecure_rand() % BLAKE2B_OUTBYTES);
+    }
+
+    mtp_impl_select(MTP_IMPL_REF);
+    std::vector<std::vector<uint8_t>> vExpected;
+    for (size_t i = 0; i < vData.size(); i++) {
+        vExpected.push_back(Blake2b(vData[i], vOutLen[i], false));
+        vExpected.push_back(Blake2b(vData[i], vOutLen[i], true));
+    }
+
+    for (int impl : mtpImpls) {
+        if (!mtp_impl_select(impl))
+            continue;
+        BOOST_TEST_MESSAGE("testing " << mtp_impl_name());
+        for (size_t i = 0; i < vData.size(); i++) {
+            BOOST_CHECK(Blake2b(vData[i], vOutLen[i], false) == vExpected[2 * i]);
+            BOOST_CHECK(Blake2b(vData[i], vOutLen[i], true) == vExpected[2 * i + 1]);
+        }
+    }
+    mtp_autodetect();
+}
+
+BOOST_AUTO_TEST_CASE(mtp_blake2b_hash_nodes)
+{
+    // Enough nodes for the full lanes and the tail of every kernel
+    for (size_t nCount : {0, 1, 2, 3, 4, 7, 8, 9, 17, 100}) {
+        std::vector<uint8_t> nodes(nCount * 32);
+        if (nCount > 0)
+            GetRandBytes(nodes.data(), nodes.size());
+
+        std::vector<uint8_t> expected;
+        for (size_t i = 0; i < nCount; i++) {
+            std::vector<uint8_t> node(nodes.begin() + i * 32, nodes.begin() + (i + 1) * 32);
+            std::vector<uint8_t> digest = Blake2b(node, 16, true);
+            expected.insert(expected.end(), digest.begin(), digest.end());
+        }
+
+        for (int impl : mtpImpls) {
+            if (!mtp_impl_select(impl))
+                continue;
+            std::vector<uint8_t> digests(nCount * 16);
+            blake2b_4r_hash_nodes(digests.data(), nodes.data(), nCount);
+            BOOST_CHECK_MESSAGE(digests == expected, mtp_impl_name());
+        }
+    }
+    mtp_autodetect();
+}
+
+BOOST_AUTO_TEST_CASE(mtp_verify_all_impls)
+{
+    // A proof made with the fastest implementation verifies the same way with all of them
+    char input[80];
+    for (size_t i = 0; i < sizeof(input); i++)
+        input[i] = (char)i;
+    uint32_t target = 0x2000ffffUL;
+    uint256 pow_limit = uint256S("00ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+
+    uint8_t hash_root_mtp[16];
+    unsigned int nonce;
+    static uint64_t block_mtp[mtp::MTP_L * 2][128];
+    static std::deque<std::vector<uint8_t>> proof_mtp[mtp::MTP_L * 3];
+    uint256 output;
+    mtp::impl::mtp_hash(input, target, hash_root_mtp, nonce, block_mtp, proof_mtp, pow_limit, output);
+
+    for (int impl : mtpImpls) {
+        if (!mtp_impl_select(impl))
+            continue;
+        uint256 mtpHashValue;
+        BOOST_CHECK_MESSAGE(mtp::impl::mtp_verify(input, target, hash_root_mtp, nonce, block_mtp, proof_mtp, pow_limit, &mtpHashValue),
+                            mtp_impl_name());
+        BOOST_CHECK(mtpHashValue == output);
+    }
+    mtp_autodetect();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
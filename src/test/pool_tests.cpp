@@ -0,0 +1,127 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coins.h"
+#include "memusage.h"
+#include "random.h"
+#include "support/allocators/pool.h"
+#include "test/test_bitcoin.h"
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(pool_resource_blocks)
+{
+    PoolResource<128, 8> resource(1024);
+    BOOST_CHECK_EQUAL(resource.ChunkSizeBytes(), 1024U);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+
+    // Blocks are rounded up to the alignment and handed out one after the other
+    char* a = static_cast<char*>(resource.Allocate(20, 8));
+    char* b = static_cast<char*>(resource.Allocate(24, 8));
+    BOOST_CHECK_EQUAL(b - a, 24);
+    BOOST_CHECK_EQUAL(resource.UsedBytes(), 48U);
+
+    // A freed block is given to the next allocation of its size only
+    resource.Deallocate(a, 20, 8);
+    BOOST_CHECK_EQUAL(resource.UsedBytes(), 24U);
+    void* c = resource.Allocate(16, 8);
+    BOOST_CHECK(c != a);
+    BOOST_CHECK(resource.Allocate(24, 8) == a);
+
+    // Large or over-aligned allocations come from the heap
+    void* d = resource.Allocate(256, 8);
+    void* e = resource.Allocate(16, 16);
+    BOOST_CHECK_EQUAL(resource.UsedBytes(), 24U + 16U + 24U);
+    resource.Deallocate(d, 256, 8);
+    resource.Deallocate(e, 16, 16);
+    resource.Deallocate(c, 16, 8);
+    resource.Deallocate(b, 24, 8);
+    resource.Deallocate(a, 24, 8);
+    BOOST_CHECK_EQUAL(resource.UsedBytes(), 0U);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+
+    // More chunks are taken when the freed blocks don't fit
+    std::vector<void*> blocks;
+    for (int i = 0; i < 100; i++)
+        blocks.push_back(resource.Allocate(128, 8));
+    BOOST_CHECK(resource.NumAllocatedChunks() >= 13U);
+    for (void* block : blocks)
+        resource.Deallocate(block, 128, 8);
+    size_t nChunks = resource.NumAllocatedChunks();
+    for (int i = 0; i < 100; i++)
+        blocks[i] = resource.Allocate(128, 8);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), nChunks);
+    for (void* block : blocks)
+        resource.Deallocate(block, 128, 8);
+}
+
+BOOST_AUTO_TEST_CASE(pool_coins_map)
+{
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map(0, SaltedOutpointHasher(), CCoinsMap::key_equal(), &resource);
+    std::map<COutPoint, CAmount> expected;
+
+    for (int i = 0; i < 20000; i++) {
+        COutPoint outpoint(GetRandHash(), i);
+        CAmount nValue = i * 7;
+        map[outpoint].coin = Coin(CTxOut(nValue, CScript() << OP_TRUE), 1, false);
+        expected[outpoint] = nValue;
+    }
+    for (std::map<COutPoint, CAmount>::iterator it = expected.begin(); it != expected.end();) {
+        if (it->second % 3 == 0) {
+            BOOST_CHECK_EQUAL(map.erase(it->first), 1U);
+            it = expected.erase(it);
+        } else {
+            it++;
+        }
+    }
+    BOOST_CHECK_EQUAL(map.size(), expected.size());
+    for (const std::pair<const COutPoint, CAmount>& entry : expected) {
+        CCoinsMap::const_iterator it = map.find(entry.first);
+        BOOST_CHECK(it != map.end() && it->second.coin.out.nValue == entry.second);
+    }
+
+    // The nodes are in the pool: the accounted memory is its chunks and the buckets
+    BOOST_CHECK(resource.UsedBytes() >= map.size() * sizeof(CCoinsMap::value_type));
+    BOOST_CHECK(resource.UsedBytes() <= resource.NumAllocatedChunks() * resource.ChunkSizeBytes());
+    BOOST_CHECK(memusage::DynamicUsage(map) >= resource.NumAllocatedChunks() * resource.ChunkSizeBytes());
+    BOOST_CHECK(memusage::DynamicUsage(map) < (resource.NumAllocatedChunks() + 1) * resource.ChunkSizeBytes() +
+                                              memusage::MallocUsage(sizeof(void*) * map.bucket_count()));
+
+    map.clear();
+    BOOST_CHECK(resource.UsedBytes() <= memusage::MallocUsage(sizeof(void*) * map.bucket_count()));
+}
+
+BOOST_AUTO_TEST_CASE(pool_coins_cache_usage)
+{
+    CCoinsView base;
+    CCoinsViewCache cache(&base);
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 5000; i++) {
+        outpoints.push_back(COutPoint(GetRandHash(), 0));
+        cache.AddCoin(outpoints.back(), Coin(CTxOut(i, CScript() << OP_TRUE), 1, false), false);
+    }
+    size_t nUsage = cache.DynamicMemoryUsage();
+    size_t nInUse = cache.DynamicMemoryUsageInUse();
+    BOOST_CHECK(nInUse <= nUsage);
+
+    // Spent fresh coins are erased, their memory stays with the cache but isn't in use
+    for (size_t i = 0; i < outpoints.size(); i += 2)
+        cache.SpendCoin(outpoints[i]);
+    BOOST_CHECK_EQUAL(cache.DynamicMemoryUsage(), nUsage);
+    BOOST_CHECK(cache.DynamicMemoryUsageInUse() < nInUse);
+
+    // A flush releases it
+    cache.Flush();
+    BOOST_CHECK(cache.DynamicMemoryUsage() < nUsage);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
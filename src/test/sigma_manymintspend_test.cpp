@@ -204,7 +204,7 @@ BOOST_AUTO_TEST_CASE(sigma_mintspend_many)
 
         //Temporary disable usedCoinSerials check to force double spend in mempool
         auto tempSerials = sigmaState->GetSpends();
-        sigmaState->containers.usedCoinSerials.clear();
+        SetSigmaSpends(sigmaState, sigma::spend_info_container());
 
         wtx.Init(NULL);
 
@@ -212,15 +212,15 @@ BOOST_AUTO_TEST_CASE(sigma_mintspend_many)
             pwalletMain->zwallet->GetTracker().SetPubcoinNotUsed(primitives::GetPubCoinValueHash(mint.value));
         BOOST_CHECK_NO_THROW(pwalletMain->SpendSigma(recipients, wtx));
         BOOST_CHECK_MESSAGE(mempool.size() == 1, "mempool not set after used coin serials removed");
-        sigmaState->containers.usedCoinSerials = tempSerials;
+        SetSigmaSpends(sigmaState, tempSerials);
 
         BOOST_CHECK_EXCEPTION(CreateBlock(scriptPubKey), std::runtime_error, no_check);
         BOOST_CHECK_MESSAGE(mempool.size() == 1, "mempool not set after block created");
 
-        tempSerials = sigmaState->containers.usedCoinSerials;
-        sigmaState->containers.usedCoinSerials.clear();
+        tempSerials = sigmaState->GetSpends();
+        SetSigmaSpends(sigmaState, sigma::spend_info_container());
         CreateBlock(scriptPubKey);
-        sigmaState->containers.usedCoinSerials = tempSerials;
+        SetSigmaSpends(sigmaState, tempSerials);
 
         mempool.clear();
         previousHeight = chainActive.Height();
@@ -190,8 +190,8 @@ BOOST_AUTO_TEST_CASE(sigma_mintspend_test)
         BOOST_CHECK_MESSAGE(mempool.size() == 0, "Mempool not empty although mempool should reject double spend");
 
         //Temporary disable usedCoinSerials check to force double spend in mempool
-        auto tempSerials = sigmaState->containers.usedCoinSerials;
-        sigmaState->containers.usedCoinSerials.clear();
+        auto tempSerials = sigmaState->GetSpends();
+        SetSigmaSpends(sigmaState, sigma::spend_info_container());
 
         {
             //Set mints unused, and try to spend again
@@ -202,15 +202,15 @@ BOOST_AUTO_TEST_CASE(sigma_mintspend_test)
             BOOST_CHECK_MESSAGE(mempool.size() == 1, "Spend was not added to mempool");
         }
 
-        sigmaState->containers.usedCoinSerials = tempSerials;
+        SetSigmaSpends(sigmaState, tempSerials);
 
         BOOST_CHECK_EXCEPTION(CreateBlock(scriptPubKey), std::runtime_error, no_check);
         BOOST_CHECK_MESSAGE(mempool.size() == 1, "Mempool not set");
-        tempSerials = sigmaState->containers.usedCoinSerials;
-        sigmaState->containers.usedCoinSerials.clear();
+        tempSerials = sigmaState->GetSpends();
+        SetSigmaSpends(sigmaState, sigma::spend_info_container());
         CreateBlock(scriptPubKey);
 
-        sigmaState->containers.usedCoinSerials = tempSerials;
+        SetSigmaSpends(sigmaState, tempSerials);
 
         mempool.clear();
         previousHeight = chainActive.Height();
@@ -160,15 +160,15 @@ BOOST_AUTO_TEST_CASE(partialspend)
         BOOST_CHECK_MESSAGE(mempool.size() == 0, "Mempool not empty although mempool should reject double spend");
 
         // Temporary disable usedCoinSerials check to force double spend in mempool
-        auto tempSerials = sigmaState->containers.usedCoinSerials;
-        sigmaState->containers.usedCoinSerials.clear();
+        auto tempSerials = sigmaState->GetSpends();
+        SetSigmaSpends(sigmaState, sigma::spend_info_container());
 
         // Add invalid transaction to mempool, this will pass because we have removed serials from state
         BOOST_CHECK_MESSAGE(addToMempool(dtx), "Spend created although double");
         BOOST_CHECK_MESSAGE(mempool.size() == 1, "Mempool not set");
 
         // Bring serials back to zerocoin state
-        sigmaState->containers.usedCoinSerials = tempSerials;
+        SetSigmaSpends(sigmaState, tempSerials);
 
         // CreateBlock throw exception because invalid transaction is in mempool
         BOOST_CHECK_EXCEPTION(CreateBlock(scriptPubKey), std::runtime_error, no_check);
@@ -176,12 +176,12 @@ BOOST_AUTO_TEST_CASE(partialspend)
 
         // Add invalid tx too block manually
         // it will work be cause we remove serials from state and don't bring it back before create block like previous test
-        tempSerials = sigmaState->containers.usedCoinSerials;
-        sigmaState->containers.usedCoinSerials.clear();
+        tempSerials = sigmaState->GetSpends();
+        SetSigmaSpends(sigmaState, sigma::spend_info_container());
         CreateBlock(scriptPubKey);
 
         // Bring serials back
-        sigmaState->containers.usedCoinSerials = tempSerials;
+        SetSigmaSpends(sigmaState, tempSerials);
 
         // Create new block, last block should be remove because it contain invalid spend tx
         mempool.clear();
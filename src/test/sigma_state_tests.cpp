@@ -4,12 +4,15 @@
 #include "../validation.h"
 #include "../secp256k1/include/Scalar.h"
 #include "../sigma.h"
+#include "../primitives/zerocoin.h"
+#include "../txdb.h"
 #include "./test_bitcoin.h"
 #include "../wallet/wallet.h"
 
 #include "test/fixtures.h"
 #include "test/testutil.h"
 
+#include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
 #include <stdlib.h>
@@ -760,6 +763,112 @@ BOOST_AUTO_TEST_CASE(zerocoin_sigma_removeblock_remove)
     sigmaState->Reset();
 }
 
+// Checking the lookups by hash follow the blocks added and removed
+BOOST_AUTO_TEST_CASE(sigma_hascoinhash_isusedcoinserialhash)
+{
+    sigma::CSigmaState *sigmaState = sigma::CSigmaState::GetState();
+    auto params = sigma::Params::get_default();
+
+    auto coins = generateCoins(params, 10, sigma::CoinDenomination::SIGMA_DENOM_1);
+    auto pubCoins = getPubcoins(coins);
+
+    auto index1 = CreateBlockIndex(1);
+    std::pair<sigma::CoinDenomination, int> denomination1Group1(sigma::CoinDenomination::SIGMA_DENOM_1, 1);
+    index1.sigmaMintedPubCoins[denomination1Group1] = pubCoins;
+
+    // Doesn't really matter what metadata we give here, it must pass.
+    sigma::SpendMetaData metaData(0, uint256S("120"), uint256S("120"));
+
+    sigma::CoinSpend coinSpend(params, coins[0], pubCoins, metaData, true);
+    Scalar serial = coinSpend.getCoinSerialNumber();
+    uint256 serialHash = primitives::GetSerialHash(serial);
+
+    auto index2 = CreateBlockIndex(2);
+    index2.sigmaSpentSerials.insert(std::make_pair(serial, sigma::CSpendCoinInfo::make(coinSpend.getDenomination(), 1)));
+
+    GroupElement pubCoinValue;
+    Scalar coinSerial;
+    BOOST_CHECK(!sigmaState->HasCoinHash(pubCoinValue, pubCoins[3].getValueHash()));
+
+    sigmaState->AddBlock(&index1);
+    sigmaState->AddBlock(&index2);
+
+    BOOST_CHECK(sigmaState->HasCoinHash(pubCoinValue, pubCoins[3].getValueHash()));
+    BOOST_CHECK(pubCoinValue == pubCoins[3].getValue());
+    BOOST_CHECK(!sigmaState->HasCoinHash(pubCoinValue, serialHash));
+    BOOST_CHECK(sigmaState->IsUsedCoinSerialHash(coinSerial, serialHash));
+    BOOST_CHECK(coinSerial == serial);
+    BOOST_CHECK(!sigmaState->IsUsedCoinSerialHash(coinSerial, pubCoins[3].getValueHash()));
+
+    sigmaState->RemoveBlock(&index2);
+    BOOST_CHECK(!sigmaState->IsUsedCoinSerialHash(coinSerial, serialHash));
+    BOOST_CHECK(sigmaState->HasCoinHash(pubCoinValue, pubCoins[3].getValueHash()));
+
+    sigmaState->RemoveBlock(&index1);
+    BOOST_CHECK(!sigmaState->HasCoinHash(pubCoinValue, pubCoins[3].getValueHash()));
+
+    sigmaState->AddBlock(&index1);
+    sigmaState->AddBlock(&index2);
+    sigmaState->Reset();
+    BOOST_CHECK(!sigmaState->HasCoinHash(pubCoinValue, pubCoins[3].getValueHash()));
+    BOOST_CHECK(!sigmaState->IsUsedCoinSerialHash(coinSerial, serialHash));
+}
+
+BOOST_AUTO_TEST_CASE(sigma_mint_index)
+{
+    auto params = sigma::Params::get_default();
+    auto pubCoins = getPubcoins(generateCoins(params, 3, sigma::CoinDenomination::SIGMA_DENOM_1));
+    int64_t denomination;
+    sigma::DenominationToInteger(sigma::CoinDenomination::SIGMA_DENOM_1, denomination);
+
+    // The mints follow an output which isn't one
+    CMutableTransaction tx;
+    tx.vout.resize(1);
+    for (const auto& pubCoin : pubCoins) {
+        CScript script;
+        script << OP_SIGMAMINT;
+        std::vector<unsigned char> vch = pubCoin.getValue().getvch();
+        script.insert(script.end(), vch.begin(), vch.end());
+        tx.vout.push_back(CTxOut(denomination, script));
+    }
+    CBlock block = CreateBlockWithMints(pubCoins);
+    block.vtx.push_back(MakeTransactionRef(tx));
+    auto index = CreateBlockIndex(chainActive.Height() + 1);
+
+    CSigmaMintIndexValue value;
+    BOOST_CHECK(!sigma::GetSigmaMintIndexValue(pubCoins[0].getValueHash(), value));
+
+    CValidationState state;
+    BOOST_CHECK(sigma::ConnectBlockSigma(state, Params(), &index, &block));
+
+    COutPoint outPoint;
+    for (uint32_t i = 0; i < pubCoins.size(); i++) {
+        BOOST_CHECK(sigma::GetSigmaMintIndexValue(pubCoins[i].getValueHash(), value));
+        BOOST_CHECK(value.outpoint == COutPoint(tx.GetHash(), i + 1));
+        BOOST_CHECK_EQUAL(value.blockHeight, index.nHeight);
+        BOOST_CHECK_EQUAL(value.denomination, denomination);
+        BOOST_CHECK_EQUAL(value.coinGroupId, 1);
+
+        // The block isn't on the chain, it can only be found through the index
+        BOOST_CHECK(sigma::GetOutPoint(outPoint, pubCoins[i]));
+        BOOST_CHECK(outPoint == COutPoint(tx.GetHash(), i + 1));
+        BOOST_CHECK(sigma::GetOutPoint(outPoint, pubCoins[i].getValueHash()));
+        BOOST_CHECK(outPoint == COutPoint(tx.GetHash(), i + 1));
+    }
+
+    // Entries which don't match the state are ignored
+    CSigmaMintIndexValue stale(COutPoint(tx.GetHash(), 1), index.nHeight - 1, denomination, 1);
+    BOOST_CHECK(pblocktree->WriteSigmaMintIndex({{pubCoins[0].getValueHash(), stale}}));
+    BOOST_CHECK(!sigma::GetSigmaMintIndexValue(pubCoins[0].getValueHash(), value));
+    BOOST_CHECK(sigma::GetSigmaMintIndexValue(pubCoins[1].getValueHash(), value));
+
+    sigma::DisconnectTipSigma(block, &index);
+    for (const auto& pubCoin : pubCoins) {
+        BOOST_CHECK(!pblocktree->ReadSigmaMintIndex(pubCoin.getValueHash(), value));
+        BOOST_CHECK(!sigma::GetSigmaMintIndexValue(pubCoin.getValueHash(), value));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(getmempoolconflictingtxhash_added_no)
 {
     sigma::CSigmaState state;
@@ -1003,6 +1112,97 @@ BOOST_AUTO_TEST_CASE(sigma_build_state)
     chainActive.SetTip(NULL);
 }
 
+BOOST_AUTO_TEST_CASE(sigma_state_file)
+{
+    sigma::CSigmaState *sigmaState = sigma::CSigmaState::GetState();
+    auto params = sigma::Params::get_default();
+    boost::filesystem::path path = GetDataDir() / "sigmastate_test.dat";
+    chainActive.SetTip(NULL);
+
+    std::vector<uint256> hashes(20);
+    std::vector<CBlockIndex> indices;
+    indices.reserve(hashes.size());
+    for (size_t i = 0; i < hashes.size(); i++) {
+        hashes[i] = uint256S(std::to_string(i + 1));
+        indices.emplace_back(CreateBlockIndex(i));
+        indices.back().phashBlock = &hashes[i];
+        chainActive.SetTip(&indices.back());
+    }
+
+    auto pubCoins = getPubcoins(generateCoins(params, 10, sigma::CoinDenomination::SIGMA_DENOM_1));
+    auto pubCoins2 = getPubcoins(generateCoins(params, 2, sigma::CoinDenomination::SIGMA_DENOM_10));
+    std::pair<sigma::CoinDenomination, int> denomination1Group1(sigma::CoinDenomination::SIGMA_DENOM_1, 1);
+    std::pair<sigma::CoinDenomination, int> denomination10Group1(sigma::CoinDenomination::SIGMA_DENOM_10, 1);
+    indices[3].sigmaMintedPubCoins[denomination1Group1] = pubCoins;
+    indices[5].sigmaMintedPubCoins[denomination10Group1] = {pubCoins2[0]};
+    secp_primitives::Scalar serial;
+    serial.randomize();
+    indices[5].sigmaSpentSerials.insert(std::make_pair(serial, sigma::CSpendCoinInfo::make(sigma::CoinDenomination::SIGMA_DENOM_1, 1)));
+    // Not in the snapshot, added by the load after it
+    indices[15].sigmaMintedPubCoins[denomination10Group1] = {pubCoins2[1]};
+
+    chainActive.SetTip(&indices[10]);
+    sigma::BuildSigmaStateFromIndex(&chainActive);
+    BOOST_CHECK(sigmaState->WriteToFile(path, chainActive));
+
+    chainActive.SetTip(&indices.back());
+    sigmaState->Reset();
+    BOOST_CHECK(sigmaState->LoadFromFile(path, &chainActive));
+
+    auto mints = sigmaState->GetMints();
+    auto spends = sigmaState->GetSpends();
+    auto coinGroups = sigmaState->GetCoinGroups();
+    auto latestCoinIds = sigmaState->GetLatestCoinIds();
+    sigmaState->Reset();
+    sigma::BuildSigmaStateFromIndex(&chainActive);
+    BOOST_CHECK_EQUAL(mints.size(), sigmaState->GetMints().size());
+    for (const auto& mint : sigmaState->GetMints()) {
+        BOOST_CHECK(mints.count(mint.first));
+        BOOST_CHECK(mints[mint.first].denomination == mint.second.denomination);
+        BOOST_CHECK_EQUAL(mints[mint.first].coinGroupId, mint.second.coinGroupId);
+        BOOST_CHECK_EQUAL(mints[mint.first].nHeight, mint.second.nHeight);
+    }
+    BOOST_CHECK_EQUAL(spends.size(), sigmaState->GetSpends().size());
+    for (const auto& spend : sigmaState->GetSpends()) {
+        BOOST_CHECK(spends.count(spend.first));
+        BOOST_CHECK(spends[spend.first].denomination == spend.second.denomination);
+        BOOST_CHECK_EQUAL(spends[spend.first].coinGroupId, spend.second.coinGroupId);
+    }
+    BOOST_CHECK(latestCoinIds == sigmaState->GetLatestCoinIds());
+    BOOST_CHECK_EQUAL(coinGroups.size(), sigmaState->GetCoinGroups().size());
+    for (const auto& coinGroup : sigmaState->GetCoinGroups()) {
+        BOOST_CHECK(coinGroups[coinGroup.first].firstBlock == coinGroup.second.firstBlock);
+        BOOST_CHECK(coinGroups[coinGroup.first].lastBlock == coinGroup.second.lastBlock);
+        BOOST_CHECK_EQUAL(coinGroups[coinGroup.first].nCoins, coinGroup.second.nCoins);
+    }
+    BOOST_CHECK(coinGroups[denomination10Group1].lastBlock == &indices[15]);
+    GroupElement pubCoinValue;
+    BOOST_CHECK(sigmaState->HasCoinHash(pubCoinValue, pubCoins[4].getValueHash()));
+
+    // The file isn't used if its tip is no longer on the chain
+    uint256 otherHash = uint256S("ff");
+    indices[10].phashBlock = &otherHash;
+    BOOST_CHECK(!sigmaState->LoadFromFile(path, &chainActive));
+    BOOST_CHECK_EQUAL(sigmaState->GetMints().size(), mints.size());
+    indices[10].phashBlock = &hashes[10];
+
+    // or if it's damaged
+    std::vector<char> data(boost::filesystem::file_size(path));
+    FILE *file = fopen(path.string().c_str(), "rb");
+    BOOST_CHECK_EQUAL(fread(data.data(), 1, data.size(), file), data.size());
+    fclose(file);
+    data[data.size() / 2] ^= 1;
+    file = fopen(path.string().c_str(), "wb");
+    BOOST_CHECK_EQUAL(fwrite(data.data(), 1, data.size(), file), data.size());
+    fclose(file);
+    BOOST_CHECK(!sigmaState->LoadFromFile(path, &chainActive));
+    BOOST_CHECK(!sigmaState->LoadFromFile(GetDataDir() / "nonexistent.dat", &chainActive));
+
+    boost::filesystem::remove(path);
+    sigmaState->Reset();
+    chainActive.SetTip(NULL);
+}
+
 BOOST_AUTO_TEST_CASE(sigma_build_state_no_sigma)
 {
     sigma::CSigmaState *sigmaState = sigma::CSigmaState::GetState();
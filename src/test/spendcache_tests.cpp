@@ -0,0 +1,30 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "spendcache.h"
+#include "random.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(spendcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(spendcache_hits)
+{
+    CSpendCacheStats before = GetSpendVerificationCacheStats();
+
+    uint256 spendHash = GetRandHash();
+    BOOST_CHECK(!IsSpendVerificationCached(spendHash));
+    AddSpendVerificationToCache(spendHash);
+    BOOST_CHECK(IsSpendVerificationCached(spendHash));
+    // Entries stay in the cache once found, a spend may be connected again after a reorg
+    BOOST_CHECK(IsSpendVerificationCached(spendHash));
+    BOOST_CHECK(!IsSpendVerificationCached(GetRandHash()));
+
+    CSpendCacheStats after = GetSpendVerificationCacheStats();
+    BOOST_CHECK_EQUAL(after.nHits - before.nHits, 2U);
+    BOOST_CHECK_EQUAL(after.nMisses - before.nMisses, 2U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -72,6 +72,74 @@ BOOST_AUTO_TEST_CASE(streams_vector_writer)
     vch.clear();
 }
 
+BOOST_AUTO_TEST_CASE(streams_vector_reader)
+{
+    std::vector<unsigned char> vch = {1, 255, 3, 4, 5, 6};
+
+    VectorReader reader(SER_NETWORK, INIT_PROTO_VERSION, vch, 0);
+    BOOST_CHECK_EQUAL(reader.size(), 6);
+    BOOST_CHECK(!reader.empty());
+
+    unsigned char a;
+    reader >> a;
+    BOOST_CHECK_EQUAL(a, 1);
+    BOOST_CHECK_EQUAL(reader.size(), 5);
+
+    uint16_t b;
+    reader >> b;
+    BOOST_CHECK_EQUAL(b, 1023); // little-endian 255, 3
+
+    uint16_t c;
+    reader >> c;
+    BOOST_CHECK_EQUAL(c, 1284); // little-endian 4, 5
+    BOOST_CHECK_EQUAL(reader.size(), 1);
+
+    // Reading past the end fails
+    BOOST_CHECK_THROW(reader >> c, std::ios_base::failure);
+
+    // Reads start at the given position
+    VectorReader reader2(SER_NETWORK, INIT_PROTO_VERSION, vch, 5);
+    unsigned char d;
+    reader2 >> d;
+    BOOST_CHECK_EQUAL(d, 6);
+    BOOST_CHECK(reader2.empty());
+}
+
+BOOST_AUTO_TEST_CASE(streams_bitstream)
+{
+    CDataStream data(SER_NETWORK, INIT_PROTO_VERSION);
+
+    BitStreamWriter<CDataStream> bitwriter(data);
+    bitwriter.Write(0, 1);
+    bitwriter.Write(2, 2);
+    bitwriter.Write(6, 3);
+    bitwriter.Write(11, 4);
+    bitwriter.Write(1, 5);
+    bitwriter.Write(32, 6);
+    bitwriter.Write(7, 7);
+    bitwriter.Write(30497, 16);
+    bitwriter.Flush();
+
+    CDataStream dataCopy(data);
+    uint32_t serializedInt1;
+    data >> serializedInt1;
+    BOOST_CHECK_EQUAL(serializedInt1, (uint32_t)0x7700C35A); // NOTE: Serialized as LE
+    uint16_t serializedInt2;
+    data >> serializedInt2;
+    BOOST_CHECK_EQUAL(serializedInt2, (uint16_t)0x1072); // NOTE: Serialized as LE
+
+    BitStreamReader<CDataStream> bitreader(dataCopy);
+    BOOST_CHECK_EQUAL(bitreader.Read(1), 0);
+    BOOST_CHECK_EQUAL(bitreader.Read(2), 2);
+    BOOST_CHECK_EQUAL(bitreader.Read(3), 6);
+    BOOST_CHECK_EQUAL(bitreader.Read(4), 11);
+    BOOST_CHECK_EQUAL(bitreader.Read(5), 1);
+    BOOST_CHECK_EQUAL(bitreader.Read(6), 32);
+    BOOST_CHECK_EQUAL(bitreader.Read(7), 7);
+    BOOST_CHECK_EQUAL(bitreader.Read(16), 30497);
+    BOOST_CHECK_THROW(bitreader.Read(8), std::ios_base::failure);
+}
+
 BOOST_AUTO_TEST_CASE(streams_serializedata_xor)
 {
     std::vector<char> in;
@@ -14,6 +14,8 @@
 #include "chainparams.h"
 #include "consensus/consensus.h"
 #include "consensus/validation.h"
+#include "crypto/Lyra2Z/Lyra2Z.h"
+#include "crypto/MerkleTreeProof/opt.h"
 #include "key.h"
 #include "validation.h"
 #include "miner.h"
@@ -26,6 +28,7 @@
 #include "rpc/server.h"
 #include "rpc/register.h"
 #include "script/sigcache.h"
+#include "spendcache.h"
 #include "stacktraces.h"
 
 #include "test/testutil.h"
@@ -60,9 +63,12 @@ extern CEvoDB* evoDb;
 BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
 {
     ECC_Start();
+    lyra2z_autodetect();
+    mtp_autodetect();
     SetupEnvironment();
     SetupNetworking();
     InitSignatureCache();
+    InitSpendVerificationCache();
     fPrintToDebugLog = false; // don't want to write to debug.log file
     fCheckBlockIndex = true;
     SelectParams(chainName);
@@ -0,0 +1,82 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "utxostats.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "coins.h"
+#include "script/standard.h"
+#include "validation.h"
+
+#include "test/test_bitcoin.h"
+
+#include <memory>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(utxostats_tests, TestChain100Setup)
+
+//! Statistics of the whole UTXO set, as written to the database
+static CUTXOStats ComputeTipUTXOStats()
+{
+    FlushStateToDisk();
+    CUTXOStats stats;
+    std::unique_ptr<CCoinsViewCursor> pcursor(pcoinsTip->Cursor());
+    while (pcursor->Valid()) {
+        COutPoint key;
+        Coin coin;
+        BOOST_REQUIRE(pcursor->GetKey(key) && pcursor->GetValue(coin));
+        stats.AddCoin(key, coin);
+        pcursor->Next();
+    }
+    return stats;
+}
+
+BOOST_AUTO_TEST_CASE(utxostats_verifydb)
+{
+    fUTXOStats = true;
+    LoadUTXOStats();
+    BuildUTXOStats();
+
+    CUTXOStats statsBefore;
+    {
+        LOCK(cs_main);
+        BOOST_REQUIRE(GetBlockUTXOStats(chainActive.Tip(), statsBefore));
+        BOOST_CHECK(statsBefore.hashBlock == chainActive.Tip()->GetBlockHash());
+
+        // The blocks disconnected and connected again on a scratch view don't move the statistics
+        BOOST_CHECK(CVerifyDB().VerifyDB(Params(), pcoinsTip, 4, 6));
+
+        CUTXOStats statsAfter;
+        BOOST_REQUIRE(GetBlockUTXOStats(chainActive.Tip(), statsAfter));
+        BOOST_CHECK(statsAfter.hashBlock == statsBefore.hashBlock);
+        BOOST_CHECK_EQUAL(statsAfter.nTransactionOutputs, statsBefore.nTransactionOutputs);
+        BOOST_CHECK_EQUAL(statsAfter.nTotalAmount, statsBefore.nTotalAmount);
+        BOOST_CHECK(statsAfter.GetMuHash() == statsBefore.GetMuHash());
+    }
+
+    // The tip still moves them, and they match the set
+    CScript scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CreateAndProcessBlock({}, scriptPubKey);
+    {
+        LOCK(cs_main);
+        CUTXOStats statsTip;
+        BOOST_REQUIRE(GetBlockUTXOStats(chainActive.Tip(), statsTip));
+        BOOST_CHECK(statsTip.hashBlock == chainActive.Tip()->GetBlockHash());
+        BOOST_CHECK_EQUAL(statsTip.nHeight, chainActive.Height());
+        BOOST_CHECK(statsTip.nTransactionOutputs > statsBefore.nTransactionOutputs);
+
+        CUTXOStats expected = ComputeTipUTXOStats();
+        BOOST_CHECK_EQUAL(statsTip.nTransactionOutputs, expected.nTransactionOutputs);
+        BOOST_CHECK_EQUAL(statsTip.nBogoSize, expected.nBogoSize);
+        BOOST_CHECK_EQUAL(statsTip.nTotalAmount, expected.nTotalAmount);
+        BOOST_CHECK(statsTip.GetMuHash() == expected.GetMuHash());
+    }
+
+    fUTXOStats = false;
+    LoadUTXOStats();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,42 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "libzerocoin/Zerocoin.h"
+#include "test/test_bitcoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(zerocoin_bignum_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(pow_mod_public)
+{
+    CBigNum m = CBigNum::generatePrime(512, false);
+    for (int i = 0; i < 20; i++) {
+        CBigNum base = CBigNum::randBignum(m * 4);
+        CBigNum exp = CBigNum::randBignum(m * m);
+        BOOST_CHECK(base.pow_mod_public(exp, m) == base.pow_mod(exp, m));
+        BOOST_CHECK(base.pow_mod_public(-exp, m) == base.pow_mod(-exp, m));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(multi_pow_mod)
+{
+    CBigNum m = CBigNum::generatePrime(512, false);
+    for (int n = 0; n < 6; n++) {
+        std::vector<std::pair<CBigNum, CBigNum>> terms;
+        CBigNum expected = 1;
+        for (int i = 0; i < n; i++) {
+            CBigNum base = CBigNum::randBignum(m * 4);
+            // Exponents of different sizes, some of them negative
+            CBigNum exp = CBigNum::randBignum(CBigNum(2).pow(64 * (i + 1)));
+            if (i % 2)
+                exp = -exp;
+            terms.emplace_back(base, exp);
+            expected = expected.mul_mod(base.pow_mod(exp, m), m);
+        }
+        BOOST_CHECK(CBigNum::multi_pow_mod(terms, m) == expected % m);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,14 +5,18 @@
 
 #include "txdb.h"
 
+#include "blockindexfile.h"
 #include "chainparams.h"
 #include "hash.h"
 #include "pow.h"
+#include "random.h"
 #include "uint256.h"
+#include "utiltime.h"
 #include "validation.h"
 #include "consensus/consensus.h"
 #include "base58.h"
 
+#include <limits>
 #include <stdint.h>
 
 #include <boost/thread.hpp>
@@ -25,13 +29,18 @@ static const char DB_ADDRESSINDEX = 'a';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
+static const char DB_SIGMAMINTINDEX = 'm';
 static const char DB_BLOCK_INDEX = 'b';
+static const char DB_BLOCK_INDEX_FILE = 'M';
 
 static const char DB_BEST_BLOCK = 'B';
+static const char DB_HEAD_BLOCKS = 'H';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
 static const char DB_TOTAL_SUPPLY = 'S';
+static const char DB_UTXOSTATS = 'U';
+static const char DB_BLOCKFILTER = 'G';
 
 namespace {
 
@@ -76,10 +85,57 @@ uint256 CCoinsViewDB::GetBestBlock() const {
     return hashBestChain;
 }
 
+std::vector<uint256> CCoinsViewDB::GetHeadBlocks() const {
+    std::vector<uint256> vhashHeadBlocks;
+    if (!db.Read(DB_HEAD_BLOCKS, vhashHeadBlocks)) {
+        return std::vector<uint256>();
+    }
+    return vhashHeadBlocks;
+}
+
 bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
+    return WriteCoins(mapCoins, hashBlock, true);
+}
+
+bool CCoinsViewDB::BatchWritePartial(CCoinsMap &mapCoins, const uint256 &hashBlock) {
+    // Partial writes can only be undone back to a best block
+    if (hashBlock.IsNull() || GetBestBlock().IsNull())
+        return false;
+    return WriteCoins(mapCoins, hashBlock, false);
+}
+
+bool CCoinsViewDB::WriteCoins(CCoinsMap &mapCoins, const uint256 &hashBlock, bool fComplete) {
     CDBBatch batch(db);
     size_t count = 0;
     size_t changed = 0;
+    size_t batch_size = (size_t)GetArg("-dbbatchsize", nDefaultDbBatchSize);
+    uint256 hashOldBlock = GetBestBlock();
+
+    // The changes may take several batches. Until the last one is written, the
+    // head blocks record that the coins are somewhere between the best block,
+    // which is only moved at the end, and hashBlock (see ReplayBlocks).
+    // Before the first flush there is no state to go back to, it is written at once.
+    if (hashOldBlock.IsNull()) {
+        batch_size = std::numeric_limits<size_t>::max();
+    } else if (!hashBlock.IsNull()) {
+        std::vector<uint256> vhashHeadBlocks;
+        vhashHeadBlocks.push_back(hashBlock);
+        vhashHeadBlocks.push_back(hashOldBlock);
+        // The coins of an earlier flush that didn't complete may still be in the
+        // database. Its heads are kept until a flush completes: the best block
+        // hasn't moved since, and a flush back to it, as after ReplayBlocks, must
+        // not forget how far the earlier one went. Other flushes only go forward
+        // from it, as a partially flushed cache is flushed in full before a block
+        // is disconnected.
+        std::vector<uint256> vhashOldHeads = GetHeadBlocks();
+        if (!vhashOldHeads.empty()) {
+            assert(vhashOldHeads.size() == 2 && vhashOldHeads[1] == hashOldBlock);
+            if (hashBlock == hashOldBlock)
+                vhashHeadBlocks[0] = vhashOldHeads[0];
+        }
+        batch.Write(DB_HEAD_BLOCKS, vhashHeadBlocks);
+    }
+
     for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
             CoinEntry entry(&it->first);
@@ -92,12 +148,21 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
         count++;
         CCoinsMap::iterator itOld = it++;
         mapCoins.erase(itOld);
+        if (batch.SizeEstimate() > batch_size) {
+            LogPrint("coindb", "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
+            if (!db.WriteBatch(batch))
+                return false;
+            batch.Clear();
+        }
     }
-    if (!hashBlock.IsNull())
+    if (fComplete && !hashBlock.IsNull()) {
+        batch.Erase(DB_HEAD_BLOCKS);
         batch.Write(DB_BEST_BLOCK, hashBlock);
+    }
 
     bool ret = db.WriteBatch(batch);
-    LogPrint("coindb", "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
+    LogPrint("coindb", "Committed %u changed transaction outputs (out of %u) to coin database%s...\n", (unsigned int)changed, (unsigned int)count,
+             fComplete ? "" : " (partial)");
     return ret;
 }
 
@@ -106,7 +171,7 @@ size_t CCoinsViewDB::EstimateSize() const
     return db.EstimateSize(DB_COIN, (char)(DB_COIN+1));
 }
 
-CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe) {
+CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe, false, DBProfile::SCAN, "blockindex") {
 }
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
@@ -192,9 +257,20 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     for (std::vector<const CBlockIndex*>::const_iterator it=blockinfo.begin(); it != blockinfo.end(); it++) {
         batch.Write(std::make_pair(DB_BLOCK_INDEX, (*it)->GetBlockHash()), CDiskBlockIndex(*it));
     }
+    // The flat block index file no longer matches the database
+    batch.Erase(DB_BLOCK_INDEX_FILE);
     return WriteBatch(batch, true);
 }
 
+bool CBlockTreeDB::WriteBlockIndexEntries(const std::vector<std::pair<uint256, CDiskBlockIndex> >& entries) {
+    CDBBatch batch(*this);
+    for (std::vector<std::pair<uint256, CDiskBlockIndex> >::const_iterator it=entries.begin(); it != entries.end(); it++) {
+        batch.Write(std::make_pair(DB_BLOCK_INDEX, it->first), it->second);
+    }
+    batch.Erase(DB_BLOCK_INDEX_FILE);
+    return WriteBatch(batch);
+}
+
 bool CBlockTreeDB::ReadTxIndex(const uint256 &txid, CDiskTxPos &pos) {
     return Read(std::make_pair(DB_TXINDEX, txid), pos);
 }
@@ -222,6 +298,24 @@ bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey,
     return WriteBatch(batch);
 }
 
+bool CBlockTreeDB::ReadSigmaMintIndex(const uint256 &pubCoinValueHash, CSigmaMintIndexValue &value) {
+    return Read(std::make_pair(DB_SIGMAMINTINDEX, pubCoinValueHash), value);
+}
+
+bool CBlockTreeDB::WriteSigmaMintIndex(const std::vector<std::pair<uint256, CSigmaMintIndexValue> > &vect) {
+    CDBBatch batch(*this);
+    for (std::vector<std::pair<uint256, CSigmaMintIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
+        batch.Write(std::make_pair(DB_SIGMAMINTINDEX, it->first), it->second);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::EraseSigmaMintIndex(const std::vector<uint256> &pubCoinValueHashes) {
+    CDBBatch batch(*this);
+    for (std::vector<uint256>::const_iterator it=pubCoinValueHashes.begin(); it!=pubCoinValueHashes.end(); it++)
+        batch.Erase(std::make_pair(DB_SIGMAMINTINDEX, *it));
+    return WriteBatch(batch);
+}
+
 bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
     CDBBatch batch(*this);
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
@@ -348,8 +442,60 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+static boost::filesystem::path GetBlockIndexFilePath()
+{
+    return GetDataDir() / "blocks" / "blockindex.dat";
+}
+
+bool CBlockTreeDB::WriteBlockIndexFile(const std::vector<const CBlockIndex*>& vpindex)
+{
+    uint256 token = GetRandHash();
+    if (!CBlockIndexFile(GetBlockIndexFilePath()).Write(vpindex, token))
+        return false;
+    return Write(DB_BLOCK_INDEX_FILE, token, true);
+}
+
+bool CBlockTreeDB::LoadBlockIndexFile(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+{
+    uint256 token;
+    if (!Read(DB_BLOCK_INDEX_FILE, token))
+        return false;
+
+    int64_t nStart = GetTimeMillis();
+    std::vector<CBlockIndex*> vExtended;
+    if (!CBlockIndexFile(GetBlockIndexFilePath()).Load(token, insertBlockIndex, vExtended))
+        return false;
+
+    // Only the entries with zerocoin, sigma, lelantus or spork data are read from the database
+    for (CBlockIndex* pindex : vExtended) {
+        boost::this_thread::interruption_point();
+        CDiskBlockIndex diskindex;
+        if (!Read(std::make_pair(DB_BLOCK_INDEX, pindex->GetBlockHash()), diskindex))
+            return error("%s: failed to read block index entry %s", __func__, pindex->GetBlockHash().ToString());
+
+        pindex->accumulatorChanges = diskindex.accumulatorChanges;
+        pindex->mintedPubCoins     = diskindex.mintedPubCoins;
+        pindex->spentSerials       = diskindex.spentSerials;
+
+        pindex->sigmaMintedPubCoins   = diskindex.sigmaMintedPubCoins;
+        pindex->sigmaSpentSerials     = diskindex.sigmaSpentSerials;
+
+        pindex->lelantusMintedPubCoins   = diskindex.lelantusMintedPubCoins;
+        pindex->lelantusSpentSerials     = diskindex.lelantusSpentSerials;
+
+        pindex->activeDisablingSporks = diskindex.activeDisablingSporks;
+    }
+
+    LogPrintf("%s: loaded block index from %s in %dms, %u entries read from the database\n",
+              __func__, GetBlockIndexFilePath().string(), GetTimeMillis() - nStart, vExtended.size());
+    return true;
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
 {
+    if (GetBoolArg("-blockindexfile", DEFAULT_BLOCK_INDEX_FILE) && LoadBlockIndexFile(insertBlockIndex))
+        return true;
+
     auto consensusParams = Params().GetConsensus();
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
@@ -464,6 +610,35 @@ bool CBlockTreeDB::ReadTotalSupply(CAmount & supply)
     return false;
 }
 
+bool CBlockTreeDB::ReadUTXOStats(const uint256 &hashBlock, CUTXOStats &stats)
+{
+    return Read(std::make_pair(DB_UTXOSTATS, hashBlock), stats);
+}
+
+bool CBlockTreeDB::WriteUTXOStats(const CUTXOStats &stats, const uint256 &hashExpired)
+{
+    CDBBatch batch(*this);
+    batch.Write(std::make_pair(DB_UTXOSTATS, stats.hashBlock), stats);
+    if (!hashExpired.IsNull())
+        batch.Erase(std::make_pair(DB_UTXOSTATS, hashExpired));
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadBlockFilter(const uint256 &hashBlock, CBlockFilterIndexValue &value)
+{
+    return Read(std::make_pair(DB_BLOCKFILTER, hashBlock), value);
+}
+
+bool CBlockTreeDB::WriteBlockFilter(const uint256 &hashBlock, const CBlockFilterIndexValue &value)
+{
+    return Write(std::make_pair(DB_BLOCKFILTER, hashBlock), value);
+}
+
+bool CBlockTreeDB::HaveBlockFilter(const uint256 &hashBlock)
+{
+    return Exists(std::make_pair(DB_BLOCKFILTER, hashBlock));
+}
+
 /******************************************************************************/
 
 CDbIndexHelper::CDbIndexHelper(bool addressIndex_, bool spentIndex_)
@@ -9,7 +9,10 @@
 #include "coins.h"
 #include "dbwrapper.h"
 #include "chain.h"
+#include "blockfilterindex.h"
 #include "spentindex.h"
+#include "sigmamintindex.h"
+#include "utxostats.h"
 
 #include <map>
 #include <string>
@@ -30,6 +33,8 @@ static constexpr int EVO_DB_USAGE_FACTOR = 30;
 static constexpr int MAX_BLOCK_COINSDB_USAGE = 10 * DB_PEAK_USAGE_FACTOR;
 //! -dbcache default (MiB)
 static const int64_t nDefaultDbCache = 450;
+//! -dbbatchsize default (bytes)
+static const int64_t nDefaultDbBatchSize = 16 << 20;
 //! max. -dbcache (MiB)
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 16384 : 1024;
 //! min. -dbcache (MiB)
@@ -79,12 +84,19 @@ public:
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
     uint256 GetBestBlock() const override;
+    std::vector<uint256> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
+    bool BatchWritePartial(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
 
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
     size_t EstimateSize() const override;
+
+private:
+    //! Write the changes in mapCoins in batches of -dbbatchsize bytes, moving
+    //! the best block to hashBlock once they are all on disk if fComplete.
+    bool WriteCoins(CCoinsMap &mapCoins, const uint256 &hashBlock, bool fComplete);
 };
 
 /** Specialization of CCoinsViewCursor to iterate over a CCoinsViewDB */
@@ -119,6 +131,8 @@ private:
     void operator=(const CBlockTreeDB&);
 public:
     bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo);
+    //! Write block index entries as they are, keyed by their block hash, e.g. the ones of a chain state snapshot
+    bool WriteBlockIndexEntries(const std::vector<std::pair<uint256, CDiskBlockIndex> >& entries);
     bool ReadBlockFileInfo(int nFile, CBlockFileInfo &fileinfo);
     bool ReadLastBlockFile(int &nFile);
     bool WriteReindexing(bool fReindex);
@@ -127,6 +141,9 @@ public:
     bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &list);
     bool ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
     bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect);
+    bool ReadSigmaMintIndex(const uint256 &pubCoinValueHash, CSigmaMintIndexValue &value);
+    bool WriteSigmaMintIndex(const std::vector<std::pair<uint256, CSigmaMintIndexValue> > &vect);
+    bool EraseSigmaMintIndex(const std::vector<uint256> &pubCoinValueHashes);
     bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
     bool ReadAddressUnspentIndex(uint160 addressHash, AddressType type,
                                  std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
@@ -141,10 +158,20 @@ public:
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+    //! Write the flat block index file, all entries must already be written to the database
+    bool WriteBlockIndexFile(const std::vector<const CBlockIndex*>& vpindex);
     int GetBlockIndexVersion();
     int GetBlockIndexVersion(uint256 const & blockHash);
     bool AddTotalSupply(CAmount const & supply);
     bool ReadTotalSupply(CAmount & supply);
+    bool ReadUTXOStats(const uint256 &hashBlock, CUTXOStats &stats);
+    //! Write the statistics of a block and erase the ones of hashExpired, which are no longer kept
+    bool WriteUTXOStats(const CUTXOStats &stats, const uint256 &hashExpired);
+    bool ReadBlockFilter(const uint256 &hashBlock, CBlockFilterIndexValue &value);
+    bool WriteBlockFilter(const uint256 &hashBlock, const CBlockFilterIndexValue &value);
+    bool HaveBlockFilter(const uint256 &hashBlock);
+private:
+    bool LoadBlockIndexFile(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
 };
 
 
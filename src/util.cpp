@@ -10,6 +10,7 @@
 #include "util.h"
 
 #include "support/allocators/secure.h"
+#include "asynclog.h"
 #include "chainparamsbase.h"
 #include "ctpl.h"
 #include "random.h"
@@ -198,10 +199,10 @@ instance_of_cinit;
 static boost::once_flag debugPrintInitFlag = BOOST_ONCE_INIT;
 
 /**
- * We use boost::call_once() to make sure mutexDebugLog and
- * vMsgsBeforeOpenLog are initialized in a thread-safe manner.
+ * We use boost::call_once() to make sure mutexDebugLog,
+ * vMsgsBeforeOpenLog and debugLogSink are initialized in a thread-safe manner.
  *
- * NOTE: fileout, mutexDebugLog and sometimes vMsgsBeforeOpenLog
+ * NOTE: fileout, mutexDebugLog, debugLogSink and sometimes vMsgsBeforeOpenLog
  * are leaked on exit. This is ugly, but will be cleaned up by
  * the OS/libc. When the shutdown sequence is fully audited and
  * tested, explicit destruction of these objects can be implemented.
@@ -209,17 +210,98 @@ static boost::once_flag debugPrintInitFlag = BOOST_ONCE_INIT;
 static FILE* fileout = NULL;
 static boost::mutex* mutexDebugLog = NULL;
 static list<string> *vMsgsBeforeOpenLog;
+static CLogSink* debugLogSink = NULL;
 
 static int FileWriteStr(const std::string &str, FILE *fp)
 {
     return fwrite(str.data(), 1, str.size(), fp);
 }
 
+/**
+ * fStartedNewLine is a state variable held by the log sink that will
+ * suppress printing of the timestamp when multiple calls are made that don't
+ * end in a newline. Initialize it to true, and hold it, in the log sink.
+ */
+static std::string LogTimestampStr(const std::string &str, int64_t nTimeMicros, std::atomic_bool *fStartedNewLine)
+{
+    string strStamped;
+
+    if (!fLogTimestamps)
+        return str;
+
+    if (*fStartedNewLine) {
+        strStamped = DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nTimeMicros/1000000);
+        if (fLogTimeMicros)
+            strStamped += strprintf(".%06d", nTimeMicros%1000000);
+        strStamped += ' ' + str;
+    } else
+        strStamped = str;
+
+    if (!str.empty() && str[str.size()-1] == '\n')
+        *fStartedNewLine = true;
+    else
+        *fStartedNewLine = false;
+
+    return strStamped;
+}
+
+/** The console, or debug.log, written by LogPrintStr or the logging thread */
+class CDebugLogSink : public CLogSink
+{
+private:
+    std::atomic_bool fStartedNewLine;
+
+public:
+    CDebugLogSink() : fStartedNewLine(true) {}
+
+    std::string Stamp(const std::string& str, int64_t nTimeMicros) override
+    {
+        return LogTimestampStr(str, nTimeMicros, &fStartedNewLine);
+    }
+
+    int Write(const std::string& strTimestamped) override
+    {
+        int ret = 0; // Returns total number of characters written
+
+        if (fPrintToConsole)
+        {
+            // print to console
+            ret = fwrite(strTimestamped.data(), 1, strTimestamped.size(), stdout);
+            fflush(stdout);
+        }
+        else if (fPrintToDebugLog)
+        {
+            boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
+
+            // buffer if we haven't opened the log yet
+            if (fileout == NULL) {
+                assert(vMsgsBeforeOpenLog);
+                ret = strTimestamped.length();
+                vMsgsBeforeOpenLog->push_back(strTimestamped);
+            }
+            else
+            {
+                // reopen the log file, if requested
+                if (fReopenDebugLog) {
+                    fReopenDebugLog = false;
+                    boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
+                    if (freopen(pathDebug.string().c_str(),"a",fileout) != NULL)
+                        setbuf(fileout, NULL); // unbuffered
+                }
+
+                ret = FileWriteStr(strTimestamped, fileout);
+            }
+        }
+        return ret;
+    }
+};
+
 static void DebugPrintInit()
 {
     assert(mutexDebugLog == NULL);
     mutexDebugLog = new boost::mutex();
     vMsgsBeforeOpenLog = new list<string>;
+    debugLogSink = new CDebugLogSink();
 }
 
 
@@ -287,73 +369,29 @@ bool LogAcceptCategory(const char* category)
     return true;
 }
 
-/**
- * fStartedNewLine is a state variable held by the calling context that will
- * suppress printing of the timestamp when multiple calls are made that don't
- * end in a newline. Initialize it to true, and hold it, in the calling context.
- */
-static std::string LogTimestampStr(const std::string &str, std::atomic_bool *fStartedNewLine)
+int LogPrintStr(const std::string &str)
 {
-    string strStamped;
-
-    if (!fLogTimestamps)
-        return str;
-
-    if (*fStartedNewLine) {
-        int64_t nTimeMicros = GetLogTimeMicros();
-        strStamped = DateTimeStrFormat("%Y-%m-%d %H:%M:%S", nTimeMicros/1000000);
-        if (fLogTimeMicros)
-            strStamped += strprintf(".%06d", nTimeMicros%1000000);
-        strStamped += ' ' + str;
-    } else
-        strStamped = str;
+    if (!fPrintToConsole && !fPrintToDebugLog)
+        return 0;
 
-    if (!str.empty() && str[str.size()-1] == '\n')
-        *fStartedNewLine = true;
-    else
-        *fStartedNewLine = false;
-
-    return strStamped;
+    boost::call_once(&DebugPrintInit, debugPrintInitFlag);
+    int64_t nTimeMicros = GetLogTimeMicros();
+    // Timestamped when logged, written by the logging thread if it is running
+    if (AsyncLogPush(debugLogSink, nTimeMicros, std::string(str), std::function<std::string()>()))
+        return str.size();
+    return debugLogSink->Write(debugLogSink->Stamp(str, nTimeMicros));
 }
 
-int LogPrintStr(const std::string &str)
+void LogPrintDeferredStr(std::function<std::string()>&& format)
 {
-    int ret = 0; // Returns total number of characters written
-    static std::atomic_bool fStartedNewLine(true);
-
-    string strTimestamped = LogTimestampStr(str, &fStartedNewLine);
+    if (!fPrintToConsole && !fPrintToDebugLog)
+        return;
 
-    if (fPrintToConsole)
-    {
-        // print to console
-        ret = fwrite(strTimestamped.data(), 1, strTimestamped.size(), stdout);
-        fflush(stdout);
-    }
-    else if (fPrintToDebugLog)
-    {
-        boost::call_once(&DebugPrintInit, debugPrintInitFlag);
-        boost::mutex::scoped_lock scoped_lock(*mutexDebugLog);
-
-        // buffer if we haven't opened the log yet
-        if (fileout == NULL) {
-            assert(vMsgsBeforeOpenLog);
-            ret = strTimestamped.length();
-            vMsgsBeforeOpenLog->push_back(strTimestamped);
-        }
-        else
-        {
-            // reopen the log file, if requested
-            if (fReopenDebugLog) {
-                fReopenDebugLog = false;
-                boost::filesystem::path pathDebug = GetDataDir() / "debug.log";
-                if (freopen(pathDebug.string().c_str(),"a",fileout) != NULL)
-                    setbuf(fileout, NULL); // unbuffered
-            }
-
-            ret = FileWriteStr(strTimestamped, fileout);
-        }
-    }
-    return ret;
+    boost::call_once(&DebugPrintInit, debugPrintInitFlag);
+    int64_t nTimeMicros = GetLogTimeMicros();
+    if (AsyncLogPush(debugLogSink, nTimeMicros, std::string(), std::move(format)))
+        return;
+    debugLogSink->Write(debugLogSink->Stamp(format(), nTimeMicros));
 }
 
 /** Interpret string as boolean, for argument parsing */
@@ -21,9 +21,11 @@
 
 #include <atomic>
 #include <exception>
+#include <functional>
 #include <map>
 #include <stdint.h>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -40,6 +42,9 @@ using namespace boost::placeholders;
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS        = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
+/** Messages queued for the logging thread, 0 to write the log synchronously */
+static const unsigned int DEFAULT_LOGQUEUESIZE = 0;
+static const unsigned int MAX_LOGQUEUESIZE = 1 << 24;
 
 /** Signals for translation. */
 class CTranslationInterface
@@ -108,6 +113,37 @@ int LogPrintStr(const std::string &str);
     LogPrintStr(tfm::format(__VA_ARGS__)); \
 } while(0)
 
+/** Send a message formatted when it is written to the log output, in the logging thread if it is running */
+void LogPrintDeferredStr(std::function<std::string()>&& format);
+
+/** Arguments of a deferred message are copied, and C strings copied to strings, as it outlives them */
+template<typename T> struct CDeferredLogArg { typedef T type; };
+template<> struct CDeferredLogArg<const char*> { typedef std::string type; };
+template<> struct CDeferredLogArg<char*> { typedef std::string type; };
+
+struct CDeferredLogFormatter
+{
+    template<typename... Args>
+    std::string operator()(const char* fmt, const Args&... args) const
+    {
+        return tfm::format(fmt, args...);
+    }
+};
+
+/** Format a message later, fmt has to be a string literal */
+template<typename... Args>
+std::function<std::string()> MakeDeferredLogFormat(const char* fmt, const Args&... args)
+{
+    return std::bind(CDeferredLogFormatter(), fmt, typename CDeferredLogArg<typename std::decay<Args>::type>::type(args)...);
+}
+
+/** LogPrint, formatting the message in the logging thread. For frequent messages with a literal format string */
+#define LogPrintDeferred(category, ...) do { \
+    if (LogAcceptCategory((category))) { \
+        LogPrintDeferredStr(MakeDeferredLogFormat(__VA_ARGS__)); \
+    } \
+} while(0)
+
 template<typename... Args>
 bool error(const char* fmt, const Args&... args)
 {
@@ -0,0 +1,167 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "utxostats.h"
+
+#include "chain.h"
+#include "coins.h"
+#include "init.h"
+#include "streams.h"
+#include "txdb.h"
+#include "util.h"
+#include "validation.h"
+#include "version.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+//! Statistics of the UTXO set at the tip, when fUTXOStatsTip is set
+CUTXOStats utxoStatsTip;
+bool fUTXOStatsTip = false;
+
+//! Rough size of a coin in the set: outpoint, height and coinbase flag, amount and script
+uint64_t GetBogoSize(const Coin& coin)
+{
+    return 32 + 4 + 4 + 8 + 2 + coin.out.scriptPubKey.size();
+}
+
+std::vector<unsigned char> SerializeCoin(const COutPoint& outpoint, const Coin& coin)
+{
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << outpoint;
+    ss << (uint32_t)(coin.nHeight * 2 + coin.fCoinBase);
+    ss << coin.out;
+    return std::vector<unsigned char>(ss.begin(), ss.end());
+}
+
+bool WriteUTXOStatsTip(const CBlockIndex* pindex)
+{
+    const CBlockIndex* pindexExpired = pindex->GetAncestor(pindex->nHeight - UTXO_STATS_BLOCKS_TO_KEEP);
+    return pblocktree->WriteUTXOStats(utxoStatsTip, pindexExpired ? pindexExpired->GetBlockHash() : uint256());
+}
+
+}
+
+void CUTXOStats::AddCoin(const COutPoint& outpoint, const Coin& coin)
+{
+    std::vector<unsigned char> data = SerializeCoin(outpoint, coin);
+    muhash.Insert(data.data(), data.size());
+    nTransactionOutputs++;
+    nBogoSize += GetBogoSize(coin);
+    nTotalAmount += coin.out.nValue;
+}
+
+void CUTXOStats::RemoveCoin(const COutPoint& outpoint, const Coin& coin)
+{
+    std::vector<unsigned char> data = SerializeCoin(outpoint, coin);
+    muhash.Remove(data.data(), data.size());
+    nTransactionOutputs--;
+    nBogoSize -= GetBogoSize(coin);
+    nTotalAmount -= coin.out.nValue;
+}
+
+void CUTXOStats::ApplyChanges(const CCoinsViewCache& view)
+{
+    view.ForEachModifiedCoin([this](const COutPoint& outpoint, const Coin& coinBefore, const Coin& coinAfter) {
+        if (!coinBefore.IsSpent())
+            RemoveCoin(outpoint, coinBefore);
+        if (!coinAfter.IsSpent())
+            AddCoin(outpoint, coinAfter);
+    });
+}
+
+uint256 CUTXOStats::GetMuHash() const
+{
+    MuHash3072 muhashCopy = muhash;
+    uint256 hash;
+    muhashCopy.Finalize(hash);
+    return hash;
+}
+
+void LoadUTXOStats()
+{
+    LOCK(cs_main);
+    fUTXOStatsTip = false;
+    if (!fUTXOStats)
+        return;
+
+    CBlockIndex* pindexTip = chainActive.Tip();
+    if (pindexTip == NULL) {
+        // The genesis block is connected on top of the empty set
+        utxoStatsTip = CUTXOStats();
+        fUTXOStatsTip = true;
+    } else if (pblocktree->ReadUTXOStats(pindexTip->GetBlockHash(), utxoStatsTip)) {
+        fUTXOStatsTip = true;
+    } else {
+        LogPrintf("%s: no UTXO set statistics for block %s, they will be built\n", __func__, pindexTip->GetBlockHash().ToString());
+    }
+}
+
+bool UpdateUTXOStats(const CBlockIndex* pindexFrom, const CBlockIndex* pindexTo, const CCoinsViewCache& view)
+{
+    AssertLockHeld(cs_main);
+    if (!fUTXOStats || !fUTXOStatsTip)
+        return true;
+    if (utxoStatsTip.hashBlock != (pindexFrom ? pindexFrom->GetBlockHash() : uint256())) {
+        // Only the tip moves them, they can't follow blocks they've missed: build them again on the next start
+        LogPrintf("%s: UTXO set statistics at block %s, not %s, dropping them\n", __func__,
+            utxoStatsTip.hashBlock.ToString(), pindexFrom ? pindexFrom->GetBlockHash().ToString() : "null");
+        fUTXOStatsTip = false;
+        return true;
+    }
+
+    utxoStatsTip.ApplyChanges(view);
+    utxoStatsTip.hashBlock = pindexTo->GetBlockHash();
+    utxoStatsTip.nHeight = pindexTo->nHeight;
+    return WriteUTXOStatsTip(pindexTo);
+}
+
+bool GetBlockUTXOStats(const CBlockIndex* pindex, CUTXOStats& stats)
+{
+    AssertLockHeld(cs_main);
+    if (fUTXOStatsTip && utxoStatsTip.hashBlock == pindex->GetBlockHash()) {
+        stats = utxoStatsTip;
+        return true;
+    }
+    return pblocktree->ReadUTXOStats(pindex->GetBlockHash(), stats);
+}
+
+void BuildUTXOStats()
+{
+    LOCK(cs_main);
+    if (!fUTXOStats || fUTXOStatsTip)
+        return;
+
+    // The statistics are taken from the database, with all the blocks connected so far
+    FlushStateToDisk();
+    std::unique_ptr<CCoinsViewCursor> pcursor(pcoinsTip->Cursor());
+    BlockMap::const_iterator it = mapBlockIndex.find(pcursor->GetBestBlock());
+    if (it == mapBlockIndex.end())
+        return;
+
+    LogPrintf("Building the UTXO set statistics at block %s...\n", pcursor->GetBestBlock().ToString());
+    CUTXOStats stats;
+    stats.hashBlock = it->second->GetBlockHash();
+    stats.nHeight = it->second->nHeight;
+    while (pcursor->Valid()) {
+        if (ShutdownRequested())
+            return;
+        COutPoint key;
+        Coin coin;
+        if (!pcursor->GetKey(key) || !pcursor->GetValue(coin)) {
+            LogPrintf("%s: unable to read the UTXO set\n", __func__);
+            return;
+        }
+        stats.AddCoin(key, coin);
+        pcursor->Next();
+    }
+
+    utxoStatsTip = stats;
+    fUTXOStatsTip = true;
+    if (!WriteUTXOStatsTip(it->second))
+        LogPrintf("%s: failed to write the UTXO set statistics\n", __func__);
+    LogPrintf("UTXO set statistics built, %u outputs\n", stats.nTransactionOutputs);
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2018-2020 The TecraCoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTXOSTATS_H
+#define BITCOIN_UTXOSTATS_H
+
+#include "amount.h"
+#include "crypto/muhash.h"
+#include "serialize.h"
+#include "uint256.h"
+
+class CBlockIndex;
+class CCoinsViewCache;
+class COutPoint;
+class Coin;
+
+/** Number of blocks below the tip the UTXO set statistics are kept for */
+static const int UTXO_STATS_BLOCKS_TO_KEEP = 2016;
+
+/**
+ * Statistics and MuHash3072 of the UTXO set at a block. They are kept up to
+ * date as blocks are connected and disconnected (-utxostats) and stored for
+ * the recent blocks in the block tree database.
+ */
+class CUTXOStats
+{
+public:
+    uint256 hashBlock;
+    int nHeight;
+    uint64_t nTransactionOutputs;
+    //! Size of the set estimated from its coins, which doesn't depend on the database format
+    uint64_t nBogoSize;
+    CAmount nTotalAmount;
+    MuHash3072 muhash;
+
+    CUTXOStats() : nHeight(-1), nTransactionOutputs(0), nBogoSize(0), nTotalAmount(0) {}
+
+    void AddCoin(const COutPoint& outpoint, const Coin& coin);
+    void RemoveCoin(const COutPoint& outpoint, const Coin& coin);
+
+    //! Apply the changes of view, a cache on top of the UTXO set of these statistics
+    void ApplyChanges(const CCoinsViewCache& view);
+
+    //! The hash of the set, computing it takes a few milliseconds
+    uint256 GetMuHash() const;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(nHeight);
+        READWRITE(nTransactionOutputs);
+        READWRITE(nBogoSize);
+        READWRITE(nTotalAmount);
+        READWRITE(muhash);
+    }
+};
+
+/** Take the statistics of the UTXO set at the tip of chainActive from the ones stored for it */
+void LoadUTXOStats();
+
+/**
+ * Move the statistics of the tip from pindexFrom to pindexTo, a block
+ * connected to or disconnected from chainActive through view, and store them
+ * for pindexTo. Only called by ConnectTip and DisconnectTip: blocks checked on
+ * other views (VerifyDB) must not move them.
+ */
+bool UpdateUTXOStats(const CBlockIndex* pindexFrom, const CBlockIndex* pindexTo, const CCoinsViewCache& view);
+
+/** Statistics of the UTXO set at pindex, if it is the tip or one of the recent blocks they're kept for */
+bool GetBlockUTXOStats(const CBlockIndex* pindex, CUTXOStats& stats);
+
+/** Compute the statistics of the tip from the whole UTXO set, when they weren't kept up to it */
+void BuildUTXOStats();
+
+#endif // BITCOIN_UTXOSTATS_H
@@ -12,16 +12,20 @@
 #include "zerocoin.h"
 
 #include "arith_uint256.h"
+#include "blockfilterindex.h"
+#include "blockprefetch.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "checkqueue.h"
 #include "consensus/consensus.h"
 #include "consensus/merkle.h"
 #include "consensus/validation.h"
+#include "ctpl.h"
 #include "hash.h"
 #include "init.h"
 #include "base58.h"
 #include "merkleblock.h"
+#include "metrics.h"
 #include "net.h"
 #include "policy/fees.h"
 #include "policy/policy.h"
@@ -50,6 +54,7 @@
 #include "versionbits.h"
 #include "definition.h"
 #include "utiltime.h"
+#include "utxostats.h"
 #include "mtpstate.h"
 
 #include "coins.h"
@@ -114,6 +119,8 @@ bool fPruneMode = false;
 bool fAddressIndex = false;
 bool fSpentIndex = false;
 bool fTimestampIndex = false;
+bool fUTXOStats = DEFAULT_UTXOSTATS;
+bool fBlockFilterIndex = DEFAULT_BLOCKFILTERINDEX;
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
 bool fRequireStandard = true;
 bool fCheckBlockIndex = false;
@@ -132,6 +139,14 @@ CTxMemPool mempool(::minRelayTxFee);
 FeeFilterRounder filterRounder(::minRelayTxFee);
 CTxPoolAggregate txpools(::minRelayTxFee);
 
+static CMetricFunction metricMempoolTransactions("tecracoin_mempool_transactions", "Transactions in the mempool",
+    MetricType::GAUGE, [] { return (double)mempool.size(); });
+static CMetricFunction metricMempoolBytes("tecracoin_mempool_bytes", "Total size of the transactions in the mempool",
+    MetricType::GAUGE, [] { return (double)mempool.GetTotalTxSize(); });
+static CMetricHistogram metricMempoolAccept("tecracoin_mempool_accept_seconds", "Time spent checking transactions for the mempool");
+static CMetricCounter metricMempoolAccepted("tecracoin_mempool_accept_total", "Transactions checked for the mempool", "result", "accepted");
+static CMetricCounter metricMempoolRejected("tecracoin_mempool_accept_total", "Transactions checked for the mempool", "result", "rejected");
+
 // TecraCoin tnode
 map <uint256, int64_t> mapRejectedBlocks GUARDED_BY(cs_main);
 
@@ -206,6 +221,12 @@ namespace {
 
     /** Dirty block file entries. */
     std::set<int> setDirtyFileInfo;
+
+    /** Set while mapBlockIndex may hold only part of the block tree database. */
+    bool fBlockIndexPartial = false;
+
+    /** Set while the coins database holds only part of the changes up to the tip (-partialflush). */
+    bool fCoinsPartiallyFlushed = false;
 } // anon namespace
 
 int GetHeight()
@@ -1519,7 +1540,12 @@ bool AcceptToMemoryPoolWithTime(CTxMemPool& pool, CValidationState &state, const
 {
     LogPrintf("AcceptToMemoryPool(), transaction: %s\n", tx->GetHash().ToString());
     std::vector<COutPoint> coins_to_uncache;
+    int64_t nTimeStart = GetTimeMicros();
     bool res = AcceptToMemoryPoolWorker(pool, state, tx, fLimitFree, pfMissingInputs, nAcceptTime, plTxnReplaced, fOverrideMempoolLimit, nAbsurdFee, coins_to_uncache, isCheckWalletTransaction, markFiroSpendTransactionSerial);
+    if (&pool == &mempool) {
+        metricMempoolAccept.Observe(GetTimeMicros() - nTimeStart);
+        (res ? metricMempoolAccepted : metricMempoolRejected).Inc();
+    }
     if (!res) {
         BOOST_FOREACH(const COutPoint& hashTx, coins_to_uncache)
             pcoinsTip->Uncache(hashTx);
@@ -1722,6 +1748,40 @@ bool ReadBlockFromDisk(CBlock &block, const CBlockIndex *pindex, const Consensus
     return true;
 }
 
+bool ReadRawBlockFromDisk(std::vector<unsigned char>& block, const CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart)
+{
+    // The block is preceded on disk by its message start and size (see WriteBlockToDisk)
+    if (pos.nPos < CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int))
+        return error("ReadRawBlockFromDisk: invalid block position %s", pos.ToString());
+
+    CDiskBlockPos hpos = pos;
+    hpos.nPos -= CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int);
+    CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("ReadRawBlockFromDisk: OpenBlockFile failed for %s", pos.ToString());
+
+    try {
+        CMessageHeader::MessageStartChars blkStart;
+        unsigned int nSize;
+        filein >> FLATDATA(blkStart) >> nSize;
+
+        if (memcmp(blkStart, messageStart, CMessageHeader::MESSAGE_START_SIZE))
+            return error("%s: Block magic mismatch for %s", __func__, pos.ToString());
+
+        if (nSize > MAX_BLOCK_SERIALIZED_SIZE)
+            return error("%s: Block data is larger than maximum deserialization size for %s: %u > %u",
+                         __func__, pos.ToString(), nSize, MAX_BLOCK_SERIALIZED_SIZE);
+
+        block.resize(nSize);
+        filein.read((char*)block.data(), nSize);
+    }
+    catch (const std::exception &e) {
+        return error("%s: Read from block file failed: %s for %s", __func__, e.what(), pos.ToString());
+    }
+
+    return true;
+}
+
 bool ReadBlockHeaderFromDisk(CBlock &block, const CDiskBlockPos &pos) {
     CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
     if (filein.IsNull())
@@ -2139,6 +2199,8 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
+} // anon namespace
+
 bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock)
 {
     // Open history file to read
@@ -2165,8 +2227,6 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uin
     return true;
 }
 
-} // anon namespace
-
 /** Abort with a message */
 bool AbortNode(const std::string& strMessage, const std::string& userMessage)
 {
@@ -2450,6 +2510,15 @@ static int64_t nTimeIndex = 0;
 static int64_t nTimeCallbacks = 0;
 static int64_t nTimeTotal = 0;
 
+static CMetricHistogram metricConnectSanityChecks("tecracoin_connectblock_phase_seconds", "Time spent in each phase of ConnectBlock", "phase", "sanity_checks");
+static CMetricHistogram metricConnectForkChecks("tecracoin_connectblock_phase_seconds", "Time spent in each phase of ConnectBlock", "phase", "fork_checks");
+static CMetricHistogram metricConnectTransactions("tecracoin_connectblock_phase_seconds", "Time spent in each phase of ConnectBlock", "phase", "connect_transactions");
+static CMetricHistogram metricConnectVerify("tecracoin_connectblock_phase_seconds", "Time spent in each phase of ConnectBlock", "phase", "verify");
+static CMetricHistogram metricConnectIndex("tecracoin_connectblock_phase_seconds", "Time spent in each phase of ConnectBlock", "phase", "index");
+static CMetricHistogram metricConnectCallbacks("tecracoin_connectblock_phase_seconds", "Time spent in each phase of ConnectBlock", "phase", "callbacks");
+static CMetricCounter metricConnectedTransactions("tecracoin_connectblock_transactions_total", "Transactions of the blocks connected");
+static CMetricCounter metricConnectedInputs("tecracoin_connectblock_inputs_total", "Inputs of the transactions of the blocks connected");
+
 bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex,
                   CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck)
 {
@@ -2481,8 +2550,11 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     // Special case for the genesis block, skipping connection of its transactions
     // (its coinbase is unspendable)
     if (block.GetHash() == chainparams.GetConsensus().hashGenesisBlock) {
-        if (!fJustCheck)
+        if (!fJustCheck) {
             view.SetBestBlock(pindex->GetBlockHash());
+            if (fBlockFilterIndex && !IndexBlockFilter(block, CBlockUndo(), pindex))
+                return AbortNode(state, "Failed to write block filter index");
+        }
         return true;
     }
 
@@ -2513,7 +2585,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     }
 
     int64_t nTime1 = GetTimeMicros(); nTimeCheck += nTime1 - nTimeStart;
-    LogPrint("bench", "    - Sanity checks: %.2fms [%.2fs]\n", 0.001 * (nTime1 - nTimeStart), nTimeCheck * 0.000001);
+    metricConnectSanityChecks.Observe(nTime1 - nTimeStart);
+    LogPrintDeferred("bench", "    - Sanity checks: %.2fms [%.2fs]\n", 0.001 * (nTime1 - nTimeStart), nTimeCheck * 0.000001);
 
     // Do not allow blocks that contain transactions which 'overwrite' older transactions,
     // unless those are already completely spent.
@@ -2587,7 +2660,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     }
 
     int64_t nTime2 = GetTimeMicros(); nTimeForks += nTime2 - nTime1;
-    LogPrint("bench", "    - Fork checks: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeForks * 0.000001);
+    metricConnectForkChecks.Observe(nTime2 - nTime1);
+    LogPrintDeferred("bench", "    - Fork checks: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeForks * 0.000001);
 
     CBlockUndo blockundo;
 
@@ -2725,12 +2799,16 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     block.lelantusTxInfo->Complete();
 
     int64_t nTime3 = GetTimeMicros(); nTimeConnect += nTime3 - nTime2;
-    LogPrint("bench", "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n", (unsigned)block.vtx.size(), 0.001 * (nTime3 - nTime2), 0.001 * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : 0.001 * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * 0.000001);
+    metricConnectTransactions.Observe(nTime3 - nTime2);
+    metricConnectedTransactions.Inc(block.vtx.size());
+    metricConnectedInputs.Inc(nInputs);
+    LogPrintDeferred("bench", "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n", (unsigned)block.vtx.size(), 0.001 * (nTime3 - nTime2), 0.001 * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : 0.001 * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * 0.000001);
 
     if (!control.Wait())
         return state.DoS(100, false);
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
-    LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime4 - nTime2), nInputs <= 1 ? 0 : 0.001 * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * 0.000001);
+    metricConnectVerify.Observe(nTime4 - nTime3);
+    LogPrintDeferred("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime4 - nTime2), nInputs <= 1 ? 0 : 0.001 * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * 0.000001);
 
     //btzc: Add time to check
     CAmount blockSubsidy = GetBlockSubsidy(pindex->nHeight, chainparams.GetConsensus(), pindex->nTime);
@@ -2836,6 +2914,10 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
             return AbortNode(state, "Failed to write timestamp index");
 
+    if (fBlockFilterIndex)
+        if (!IndexBlockFilter(block, blockundo, pindex))
+            return AbortNode(state, "Failed to write block filter index");
+
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
@@ -2843,7 +2925,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     batchProofContainer->finalize();
 
     int64_t nTime5 = GetTimeMicros(); nTimeIndex += nTime5 - nTime4;
-    LogPrint("bench", "    - Index writing: %.2fms [%.2fs]\n", 0.001 * (nTime5 - nTime4), nTimeIndex * 0.000001);
+    metricConnectIndex.Observe(nTime5 - nTime4);
+    LogPrintDeferred("bench", "    - Index writing: %.2fms [%.2fs]\n", 0.001 * (nTime5 - nTime4), nTimeIndex * 0.000001);
 
     // Watch for changes to the previous coinbase transaction.
     static uint256 hashPrevBestCoinBase;
@@ -2853,7 +2936,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     evoDb->WriteBestBlock(pindex->GetBlockHash());
 
     int64_t nTime6 = GetTimeMicros(); nTimeCallbacks += nTime6 - nTime5;
-    LogPrint("bench", "    - Callbacks: %.2fms [%.2fs]\n", 0.001 * (nTime6 - nTime5), nTimeCallbacks * 0.000001);
+    metricConnectCallbacks.Observe(nTime6 - nTime5);
+    LogPrintDeferred("bench", "    - Callbacks: %.2fms [%.2fs]\n", 0.001 * (nTime6 - nTime5), nTimeCallbacks * 0.000001);
 
     return true;
 }
@@ -2971,6 +3055,7 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
     static int64_t nLastWrite = 0;
     static int64_t nLastFlush = 0;
     static int64_t nLastSetChain = 0;
+    static bool fCoinsFlushed = false;
     std::set<int> setFilesToPrune;
     bool fFlushForPrune = false;
     try {
@@ -3001,7 +3086,8 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
         nLastSetChain = nNow;
     }
     int64_t nMempoolSizeMax = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
-    int64_t cacheSize = pcoinsTip->DynamicMemoryUsage() * DB_PEAK_USAGE_FACTOR;
+    // The memory of erased coins is kept for new ones, what matters is how much is in use
+    int64_t cacheSize = pcoinsTip->DynamicMemoryUsageInUse() * DB_PEAK_USAGE_FACTOR;
     cacheSize += evoDb->GetMemoryUsage() * EVO_DB_USAGE_FACTOR * DB_PEAK_USAGE_FACTOR;
     int64_t nTotalSpace = nCoinCacheUsage + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
     // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
@@ -3012,10 +3098,15 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
     bool fPeriodicWrite = mode == FLUSH_STATE_PERIODIC && nNow > nLastWrite + (int64_t)DATABASE_WRITE_INTERVAL * 1000000;
     // It's been very long since we flushed the cache. Do this infrequently, to optimize cache usage.
     bool fPeriodicFlush = mode == FLUSH_STATE_PERIODIC && nNow > nLastFlush + (int64_t)DATABASE_FLUSH_INTERVAL * 1000000;
+    // Instead of flushing all of a large cache, write its oldest coins until it is back at 80% of the limit.
+    // This needs a flushed best block for ReplayBlocks to go back to if the node stops before the next full flush.
+    int64_t nPartialFlushTarget = (8 * nTotalSpace) / 10 / DB_PEAK_USAGE_FACTOR - evoDb->GetMemoryUsage() * EVO_DB_USAGE_FACTOR;
+    bool fPartialFlush = fCacheLarge && !fPeriodicFlush && !fFlushForPrune && fCoinsFlushed && GetBoolArg("-partialflush", DEFAULT_PARTIAL_FLUSH) &&
+        nPartialFlushTarget > 0 && (size_t)nPartialFlushTarget < pcoinsTip->DynamicMemoryUsageInUse();
     // Combine all conditions that result in a full cache flush.
-    bool fDoFullFlush = (mode == FLUSH_STATE_ALWAYS) || fCacheLarge || fCacheCritical || fPeriodicFlush || fFlushForPrune;
+    bool fDoFullFlush = (mode == FLUSH_STATE_ALWAYS) || (fCacheLarge && !fPartialFlush) || fCacheCritical || fPeriodicFlush || fFlushForPrune;
     // Write blocks and block index to disk.
-    if (fDoFullFlush || fPeriodicWrite) {
+    if (fDoFullFlush || fPartialFlush || fPeriodicWrite) {
         // Depend on nMinDiskSpace to ensure we can write block index
         if (!CheckDiskSpace(0))
             return state.Error("out of disk space");
@@ -3044,6 +3135,16 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
             UnlinkPrunedFiles(setFilesToPrune);
         nLastWrite = nNow;
     }
+    // The coins written by a partial flush refer to blocks which have to be on disk as well.
+    if (fPartialFlush) {
+        size_t nCacheSizeBefore = pcoinsTip->GetCacheSize();
+        if (!CheckDiskSpace(48 * 2 * 2 * nCacheSizeBefore))
+            return state.Error("out of disk space");
+        if (!pcoinsTip->PartialFlush(nPartialFlushTarget))
+            return AbortNode(state, "Failed to write to coin database");
+        fCoinsPartiallyFlushed = true;
+        LogPrint("coindb", "%s: partially flushed %u coins\n", __func__, nCacheSizeBefore - pcoinsTip->GetCacheSize());
+    }
     // Flush best chain related state. This can only be done if the blocks / block index write was also done.
     if (fDoFullFlush) {
         // Typical Coin structures on disk are around 48 bytes in size.
@@ -3056,9 +3157,14 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
         // Flush the chainstate (which may refer to block index entries).
         if (!pcoinsTip->Flush())
             return AbortNode(state, "Failed to write to coin database");
+        fCoinsFlushed = !pcoinsTip->GetBestBlock().IsNull();
+        fCoinsPartiallyFlushed = false;
         if (!evoDb->CommitRootTransaction()) {
             return AbortNode(state, "Failed to commit EvoDB");
         }
+        // Snapshot the sigma state from time to time, so it doesn't have to be rebuilt after a crash
+        if (fPeriodicFlush && !sigma::WriteSigmaStateFile(chainActive))
+            LogPrintf("%s: failed to write the sigma state\n", __func__);
         nLastFlush = nNow;
     }
     if (fDoFullFlush || ((mode == FLUSH_STATE_ALWAYS || mode == FLUSH_STATE_PERIODIC) && nNow > nLastSetChain + (int64_t)DATABASE_WRITE_INTERVAL * 1000000)) {
@@ -3077,6 +3183,19 @@ void FlushStateToDisk() {
     FlushStateToDisk(state, FLUSH_STATE_ALWAYS);
 }
 
+void WriteBlockIndexFile() {
+    AssertLockHeld(cs_main);
+    if (!pblocktree || fBlockIndexPartial || !setDirtyBlockIndex.empty())
+        return;
+
+    std::vector<const CBlockIndex*> vpindex;
+    vpindex.reserve(mapBlockIndex.size());
+    for (const BlockMap::value_type& entry : mapBlockIndex)
+        vpindex.push_back(entry.second);
+    if (!pblocktree->WriteBlockIndexFile(vpindex))
+        LogPrintf("%s: failed to write the block index file\n", __func__);
+}
+
 void PruneAndFlush() {
     CValidationState state;
     fCheckForPruning = true;
@@ -3084,9 +3203,12 @@ void PruneAndFlush() {
 }
 
 /** Update chainActive and related internal data structures. */
+static CMetricGauge metricChainHeight("tecracoin_chain_height", "Height of the active chain");
+
 void static UpdateTip(CBlockIndex *pindexNew, const CChainParams &chainParams) {
     LogPrintf("UpdateTip() pindexNew.nHeight=%s\n", pindexNew->nHeight);
     chainActive.SetTip(pindexNew);
+    metricChainHeight.Set(pindexNew->nHeight);
 
     // New best block
     txpools.AddTransactionsUpdated(1);
@@ -3151,9 +3273,15 @@ void static UpdateTip(CBlockIndex *pindexNew, const CChainParams &chainParams) {
 }
 
 /** Disconnect chainActive's tip. You probably want to call mempool.removeForReorg and manually re-limit mempool size after this, with cs_main held. */
+static CMetricHistogram metricDisconnectTip("tecracoin_disconnecttip_seconds", "Time spent disconnecting the block of the tip");
+
 bool static DisconnectTip(CValidationState& state, const CChainParams& chainparams, bool fBare = false)
 {
     LogPrintf("DisconnectTip()\n");
+    // The coins database may hold changes of the blocks about to be disconnected, which
+    // ReplayBlocks couldn't undo after a crash: bring it to a consistent state first
+    if (fCoinsPartiallyFlushed && !FlushStateToDisk(state, FLUSH_STATE_ALWAYS))
+        return false;
     CBlockIndex *pindexDelete = chainActive.Tip();
     assert(pindexDelete);
     // Read block from disk.
@@ -3237,11 +3365,14 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
         CCoinsViewCache view(pcoinsTip);
         if (DisconnectBlock(block, state, pindexDelete, view) != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
+        if (!UpdateUTXOStats(pindexDelete, pindexDelete->pprev, view))
+            return AbortNode(state, "Failed to write UTXO set statistics");
         bool flushed = view.Flush();
         assert(flushed);
         dbTx->Commit();
     }
-    LogPrint("bench", "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
+    metricDisconnectTip.Observe(GetTimeMicros() - nStart);
+    LogPrintDeferred("bench", "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
 
 	DisconnectTipZC(block, pindexDelete);
 	sigma::DisconnectTipSigma(block, pindexDelete);
@@ -3355,6 +3486,13 @@ static int64_t nTimeFlush = 0;
 static int64_t nTimeChainState = 0;
 static int64_t nTimePostConnect = 0;
 
+static CMetricHistogram metricConnectTipReadBlock("tecracoin_connecttip_phase_seconds", "Time spent in each phase of connecting a block to the tip", "phase", "read_block");
+static CMetricHistogram metricConnectTipConnect("tecracoin_connecttip_phase_seconds", "Time spent in each phase of connecting a block to the tip", "phase", "connect");
+static CMetricHistogram metricConnectTipFlush("tecracoin_connecttip_phase_seconds", "Time spent in each phase of connecting a block to the tip", "phase", "flush");
+static CMetricHistogram metricConnectTipChainState("tecracoin_connecttip_phase_seconds", "Time spent in each phase of connecting a block to the tip", "phase", "chainstate");
+static CMetricHistogram metricConnectTipPostProcess("tecracoin_connecttip_phase_seconds", "Time spent in each phase of connecting a block to the tip", "phase", "postprocess");
+static CMetricHistogram metricConnectTip("tecracoin_connecttip_seconds", "Time spent connecting a block to the tip");
+
 /**
  * Used to track blocks whose transactions were applied to the UTXO state as a
  * part of a single ActivateBestChainStep call.
@@ -3377,7 +3515,16 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     assert(pindexNew->pprev == chainActive.Tip());
     // Read block from disk.
     int64_t nTime1 = GetTimeMicros();
-    if (!pblock) {
+    std::shared_ptr<const CBlock> pblockPrefetched;
+    if (g_blockprefetcher) {
+        if (!pblock)
+            pblockPrefetched = g_blockprefetcher->Take(pindexNew);
+        else
+            g_blockprefetcher->Forget(pindexNew);
+    }
+    if (pblockPrefetched) {
+        connectTrace.blocksConnected.emplace_back(pindexNew, pblockPrefetched);
+    } else if (!pblock) {
         std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
         connectTrace.blocksConnected.emplace_back(pindexNew, pblockNew);
         if (!ReadBlockFromDisk(*pblockNew, pindexNew, chainparams.GetConsensus()))
@@ -3388,6 +3535,7 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     const CBlock& blockConnecting = *connectTrace.blocksConnected.back().second;
     // Apply the block atomically to the chain state.
     int64_t nTime2 = GetTimeMicros(); nTimeReadFromDisk += nTime2 - nTime1;
+    metricConnectTipReadBlock.Observe(nTime2 - nTime1);
     int64_t nTime3;
     // LogPrint("bench", "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * 0.001, nTimeReadFromDisk * 0.000001);
     {
@@ -3404,18 +3552,23 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
             return error("ConnectTip(): ConnectBlock %s failed", pindexNew->GetBlockHash().ToString());
         }
         nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTime2;
-        LogPrint("bench", "  - Connect total: %.2fms [%.2fs]\n", (nTime3 - nTime2) * 0.001, nTimeConnectTotal * 0.000001);
+        metricConnectTipConnect.Observe(nTime3 - nTime2);
+        LogPrintDeferred("bench", "  - Connect total: %.2fms [%.2fs]\n", (nTime3 - nTime2) * 0.001, nTimeConnectTotal * 0.000001);
+        if (!UpdateUTXOStats(pindexNew->pprev, pindexNew, view))
+            return AbortNode(state, "Failed to write UTXO set statistics");
         bool flushed = view.Flush();
         assert(flushed);
         dbTx->Commit();
     }
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
-    LogPrint("bench", "  - Flush: %.2fms [%.2fs]\n", (nTime4 - nTime3) * 0.001, nTimeFlush * 0.000001);
+    metricConnectTipFlush.Observe(nTime4 - nTime3);
+    LogPrintDeferred("bench", "  - Flush: %.2fms [%.2fs]\n", (nTime4 - nTime3) * 0.001, nTimeFlush * 0.000001);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(state, FLUSH_STATE_IF_NEEDED))
         return false;
     int64_t nTime5 = GetTimeMicros(); nTimeChainState += nTime5 - nTime4;
-    LogPrint("bench", "  - Writing chainstate: %.2fms [%.2fs]\n", (nTime5 - nTime4) * 0.001, nTimeChainState * 0.000001);
+    metricConnectTipChainState.Observe(nTime5 - nTime4);
+    LogPrintDeferred("bench", "  - Writing chainstate: %.2fms [%.2fs]\n", (nTime5 - nTime4) * 0.001, nTimeChainState * 0.000001);
 
 #ifdef ENABLE_ELYSIUM
     bool fElysium = isElysiumEnabled();
@@ -3441,6 +3594,7 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
 #ifdef ENABLE_ELYSIUM
         //! Elysium: new confirmed transaction notification
     if (fElysium) {
+        elysium_handler_block_spends(GetHeight(), pindexNew, blockConnecting);
         BOOST_FOREACH(CTransactionRef tx, blockConnecting.vtx) {
                 LogPrint("handler", "Elysium handler: new confirmed transaction [height: %d, idx: %u]\n", GetHeight(), nTxIdx);
                 if (elysium_handler_tx(*tx, GetHeight(), nTxIdx++, pindexNew)) ++nNumMetaTxs;
@@ -3484,8 +3638,12 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
 #endif
 
     int64_t nTime6 = GetTimeMicros(); nTimePostConnect += nTime6 - nTime5; nTimeTotal += nTime6 - nTime1;
-    LogPrint("bench", "  - Connect postprocess: %.2fms [%.2fs]\n", (nTime6 - nTime5) * 0.001, nTimePostConnect * 0.000001);
-    LogPrint("bench", "- Connect block: %.2fms [%.2fs]\n", (nTime6 - nTime1) * 0.001, nTimeTotal * 0.000001);
+    metricConnectTipPostProcess.Observe(nTime6 - nTime5);
+    metricConnectTip.Observe(nTime6 - nTime1);
+    LogPrintDeferred("bench", "  - Connect postprocess: %.2fms [%.2fs]\n", (nTime6 - nTime5) * 0.001, nTimePostConnect * 0.000001);
+    LogPrintDeferred("bench", "- Connect block: %.2fms [%.2fs]\n", (nTime6 - nTime1) * 0.001, nTimeTotal * 0.000001);
+    if (g_blockprefetcher)
+        g_blockprefetcher->BlockConnected(pindexNew);
     return true;
 }
 
@@ -3678,6 +3836,23 @@ static bool ActivateBestChainStep(CValidationState& state, const CChainParams& c
             vpindexToConnect.push_back(pindexIter);
             pindexIter = pindexIter->pprev;
         }
+
+        if (g_blockprefetcher) {
+            // Drop what a reorg or an invalid block left behind, so it doesn't hold the slots
+            g_blockprefetcher->Prune(chainActive.Tip(), pindexMostWork);
+            // Have the workers read this batch and the blocks following it while we connect,
+            // except for a block we were given
+            std::vector<const CBlockIndex*> vpindexPrefetch;
+            int nPrefetchHeight = std::min(nHeight + g_blockprefetcher->MaxBlocks(), pindexMostWork->nHeight);
+            for (const CBlockIndex *pindexPrefetch = pindexMostWork->GetAncestor(nPrefetchHeight);
+                 pindexPrefetch && pindexPrefetch->nHeight != nHeight; pindexPrefetch = pindexPrefetch->pprev) {
+                if (pindexPrefetch == pindexMostWork && pblock)
+                    continue;
+                vpindexPrefetch.push_back(pindexPrefetch);
+            }
+            std::reverse(vpindexPrefetch.begin(), vpindexPrefetch.end());
+            g_blockprefetcher->Prefetch(vpindexPrefetch);
+        }
         nHeight = nTargetHeight;
 
         // Connect new blocks.
@@ -3968,10 +4143,10 @@ bool ResetBlockFailureFlags(CBlockIndex *pindex) {
     return true;
 }
 
-CBlockIndex* AddToBlockIndex(const CBlockHeader& block)
+CBlockIndex* AddToBlockIndex(const CBlockHeader& block, const uint256* phash = NULL)
 {
     // Check for duplicate
-    uint256 hash = block.GetHash();
+    uint256 hash = phash ? *phash : block.GetHash();
     BlockMap::iterator it = mapBlockIndex.find(hash);
     if (it != mapBlockIndex.end())
         return it->second;
@@ -4488,11 +4663,11 @@ bool ContextualCheckBlock(const CBlock& block, CValidationState& state, const Co
     return true;
 }
 
-static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW = true)
+static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW = true, const uint256* phash = NULL)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
-    uint256 hash = block.GetHash();
+    uint256 hash = phash ? *phash : block.GetHash();
     BlockMap::iterator miSelf = mapBlockIndex.find(hash);
     CBlockIndex *pindex = NULL;
     if (hash != chainparams.GetConsensus().hashGenesisBlock) {
@@ -4527,7 +4702,7 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
             return error("%s: Consensus::ContextualCheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
     }
     if (pindex == NULL)
-        pindex = AddToBlockIndex(block);
+        pindex = AddToBlockIndex(block, &hash);
 
     if (ppindex)
         *ppindex = pindex;
@@ -4541,13 +4716,58 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
 }
 
 // Exposed wrapper for AcceptBlockHeader
-bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
+//! Headers hashed by every thread at least, hashing fewer isn't worth starting threads
+static const size_t MIN_HEADERS_PER_HASH_THREAD = 64;
+
+std::vector<uint256> GetBlockHeaderHashes(const std::vector<CBlockHeader>& headers)
+{
+    std::vector<uint256> hashes(headers.size());
+    auto hashHeaders = [&headers, &hashes](size_t nBegin, size_t nEnd) {
+        for (size_t i = nBegin; i < nEnd; i++) {
+            hashes[i] = headers[i].GetHash();
+            if (!headers[i].IsMTP())
+                headers[i].cachedPoWHash = hashes[i];
+        }
+    };
+
+    int nThreads = std::min(GetNumCores(), (int)(headers.size() / MIN_HEADERS_PER_HASH_THREAD));
+    if (nThreads <= 1) {
+        hashHeaders(0, headers.size());
+        return hashes;
+    }
+
+    ctpl::thread_pool workerPool(nThreads);
+    RenameThreadPool(workerPool, "bitcoin-hdrhash");
+
+    size_t nChunk = (headers.size() + nThreads - 1) / nThreads;
+    std::vector<std::future<void>> futures;
+    for (size_t nBegin = 0; nBegin < headers.size(); nBegin += nChunk) {
+        size_t nEnd = std::min(nBegin + nChunk, headers.size());
+        futures.emplace_back(workerPool.push([&hashHeaders, nBegin, nEnd](int) { hashHeaders(nBegin, nEnd); }));
+    }
+    for (auto& future : futures)
+        future.get();
+
+    workerPool.stop(true);
+    return hashes;
+}
+
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, const std::vector<uint256>* pHashes)
 {
+    // Hash the headers before taking cs_main
+    std::vector<uint256> hashes;
+    if (!pHashes) {
+        hashes = GetBlockHeaderHashes(headers);
+        pHashes = &hashes;
+    }
+    assert(pHashes->size() == headers.size());
+
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < headers.size(); i++) {
+            const CBlockHeader& header = headers[i];
             CBlockIndex *pindex = NULL; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!AcceptBlockHeader(header, state, chainparams, &pindex, true, &(*pHashes)[i])) {
                 return false;
             }
             if (ppindex) {
@@ -4904,11 +5124,131 @@ CBlockIndex * InsertBlockIndex(uint256 hash)
     return pindexNew;
 }
 
+/** Whether the transaction spends its inputs in the coins view, as in UpdateCoins */
+static bool SpendsCoins(const CTransaction& tx)
+{
+    return !tx.IsCoinBase() && !tx.IsZerocoinSpend() && !tx.IsSigmaSpend() && !tx.IsZerocoinRemint() && !tx.IsLelantusJoinSplit();
+}
+
+/** Apply the coin changes of a block, whether or not some of them are already in view */
+bool static RollforwardBlock(const CBlockIndex* pindex, CCoinsViewCache& view, const CChainParams& chainparams)
+{
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
+        return error("%s: ReadBlockFromDisk failed at %d, hash=%s", __func__, pindex->nHeight, pindex->GetBlockHash().ToString());
+
+    std::set<uint256> txIds;
+    for (const CTransactionRef& tx : block.vtx) {
+        // Duplicate transactions of old blocks don't change the coins, see ConnectBlock
+        if (!txIds.insert(tx->GetHash()).second)
+            continue;
+        if (SpendsCoins(*tx)) {
+            for (const CTxIn& txin : tx->vin)
+                view.SpendCoin(txin.prevout);
+        }
+        // Any of the outputs may be in view already
+        AddCoins(view, *tx, pindex->nHeight, true);
+    }
+    return true;
+}
+
+/** Undo the coin changes of a block, whether or not all of them are in view */
+bool static RollbackBlock(const CBlockIndex* pindex, CCoinsViewCache& view, const CChainParams& chainparams)
+{
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
+        return error("%s: ReadBlockFromDisk failed at %d, hash=%s", __func__, pindex->nHeight, pindex->GetBlockHash().ToString());
+
+    CBlockUndo blockUndo;
+    CDiskBlockPos pos = pindex->GetUndoPos();
+    if (pos.IsNull() || !UndoReadFromDisk(blockUndo, pos, pindex->pprev->GetBlockHash()))
+        return error("%s: no undo data at %d, hash=%s", __func__, pindex->nHeight, pindex->GetBlockHash().ToString());
+    if (blockUndo.vtxundo.size() + 1 != block.vtx.size())
+        return error("%s: block and undo data inconsistent", __func__);
+
+    std::set<uint256> txIds;
+    std::vector<bool> vDuplicate(block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); i++)
+        vDuplicate[i] = !txIds.insert(block.vtx[i]->GetHash()).second;
+
+    for (int i = block.vtx.size() - 1; i >= 0; i--) {
+        const CTransaction &tx = *(block.vtx[i]);
+        if (vDuplicate[i])
+            continue;
+        for (size_t o = 0; o < tx.vout.size(); o++) {
+            if (!tx.vout[o].scriptPubKey.IsUnspendable())
+                view.SpendCoin(COutPoint(tx.GetHash(), o));
+        }
+        if (SpendsCoins(tx)) {
+            CTxUndo &txundo = blockUndo.vtxundo[i-1];
+            if (txundo.vprevout.size() != tx.vin.size())
+                return error("%s: transaction and undo data inconsistent", __func__);
+            for (unsigned int j = tx.vin.size(); j-- > 0;) {
+                // An unclean result only means that the change was already there
+                if (chainparams.ApplyUndoForTxout(pindex->nHeight, tx.GetHash(), j) &&
+                        ApplyTxInUndo(std::move(txundo.vprevout[j]), view, tx.vin[j].prevout) == DISCONNECT_FAILED)
+                    return error("%s: failed to restore %s", __func__, tx.vin[j].prevout.ToString());
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Bring the coins database back to a consistent state after an interrupted
+ * flush. The coins may be anywhere between the last fully flushed best block
+ * and the tip of the flush; the rest of the chain state (EvoDB, block index)
+ * is at the former, so the coins of the newer blocks are rolled back.
+ */
+bool static ReplayBlocks(const CChainParams& chainparams, CCoinsView* view)
+{
+    LOCK(cs_main);
+
+    std::vector<uint256> vhashHeads = view->GetHeadBlocks();
+    if (vhashHeads.empty())
+        return true;
+    if (vhashHeads.size() != 2 || vhashHeads[1].IsNull())
+        return error("%s: unknown inconsistent state", __func__);
+
+    BlockMap::iterator itNew = mapBlockIndex.find(vhashHeads[0]);
+    BlockMap::iterator itOld = mapBlockIndex.find(vhashHeads[1]);
+    if (itNew == mapBlockIndex.end() || itOld == mapBlockIndex.end())
+        return error("%s: interrupted flush between unknown blocks %s and %s", __func__, vhashHeads[1].ToString(), vhashHeads[0].ToString());
+    const CBlockIndex* pindexNew = itNew->second;
+    const CBlockIndex* pindexOld = itOld->second;
+    const CBlockIndex* pindexFork = LastCommonAncestor(pindexOld, pindexNew);
+
+    uiInterface.ShowProgress(_("Replaying blocks..."), 0);
+    LogPrintf("%s: replaying the coins from %s (%d) back to %s (%d)\n", __func__,
+        pindexNew->GetBlockHash().ToString(), pindexNew->nHeight, pindexOld->GetBlockHash().ToString(), pindexOld->nHeight);
+
+    CCoinsViewCache cache(view);
+    for (const CBlockIndex* pindex = pindexNew; pindex != pindexFork; pindex = pindex->pprev) {
+        LogPrint("coindb", "Rolling back %s (%d)\n", pindex->GetBlockHash().ToString(), pindex->nHeight);
+        if (!RollbackBlock(pindex, cache, chainparams))
+            return false;
+    }
+    for (int nHeight = pindexFork->nHeight + 1; nHeight <= pindexOld->nHeight; nHeight++) {
+        const CBlockIndex* pindex = pindexOld->GetAncestor(nHeight);
+        LogPrint("coindb", "Rolling forward %s (%d)\n", pindex->GetBlockHash().ToString(), nHeight);
+        if (!RollforwardBlock(pindex, cache, chainparams))
+            return false;
+    }
+
+    cache.SetBestBlock(pindexOld->GetBlockHash());
+    if (!cache.Flush())
+        return false;
+    uiInterface.ShowProgress("", 100);
+    return true;
+}
+
 bool static LoadBlockIndexDB(const CChainParams& chainparams)
 {
     LogPrintf("LoadBlockIndexDB\n");
+    fBlockIndexPartial = true;
     if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex))
         return false;
+    fBlockIndexPartial = false;
 
     boost::this_thread::interruption_point();
 
@@ -5017,6 +5357,12 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     LogPrintf("%s: spent index %s\n", __func__, fSpentIndex ? "enabled" : "disabled");
 
 
+    // Undo what an interrupted coins flush left behind
+    if (!pcoinsTip->GetHeadBlocks().empty()) {
+        if (!ReplayBlocks(chainparams, pcoinsTip) || !pcoinsTip->Flush())
+            return error("%s: failed to replay the interrupted coins flush", __func__);
+    }
+
     // Load pointer to end of best chain
     BlockMap::iterator it = mapBlockIndex.find(pcoinsTip->GetBestBlock());
     if (it == mapBlockIndex.end())
@@ -5028,7 +5374,7 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     // some blocks in index can change as a result of ZerocoinBuildStateFromIndex() call
     set<CBlockIndex *> changes;
     ZerocoinBuildStateFromIndex(&chainActive, changes);
-    sigma::BuildSigmaStateFromIndex(&chainActive);
+    sigma::LoadSigmaState(&chainActive);
     lelantus::BuildLelantusStateFromIndex(&chainActive);
     if (!changes.empty()) {
         setDirtyBlockIndex.insert(changes.begin(), changes.end());
@@ -5265,6 +5611,7 @@ void UnloadBlockIndex()
     }
     mapBlockIndex.clear();
     fHavePruned = false;
+    fBlockIndexPartial = false;
 }
 
 bool LoadBlockIndex(const CChainParams& chainparams)
@@ -5325,6 +5672,80 @@ bool InitBlockIndex(const CChainParams& chainparams)
     return true;
 }
 
+/**
+ * Accept a block read from an external block file and connect it, together with any of its
+ * descendants that were encountered earlier. Returns false if importing should stop.
+ */
+static bool ProcessExternalBlock(const CChainParams& chainparams, const std::shared_ptr<CBlock>& pblock, const uint256& hash,
+                                 CDiskBlockPos *dbp, std::multimap<uint256, CDiskBlockPos>& mapBlocksUnknownParent, int& nLoaded)
+{
+    const CBlock& block = *pblock;
+
+    // detect out of order blocks, and store them for later
+    if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
+        LogPrint("reindex", "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                block.hashPrevBlock.ToString());
+        if (dbp)
+            mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+        return true;
+    }
+    // process in case the block isn't known yet
+    bool fAccepted = false;
+    if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
+        LOCK(cs_main);
+        CValidationState state;
+        if (AcceptBlock(pblock, state, chainparams, NULL, true, dbp, NULL)) {
+            nLoaded++;
+            fAccepted = true;
+        }
+        if (state.IsError())
+            return false;
+    } else if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex[hash]->nHeight % 1000 == 0) {
+        LogPrint("reindex", "Block Import: already had block %s at height %d\n", hash.ToString(), mapBlockIndex[hash]->nHeight);
+    }
+
+    // Activate the genesis block so normal node progress can continue
+// We should call it for every block as our tx verification algos rely on the real block heights.
+//                if (hash == chainparams.GetConsensus().hashGenesisBlock) {
+        CValidationState state;
+        // Hand over the block we just accepted so that it isn't read from disk again
+        if (!ActivateBestChain(state, chainparams, fAccepted ? pblock : std::shared_ptr<const CBlock>())) {
+            return false;
+        }
+
+    NotifyHeaderTip();
+
+    // Recursively process earlier encountered successors of this block
+    std::deque<uint256> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        uint256 head = queue.front();
+        queue.pop_front();
+        std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
+            int nHeight = mapBlockIndex[head]->nHeight+1;
+            std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
+            if (ReadBlockFromDisk(*pblockrecursive, it->second, nHeight, chainparams.GetConsensus()))
+            {
+                LogPrint("reindex", "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
+                        head.ToString());
+                LOCK(cs_main);
+                CValidationState dummy;
+                if (AcceptBlock(pblockrecursive, dummy, chainparams, NULL, true, &it->second, NULL))
+                {
+                    nLoaded++;
+                    queue.push_back(pblockrecursive->GetHash());
+                }
+            }
+            range.first++;
+            mapBlocksUnknownParent.erase(it);
+            NotifyHeaderTip();
+        }
+    }
+    return true;
+}
+
 bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskBlockPos *dbp)
 {
     // Map of disk positions for blocks with unknown parent (only used for reindex)
@@ -5332,11 +5753,29 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
     int64_t nStart = GetTimeMillis();
 
     int nLoaded = 0;
+    // Blocks read from the file that are being deserialized by the prefetcher workers, in file order
+    std::deque<std::pair<CDiskBlockPos, std::future<CBlockPrefetcher::ParsedBlock>>> queueParsing;
+    // Process the oldest block handed to the workers, returns false if importing should stop
+    auto processParsed = [&]() -> bool {
+        CDiskBlockPos pos = queueParsing.front().first;
+        CBlockPrefetcher::ParsedBlock parsed = queueParsing.front().second.get();
+        queueParsing.pop_front();
+        if (!parsed.first)
+            return true;
+        try {
+            return ProcessExternalBlock(chainparams, parsed.first, parsed.second, dbp ? &pos : NULL, mapBlocksUnknownParent, nLoaded);
+        } catch (const std::exception& e) {
+            LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+        }
+        return true;
+    };
+
     try {
         // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
         CBufferedFile blkdat(fileIn, 2*MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE+8, SER_DISK, CLIENT_VERSION);
         uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
+        bool fStop = false;
+        while (!blkdat.eof() && !fStop) {
             boost::this_thread::interruption_point();
 
             blkdat.SetPos(nRewind);
@@ -5366,79 +5805,39 @@ bool LoadExternalBlockFile(const CChainParams& chainparams, FILE* fileIn, CDiskB
                     dbp->nPos = nBlockPos;
                 blkdat.SetLimit(nBlockPos + nSize);
                 blkdat.SetPos(nBlockPos);
-                std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
-                CBlock& block = *pblock;
-                blkdat >> block;
-                nRewind = blkdat.GetPos();
 
-                // detect out of order blocks, and store them for later
-                uint256 hash = block.GetHash();
-                if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
-                    LogPrint("reindex", "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                            block.hashPrevBlock.ToString());
-                    if (dbp)
-                        mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+                if (g_blockprefetcher) {
+                    // Deserialization and hashing happen on the workers while earlier blocks are
+                    // connected here. A record that fails to deserialize is skipped as a whole.
+                    std::vector<char> vBlockData(nSize);
+                    blkdat.read(vBlockData.data(), nSize);
+                    nRewind = blkdat.GetPos();
+                    queueParsing.emplace_back(dbp ? *dbp : CDiskBlockPos(), g_blockprefetcher->Deserialize(std::move(vBlockData)));
+                    if (queueParsing.size() >= (size_t)g_blockprefetcher->MaxBlocks())
+                        fStop = !processParsed();
                     continue;
                 }
-                // process in case the block isn't known yet
-                if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
-                    LOCK(cs_main);
-                    CValidationState state;
-                    if (AcceptBlock(pblock, state, chainparams, NULL, true, dbp, NULL))
-                        nLoaded++;
-                    if (state.IsError())
-                        break;
-                } else if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex[hash]->nHeight % 1000 == 0) {
-                    LogPrint("reindex", "Block Import: already had block %s at height %d\n", hash.ToString(), mapBlockIndex[hash]->nHeight);
-                }
 
-                // Activate the genesis block so normal node progress can continue
-// We should call it for every block as our tx verification algos rely on the real block heights.
-//                if (hash == chainparams.GetConsensus().hashGenesisBlock) {
-                    CValidationState state;
-                    if (!ActivateBestChain(state, chainparams)) {
-                        break;
-                    }
+                std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+                blkdat >> *pblock;
+                nRewind = blkdat.GetPos();
 
-                NotifyHeaderTip();
-
-                // Recursively process earlier encountered successors of this block
-                std::deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
-                        int nHeight = mapBlockIndex[head]->nHeight+1;
-                        std::shared_ptr<CBlock> pblockrecursive = std::make_shared<CBlock>();
-                        if (ReadBlockFromDisk(*pblockrecursive, it->second, nHeight, chainparams.GetConsensus()))
-                        {
-                            LogPrint("reindex", "%s: Processing out of order child %s of %s\n", __func__, pblockrecursive->GetHash().ToString(),
-                                    head.ToString());
-                            LOCK(cs_main);
-                            CValidationState dummy;
-                            if (AcceptBlock(pblockrecursive, dummy, chainparams, NULL, true, &it->second, NULL))
-                            {
-                                nLoaded++;
-                                queue.push_back(pblockrecursive->GetHash());
-                            }
-                        }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                        NotifyHeaderTip();
-                    }
-                }
+                fStop = !ProcessExternalBlock(chainparams, pblock, pblock->GetHash(), dbp, mapBlocksUnknownParent, nLoaded);
             } catch (const std::exception& e) {
                 LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
             }
         }
+        while (!queueParsing.empty() && !fStop) {
+            boost::this_thread::interruption_point();
+            fStop = !processParsed();
+        }
     } catch (const std::runtime_error& e) {
         AbortNode(std::string("System error: ") + e.what());
     }
-    if (nLoaded > 0)
-        LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, GetTimeMillis() - nStart);
+    if (nLoaded > 0) {
+        int64_t nElapsed = GetTimeMillis() - nStart;
+        LogPrintf("Loaded %i blocks from external file in %dms (%.2f blocks/s)\n", nLoaded, nElapsed, 1000.0 * nLoaded / std::max(nElapsed, (int64_t)1));
+    }
     return nLoaded > 0;
 }
 
@@ -5665,6 +6064,15 @@ bool LoadMempool(void)
     int64_t failed = 0;
     int64_t nNow = GetTime();
 
+    struct MempoolEntry {
+        CTransactionRef tx;
+        int64_t nTime;
+        int64_t nFeeDelta;
+    };
+    // Transactions are dumped with their ancestors first, they are accepted in that order
+    std::vector<MempoolEntry> vEntries;
+    std::map<uint256, CAmount> mapDeltas;
+
     try {
         uint64_t version;
         file >> version;
@@ -5673,45 +6081,91 @@ bool LoadMempool(void)
         }
         uint64_t num;
         file >> num;
-        double prioritydummy = 0;
         while (num--) {
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta) {
-                mempool.PrioritiseTransaction(tx->GetHash(), tx->GetHash().ToString(), prioritydummy, amountdelta);
-            }
-            CValidationState state;
-            if (nTime + nExpiryTimeout > nNow) {
-                LOCK(cs_main);
-                AcceptToMemoryPoolWithTime(mempool, state, tx, true, NULL, nTime);
-                if (state.IsValid()) {
-                    ++count;
-                } else {
-                    ++failed;
-                }
+            MempoolEntry entry;
+            file >> entry.tx;
+            file >> entry.nTime;
+            file >> entry.nFeeDelta;
+            if (entry.nTime + nExpiryTimeout > nNow) {
+                vEntries.push_back(std::move(entry));
             } else {
                 ++skipped;
             }
-            if (ShutdownRequested())
-                return false;
         }
-        std::map<uint256, CAmount> mapDeltas;
         file >> mapDeltas;
-
-        for (const auto& i : mapDeltas) {
-            mempool.PrioritiseTransaction(i.first, i.first.ToString(), prioritydummy, i.second);
-        }
     } catch (const std::exception& e) {
         LogPrintf("Failed to deserialize mempool data on disk: %s. Continuing anyway.\n", e.what());
         return false;
     }
 
+    // Verifying the sigma spend proofs dominates the time needed to accept the transactions.
+    // They are verified on all cores first, without holding cs_main, which puts them into the
+    // spend verification cache.
+    std::vector<sigma::CSigmaSpendProofCheck> vChecks;
+    {
+        LOCK(cs_main);
+        sigma::SigmaAnonymitySetMap mapAnonymitySets;
+        for (const MempoolEntry& entry : vEntries)
+            sigma::GetSigmaSpendProofChecks(*entry.tx, vChecks, mapAnonymitySets);
+    }
+    if (!vChecks.empty()) {
+        int64_t nStart = GetTimeMillis();
+        ctpl::thread_pool pool(std::max(GetNumCores(), 1));
+        RenameThreadPool(pool, "bitcoin-mempool");
+        std::vector<std::future<bool>> vResults;
+        vResults.reserve(vChecks.size());
+        for (const sigma::CSigmaSpendProofCheck& check : vChecks)
+            vResults.push_back(pool.push([&check](int) { return check(); }));
+
+        int nLastProgress = 0;
+        size_t nVerified = 0;
+        for (size_t i = 0; i < vResults.size(); i++) {
+            if (vResults[i].get())
+                nVerified++;
+            int nProgress = (i + 1) * 10 / vResults.size();
+            if (nProgress > nLastProgress) {
+                nLastProgress = nProgress;
+                LogPrintf("Verifying spends of mempool transactions: %d%%\n", nProgress * 10);
+            }
+            if (ShutdownRequested()) {
+                pool.stop(false);
+                return false;
+            }
+        }
+        LogPrintf("Verified %u of %u sigma spends of mempool transactions in %dms\n", nVerified, vChecks.size(), GetTimeMillis() - nStart);
+    }
+
+    double prioritydummy = 0;
+    int nLastProgress = 0;
+    for (size_t i = 0; i < vEntries.size(); i++) {
+        const MempoolEntry& entry = vEntries[i];
+        CAmount amountdelta = entry.nFeeDelta;
+        if (amountdelta) {
+            mempool.PrioritiseTransaction(entry.tx->GetHash(), entry.tx->GetHash().ToString(), prioritydummy, amountdelta);
+        }
+        CValidationState state;
+        {
+            LOCK(cs_main);
+            AcceptToMemoryPoolWithTime(mempool, state, entry.tx, true, NULL, entry.nTime);
+        }
+        if (state.IsValid()) {
+            ++count;
+        } else {
+            ++failed;
+        }
+        int nProgress = (i + 1) * 10 / vEntries.size();
+        if (nProgress > nLastProgress) {
+            nLastProgress = nProgress;
+            LogPrintf("Importing mempool transactions: %d%%\n", nProgress * 10);
+        }
+        if (ShutdownRequested())
+            return false;
+    }
+
+    for (const auto& i : mapDeltas) {
+        mempool.PrioritiseTransaction(i.first, i.first.ToString(), prioritydummy, i.second);
+    }
+
     LogPrintf("Imported mempool transactions from disk: %i successes, %i failed, %i expired\n", count, failed, skipped);
     return true;
 }
@@ -9,10 +9,15 @@
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 #include "sigma/remint.h"
+#include "spendcache.h"
+#include "ui_interface.h"
+#include "ctpl.h"
 
 #include <atomic>
 #include <sstream>
 #include <chrono>
+#include <functional>
+#include <future>
 
 #include <boost/foreach.hpp>
 
@@ -369,6 +374,16 @@ bool CheckSpendFiroTransaction(const CTransaction &tx,
         bool passVerify = false;
         CBlockIndex *index = coinGroup.lastBlock;
 
+        // The accumulator search below depends only on the spend and the blocks of the coin group,
+        // a spend already verified against the same group tip (e.g. when it entered the mempool) is valid
+        CHashWriter spendHasher(SER_GETHASH, 0);
+        spendHasher << txin.scriptSig << txin.nSequence << txHashForMetadata << spendVersion;
+        spendHasher << (int64_t)targetDenominations[vinIndex] << pubcoinId << fModulusV2 << fModulusV2InIndex;
+        spendHasher << coinGroup.firstBlock->GetBlockHash() << coinGroup.lastBlock->GetBlockHash();
+        uint256 spendHash = spendHasher.GetHash();
+        if (IsSpendVerificationCached(spendHash))
+            continue;
+
         pair<int,int> denominationAndId = make_pair(targetDenominations[vinIndex], pubcoinId);
 
         bool spendHasBlockHash = false;
@@ -447,6 +462,8 @@ bool CheckSpendFiroTransaction(const CTransaction &tx,
             LogPrintf("CheckSpendFiroTransaction: verification failed at block %d\n", nHeight);
             return false;
         }
+
+        AddSpendVerificationToCache(spendHash);
     }
 
     if (hasZerocoinSpendInputs) {
@@ -1160,6 +1177,48 @@ int CZerocoinState::GetMintedCoinHeightAndId(const CBigNum &pubCoin, int denomin
         return -1;
 }
 
+namespace {
+
+// Raise the accumulator value to the product of the coins minted in a block. Same as adding the coins
+// one by one, but each block costs a single modular exponentiation
+CBigNum AccumulateBlockMints(const CBigNum &value, const vector<CBigNum> &mintedCoins, const CBigNum &modulus) {
+    if (mintedCoins.empty())
+        return value;
+
+    CBigNum exponent = mintedCoins[0];
+    for (size_t i = 1; i < mintedCoins.size(); i++)
+        exponent *= mintedCoins[i];
+    return value.pow_mod(exponent, modulus);
+}
+
+// Coin groups are independent of each other. Run a task for each of them on worker threads and report
+// progress through the UI as they complete. Results are returned in the order of the tasks
+template <typename Result>
+vector<Result> RunCoinGroupTasks(const std::string &strTitle, const vector<std::function<Result()>> &tasks) {
+    vector<Result> results;
+    if (tasks.empty())
+        return results;
+
+    ctpl::thread_pool workerPool(std::max(std::min(GetNumCores(), (int)tasks.size()), 1));
+    RenameThreadPool(workerPool, "bitcoin-zcacc");
+
+    vector<std::future<Result>> futures;
+    for (const auto &task : tasks)
+        futures.emplace_back(workerPool.push([&task](int) { return task(); }));
+
+    uiInterface.ShowProgress(strTitle, 0);
+    for (size_t i = 0; i < futures.size(); i++) {
+        results.push_back(futures[i].get());
+        uiInterface.ShowProgress(strTitle, std::min(99, (int)((i + 1) * 100 / futures.size())));
+    }
+    uiInterface.ShowProgress(strTitle, 100);
+
+    workerPool.stop(true);
+    return results;
+}
+
+} // anon namespace
+
 void CZerocoinState::CalculateAlternativeModulusAccumulatorValues(CChain *chain, int denomination, int id) {
     libzerocoin::CoinDenomination d = (libzerocoin::CoinDenomination)denomination;
     pair<int, int> denomAndId = pair<int, int>(denomination, id);
@@ -1183,9 +1242,8 @@ void CZerocoinState::CalculateAlternativeModulusAccumulatorValues(CChain *chain,
                 // re-create accumulator changes with alternative params
                 assert(block->mintedPubCoins.count(denomAndId) > 0);
                 const vector<CBigNum> &mintedCoins = block->mintedPubCoins[denomAndId];
-                BOOST_FOREACH(const CBigNum &c, mintedCoins) {
-                    accumulator += libzerocoin::PublicCoin(altParams, c, d);
-                }
+                accumulator = libzerocoin::Accumulator(altParams,
+                        AccumulateBlockMints(accumulator.getValue(), mintedCoins, altParams->accumulatorParams.accumulatorModulus), d);
                 block->alternativeAccumulatorChanges[denomAndId] = make_pair(accumulator.getValue(), (int)mintedCoins.size());
             }
         }
@@ -1198,85 +1256,121 @@ void CZerocoinState::CalculateAlternativeModulusAccumulatorValues(CChain *chain,
 }
 
 bool CZerocoinState::TestValidity(CChain *chain) {
+    // Each task returns an empty string if the group is valid, the failure otherwise. Worker threads
+    // only read the block index, find() is used as operator[] could insert
+    vector<std::function<std::string()>> tasks;
     BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), CoinGroupInfo) &coinGroup, coinGroups) {
-        fprintf(stderr, "TestValidity[denomination=%d, id=%d]\n", coinGroup.first.first, coinGroup.first.second);
+        const pair<int,int> denomAndId = coinGroup.first;
+        const CoinGroupInfo groupInfo = coinGroup.second;
+        tasks.emplace_back([chain, denomAndId, groupInfo]() -> std::string {
+            bool fModulusV2 = IsZerocoinTxV2((libzerocoin::CoinDenomination)denomAndId.first, Params().GetConsensus(), denomAndId.second);
+            libzerocoin::Params *zcParams = fModulusV2 ? ZCParamsV2 : ZCParams;
 
-        bool fModulusV2 = IsZerocoinTxV2((libzerocoin::CoinDenomination)coinGroup.first.first, Params().GetConsensus(), coinGroup.first.second);
-        libzerocoin::Params *zcParams = fModulusV2 ? ZCParamsV2 : ZCParams;
+            CBigNum acc = zcParams->accumulatorParams.accumulatorBase;
 
-        libzerocoin::Accumulator acc(&zcParams->accumulatorParams, (libzerocoin::CoinDenomination)coinGroup.first.first);
+            CBlockIndex *block = groupInfo.firstBlock;
+            for (;;) {
+                auto changes = block->accumulatorChanges.find(denomAndId);
+                if (changes != block->accumulatorChanges.end()) {
+                    auto mints = block->mintedPubCoins.find(denomAndId);
+                    if (mints == block->mintedPubCoins.end())
+                        return "no minted coins";
 
-        CBlockIndex *block = coinGroup.second.firstBlock;
-        for (;;) {
-            if (block->accumulatorChanges.count(coinGroup.first) > 0) {
-                if (block->mintedPubCoins.count(coinGroup.first) == 0) {
-                    fprintf(stderr, "  no minted coins\n");
-                    return false;
-                }
+                    acc = AccumulateBlockMints(acc, mints->second, zcParams->accumulatorParams.accumulatorModulus);
 
-                BOOST_FOREACH(const CBigNum &pubCoin, block->mintedPubCoins[coinGroup.first]) {
-                    acc += libzerocoin::PublicCoin(zcParams, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first);
-                }
+                    if (acc != changes->second.first)
+                        return strprintf("accumulator value mismatch at height %d", block->nHeight);
 
-                if (acc.getValue() != block->accumulatorChanges[coinGroup.first].first) {
-                    fprintf (stderr, "  accumulator value mismatch at height %d\n", block->nHeight);
-                    return false;
+                    if (changes->second.second != (int)mints->second.size())
+                        return strprintf("number of minted coins mismatch at height %d", block->nHeight);
                 }
 
-                if (block->accumulatorChanges[coinGroup.first].second != (int)block->mintedPubCoins[coinGroup.first].size()) {
-                    fprintf(stderr, "  number of minted coins mismatch at height %d\n", block->nHeight);
-                    return false;
-                }
+                if (block != groupInfo.lastBlock)
+                    block = (*chain)[block->nHeight+1];
+                else
+                    break;
             }
 
-            if (block != coinGroup.second.lastBlock)
-                block = (*chain)[block->nHeight+1];
-            else
-                break;
-        }
+            return "";
+        });
+    }
+
+    vector<std::string> results = RunCoinGroupTasks(_("Verifying zerocoin accumulators..."), tasks);
 
+    size_t i = 0;
+    BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), CoinGroupInfo) &coinGroup, coinGroups) {
+        fprintf(stderr, "TestValidity[denomination=%d, id=%d]\n", coinGroup.first.first, coinGroup.first.second);
+        if (!results[i].empty()) {
+            fprintf(stderr, "  %s\n", results[i].c_str());
+            return false;
+        }
         fprintf(stderr, "  verified ok\n");
+        i++;
     }
 
     return true;
 }
 
 set<CBlockIndex *> CZerocoinState::RecalculateAccumulators(CChain *chain) {
-    set<CBlockIndex *> changes;
+    typedef vector<pair<CBlockIndex *, CBigNum>> AccumulatorValues;
 
+    // Each task returns the new accumulator values of its group, empty if the group is up to date.
+    // Worker threads only read the block index, the values are stored afterwards
+    vector<pair<int,int>> groups;
+    vector<std::function<AccumulatorValues()>> tasks;
     BOOST_FOREACH(const PAIRTYPE(PAIRTYPE(int,int), CoinGroupInfo) &coinGroup, coinGroups) {
         // Skip non-modulusv2 groups
         if (!IsZerocoinTxV2((libzerocoin::CoinDenomination)coinGroup.first.first, Params().GetConsensus(), coinGroup.first.second))
             continue;
 
-        libzerocoin::Accumulator acc(&ZCParamsV2->accumulatorParams, (libzerocoin::CoinDenomination)coinGroup.first.first);
-
-        // Try to calculate accumulator for the first batch of mints. If it doesn't match we need to recalculate the rest of it
-        CBlockIndex *block = coinGroup.second.firstBlock;
-        for (;;) {
-            if (block->accumulatorChanges.count(coinGroup.first) > 0) {
-                BOOST_FOREACH(const CBigNum &pubCoin, block->mintedPubCoins[coinGroup.first]) {
-                    acc += libzerocoin::PublicCoin(ZCParamsV2, pubCoin, (libzerocoin::CoinDenomination)coinGroup.first.first);
-                }
+        const pair<int,int> denomAndId = coinGroup.first;
+        const CoinGroupInfo groupInfo = coinGroup.second;
+        groups.push_back(denomAndId);
+        tasks.emplace_back([chain, denomAndId, groupInfo]() -> AccumulatorValues {
+            AccumulatorValues values;
+            const vector<CBigNum> noMints;
+            CBigNum acc = ZCParamsV2->accumulatorParams.accumulatorBase;
+
+            // Try to calculate accumulator for the first batch of mints. If it doesn't match we need to recalculate the rest of it
+            CBlockIndex *block = groupInfo.firstBlock;
+            for (;;) {
+                auto changes = block->accumulatorChanges.find(denomAndId);
+                if (changes != block->accumulatorChanges.end()) {
+                    auto mints = block->mintedPubCoins.find(denomAndId);
+                    acc = AccumulateBlockMints(acc, mints != block->mintedPubCoins.end() ? mints->second : noMints,
+                                               ZCParamsV2->accumulatorParams.accumulatorModulus);
+
+                    // First block case is special: do the check
+                    if (block == groupInfo.firstBlock) {
+                        if (acc != changes->second.first)
+                            // recalculation is needed
+                            LogPrintf("ZerocoinState: accumulator recalculation for denomination=%d, id=%d\n", denomAndId.first, denomAndId.second);
+                        else
+                            // everything's ok
+                            break;
+                    }
 
-                // First block case is special: do the check
-                if (block == coinGroup.second.firstBlock) {
-                    if (acc.getValue() != block->accumulatorChanges[coinGroup.first].first)
-                        // recalculation is needed
-                        LogPrintf("ZerocoinState: accumulator recalculation for denomination=%d, id=%d\n", coinGroup.first.first, coinGroup.first.second);
-                    else
-                        // everything's ok
-                        break;
+                    values.emplace_back(block, acc);
                 }
 
-                block->accumulatorChanges[coinGroup.first] = make_pair(acc.getValue(), (int)block->mintedPubCoins[coinGroup.first].size());
-                changes.insert(block);
+                if (block != groupInfo.lastBlock)
+                    block = (*chain)[block->nHeight+1];
+                else
+                    break;
             }
 
-            if (block != coinGroup.second.lastBlock)
-                block = (*chain)[block->nHeight+1];
-            else
-                break;
+            return values;
+        });
+    }
+
+    vector<AccumulatorValues> results = RunCoinGroupTasks(_("Recalculating zerocoin accumulators..."), tasks);
+
+    set<CBlockIndex *> changes;
+    for (size_t i = 0; i < groups.size(); i++) {
+        for (const auto &value : results[i]) {
+            CBlockIndex *block = value.first;
+            block->accumulatorChanges[groups[i]] = make_pair(value.second, (int)block->mintedPubCoins[groups[i]].size());
+            changes.insert(block);
         }
     }
 